@@ -0,0 +1,72 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         https://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+// Catalog the headers of the Scanco files in one or more directory trees.
+//
+// Usage: ScancoArchiveIndex [-j NumberOfThreads] Catalog.jsonl Directory [Directory ...]
+//
+// Running it again with the same catalog only parses new and modified files.
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include "itkScancoArchiveIndexer.h"
+
+int
+main(int argc, char * argv[])
+{
+  int argi = 1;
+  int numberOfThreads = 0;
+  if (argc > 2 && std::strcmp(argv[1], "-j") == 0)
+  {
+    numberOfThreads = std::atoi(argv[2]);
+    argi += 2;
+  }
+  if (argc - argi < 2)
+  {
+    std::cerr << "Usage: " << argv[0] << " [-j NumberOfThreads] Catalog.jsonl Directory [Directory ...]" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  itk::ScancoArchiveIndexer::Pointer indexer = itk::ScancoArchiveIndexer::New();
+  indexer->SetCatalogFileName(argv[argi++]);
+  for (; argi < argc; ++argi)
+  {
+    indexer->AddDirectory(argv[argi]);
+  }
+  if (numberOfThreads > 0)
+  {
+    indexer->SetNumberOfWorkUnits(numberOfThreads);
+  }
+
+  try
+  {
+    indexer->Update();
+  }
+  catch (const itk::ExceptionObject & error)
+  {
+    std::cerr << "Error: " << error << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::cout << "Parsed: " << indexer->GetNumberOfParsedFiles() << std::endl;
+  std::cout << "Unchanged: " << indexer->GetNumberOfUnchangedFiles() << std::endl;
+  std::cout << "Failed: " << indexer->GetNumberOfFailedFiles() << std::endl;
+
+  return EXIT_SUCCESS;
+}
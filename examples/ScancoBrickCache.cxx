@@ -0,0 +1,72 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         https://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+// Transcode a Scanco file into a brick cache for fast region reads.
+//
+// Usage: ScancoBrickCache [-b BrickSize] Input [Cache]
+//
+// The cache is written next to the input by default, where ScancoImageIO
+// finds it when its UseBrickCache option is on.
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include "itkScancoBrickCache.h"
+
+int
+main(int argc, char * argv[])
+{
+  int          argi = 1;
+  unsigned int brickSize = itk::ScancoBrickCache::DefaultBrickSize;
+  if (argc > 2 && std::strcmp(argv[1], "-b") == 0)
+  {
+    brickSize = static_cast<unsigned int>(std::atoi(argv[2]));
+    argi += 2;
+  }
+  if (argc - argi < 1 || argc - argi > 2 || brickSize == 0)
+  {
+    std::cerr << "Usage: " << argv[0] << " [-b BrickSize] Input [Cache]" << std::endl;
+    return EXIT_FAILURE;
+  }
+  const std::string inputFileName = argv[argi];
+  const std::string cacheFileName =
+    (argc - argi == 2 ? std::string(argv[argi + 1]) : itk::ScancoBrickCache::GetCacheFileName(inputFileName));
+
+  std::vector<itk::ScancoBrickCache::BrickInformation> bricks;
+  try
+  {
+    itk::ScancoBrickCache::Transcode(inputFileName, cacheFileName, brickSize);
+    itk::ScancoBrickCache::ReadBrickInformation(cacheFileName, brickSize, bricks);
+  }
+  catch (const itk::ExceptionObject & error)
+  {
+    std::cerr << "Error: " << error << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  itk::SizeValueType uniformBricks = 0;
+  for (const auto & brick : bricks)
+  {
+    uniformBricks += (brick.Offset == 0);
+  }
+  std::cout << "Bricks: " << bricks.size() << std::endl;
+  std::cout << "Uniform: " << uniformBricks << std::endl;
+
+  return EXIT_SUCCESS;
+}
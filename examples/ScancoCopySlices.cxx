@@ -0,0 +1,78 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         https://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+// Split or join ISQ files by slice range, without decoding their data.
+//
+// Usage: ScancoCopySlices Output.isq [-z FirstSlice NumberOfSlices] Input.isq
+//                         [[-z FirstSlice NumberOfSlices] Input.isq ...]
+//
+// Each -z selects the slices of the input that follows it, and an input
+// without -z is copied whole. The slices of all inputs are written to the
+// output one after the other.
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include "itkScancoImageIO.h"
+
+int
+main(int argc, char * argv[])
+{
+  std::vector<itk::ScancoImageIO::SliceRange> ranges;
+  itk::ScancoImageIO::SliceRange              range;
+  bool                                        validArguments = (argc > 2);
+  for (int argi = 2; argi < argc && validArguments; ++argi)
+  {
+    if (std::strcmp(argv[argi], "-z") == 0)
+    {
+      validArguments = (argi + 3 < argc && std::atol(argv[argi + 2]) > 0);
+      if (validArguments)
+      {
+        range.FirstSlice = static_cast<itk::SizeValueType>(std::atol(argv[argi + 1]));
+        range.NumberOfSlices = static_cast<itk::SizeValueType>(std::atol(argv[argi + 2]));
+        argi += 2;
+      }
+    }
+    else
+    {
+      range.FileName = argv[argi];
+      ranges.push_back(range);
+      range = itk::ScancoImageIO::SliceRange();
+    }
+  }
+  if (!validArguments || ranges.empty())
+  {
+    std::cerr << "Usage: " << argv[0]
+              << " Output.isq [-z FirstSlice NumberOfSlices] Input.isq [[-z FirstSlice NumberOfSlices] Input.isq ...]"
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  try
+  {
+    itk::ScancoImageIO::CopySlices(ranges, argv[1]);
+  }
+  catch (const itk::ExceptionObject & error)
+  {
+    std::cerr << "Error: " << error << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
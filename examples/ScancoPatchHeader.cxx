@@ -0,0 +1,142 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         https://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+// Replace the patient name, patient index or date in the headers of Scanco
+// files, without rewriting their data.
+//
+// Usage: ScancoPatchHeader [-j NumberOfThreads] [--anonymize] [--patient-name Name]
+//                          [--patient-index Index] [--date Date] [--files-from List] File [File ...]
+//
+// Dates are given as in the headers, e.g. "3-MAR-2021 04:05:06.007", where
+// the time may be left out. --anonymize clears the name and index and sets
+// the date to 1-JAN-2000, and can be combined with the other options. With
+// --files-from, the names of the files are also read from a list with one
+// name per line.
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "itkMultiThreaderBase.h"
+#include "itkScancoImageIO.h"
+
+int
+main(int argc, char * argv[])
+{
+  int                             numberOfThreads = 0;
+  itk::ScancoImageIO::HeaderPatch patch;
+  std::vector<std::string>        fileNames;
+  bool                            validArguments = true;
+  for (int argi = 1; argi < argc && validArguments; ++argi)
+  {
+    const bool hasValue = (argi + 1 < argc);
+    if (std::strcmp(argv[argi], "--anonymize") == 0)
+    {
+      patch.Anonymize();
+    }
+    else if (!hasValue && argv[argi][0] == '-')
+    {
+      validArguments = false;
+    }
+    else if (std::strcmp(argv[argi], "-j") == 0)
+    {
+      numberOfThreads = std::atoi(argv[++argi]);
+    }
+    else if (std::strcmp(argv[argi], "--patient-name") == 0)
+    {
+      patch.ReplacePatientName = true;
+      patch.PatientName = argv[++argi];
+    }
+    else if (std::strcmp(argv[argi], "--patient-index") == 0)
+    {
+      patch.ReplacePatientIndex = true;
+      patch.PatientIndex = std::atoi(argv[++argi]);
+    }
+    else if (std::strcmp(argv[argi], "--date") == 0)
+    {
+      patch.ReplaceDate = true;
+      patch.Date = argv[++argi];
+    }
+    else if (std::strcmp(argv[argi], "--files-from") == 0)
+    {
+      std::ifstream list(argv[++argi]);
+      validArguments = list.is_open();
+      std::string line;
+      while (std::getline(list, line))
+      {
+        if (!line.empty() && line.back() == '\r')
+        {
+          line.pop_back();
+        }
+        if (!line.empty())
+        {
+          fileNames.push_back(line);
+        }
+      }
+    }
+    else
+    {
+      fileNames.emplace_back(argv[argi]);
+    }
+  }
+  if (!validArguments || fileNames.empty() ||
+      !(patch.ReplacePatientName || patch.ReplacePatientIndex || patch.ReplaceDate))
+  {
+    std::cerr << "Usage: " << argv[0]
+              << " [-j NumberOfThreads] [--anonymize] [--patient-name Name] [--patient-index Index] [--date Date]"
+                 " [--files-from List] File [File ...]"
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Patching a file only touches its header, so the files are patched in
+  // parallel, and a file that fails does not stop the others
+  itk::MultiThreaderBase::Pointer threader = itk::MultiThreaderBase::New();
+  if (numberOfThreads > 0)
+  {
+    threader->SetMaximumNumberOfThreads(numberOfThreads);
+    threader->SetNumberOfWorkUnits(numberOfThreads);
+  }
+  std::atomic<itk::SizeValueType> numberOfFailedFiles(0);
+  std::mutex                      outputMutex;
+  threader->ParallelizeArray(
+    0,
+    fileNames.size(),
+    [&](itk::SizeValueType i) {
+      try
+      {
+        itk::ScancoImageIO::PatchHeader(fileNames[i], patch);
+      }
+      catch (const itk::ExceptionObject & error)
+      {
+        ++numberOfFailedFiles;
+        std::lock_guard<std::mutex> lock(outputMutex);
+        std::cerr << "Error: " << fileNames[i] << ": " << error.GetDescription() << std::endl;
+      }
+    },
+    nullptr);
+
+  std::cout << "Patched: " << fileNames.size() - numberOfFailedFiles << std::endl;
+  std::cout << "Failed: " << numberOfFailedFiles << std::endl;
+
+  return (numberOfFailedFiles == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+}
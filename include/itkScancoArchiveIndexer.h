@@ -0,0 +1,119 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         https://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkScancoArchiveIndexer_h
+#define itkScancoArchiveIndexer_h
+#include "IOScancoExport.h"
+
+#include <string>
+#include <vector>
+#include "itkObject.h"
+#include "itkScancoHeader.h"
+
+namespace itk
+{
+/** \class ScancoArchiveIndexer
+ *
+ * \brief Catalog the headers of all Scanco files below a set of directories.
+ *
+ * The directories are walked recursively and every file with an ISQ, RSQ,
+ * RAD or AIM extension has its header parsed with ScancoImageIO. The voxel
+ * data is never read. Headers are parsed in parallel on the ITK thread
+ * pool.
+ *
+ * The catalog is written in JSON Lines format: one JSON object per file,
+ * keyed by "Path", "MTime" and "Size", followed by the header fields under
+ * the same names that ScancoImageIO uses in the metadata dictionary. When
+ * the catalog file already exists, entries of files whose modification time
+ * and size are unchanged are copied over without opening the file again.
+ * Files that no longer exist are dropped from the catalog. The catalog is
+ * UTF-8: paths are written as they are, and the Latin-1 text of the
+ * headers is converted.
+ *
+ * \ingroup IOScanco
+ */
+class IOScanco_EXPORT ScancoArchiveIndexer : public Object
+{
+public:
+  ITK_DISALLOW_COPY_AND_MOVE(ScancoArchiveIndexer);
+
+  /** Standard class typedefs. */
+  using Self = ScancoArchiveIndexer;
+  using Superclass = Object;
+  using Pointer = SmartPointer<Self>;
+  using ConstPointer = SmartPointer<const Self>;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(ScancoArchiveIndexer, Object);
+
+  /** Add a directory tree to be indexed. */
+  void
+  AddDirectory(const std::string & directory);
+
+  /** Remove all directories. */
+  void
+  ClearDirectories();
+
+  /** The JSON Lines catalog that is read and rewritten by Update(). */
+  itkSetStringMacro(CatalogFileName);
+  itkGetStringMacro(CatalogFileName);
+
+  /** Number of work units used to parse headers. Defaults to the global
+   * default number of threads. */
+  itkSetMacro(NumberOfWorkUnits, ThreadIdType);
+  itkGetConstMacro(NumberOfWorkUnits, ThreadIdType);
+
+  /** Walk the directories, parse new and changed files and write the
+   * catalog. */
+  void
+  Update();
+
+  /** Statistics of the last Update(). */
+  itkGetConstMacro(NumberOfParsedFiles, SizeValueType);
+  itkGetConstMacro(NumberOfUnchangedFiles, SizeValueType);
+  itkGetConstMacro(NumberOfFailedFiles, SizeValueType);
+
+  /** Format a single catalog entry, without the trailing newline. */
+  static std::string
+  FormatCatalogEntry(const std::string & path, long modifiedTime, SizeValueType size, const ScancoHeader & header);
+
+protected:
+  ScancoArchiveIndexer();
+  ~ScancoArchiveIndexer() override = default;
+
+  void
+  PrintSelf(std::ostream & os, Indent indent) const override;
+
+private:
+  /** Recursively collect the Scanco files below the directory. */
+  static void
+  FindFiles(const std::string & directory, std::vector<std::string> & files);
+
+  std::vector<std::string> m_Directories;
+  std::string              m_CatalogFileName;
+  ThreadIdType             m_NumberOfWorkUnits;
+
+  SizeValueType m_NumberOfParsedFiles{ 0 };
+  SizeValueType m_NumberOfUnchangedFiles{ 0 };
+  SizeValueType m_NumberOfFailedFiles{ 0 };
+};
+} // end namespace itk
+
+#endif // itkScancoArchiveIndexer_h
@@ -0,0 +1,355 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         https://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkScancoBitMask_h
+#define itkScancoBitMask_h
+#include "IOScancoExport.h"
+
+#include <cstdint>
+#include <vector>
+#include "itkImage.h"
+#include "itkNumericTraits.h"
+#include "itkObject.h"
+
+namespace itk
+{
+/** \class ScancoBitMask
+ *
+ * \brief A three-dimensional binary mask with one bit per voxel.
+ *
+ * Masks read as unsigned char images use eight times the memory that their
+ * content needs. ScancoBitMask packs 64 voxels into each word instead. Each
+ * row along x starts at a new word, bit x % 64 of word x / 64 holds voxel x,
+ * and the bits past the end of a row are zero. Rows are stored with y
+ * varying fastest, then z, like the voxels of an image.
+ *
+ * ScancoImageIO::ReadBitMask() fills a mask from a binary AIM file or from
+ * a threshold on read. The ConstIterator and Iterator walk a region of the
+ * mask in the manner of ImageRegionConstIterator and ImageRegionIterator,
+ * and GetImage() and SetImage() convert a region to and from an Image, so
+ * that ITK filters, e.g. for morphology, can be run block by block.
+ *
+ * \ingroup IOScanco
+ */
+class IOScanco_EXPORT ScancoBitMask : public Object
+{
+public:
+  ITK_DISALLOW_COPY_AND_MOVE(ScancoBitMask);
+
+  /** Standard class typedefs. */
+  using Self = ScancoBitMask;
+  using Superclass = Object;
+  using Pointer = SmartPointer<Self>;
+  using ConstPointer = SmartPointer<const Self>;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(ScancoBitMask, Object);
+
+  using WordType = std::uint64_t;
+  static constexpr unsigned int BitsPerWord = 64;
+
+  using ImageType = Image<unsigned char, 3>;
+  using IndexType = ImageType::IndexType;
+  using SizeType = ImageType::SizeType;
+  using RegionType = ImageType::RegionType;
+  using SpacingType = ImageType::SpacingType;
+  using PointType = ImageType::PointType;
+
+  /** Set the size of the mask, and clear all of its voxels. */
+  void
+  Allocate(const SizeType & size);
+
+  /** The region of the mask, which starts at index zero. */
+  const RegionType &
+  GetLargestPossibleRegion() const
+  {
+    return this->m_Region;
+  }
+
+  itkSetMacro(Spacing, SpacingType);
+  itkGetConstReferenceMacro(Spacing, SpacingType);
+  itkSetMacro(Origin, PointType);
+  itkGetConstReferenceMacro(Origin, PointType);
+
+  /** The number of words that hold one row. */
+  SizeValueType
+  GetWordsPerRow() const
+  {
+    return this->m_WordsPerRow;
+  }
+
+  /** The words of the row at (y, z). */
+  WordType *
+  GetRow(SizeValueType y, SizeValueType z)
+  {
+    return this->m_Words.data() + (z * this->m_Region.GetSize(1) + y) * this->m_WordsPerRow;
+  }
+  const WordType *
+  GetRow(SizeValueType y, SizeValueType z) const
+  {
+    return this->m_Words.data() + (z * this->m_Region.GetSize(1) + y) * this->m_WordsPerRow;
+  }
+
+  /** All words of the mask. */
+  WordType *
+  GetBufferPointer()
+  {
+    return this->m_Words.data();
+  }
+  const WordType *
+  GetBufferPointer() const
+  {
+    return this->m_Words.data();
+  }
+
+  /** The memory used by the words of the mask, in bytes. */
+  SizeValueType
+  GetBufferSize() const
+  {
+    return this->m_Words.size() * sizeof(WordType);
+  }
+
+  bool
+  GetPixel(const IndexType & index) const
+  {
+    const WordType * row = this->GetRow(index[1], index[2]);
+    return ((row[index[0] / BitsPerWord] >> (index[0] % BitsPerWord)) & 1) != 0;
+  }
+
+  void
+  SetPixel(const IndexType & index, bool value)
+  {
+    WordType *     row = this->GetRow(index[1], index[2]);
+    const WordType bit = WordType{ 1 } << (index[0] % BitsPerWord);
+    row[index[0] / BitsPerWord] = (value ? row[index[0] / BitsPerWord] | bit : row[index[0] / BitsPerWord] & ~bit);
+  }
+
+  /** Set or clear the voxels x to x + length - 1 of the row at (y, z). */
+  void
+  SetRun(SizeValueType x, SizeValueType y, SizeValueType z, SizeValueType length, bool value);
+
+  /** Set or clear all voxels. */
+  void
+  FillBuffer(bool value);
+
+  /** The number of set voxels. */
+  SizeValueType
+  CountSetVoxels() const;
+
+  /** Expand a region of the mask into a new image, with set voxels as
+   * foregroundValue and cleared voxels as zero. TImage is a
+   * three-dimensional image with a scalar pixel type. */
+  template <typename TImage>
+  typename TImage::Pointer
+  GetImage(const RegionType &               region,
+           const typename TImage::PixelType foregroundValue =
+             NumericTraits<typename TImage::PixelType>::OneValue()) const
+  {
+    static_assert(TImage::ImageDimension == 3, "The image must be three-dimensional.");
+    this->CheckRegion(region);
+
+    typename TImage::RegionType  imageRegion;
+    typename TImage::SpacingType spacing;
+    typename TImage::PointType   origin;
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+      imageRegion.SetIndex(i, region.GetIndex(i));
+      imageRegion.SetSize(i, region.GetSize(i));
+      spacing[i] = this->m_Spacing[i];
+      origin[i] = this->m_Origin[i];
+    }
+    typename TImage::Pointer image = TImage::New();
+    image->SetRegions(imageRegion);
+    image->SetSpacing(spacing);
+    image->SetOrigin(origin);
+    image->Allocate();
+
+    typename TImage::PixelType * pixel = image->GetBufferPointer();
+    for (ConstIterator it(this, region); !it.IsAtEnd(); ++it)
+    {
+      *pixel++ = (it.Get() ? foregroundValue : typename TImage::PixelType{});
+    }
+    return image;
+  }
+
+  /** Set the voxels that the buffered region of the image covers to whether
+   * its pixels are non-zero, e.g. to store the result of a filter run on
+   * GetImage(). The region must lie within the mask. */
+  template <typename TImage>
+  void
+  SetImage(const TImage * image)
+  {
+    static_assert(TImage::ImageDimension == 3, "The image must be three-dimensional.");
+    RegionType region;
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+      region.SetIndex(i, image->GetBufferedRegion().GetIndex(i));
+      region.SetSize(i, image->GetBufferedRegion().GetSize(i));
+    }
+    this->CheckRegion(region);
+
+    const typename TImage::PixelType * pixel = image->GetBufferPointer();
+    for (Iterator it(this, region); !it.IsAtEnd(); ++it)
+    {
+      it.Set(*pixel++ != typename TImage::PixelType{});
+    }
+  }
+
+  /** \class ConstIterator
+   *
+   * \brief Walk the voxels of a region of a ScancoBitMask, with x varying
+   * fastest, like ImageRegionConstIterator.
+   *
+   * \ingroup IOScanco
+   */
+  class ConstIterator
+  {
+  public:
+    ConstIterator() = default;
+
+    ConstIterator(const ScancoBitMask * mask, const RegionType & region)
+      : m_Mask(mask)
+      , m_Region(region)
+    {
+      mask->CheckRegion(region);
+      this->GoToBegin();
+    }
+
+    void
+    GoToBegin()
+    {
+      this->m_Index = this->m_Region.GetIndex();
+      this->m_AtEnd = (this->m_Region.GetNumberOfPixels() == 0);
+      this->UpdateWord();
+    }
+
+    bool
+    IsAtEnd() const
+    {
+      return this->m_AtEnd;
+    }
+
+    ConstIterator &
+    operator++()
+    {
+      ++this->m_Index[0];
+      if (++this->m_Bit == BitsPerWord)
+      {
+        this->m_Bit = 0;
+        ++this->m_Word;
+      }
+      if (this->m_Index[0] == this->m_Region.GetIndex(0) + static_cast<IndexValueType>(this->m_Region.GetSize(0)))
+      {
+        this->m_Index[0] = this->m_Region.GetIndex(0);
+        if (++this->m_Index[1] == this->m_Region.GetIndex(1) + static_cast<IndexValueType>(this->m_Region.GetSize(1)))
+        {
+          this->m_Index[1] = this->m_Region.GetIndex(1);
+          this->m_AtEnd = (++this->m_Index[2] == this->m_Region.GetIndex(2) +
+                                                    static_cast<IndexValueType>(this->m_Region.GetSize(2)));
+        }
+        this->UpdateWord();
+      }
+      return *this;
+    }
+
+    bool
+    Get() const
+    {
+      return ((*this->m_Word >> this->m_Bit) & 1) != 0;
+    }
+
+    const IndexType &
+    GetIndex() const
+    {
+      return this->m_Index;
+    }
+
+    const RegionType &
+    GetRegion() const
+    {
+      return this->m_Region;
+    }
+
+  protected:
+    /** Point to the word and bit of the current index. */
+    void
+    UpdateWord()
+    {
+      if (!this->m_AtEnd)
+      {
+        this->m_Word = this->m_Mask->GetRow(this->m_Index[1], this->m_Index[2]) + this->m_Index[0] / BitsPerWord;
+        this->m_Bit = this->m_Index[0] % BitsPerWord;
+      }
+    }
+
+    const ScancoBitMask * m_Mask{ nullptr };
+    RegionType            m_Region;
+    IndexType             m_Index{};
+    const WordType *      m_Word{ nullptr };
+    unsigned int          m_Bit{ 0 };
+    bool                  m_AtEnd{ true };
+  };
+
+  /** \class Iterator
+   *
+   * \brief Walk and modify the voxels of a region of a ScancoBitMask, like
+   * ImageRegionIterator.
+   *
+   * \ingroup IOScanco
+   */
+  class Iterator : public ConstIterator
+  {
+  public:
+    Iterator() = default;
+
+    Iterator(ScancoBitMask * mask, const RegionType & region)
+      : ConstIterator(mask, region)
+    {}
+
+    void
+    Set(bool value) const
+    {
+      WordType &     word = *const_cast<WordType *>(this->m_Word);
+      const WordType bit = WordType{ 1 } << this->m_Bit;
+      word = (value ? word | bit : word & ~bit);
+    }
+  };
+
+protected:
+  ScancoBitMask();
+  ~ScancoBitMask() override = default;
+
+  void
+  PrintSelf(std::ostream & os, Indent indent) const override;
+
+private:
+  /** Throw an exception unless the region lies within the mask. */
+  void
+  CheckRegion(const RegionType & region) const;
+
+  RegionType            m_Region;
+  SpacingType           m_Spacing;
+  PointType             m_Origin;
+  SizeValueType         m_WordsPerRow{ 0 };
+  std::vector<WordType> m_Words;
+};
+} // end namespace itk
+
+#endif // itkScancoBitMask_h
@@ -0,0 +1,103 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         https://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkScancoBrickCache_h
+#define itkScancoBrickCache_h
+#include "IOScancoExport.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "itkImageIORegion.h"
+#include "itkScancoHeader.h"
+
+namespace itk
+{
+/** \class ScancoBrickCache
+ *
+ * \brief Bricked copy of the voxel data of a Scanco file.
+ *
+ * The slice-major layout of Scanco files means that a small region of
+ * interest, or the bounding box of an oblique slice, touches a large part
+ * of the file. Transcode() writes the calibrated voxel data of a file once
+ * into a cache file made of cubic bricks, so that ReadRegion() only reads
+ * the bricks that intersect the requested region.
+ *
+ * For each brick the cache holds the minimum and maximum value, which lets
+ * callers skip bricks that cannot contain values of interest. Bricks that
+ * hold a single value are not stored at all.
+ *
+ * The cache records the size and modification time of the file it was made
+ * from, and is ignored once the file has changed. The cache file is
+ * specific to the byte order of the machine that wrote it.
+ *
+ * ScancoImageIO reads regions from the cache file named by
+ * GetCacheFileName() when its UseBrickCache option is on.
+ *
+ * \ingroup IOScanco
+ */
+class IOScanco_EXPORT ScancoBrickCache
+{
+public:
+  /** Location and value range of one brick. */
+  struct BrickInformation
+  {
+    /** Offset of the brick data in the cache file, or 0 if all voxels of
+     * the brick have the value Minimum. */
+    std::uint64_t Offset;
+    double        Minimum;
+    double        Maximum;
+  };
+
+  /** Default edge length of the bricks, in voxels. */
+  static constexpr unsigned int DefaultBrickSize = 64;
+
+  /** Name of the cache file that ScancoImageIO looks for. */
+  static std::string
+  GetCacheFileName(const std::string & fileName);
+
+  /** Write the cache file for a Scanco file. */
+  static void
+  Transcode(const std::string & fileName,
+            const std::string & cacheFileName,
+            unsigned int        brickSize = DefaultBrickSize);
+
+  /** True if the cache file exists and was made from the file as it is
+   * now. */
+  static bool
+  IsUpToDate(const std::string & cacheFileName, const std::string & fileName);
+
+  /** Read the brick size and the information of all bricks, with x varying
+   * fastest. Throws if the cache file is not valid. */
+  static void
+  ReadBrickInformation(const std::string &             cacheFileName,
+                       unsigned int &                  brickSize,
+                       std::vector<BrickInformation> & bricks);
+
+  /** Read a region from the cache file into the buffer, which must be large
+   * enough to hold the region. Returns false without reading anything if the
+   * cache file is missing, out of date or does not match the header. */
+  static bool
+  ReadRegion(const std::string &   cacheFileName,
+             const std::string &   fileName,
+             const ScancoHeader &  header,
+             const ImageIORegion & region,
+             void *                buffer);
+};
+} // end namespace itk
+
+#endif // itkScancoBrickCache_h
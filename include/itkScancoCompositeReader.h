@@ -0,0 +1,193 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         https://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkScancoCompositeReader_h
+#define itkScancoCompositeReader_h
+#include "IOScancoExport.h"
+
+#include <string>
+#include <vector>
+#include "itkImage.h"
+#include "itkObject.h"
+#include "itkScancoImageIO.h"
+
+namespace itk
+{
+/** \class ScancoCompositeReader
+ *
+ * \brief Read several Scanco files into one volume, each at its place.
+ *
+ * AIM files that were cropped from a larger volume store the position of
+ * the crop, which ScancoImageIO turns into the origin, and the stacks of a
+ * long ISQ scan each store the position of their first slice as their
+ * StartPosition. This reader places every file in a common voxel grid from
+ * these header fields: AIM files at their origin, ISQ files at their start
+ * position along z. The output covers the union of the files, and each
+ * file is decoded straight into its part of one buffer, with
+ * ScancoImageIO::ReadStrided(), instead of being read into an image of its
+ * own and pasted.
+ *
+ * All files must have the same spacing and pixel type. Files are decoded
+ * in parallel, except that where files overlap the later one is decoded
+ * after the earlier and wins. Voxels that no file covers are zero.
+ *
+ * \ingroup IOScanco
+ */
+class IOScanco_EXPORT ScancoCompositeReader : public Object
+{
+public:
+  ITK_DISALLOW_COPY_AND_MOVE(ScancoCompositeReader);
+
+  /** Standard class typedefs. */
+  using Self = ScancoCompositeReader;
+  using Superclass = Object;
+  using Pointer = SmartPointer<Self>;
+  using ConstPointer = SmartPointer<const Self>;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(ScancoCompositeReader, Object);
+
+  using HeaderPointer = ScancoImageIO::HeaderPointer;
+  using FileNamesContainer = std::vector<std::string>;
+  using IndexType = Index<3>;
+
+  /** The files to combine. Where files overlap, later files win. */
+  void
+  SetFileNames(const FileNamesContainer & fileNames);
+  const FileNamesContainer &
+  GetFileNames() const
+  {
+    return this->m_FileNames;
+  }
+
+  void
+  AddFileName(const std::string & fileName);
+
+  /** Number of work units used to parse headers and decode files. Defaults
+   * to the global default number of threads. */
+  itkSetMacro(NumberOfWorkUnits, ThreadIdType);
+  itkGetConstMacro(NumberOfWorkUnits, ThreadIdType);
+
+  /** Parse the headers of all files, check that they match and compute the
+   * region that they cover. Read() does this when the file names have
+   * changed. */
+  void
+  ReadInformation();
+
+  /** The header of a file, or nullptr if the headers have not been read. */
+  HeaderPointer
+  GetHeader(SizeValueType file) const;
+
+  /** Index of the first voxel of a file in the output. */
+  IndexType
+  GetFileIndex(SizeValueType file) const
+  {
+    return this->m_FileIndices[file];
+  }
+
+  /** The pixel type that all of the files are read as. */
+  itkGetConstMacro(ComponentType, IOComponentEnum);
+
+  /** Geometry of the output, which covers all of the files. */
+  SizeValueType
+  GetDimensions(unsigned int i) const
+  {
+    return this->m_Dimensions[i];
+  }
+  double
+  GetSpacing(unsigned int i) const
+  {
+    return this->m_Spacing[i];
+  }
+  double
+  GetOrigin(unsigned int i) const
+  {
+    return this->m_Origin[i];
+  }
+
+  /** Size of the buffer that Read() fills. */
+  itkGetConstMacro(ImageSizeInBytes, SizeValueType);
+
+  /** Read all files into the buffer, which must hold GetImageSizeInBytes()
+   * bytes. */
+  void
+  Read(void * buffer);
+
+  /** Read the files into a new image. TPixel must match the component type
+   * that the files are read as, no conversion is done. */
+  template <typename TPixel>
+  typename Image<TPixel, 3>::Pointer
+  ReadImage()
+  {
+    using ImageType = Image<TPixel, 3>;
+    constexpr IOComponentEnum componentType = ImageIOBase::MapPixelType<TPixel>::CType;
+    this->UpdateInformation();
+    if (componentType != this->m_ComponentType)
+    {
+      itkExceptionMacro("The files are read as " << ImageIOBase::GetComponentTypeAsString(this->m_ComponentType)
+                                                 << ", not as "
+                                                 << ImageIOBase::GetComponentTypeAsString(componentType));
+    }
+
+    typename ImageType::RegionType  region;
+    typename ImageType::SpacingType spacing;
+    typename ImageType::PointType   origin;
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+      region.SetSize(i, this->m_Dimensions[i]);
+      spacing[i] = this->m_Spacing[i];
+      origin[i] = this->m_Origin[i];
+    }
+    typename ImageType::Pointer image = ImageType::New();
+    image->SetRegions(region);
+    image->SetSpacing(spacing);
+    image->SetOrigin(origin);
+    image->Allocate();
+    this->Read(image->GetBufferPointer());
+    return image;
+  }
+
+protected:
+  ScancoCompositeReader();
+  ~ScancoCompositeReader() override = default;
+
+  void
+  PrintSelf(std::ostream & os, Indent indent) const override;
+
+private:
+  /** Read the headers if they have not been read since the file names
+   * were set. */
+  void
+  UpdateInformation();
+
+  FileNamesContainer         m_FileNames;
+  ThreadIdType               m_NumberOfWorkUnits;
+  std::vector<HeaderPointer> m_Headers;
+  std::vector<IndexType>     m_FileIndices;
+  IOComponentEnum            m_ComponentType{ IOComponentEnum::UNKNOWNCOMPONENTTYPE };
+  SizeValueType              m_Dimensions[3]{};
+  double                     m_Spacing[3]{};
+  double                     m_Origin[3]{};
+  SizeValueType              m_ComponentSize{ 0 };
+  SizeValueType              m_ImageSizeInBytes{ 0 };
+};
+} // end namespace itk
+
+#endif // itkScancoCompositeReader_h
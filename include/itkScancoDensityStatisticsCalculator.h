@@ -0,0 +1,160 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         https://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkScancoDensityStatisticsCalculator_h
+#define itkScancoDensityStatisticsCalculator_h
+#include "IOScancoExport.h"
+
+#include <map>
+#include <string>
+#include <vector>
+#include "itkObject.h"
+#include "itkScancoImageIO.h"
+
+namespace itk
+{
+/** \class ScancoDensityStatisticsCalculator
+ *
+ * \brief Density statistics of a gray scale Scanco file within the labels
+ * of a mask AIM file.
+ *
+ * The gray file, typically an ISQ, and the mask, typically a segmentation
+ * AIM of the same scan, are read together in slabs of slices, so that
+ * neither is ever held in full. The gray values are converted with the
+ * density calibration of the gray file, DensitySlope / MuScaling and
+ * DensityIntercept, e.g. to mg HA/ccm. For each value of the mask the
+ * count, mean, variance, minimum, maximum and a histogram of the density
+ * are computed. Slabs are processed in parallel.
+ *
+ * The mask is placed in the grid of the gray file at its origin, as AIM
+ * files cropped from a scan store their position. Gray voxels outside of
+ * the mask have the label 0. Both files must have the same spacing.
+ *
+ * \ingroup IOScanco
+ */
+class IOScanco_EXPORT ScancoDensityStatisticsCalculator : public Object
+{
+public:
+  ITK_DISALLOW_COPY_AND_MOVE(ScancoDensityStatisticsCalculator);
+
+  /** Standard class typedefs. */
+  using Self = ScancoDensityStatisticsCalculator;
+  using Superclass = Object;
+  using Pointer = SmartPointer<Self>;
+  using ConstPointer = SmartPointer<const Self>;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(ScancoDensityStatisticsCalculator, Object);
+
+  /** \brief Statistics of the voxels with one label. */
+  struct LabelStatistics
+  {
+    SizeValueType              Count{ 0 };
+    double                     Mean{ 0.0 };
+    double                     Variance{ 0.0 };
+    double                     Minimum{ 0.0 };
+    double                     Maximum{ 0.0 };
+    std::vector<SizeValueType> Histogram;
+  };
+
+  using StatisticsContainer = std::map<int, LabelStatistics>;
+
+  /** The gray scale file, which must hold uncompressed short data. */
+  itkSetStringMacro(FileName);
+  itkGetStringMacro(FileName);
+
+  /** The mask, an 8-bit file whose values are the labels. */
+  itkSetStringMacro(MaskFileName);
+  itkGetStringMacro(MaskFileName);
+
+  /** Convert gray values with the density calibration of the file. When
+   * off, statistics are of the stored values. Default is on. */
+  itkSetMacro(UseCalibration, bool);
+  itkGetConstMacro(UseCalibration, bool);
+  itkBooleanMacro(UseCalibration);
+
+  /** The histograms have NumberOfHistogramBins bins of equal width between
+   * HistogramMinimum and HistogramMaximum, in calibrated units. Values
+   * outside of this range are counted in the first and last bins. */
+  itkSetMacro(NumberOfHistogramBins, SizeValueType);
+  itkGetConstMacro(NumberOfHistogramBins, SizeValueType);
+  itkSetMacro(HistogramMinimum, double);
+  itkGetConstMacro(HistogramMinimum, double);
+  itkSetMacro(HistogramMaximum, double);
+  itkGetConstMacro(HistogramMaximum, double);
+
+  /** Number of slices that a work unit reads at once. Default is 16. */
+  itkSetMacro(NumberOfSlicesPerSlab, SizeValueType);
+  itkGetConstMacro(NumberOfSlicesPerSlab, SizeValueType);
+
+  /** Number of work units used to process slabs. Defaults to the global
+   * default number of threads. */
+  itkSetMacro(NumberOfWorkUnits, ThreadIdType);
+  itkGetConstMacro(NumberOfWorkUnits, ThreadIdType);
+
+  /** The slope and intercept that converted the gray values in the last
+   * Compute(). */
+  itkGetConstMacro(DensitySlope, double);
+  itkGetConstMacro(DensityIntercept, double);
+
+  /** Read both files and compute the statistics. */
+  void
+  Compute();
+
+  /** The statistics of each label found by Compute(). */
+  const StatisticsContainer &
+  GetStatistics() const
+  {
+    return this->m_Statistics;
+  }
+
+  bool
+  HasLabel(int label) const
+  {
+    return this->m_Statistics.find(label) != this->m_Statistics.end();
+  }
+
+  /** The statistics of one label. Throws if the label was not found. */
+  const LabelStatistics &
+  GetStatistics(int label) const;
+
+protected:
+  ScancoDensityStatisticsCalculator();
+  ~ScancoDensityStatisticsCalculator() override = default;
+
+  void
+  PrintSelf(std::ostream & os, Indent indent) const override;
+
+private:
+  std::string         m_FileName;
+  std::string         m_MaskFileName;
+  bool                m_UseCalibration{ true };
+  SizeValueType       m_NumberOfHistogramBins{ 256 };
+  double              m_HistogramMinimum{ -1000.0 };
+  double              m_HistogramMaximum{ 3000.0 };
+  SizeValueType       m_NumberOfSlicesPerSlab{ 16 };
+  ThreadIdType        m_NumberOfWorkUnits;
+  double              m_DensitySlope{ 1.0 };
+  double              m_DensityIntercept{ 0.0 };
+  StatisticsContainer m_Statistics;
+};
+} // end namespace itk
+
+#endif // itkScancoDensityStatisticsCalculator_h
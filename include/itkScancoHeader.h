@@ -0,0 +1,103 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         https://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkScancoHeader_h
+#define itkScancoHeader_h
+#include "IOScancoExport.h"
+
+#include "itkImageIOBase.h"
+
+namespace itk
+{
+/** \class ScancoHeader
+ *
+ * \brief Parsed header of a Scanco ISQ, RAD or AIM file.
+ *
+ * This is a plain value that holds everything ScancoImageIO needs to know
+ * about a file in order to read its data: the acquisition metadata, the
+ * image geometry and the location and encoding of the voxel data. Once
+ * parsed it is never modified, so a single instance can be shared between
+ * threads and between ScancoImageIO objects that read the same file.
+ *
+ * Units follow the conventions of ScancoImageIO: distances in millimeters,
+ * times in milliseconds, voltage and current in kV and mA.
+ *
+ * ScancoHeaderCache stores the members by name, so a new member must also be
+ * added to its field list.
+ *
+ * \ingroup IOScanco
+ */
+struct ScancoHeader
+{
+  /** 0 if unrecognized, 1 if ISQ/RAD, 2 if AIM 020, 3 if AIM 030. */
+  int FileType{ 0 };
+
+  // Header information
+  char   Version[18]{};
+  char   PatientName[42]{};
+  int    PatientIndex{ 0 };
+  int    ScannerID{ 0 };
+  char   CreationDate[32]{};
+  char   ModificationDate[32]{};
+  int    ScanDimensionsPixels[3]{};
+  double ScanDimensionsPhysical[3]{};
+  double SliceThickness{ 0.0 };
+  double SliceIncrement{ 0.0 };
+  double StartPosition{ 0.0 };
+  double EndPosition{ 0.0 };
+  double ZPosition{ 0.0 };
+  double DataRange[2]{};
+  double MuScaling{ 1.0 };
+  int    NumberOfSamples{ 0 };
+  int    NumberOfProjections{ 0 };
+  double ScanDistance{ 0.0 };
+  double SampleTime{ 0.0 };
+  int    ScannerType{ 0 };
+  int    MeasurementIndex{ 0 };
+  int    Site{ 0 };
+  int    ReconstructionAlg{ 0 };
+  double ReferenceLine{ 0.0 };
+  double Energy{ 0.0 };
+  double Intensity{ 0.0 };
+  int    RescaleType{ 0 };
+  char   RescaleUnits[18]{};
+  char   CalibrationData[66]{};
+  double RescaleSlope{ 1.0 };
+  double RescaleIntercept{ 0.0 };
+  double MuWater{ 0.70329999923706055 };
+
+  // Density calibration as stored in the file, in RescaleUnits per unit of
+  // linear attenuation. RescaleSlope and RescaleIntercept are derived from it.
+  double DensitySlope{ 1.0 };
+  double DensityIntercept{ 0.0 };
+
+  // Image geometry
+  SizeValueType   Dimensions[3]{};
+  double          Spacing[3]{ 1.0, 1.0, 1.0 };
+  double          Origin[3]{};
+  IOComponentEnum ComponentType{ IOComponentEnum::UNKNOWNCOMPONENTTYPE };
+  IOPixelEnum     PixelType{ IOPixelEnum::SCALAR };
+
+  // The compression mode, if any.
+  int Compression{ 0 };
+
+  // Offset of the voxel data from the start of the file.
+  SizeValueType HeaderSize{ 0 };
+};
+} // end namespace itk
+
+#endif // itkScancoHeader_h
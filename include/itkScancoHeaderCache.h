@@ -0,0 +1,135 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         https://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkScancoHeaderCache_h
+#define itkScancoHeaderCache_h
+#include "IOScancoExport.h"
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "itkScancoHeader.h"
+
+namespace itk
+{
+/** \class ScancoHeaderCache
+ *
+ * \brief Process-wide, bounded cache of parsed Scanco headers.
+ *
+ * Headers are keyed by the canonical path of the file together with its
+ * size and modification time, so an entry is only used while the file is
+ * unchanged. Looking up a file costs a stat of the file, but the file itself
+ * is not opened. When the cache is full, the least recently used entry is
+ * dropped.
+ *
+ * The modification time has a resolution of one second, so a file that is
+ * rewritten with the same size within the same second as the cached version
+ * is not detected as changed.
+ *
+ * The cache can be saved to and loaded from a binary file, so that the
+ * headers parsed in one run are available in the next. The file is specific
+ * to the build of the library that wrote it, and files from other builds
+ * are rejected.
+ *
+ * All methods are thread-safe. ScancoImageIO uses the cache when its
+ * UseHeaderCache option is on.
+ *
+ * \ingroup IOScanco
+ */
+class IOScanco_EXPORT ScancoHeaderCache
+{
+public:
+  using HeaderPointer = std::shared_ptr<const ScancoHeader>;
+
+  /** The process-wide instance. */
+  static ScancoHeaderCache &
+  GetInstance();
+
+  ScancoHeaderCache() = default;
+  ScancoHeaderCache(const ScancoHeaderCache &) = delete;
+  ScancoHeaderCache &
+  operator=(const ScancoHeaderCache &) = delete;
+
+  /** Get the cached header of a file. Returns nullptr if the file is not in
+   * the cache or has changed since its header was added. */
+  HeaderPointer
+  GetHeader(const std::string & fileName);
+
+  /** Add the header of a file, replacing any previous entry. */
+  void
+  AddHeader(const std::string & fileName, const HeaderPointer & header);
+
+  /** Get the cached header of a file, or parse it with
+   * ScancoImageIO::ReadHeader() and add it to the cache. Parsing is done
+   * without holding the lock. */
+  HeaderPointer
+  ReadHeader(const std::string & fileName);
+
+  /** Maximum number of headers held. Default is 1024. */
+  void
+  SetMaximumNumberOfEntries(SizeValueType maximumNumberOfEntries);
+  SizeValueType
+  GetMaximumNumberOfEntries() const;
+
+  SizeValueType
+  GetNumberOfEntries() const;
+
+  void
+  Clear();
+
+  /** Write all entries to a file, most recently used first. The entries are
+   * written to a temporary file that then replaces the file, so that a
+   * concurrent Load() sees either the old or the new cache. */
+  void
+  Save(const std::string & fileName) const;
+
+  /** Add the entries of a file written by Save(). Entries of files that have
+   * changed since are kept, but are never returned. */
+  void
+  Load(const std::string & fileName);
+
+private:
+  struct Entry
+  {
+    SizeValueType                    Size;
+    long                             ModifiedTime;
+    HeaderPointer                    Header;
+    std::list<std::string>::iterator Position;
+  };
+
+  /** Canonical path, size and modification time of a file. Returns false
+   * if the file does not exist. */
+  static bool
+  GetFileKey(const std::string & fileName, std::string & path, SizeValueType & size, long & modifiedTime);
+
+  void
+  AddEntry(const std::string & path, SizeValueType size, long modifiedTime, const HeaderPointer & header);
+
+  void
+  Prune();
+
+  mutable std::mutex                     m_Mutex;
+  std::unordered_map<std::string, Entry> m_Entries;
+  /** Paths of the entries, most recently used first. */
+  std::list<std::string> m_Order;
+  SizeValueType          m_MaximumNumberOfEntries{ 1024 };
+};
+} // end namespace itk
+
+#endif // itkScancoHeaderCache_h
@@ -52,8 +52,18 @@
 #include "IOScancoExport.h"
 
 
+#include <cstdint>
+#include <exception>
 #include <fstream>
+#include <functional>
+#include <future>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
 #include "itkImageIOBase.h"
+#include "itkScancoBitMask.h"
+#include "itkScancoHeader.h"
 
 namespace itk
 {
@@ -83,6 +93,9 @@ public:
   /** Run-time type information (and related methods). */
   itkTypeMacro(ScancoImageIO, ImageIOBase);
 
+  /** Immutable, shareable parsed file header. */
+  using HeaderPointer = std::shared_ptr<const ScancoHeader>;
+
   /** The different types of ImageIO's can support data of varying
    * dimensionality. For example, some file formats are strictly 2D
    * while others can support 2D, 3D, or even n-D. This method returns
@@ -113,6 +126,204 @@ public:
   void
   Read(void * buffer) override;
 
+  /** Reads the given region of the image into the memory buffer provided,
+   * which must be large enough to hold the region.
+   *
+   * This only uses the parsed header and the file name, so it can be called
+   * concurrently from several threads once ReadImageInformation() or
+   * SetHeader() has been called. Each call opens its own file stream. */
+  void
+  ReadRegion(const ImageIORegion & region, void * buffer) const;
+
+  /** Read the plane orthogonal to an axis: axis 0 gives the yz plane at
+   * x = index, axis 1 the xz plane at y = index and axis 2 the xy plane at
+   * z = index. The buffer must hold the plane, which is stored with z
+   * varying slowest.
+   *
+   * For uncompressed files only the data that intersects the plane is read:
+   * one row per slice for an xz plane, and one pixel per row for a yz plane,
+   * where the pixels of rows less than 64 KiB apart are read together. The
+   * slices are split over the work units of a MultiThreaderBase. Compressed
+   * files are decoded in full. Like
+   * ReadRegion(), this can be called concurrently from several threads. */
+  void
+  ReadOrthogonalSlice(unsigned int axis, SizeValueType index, void * buffer) const;
+
+  /** Read the whole image into a part of a larger buffer. Consecutive rows
+   * of the image are rowStride pixels apart in the buffer, and consecutive
+   * slices sliceStride pixels apart, so that a file can be decoded straight
+   * into its place in a composite volume.
+   *
+   * Uncompressed data is read one slice at a time and compressed data is
+   * decoded row by row into the buffer. Like ReadRegion(), this can be
+   * called concurrently from several threads. */
+  void
+  ReadStrided(void * buffer, SizeValueType rowStride, SizeValueType sliceStride) const;
+
+  /** Called by ReadRuns() for each run of voxels along x that have the same
+   * value, which is not zero, at index (x, y, z). */
+  using RunFunction =
+    std::function<void(SizeValueType x, SizeValueType y, SizeValueType z, SizeValueType length, int value)>;
+
+  /** Read the runs of non-zero voxels of an 8-bit image, such as a binary
+   * or label AIM file, without decoding it into a volume. Runs are reported
+   * in file order, one row at a time, and never cross the end of a row.
+   * Values are the stored values, without rescaling.
+   *
+   * Run-length compressed data is walked run by run. Packed bits and
+   * uncompressed data are decoded one row or one slice at a time, so memory
+   * use does not grow with the size of the image. Like ReadRegion(), this
+   * can be called concurrently from several threads. */
+  void
+  ReadRuns(const RunFunction & runFunction) const;
+
+  /** Read the whole image into a new bit mask, with one bit per voxel. With
+   * ThresholdOnRead, the voxels within the thresholds are set, otherwise
+   * the non-zero voxels of an 8-bit image, such as a binary AIM file.
+   *
+   * 8-bit images are read run by run through ReadRuns(). Wider images are
+   * thresholded in slabs of slices, so neither the image nor an unsigned
+   * char mask of it is ever held in full. Like ReadRegion(), this can be
+   * called concurrently from several threads. */
+  ScancoBitMask::Pointer
+  ReadBitMask() const;
+
+  /** \brief Summary of a Scanco file, as returned by Probe(). */
+  struct ProbeInformation
+  {
+    /** 0 if unrecognized, 1 if ISQ/RAD, 2 if AIM 020, 3 if AIM 030. */
+    int             FileType{ 0 };
+    char            Version[18]{};
+    SizeValueType   Dimensions[3]{};
+    IOComponentEnum ComponentType{ IOComponentEnum::UNKNOWNCOMPONENTTYPE };
+    IOPixelEnum     PixelType{ IOPixelEnum::SCALAR };
+    int             Compression{ 0 };
+    /** Offset of the voxel data from the start of the file. */
+    SizeValueType DataOffset{ 0 };
+    /** Size that the file needs to have to hold all of the data. */
+    SizeValueType ExpectedFileSize{ 0 };
+    SizeValueType ActualFileSize{ 0 };
+
+    bool
+    IsTruncated() const
+    {
+      return this->ActualFileSize < this->ExpectedFileSize;
+    }
+  };
+
+  /** Quickly identify a file from its first 512 bytes, without decoding the
+   * rest of the header. For run-length compressed AIM files, the size of the
+   * compressed data is read as well. Files that cannot be opened or are not
+   * recognized give a FileType of 0; no exception is thrown. */
+  static ProbeInformation
+  Probe(const std::string & fileName);
+
+  /** Parse the header of a Scanco file. This does not touch any ImageIO
+   * state and is safe to call concurrently. */
+  static HeaderPointer
+  ReadHeader(const std::string & fileName);
+
+  /** \brief Header fields for PatchHeader() to replace.
+   *
+   * Only the fields whose flag is set are replaced. The date is given in the
+   * format of GetCreationDate(), e.g. "1-JAN-2000 00:00:00.000", where the
+   * time may be left out. */
+  struct HeaderPatch
+  {
+    bool        ReplacePatientName{ false };
+    std::string PatientName;
+    bool        ReplacePatientIndex{ false };
+    int         PatientIndex{ 0 };
+    bool        ReplaceDate{ false };
+    std::string Date;
+
+    /** Clear the patient name and index, and set the date to 1-JAN-2000. */
+    void
+    Anonymize()
+    {
+      this->ReplacePatientName = true;
+      this->PatientName.clear();
+      this->ReplacePatientIndex = true;
+      this->PatientIndex = 0;
+      this->ReplaceDate = true;
+      this->Date = "1-JAN-2000 00:00:00.000";
+    }
+  };
+
+  /** Replace fields of the header of a file without rewriting its data.
+   *
+   * The first header block of ISQ and RAD files is rewritten in place. In
+   * AIM files the fields are replaced in the processing log, where only the
+   * keys that the log has are replaced, and the date replaces both the
+   * creation and the modification date. A log that fits in the space of the
+   * old one is written in place. Otherwise the header is rebuilt in a
+   * temporary file, the voxel data is copied behind it untouched, and the
+   * temporary file replaces the file, so that the file is never left half
+   * written. */
+  static void
+  PatchHeader(const std::string & fileName, const HeaderPatch & patch);
+
+  /** A range of slices of a file, for CopySlices(). A NumberOfSlices of 0
+   * selects all slices from FirstSlice on. */
+  struct SliceRange
+  {
+    std::string   FileName;
+    SizeValueType FirstSlice{ 0 };
+    SizeValueType NumberOfSlices{ 0 };
+  };
+
+  /** Write an ISQ file that holds the given ranges of slices of ISQ files,
+   * one after the other, without decoding the data.
+   *
+   * All files must have the same number of columns and rows, the same
+   * spacing and the same calibration. The header of the first file is used,
+   * with its number of slices, start position and data range updated; the
+   * data range is the union of the data ranges of the files. The slices are
+   * copied with CopyFrom() of ScancoRawFile, within the kernel where
+   * possible. The output is written to a temporary file that then replaces
+   * it, so the output may be one of the inputs. */
+  static void
+  CopySlices(const std::vector<SliceRange> & ranges, const std::string & outputFileName);
+
+  /** Set the data range in the first header block of an ISQ or RAD file,
+   * e.g. after its data has been written in place. */
+  static void
+  EncodeDataRange(const double dataRange[2], char * block);
+
+  /** Read the compressed data of the file described by the header into
+   * inputBuffer. Returns its size. */
+  static SizeValueType
+  ReadCompressedData(std::istream & file, const ScancoHeader & header, std::vector<char> & inputBuffer);
+
+  /** Decode row y of slice z of packed-bit data into row, with one byte
+   * per voxel. */
+  static void
+  DecodePackedRow(const char *         input,
+                  SizeValueType        size,
+                  const ScancoHeader & header,
+                  SizeValueType        y,
+                  SizeValueType        z,
+                  unsigned char *      row);
+
+  /** Get the header parsed by the last call to ReadImageInformation(), or
+   * set with SetHeader(). This is nullptr after ReadImageInformation()
+   * fails. */
+  const HeaderPointer &
+  GetHeader() const
+  {
+    return this->m_Header;
+  }
+
+  /** Use an already parsed header for the current file name instead of
+   * parsing it again. This updates the image information and the metadata
+   * dictionary exactly as ReadImageInformation() would. */
+  void
+  SetHeader(const HeaderPointer & header);
+
+  /** Offset of the voxel data from the start of the file, as set by the
+   * last header that was read or written. */
+  itkGetConstMacro(HeaderSize, SizeValueType);
+
   /*-------- This part of the interfaces deals with writing data. ----- */
 
   /** Determine the file type. Returns true if this ImageIO can write the
@@ -125,23 +336,193 @@ public:
   WriteImageInformation() override;
 
   /** Writes the data to disk from the memory buffer provided. Make sure
-   * that the IORegions has been set properly. */
+   * that the IORegions has been set properly.
+   *
+   * Scalar data of any integer or floating point type up to 32 bits, and
+   * double, is converted to the shorts of an ISQ file. When the data is in
+   * the calibrated units that reading applies, as given by MuScaling, MuWater
+   * and the density calibration, it is converted back and the calibration is
+   * written to an extended header, so that reading the file gives back the
+   * data. Values are rounded and clamped to the range of short. The data
+   * range of the header is computed from the written values. */
   void
   Write(const void * buffer) override;
 
+  /** Overwrite a region of an existing ISQ file in place, without touching
+   * the rest of the file. Write() does this when the IORegion is not the
+   * whole image, except that the first piece of a streamed write, which
+   * starts at index 0 and covers whole slices, creates the file anew. The
+   * dimensions, spacing and calibration of the file must match the image
+   * information, since the data is converted with the calibration of the
+   * file. The data range in the header is widened to include the written
+   * values; it does not shrink when the extreme values are overwritten. When
+   * the file does not exist yet, it is created like Write() would, and holds
+   * stored zeros outside of the region.
+   *
+   * The header is updated without locking, so regions of one file must not
+   * be written concurrently. */
+  void
+  WriteRegion(const ImageIORegion & region, const void * buffer);
+
+  /** Called when a write started by WriteAsync() has finished, with a null
+   * pointer on success or the exception that the write failed with. */
+  using WriteCallback = std::function<void(std::exception_ptr)>;
 
+  /** Write the data like Write(), but on a background thread. The header is
+   * encoded from the current image information before this returns, so the
+   * IO can be set up for another file at once. The buffer is copied; the
+   * overload that takes a shared pointer keeps the buffer alive until it has
+   * been written instead.
+   *
+   * The returned future becomes ready once the file has been written and the
+   * callback has returned, and rethrows any error from get(). Writes are
+   * done one at a time, in the order they were started. While the queued
+   * and running writes hold more than the maximum number of bytes in
+   * flight, this blocks until enough of them have finished. The callback is
+   * run on the background thread and must not start another write. */
+  std::shared_future<void>
+  WriteAsync(const void * buffer, WriteCallback callback = nullptr);
+  std::shared_future<void>
+  WriteAsync(std::shared_ptr<const void> buffer, WriteCallback callback = nullptr);
+
+  /** Process-wide limit on the bytes of data held by queued and running
+   * asynchronous writes. A single write that is larger than the limit is
+   * still started once nothing else is in flight. Default is 1 GiB. */
+  static void
+  SetMaximumAsyncWriteBytes(SizeValueType maximumBytes);
+  static SizeValueType
+  GetMaximumAsyncWriteBytes();
+
+  /** Block until all asynchronous writes have finished. Call this before
+   * the process exits. */
+  static void
+  WaitForAsyncWrites();
+
+
+  /** Uncompressed data can be read one region at a time. */
   bool
   CanStreamRead() override
   {
-    return false;
+    return this->m_Header != nullptr && this->m_Header->Compression == 0;
   }
 
+  /** ISQ files are uncompressed, so a region can be written into an
+   * existing file, see WriteRegion(). */
   bool
   CanStreamWrite() override
   {
-    return false;
+    return true;
   }
 
+  /** Service mode is intended for long-running processes that use one IO
+   * object for many files. The file opened by ReadImageInformation() stays
+   * open for the following Read(), and the raw header, the parsed header
+   * and the decompression buffers are kept and reused for the next file
+   * instead of being reallocated. A parsed header that is still held, e.g.
+   * from GetHeader(), is never reused. Turning service mode off releases
+   * them.
+   * Default is off. */
+  void
+  SetServiceMode(bool serviceMode);
+  itkGetConstMacro(ServiceMode, bool);
+  itkBooleanMacro(ServiceMode);
+
+  /** Look up and store parsed headers in the process-wide
+   * ScancoHeaderCache. Files that are unchanged since their header was
+   * cached are then not parsed again by ReadImageInformation(), and
+   * CanReadFile() does not open them. Default is off. */
+  itkSetMacro(UseHeaderCache, bool);
+  itkGetConstMacro(UseHeaderCache, bool);
+  itkBooleanMacro(UseHeaderCache);
+
+  /** Let ReadRegion(), and Read() outside of service mode, use the brick
+   * cache file written by ScancoBrickCache::Transcode() next to the file,
+   * when that cache exists and is up to date. Default is off. */
+  itkSetMacro(UseBrickCache, bool);
+  itkGetConstMacro(UseBrickCache, bool);
+  itkBooleanMacro(UseBrickCache);
+
+  /** Let Write() bypass the page cache with direct I/O, where the file
+   * system supports it. Default is off. */
+  itkSetMacro(UseDirectIO, bool);
+  itkGetConstMacro(UseDirectIO, bool);
+  itkBooleanMacro(UseDirectIO);
+
+  /** Let Write() start writing back each block as soon as it has been
+   * written, and wait for the block before it. This keeps dirty pages from
+   * piling up and stalling the system on large files. Only has an effect on
+   * Linux. Default is off. */
+  itkSetMacro(ThrottleWriteBack, bool);
+  itkGetConstMacro(ThrottleWriteBack, bool);
+  itkBooleanMacro(ThrottleWriteBack);
+
+  /** Let Read() apply a global threshold while decoding and produce a mask
+   * instead of the image, and let ReadImageInformation() report UCHAR pixels
+   * accordingly. Voxels whose density lies within [LowerThreshold,
+   * UpperThreshold] are set to ThresholdInsideValue, all others to zero. The
+   * density is the stored value calibrated by DensitySlope / MuScaling and
+   * DensityIntercept, e.g. in mg HA/ccm, except for run-length encoded
+   * segmentations, whose stored values are compared as they are.
+   * Uncompressed data is read in slabs of slices, so the image is never held
+   * in full. ReadRegion() and ReadOrthogonalSlice() are not affected. Default
+   * is off. */
+  void
+  SetThresholdOnRead(bool thresholdOnRead);
+  itkGetConstMacro(ThresholdOnRead, bool);
+  itkBooleanMacro(ThresholdOnRead);
+
+  /** The thresholds of ThresholdOnRead, inclusive. Default is the full range
+   * of double. */
+  itkSetMacro(LowerThreshold, double);
+  itkGetConstMacro(LowerThreshold, double);
+  itkSetMacro(UpperThreshold, double);
+  itkGetConstMacro(UpperThreshold, double);
+
+  /** The mask value of voxels within the thresholds. Default is 255. */
+  itkSetMacro(ThresholdInsideValue, unsigned char);
+  itkGetConstMacro(ThresholdInsideValue, unsigned char);
+
+  /** How a ScancoHeader field is stored in a file. */
+  enum class FieldEncoding : std::uint8_t
+  {
+    /** 32-bit integer in the file, int in ScancoHeader. */
+    Integer,
+    /** 32-bit integer or decimal text in the file, double in ScancoHeader. */
+    Real,
+    /** Like Real, but micrometers, microseconds etc. in the file and
+     * millimeters, milliseconds etc. in ScancoHeader. */
+    Micro,
+    /** Scanco double precision value in the file, double in ScancoHeader. */
+    Double,
+    /** Space padded characters in the file, null-terminated in ScancoHeader. */
+    Text
+  };
+
+  /** Location of a ScancoHeader field in a fixed-layout header block. The
+   * ISQ, RAD and calibration block layouts are tables of these, which drive
+   * both reading and writing. */
+  struct HeaderField
+  {
+    /** Byte offset in the block. */
+    unsigned int  Offset;
+    FieldEncoding Encoding;
+    /** Byte offset in ScancoHeader. */
+    size_t Member;
+    /** Number of characters, for Text. */
+    unsigned int Length;
+  };
+
+  /** A key of the AIM processing log and the ScancoHeader field it sets. */
+  struct AIMLogField
+  {
+    const char *  Key;
+    FieldEncoding Encoding;
+    /** Byte offset in ScancoHeader. */
+    size_t Member;
+    /** Maximum number of characters for Text, number of values otherwise. */
+    unsigned int Length;
+  };
+
   /** Get a string that states the version of the file header.
    * Max size: 16 characters. */
   const char *
@@ -223,6 +604,15 @@ public:
   itkGetConstMacro(RescaleIntercept, double);
   itkSetMacro(RescaleIntercept, double);
 
+  /** The density calibration of the file, per unit of linear attenuation.
+   * When MuScaling is not above 1, this is also the rescale slope and
+   * intercept. */
+  itkGetConstMacro(DensitySlope, double);
+  itkSetMacro(DensitySlope, double);
+
+  itkGetConstMacro(DensityIntercept, double);
+  itkSetMacro(DensityIntercept, double);
+
   itkGetConstMacro(NumberOfSamples, int);
   itkSetMacro(NumberOfSamples, int);
 
@@ -307,7 +697,7 @@ private:
    *  Return values are: 0 if unrecognized, 1 if ISQ/RAD,
    *  2 if AIM 020, 3 if AIM 030.
    */
-  int
+  static int
   CheckVersion(const char header[16]);
 
   /** Convert char data to 32-bit int (little-endian). */
@@ -316,6 +706,13 @@ private:
   /** Convert 32-bit int (little-endian) to char data. */
   static void
   EncodeInt(int data, void * target);
+  /** Convert char data to 64-bit int (little-endian). */
+  static std::int64_t
+  DecodeInt64(const void * data);
+  /** Convert an AIM header int, which is 64-bit in AIM v030 (intSize 8)
+   *  and 32-bit in AIM v020 (intSize 4). */
+  static std::int64_t
+  DecodeAIMInt(const void * data, SizeValueType intSize);
 
   /** Convert char data to float (single precision). */
   static float
@@ -324,9 +721,12 @@ private:
   /** Convert char data to float (double precision). */
   static double
   DecodeDouble(const void * data);
+  /** Convert float (double precision) to char data. */
+  static void
+  EncodeDouble(double data, void * target);
 
   //! Convert a VMS timestamp to a calendar date.
-  void
+  static void
   DecodeDate(const void * data,
              int &        year,
              int &        month,
@@ -336,8 +736,15 @@ private:
              int &        second,
              int &        millis);
   //! Convert the current calendar date to a VMS timestamp and store in target
-  void
+  static void
   EncodeDate(void * target);
+  //! Convert a calendar date to a VMS timestamp and store in target
+  static void
+  EncodeDate(void * target, int year, int month, int day, int hour, int minute, int second, int millis);
+
+  /** Check whether an ISQ header block is that of a RAD file. */
+  static bool
+  IsRADHeader(const char * block);
 
   //! Strip a string by removing trailing whitespace.
   /*!
@@ -351,11 +758,104 @@ private:
   void
   InitializeHeader();
 
-  int
-  ReadISQHeader(std::ifstream * file, unsigned long bytesRead);
+  /** Copy the fields of a parsed header into the members of this IO. */
+  void
+  CopyHeaderToMembers(const ScancoHeader & header);
+
+  /** Copy the members and the image information of this IO into a header. */
+  void
+  CopyMembersToHeader(ScancoHeader & header) const;
+
+  /** Decode the fields of a header block described by a field table. */
+  static void
+  DecodeHeaderFields(const char * block, const HeaderField * first, const HeaderField * last, ScancoHeader & header);
+
+  /** Encode the fields of a header block described by a field table. */
+  static void
+  EncodeHeaderFields(const ScancoHeader & header, const HeaderField * first, const HeaderField * last, char * block);
+
+  /** Look up a key of the AIM processing log. Returns nullptr for keys that
+   * are not used. */
+  static const AIMLogField *
+  FindAIMLogField(const char * key, size_t length);
 
-  int
-  ReadAIMHeader(std::ifstream * file, unsigned long bytesRead);
+  /** Set the header field of an AIM processing log entry from its value. */
+  static void
+  DecodeAIMLogValue(const AIMLogField & field, const char * value, size_t length, ScancoHeader & header);
+
+  /** Encode the ISQ header, which is HeaderSize bytes long. Headers of more
+   * than 512 bytes hold an extended header with the calibration. */
+  static void
+  EncodeISQHeader(const ScancoHeader & header, char * block);
+
+  /** Encode the size of the data in the first ISQ header block. */
+  static void
+  EncodeISQDataSize(SizeValueType numberOfBytes, char * block);
+
+  /** Parse the header from the start of the stream. rawHeader is used as
+   * storage for the raw header bytes. Returns false if the file type is
+   * not recognized or the header is truncated or invalid. */
+  static bool
+  ReadHeader(std::istream & file, std::vector<char> & rawHeader, ScancoHeader & header);
+
+  static int
+  ReadISQHeader(std::istream * file, SizeValueType bytesRead, std::vector<char> & rawHeader, ScancoHeader & header);
+
+  static int
+  ReadAIMHeader(std::istream * file, SizeValueType bytesRead, std::vector<char> & rawHeader, ScancoHeader & header);
+
+  /** Set the component type, pixel type and compression of the header from
+   * the AIM data type code. Returns false for unknown codes. */
+  static bool
+  DecodeAIMDataType(int dataType, ScancoHeader & header);
+
+  /** Size in bytes of one pixel of the data described by the header. */
+  static SizeValueType
+  GetHeaderComponentSize(const ScancoHeader & header);
+
+  /** Decode the whole compressed volume described by the header into the
+   * buffer. inputBuffer holds the compressed data. */
+  static void
+  DecodeCompressedData(std::istream &       file,
+                       const ScancoHeader & header,
+                       void *               buffer,
+                       std::vector<char> &  inputBuffer);
+
+  /** Read a region from the stream, using inputBuffer and volumeBuffer as
+   * scratch space for compressed data. */
+  static void
+  ReadRegionFromStream(std::istream &        file,
+                       const ScancoHeader &  header,
+                       const ImageIORegion & region,
+                       void *                buffer,
+                       std::vector<char> &   inputBuffer,
+                       std::vector<char> &   volumeBuffer);
+
+  /** Like ReadRegionFromStream(), but without converting the data to the
+   * calibrated units of the header. */
+  static void
+  ReadRawRegionFromStream(std::istream &        file,
+                          const ScancoHeader &  header,
+                          const ImageIORegion & region,
+                          void *                buffer,
+                          std::vector<char> &   inputBuffer,
+                          std::vector<char> &   volumeBuffer);
+
+  /** Read a region from the stream and threshold it into the mask, with
+   * insideValue within the thresholds, see SetThresholdOnRead(). */
+  void
+  ReadMaskFromStream(std::istream &        file,
+                     const ScancoHeader &  header,
+                     const ImageIORegion & region,
+                     unsigned char *       mask,
+                     unsigned char         insideValue,
+                     std::vector<char> &   inputBuffer,
+                     std::vector<char> &   volumeBuffer) const;
+
+  /** Convert the data read from a file to the calibrated units given by the
+   * rescale slope and intercept of the header. */
+  static void
+  RescaleBuffer(const ScancoHeader & header, void * buffer, SizeValueType bufferSize);
 
   void
   PopulateMetaDataDictionary();
@@ -363,9 +863,47 @@ private:
   void
   SetHeaderFromMetaDataDictionary();
 
+  /** Set the rescale slope and intercept that the data is converted with on
+   * reading from the density calibration, MuScaling and MuWater. */
+  static void
+  ComputeRescale(ScancoHeader & header);
+
+  /** Fill in the ISQ header for the current image information. With
+   * calibration, the header keeps MuScaling and the density calibration, and
+   * its rescale slope and intercept are the ones that the data has to be
+   * converted back with. Without, the data is stored as it is. */
+  void
+  PrepareISQHeader(ScancoHeader & header, bool withCalibration);
+
+  /** Check that the image information can be written by Write() and fill
+   * in the header for it. */
+  void
+  PrepareISQWrite(ScancoHeader & header);
+
   void
   WriteISQHeader(std::ofstream * file);
 
+  /** Implement WriteRegion(). With replaceFile, the file is created anew
+   * even when it exists. */
+  void
+  WriteRegionToFile(const ImageIORegion & region, const void * buffer, bool replaceFile);
+
+  /** Write the header followed by the data converted to ISQ values, as done
+   * by Write(). The data range of the header is set from the written values.
+   * This uses no state of the IO. */
+  static void
+  WriteISQFile(const std::string & fileName,
+               ScancoHeader &      header,
+               const void *        buffer,
+               IOComponentEnum     componentType,
+               bool                useDirectIO,
+               bool                throttleWriteBack);
+
+  /** Queue the write of the buffer to the file name of this IO on the
+   * background thread. When owner is null, the buffer is copied. */
+  std::shared_future<void>
+  StartAsyncWrite(const void * buffer, std::shared_ptr<const void> owner, WriteCallback callback);
+
   // Header information
   char   m_Version[18];
   char   m_PatientName[42];
@@ -399,7 +937,9 @@ private:
   double m_RescaleSlope;
   double m_RescaleIntercept;
   double m_MuWater;
-  char * m_RawHeader;
+  double m_DensitySlope;
+  double m_DensityIntercept;
+  std::vector<char> m_RawHeader;
 
   // The compression mode, if any.
   int m_Compression;
@@ -407,6 +947,25 @@ private:
   bool m_HeaderInitialized = false;
 
   SizeValueType m_HeaderSize{ 0 };
+
+  // The header that the data is read with
+  HeaderPointer m_Header;
+  bool          m_UseHeaderCache{ false };
+  bool          m_UseBrickCache{ false };
+  bool          m_UseDirectIO{ false };
+  bool          m_ThrottleWriteBack{ false };
+
+  bool          m_ThresholdOnRead{ false };
+  double        m_LowerThreshold{ std::numeric_limits<double>::lowest() };
+  double        m_UpperThreshold{ std::numeric_limits<double>::max() };
+  unsigned char m_ThresholdInsideValue{ 255 };
+
+  // Resources that are reused between files in service mode
+  bool                          m_ServiceMode{ false };
+  std::ifstream                 m_ServiceFile;
+  std::shared_ptr<ScancoHeader> m_ServiceHeader;
+  std::vector<char>             m_InputBuffer;
+  std::vector<char>             m_VolumeBuffer;
 };
 } // end namespace itk
 
@@ -0,0 +1,140 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         https://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkScancoLabelMapReader_h
+#define itkScancoLabelMapReader_h
+#include "IOScancoExport.h"
+
+#include <string>
+#include "itkObject.h"
+#include "itkScancoImageIO.h"
+
+namespace itk
+{
+/** \class ScancoLabelMapReader
+ *
+ * \brief Read a binary or label AIM file into a LabelMap.
+ *
+ * Segmentations are stored as 8-bit AIM files, often run-length compressed
+ * or as packed bits, and are mostly background. Reading them with
+ * ScancoImageIO expands them into a dense volume. This reader instead
+ * passes the runs of non-zero voxels from ScancoImageIO::ReadRuns()
+ * straight to the lines of a LabelMap, so that memory follows the surface
+ * of the objects rather than the size of the image.
+ *
+ * Each non-zero value of the file becomes a label object, and zero is the
+ * background.
+ *
+ * \ingroup IOScanco
+ */
+class IOScanco_EXPORT ScancoLabelMapReader : public Object
+{
+public:
+  ITK_DISALLOW_COPY_AND_MOVE(ScancoLabelMapReader);
+
+  /** Standard class typedefs. */
+  using Self = ScancoLabelMapReader;
+  using Superclass = Object;
+  using Pointer = SmartPointer<Self>;
+  using ConstPointer = SmartPointer<const Self>;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(ScancoLabelMapReader, Object);
+
+  using HeaderPointer = ScancoImageIO::HeaderPointer;
+  using RunFunction = ScancoImageIO::RunFunction;
+
+  /** The file to read. */
+  void
+  SetFileName(const std::string & fileName);
+  itkGetStringMacro(FileName);
+
+  /** Parse the header of the file. ReadRuns() and ReadLabelMap() do this
+   * when the file name has changed. */
+  void
+  ReadInformation();
+
+  /** The header of the file, or nullptr if it has not been read. */
+  HeaderPointer
+  GetHeader() const
+  {
+    return this->m_Header;
+  }
+
+  /** Pass the runs of non-zero voxels of the file to runFunction, see
+   * ScancoImageIO::ReadRuns(). */
+  void
+  ReadRuns(const RunFunction & runFunction);
+
+  /** Read the file into a new label map. TLabelMap is a three-dimensional
+   * LabelMap, such as LabelMap<LabelObject<unsigned char, 3>>. Values are
+   * cast to its label type. */
+  template <typename TLabelMap>
+  typename TLabelMap::Pointer
+  ReadLabelMap()
+  {
+    static_assert(TLabelMap::ImageDimension == 3, "The label map must be three-dimensional.");
+    using LabelType = typename TLabelMap::LabelType;
+    this->UpdateInformation();
+
+    typename TLabelMap::RegionType  region;
+    typename TLabelMap::SpacingType spacing;
+    typename TLabelMap::PointType   origin;
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+      region.SetSize(i, this->m_Header->Dimensions[i]);
+      spacing[i] = this->m_Header->Spacing[i];
+      origin[i] = this->m_Header->Origin[i];
+    }
+    typename TLabelMap::Pointer labelMap = TLabelMap::New();
+    labelMap->SetRegions(region);
+    labelMap->SetSpacing(spacing);
+    labelMap->SetOrigin(origin);
+    labelMap->Allocate();
+    labelMap->SetBackgroundValue(LabelType{});
+
+    this->ReadRuns([&labelMap](SizeValueType x, SizeValueType y, SizeValueType z, SizeValueType length, int value) {
+      typename TLabelMap::IndexType index;
+      index[0] = static_cast<IndexValueType>(x);
+      index[1] = static_cast<IndexValueType>(y);
+      index[2] = static_cast<IndexValueType>(z);
+      labelMap->SetLine(index, length, static_cast<LabelType>(value));
+    });
+    return labelMap;
+  }
+
+protected:
+  ScancoLabelMapReader() = default;
+  ~ScancoLabelMapReader() override = default;
+
+  void
+  PrintSelf(std::ostream & os, Indent indent) const override;
+
+private:
+  /** Read the header if it has not been read since the file name was set. */
+  void
+  UpdateInformation();
+
+  std::string   m_FileName;
+  HeaderPointer m_Header;
+};
+} // end namespace itk
+
+#endif // itkScancoLabelMapReader_h
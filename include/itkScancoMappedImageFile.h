@@ -0,0 +1,151 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         https://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkScancoMappedImageFile_h
+#define itkScancoMappedImageFile_h
+#include "IOScancoExport.h"
+
+#include <cstdint>
+#include <string>
+#include "itkImage.h"
+#include "itkImportImageContainer.h"
+#include "itkObject.h"
+
+namespace itk
+{
+/** \class ScancoMappedImageFile
+ *
+ * \brief An ISQ file whose voxel data is the buffer of an image.
+ *
+ * Create() writes the ISQ header with ScancoImageIO, sets the file to its
+ * final size and maps the data into memory. The image returned by
+ * GetImage() uses the mapped data as its pixel container, so whatever is
+ * written into the image is written into the file, without a second copy
+ * of the volume in memory. A filter can produce its output directly into
+ * the file by grafting the image onto its output before updating. By
+ * default a filter releases the data of its outputs before it updates,
+ * which replaces the grafted pixel container with a new one, and an
+ * in-place filter reuses the buffer of its input, so both must be turned
+ * off:
+ *
+ * \code
+ * mappedFile->Create(inputImage);
+ * filter->InPlaceOff();
+ * filter->ReleaseDataBeforeUpdateFlagOff();
+ * filter->GraftOutput(mappedFile->GetImage());
+ * filter->Update();
+ * mappedFile->Close();
+ * \endcode
+ *
+ * The largest possible region of the filter output must be that of the
+ * reference image, or the filter allocates a buffer of its own.
+ *
+ * Flush() writes modified data back to the file. Close() sets the data
+ * range in the header to the minimum and maximum of the voxels, flushes,
+ * unmaps the file and detaches the pixel container from the image. The
+ * destructor calls Close(), but can only warn if it fails, so call Close()
+ * to have errors reported.
+ *
+ * The data is stored in the byte order of the machine, so mapping requires
+ * a little-endian system.
+ *
+ * \ingroup IOScanco
+ */
+class IOScanco_EXPORT ScancoMappedImageFile : public Object
+{
+public:
+  ITK_DISALLOW_COPY_AND_MOVE(ScancoMappedImageFile);
+
+  /** Standard class typedefs. */
+  using Self = ScancoMappedImageFile;
+  using Superclass = Object;
+  using Pointer = SmartPointer<Self>;
+  using ConstPointer = SmartPointer<const Self>;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(ScancoMappedImageFile, Object);
+
+  /** ISQ files hold short voxels. */
+  using PixelType = short;
+  using ImageType = Image<PixelType, 3>;
+  using PixelContainerType = ImportImageContainer<SizeValueType, PixelType>;
+
+  /** The ISQ file to create. */
+  itkSetStringMacro(FileName);
+  itkGetStringMacro(FileName);
+
+  /** Create the file, with the largest possible region, spacing and origin
+   * of the reference image. The metadata dictionary of the reference image
+   * is used for the header fields, as ScancoImageIO does when writing. The
+   * voxels are initialized to zero. */
+  void
+  Create(const ImageBase<3> * reference);
+
+  /** The image that is backed by the file, or nullptr if the file is not
+   * mapped. */
+  ImageType *
+  GetImage() const
+  {
+    return this->m_Image.GetPointer();
+  }
+
+  /** True between Create() and Close(). */
+  bool
+  IsMapped() const
+  {
+    return this->m_Mapping != nullptr;
+  }
+
+  /** Write modified data back to the file. */
+  void
+  Flush();
+
+  /** Update the data range in the header, flush and unmap the file. */
+  void
+  Close();
+
+protected:
+  ScancoMappedImageFile() = default;
+  ~ScancoMappedImageFile() override;
+
+  void
+  PrintSelf(std::ostream & os, Indent indent) const override;
+
+private:
+  /** Unmap and close the file, without flushing. */
+  void
+  Unmap();
+
+  std::string                 m_FileName;
+  ImageType::Pointer          m_Image;
+  PixelContainerType::Pointer m_PixelContainer;
+
+  char *        m_Mapping{ nullptr };
+  std::uint64_t m_MappingSize{ 0 };
+#ifdef _WIN32
+  void * m_FileHandle{ nullptr };
+  void * m_MappingHandle{ nullptr };
+#else
+  int m_FileDescriptor{ -1 };
+#endif
+};
+} // end namespace itk
+
+#endif // itkScancoMappedImageFile_h
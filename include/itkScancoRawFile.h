@@ -0,0 +1,125 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         https://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkScancoRawFile_h
+#define itkScancoRawFile_h
+#include "IOScancoExport.h"
+
+#include <cstdint>
+#include <string>
+#include "itkIntTypes.h"
+
+namespace itk
+{
+/** \class ScancoRawFile
+ *
+ * \brief Unbuffered file with positional reads and writes.
+ *
+ * This is a thin wrapper around a POSIX file descriptor or a Windows file
+ * handle. Reads and writes take an explicit offset and do not move a shared
+ * file position, so several threads can use the same file at once.
+ *
+ * With direct I/O the page cache is bypassed. Buffers, sizes and offsets
+ * must then be multiples of DirectIOAlignment. File systems that do not
+ * support direct I/O are opened normally, which IsDirectIO() reports.
+ *
+ * All errors throw an ExceptionObject.
+ *
+ * \ingroup IOScanco
+ */
+class IOScanco_EXPORT ScancoRawFile
+{
+public:
+  /** Alignment of buffers, sizes and offsets for direct I/O. */
+  static constexpr SizeValueType DirectIOAlignment = 4096;
+
+  ScancoRawFile() = default;
+  ~ScancoRawFile();
+  ScancoRawFile(const ScancoRawFile &) = delete;
+  ScancoRawFile &
+  operator=(const ScancoRawFile &) = delete;
+
+  /** Open a file for reading, or create or truncate it for writing. */
+  void
+  Open(const std::string & fileName, bool forWriting, bool directIO = false);
+
+  /** Open an existing file for reading and writing, without truncating it. */
+  void
+  OpenForUpdate(const std::string & fileName);
+
+  void
+  Close();
+
+  bool
+  IsOpen() const;
+
+  bool
+  IsDirectIO() const
+  {
+    return this->m_DirectIO;
+  }
+
+  /** Read exactly size bytes at offset. */
+  void
+  Read(void * buffer, std::uint64_t size, std::uint64_t offset) const;
+
+  /** Write size bytes at offset. */
+  void
+  Write(const void * buffer, std::uint64_t size, std::uint64_t offset) const;
+
+  /** Copy size bytes at sourceOffset of another file to offset of this one.
+   * Where the operating system supports it, the data is copied within the
+   * kernel, or shared between the files by file systems that can. */
+  void
+  CopyFrom(const ScancoRawFile & source, std::uint64_t sourceOffset, std::uint64_t size, std::uint64_t offset) const;
+
+  /** Get the size of the file. */
+  std::uint64_t
+  GetSize() const;
+
+  /** Set the size of the file, truncating or extending it. */
+  void
+  SetSize(std::uint64_t size) const;
+
+  /** Set the size of the file and reserve its blocks on disk, so that
+   * running out of space is reported here and the data is laid out
+   * contiguously. Where blocks cannot be reserved, only the size is set. */
+  void
+  Preallocate(std::uint64_t size) const;
+
+  /** Start writing back a range of the file without waiting. Does nothing
+   * where this is not supported. */
+  void
+  StartWriteBack(std::uint64_t offset, std::uint64_t size) const;
+
+  /** Wait for a range of the file to be written back, then drop it from the
+   * page cache. Does nothing where this is not supported. */
+  void
+  FinishWriteBack(std::uint64_t offset, std::uint64_t size) const;
+
+private:
+  std::string m_FileName;
+  bool        m_DirectIO{ false };
+#ifdef _WIN32
+  void * m_Handle{ nullptr };
+#else
+  int m_FileDescriptor{ -1 };
+#endif
+};
+} // end namespace itk
+
+#endif // itkScancoRawFile_h
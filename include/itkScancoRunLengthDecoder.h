@@ -0,0 +1,97 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         https://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkScancoRunLengthDecoder_h
+#define itkScancoRunLengthDecoder_h
+#include "IOScancoExport.h"
+
+#include "itkIntTypes.h"
+
+namespace itk
+{
+/** \class ScancoRunLengthDecoder
+ *
+ * \brief Resumable decoder for run-length compressed AIM data.
+ *
+ * Two encodings are supported: binary run-lengths (0x00b2), where the data
+ * starts with the two voxel values and is followed by run lengths that
+ * alternate between them, and 8-bit run-lengths (0x00c2), made of (length,
+ * value) pairs.
+ *
+ * All progress is kept in a State, so decoding can stop at any output
+ * position and continue later, possibly after more compressed data has
+ * become available. Saving the state at the start of every slice gives
+ * checkpoints from which any slice can be decoded without starting over.
+ *
+ * \ingroup IOScanco
+ */
+class IOScanco_EXPORT ScancoRunLengthDecoder
+{
+public:
+  /** Position of the decoder in the compressed and the decoded data. */
+  struct State
+  {
+    /** Offset of the next unread byte of compressed data. */
+    SizeValueType Position{ 0 };
+    /** Voxels of the current run that have not been produced yet. */
+    SizeValueType Remaining{ 0 };
+    unsigned char Value{ 0 };
+    /** Which of the two values the next binary run has. */
+    bool Flip{ false };
+  };
+
+  /** The compressed data, following the size word of the file. data can
+   * hold just the first size bytes of it. */
+  ScancoRunLengthDecoder(int compression, const char * data, SizeValueType size);
+
+  /** True for the compression codes that this class decodes. */
+  static bool
+  IsRunLength(int compression)
+  {
+    return compression == 0x00b2 || compression == 0x00c2;
+  }
+
+  /** The state at the start of the data. */
+  State
+  GetInitialState() const;
+
+  /** Produce up to count voxels from the state into output, or skip them if
+   * output is nullptr. Returns the number of voxels produced, which is less
+   * than count when the available compressed data runs out. */
+  SizeValueType
+  Decode(State & state, unsigned char * output, SizeValueType count) const;
+
+  /** Take up to count voxels of the current run from the state, without
+   * writing them, and set value to their value. Returns the number of
+   * voxels taken, which is 0 only when count is 0 or the available
+   * compressed data runs out. */
+  SizeValueType
+  DecodeRun(State & state, unsigned char & value, SizeValueType count) const;
+
+private:
+  /** Read the next run into the state. Returns false when the available
+   * compressed data runs out. */
+  bool
+  StartRun(State & state) const;
+
+  int                   m_Compression;
+  const unsigned char * m_Data;
+  SizeValueType         m_Size;
+};
+} // end namespace itk
+
+#endif // itkScancoRunLengthDecoder_h
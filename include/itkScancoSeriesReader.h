@@ -0,0 +1,175 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         https://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkScancoSeriesReader_h
+#define itkScancoSeriesReader_h
+#include "IOScancoExport.h"
+
+#include <string>
+#include <vector>
+#include "itkImage.h"
+#include "itkObject.h"
+#include "itkScancoImageIO.h"
+
+namespace itk
+{
+/** \class ScancoSeriesReader
+ *
+ * \brief Read a series of Scanco files into one 4D buffer.
+ *
+ * Longitudinal and time-lapse studies scan the same site several times.
+ * This reader takes the files of the timepoints in order, checks from
+ * their headers that they have the same dimensions, spacing and pixel
+ * type, and decodes them in parallel, each straight into its own slot of
+ * a single 4D buffer, instead of reading each one into an image of its own
+ * and joining them with JoinSeriesImageFilter.
+ *
+ * Read() fills a buffer that the caller provides. ReadImage() allocates a
+ * 4D image and reads into its buffer. The spacing and origin of the first
+ * three dimensions are those of the first file; the fourth dimension has
+ * the spacing TimeSpacing and origin 0.
+ *
+ * \ingroup IOScanco
+ */
+class IOScanco_EXPORT ScancoSeriesReader : public Object
+{
+public:
+  ITK_DISALLOW_COPY_AND_MOVE(ScancoSeriesReader);
+
+  /** Standard class typedefs. */
+  using Self = ScancoSeriesReader;
+  using Superclass = Object;
+  using Pointer = SmartPointer<Self>;
+  using ConstPointer = SmartPointer<const Self>;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(ScancoSeriesReader, Object);
+
+  using HeaderPointer = ScancoImageIO::HeaderPointer;
+  using FileNamesContainer = std::vector<std::string>;
+
+  /** The files of the timepoints, in order. */
+  void
+  SetFileNames(const FileNamesContainer & fileNames);
+  const FileNamesContainer &
+  GetFileNames() const
+  {
+    return this->m_FileNames;
+  }
+
+  void
+  AddFileName(const std::string & fileName);
+
+  /** Spacing of the fourth dimension. Default is 1. */
+  itkSetMacro(TimeSpacing, double);
+  itkGetConstMacro(TimeSpacing, double);
+
+  /** Number of work units used to parse headers and decode files. Defaults
+   * to the global default number of threads. */
+  itkSetMacro(NumberOfWorkUnits, ThreadIdType);
+  itkGetConstMacro(NumberOfWorkUnits, ThreadIdType);
+
+  /** Parse the headers of all files and check that they match. Read() does
+   * this when the file names have changed. */
+  void
+  ReadInformation();
+
+  /** The header of a timepoint, or nullptr if the headers have not been
+   * read. */
+  HeaderPointer
+  GetHeader(SizeValueType timepoint) const;
+
+  /** The pixel type that all of the files are read as. */
+  itkGetConstMacro(ComponentType, IOComponentEnum);
+
+  /** Size of the 4D image, where the last dimension is the number of files. */
+  SizeValueType
+  GetDimensions(unsigned int i) const
+  {
+    return this->m_Dimensions[i];
+  }
+
+  /** Size of one timepoint in the buffer that Read() fills. */
+  itkGetConstMacro(TimepointSizeInBytes, SizeValueType);
+
+  /** Read all timepoints into the buffer, which must hold the number of
+   * files times GetTimepointSizeInBytes() bytes. */
+  void
+  Read(void * buffer);
+
+  /** Read the series into a new 4D image. TPixel must match the component
+   * type that the files are read as, no conversion is done. */
+  template <typename TPixel>
+  typename Image<TPixel, 4>::Pointer
+  ReadImage()
+  {
+    using ImageType = Image<TPixel, 4>;
+    constexpr IOComponentEnum componentType = ImageIOBase::MapPixelType<TPixel>::CType;
+    this->UpdateInformation();
+    if (componentType != this->m_ComponentType)
+    {
+      itkExceptionMacro("The series is read as " << ImageIOBase::GetComponentTypeAsString(this->m_ComponentType)
+                                                 << ", not as "
+                                                 << ImageIOBase::GetComponentTypeAsString(componentType));
+    }
+
+    typename ImageType::RegionType  region;
+    typename ImageType::SpacingType spacing;
+    typename ImageType::PointType   origin;
+    const HeaderPointer &           header = this->m_Headers[0];
+    for (unsigned int i = 0; i < 4; ++i)
+    {
+      region.SetSize(i, this->m_Dimensions[i]);
+      spacing[i] = (i < 3 ? header->Spacing[i] : this->m_TimeSpacing);
+      origin[i] = (i < 3 ? header->Origin[i] : 0.0);
+    }
+    typename ImageType::Pointer image = ImageType::New();
+    image->SetRegions(region);
+    image->SetSpacing(spacing);
+    image->SetOrigin(origin);
+    image->Allocate();
+    this->Read(image->GetBufferPointer());
+    return image;
+  }
+
+protected:
+  ScancoSeriesReader();
+  ~ScancoSeriesReader() override = default;
+
+  void
+  PrintSelf(std::ostream & os, Indent indent) const override;
+
+private:
+  /** Read the headers if they have not been read since the file names
+   * were set. */
+  void
+  UpdateInformation();
+
+  FileNamesContainer         m_FileNames;
+  double                     m_TimeSpacing{ 1.0 };
+  ThreadIdType               m_NumberOfWorkUnits;
+  std::vector<HeaderPointer> m_Headers;
+  IOComponentEnum            m_ComponentType{ IOComponentEnum::UNKNOWNCOMPONENTTYPE };
+  SizeValueType              m_Dimensions[4]{};
+  SizeValueType              m_TimepointSizeInBytes{ 0 };
+};
+} // end namespace itk
+
+#endif // itkScancoSeriesReader_h
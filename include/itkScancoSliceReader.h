@@ -0,0 +1,189 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         https://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkScancoSliceReader_h
+#define itkScancoSliceReader_h
+#include "IOScancoExport.h"
+
+#include <fstream>
+#include <future>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "itkObject.h"
+#include "itkScancoImageIO.h"
+#include "itkScancoRunLengthDecoder.h"
+
+namespace itk
+{
+/** \class ScancoSliceReader
+ *
+ * \brief Random access to the z-slices of a Scanco file.
+ *
+ * ReadSlice() returns one slice, with the same pixel type and the same
+ * calibration that ScancoImageIO gives for the whole volume. Decoded slices
+ * are kept in a bounded least recently used cache. After each request, the
+ * next slices in the direction of travel are read ahead on background
+ * threads, so that scrolling through a volume mostly hits the cache.
+ *
+ * Uncompressed files are read one slice at a time. For run-length
+ * compressed AIM files, the compressed data is loaded only as far as
+ * needed and the decoder state at the start of every slice that has been
+ * passed is kept, so a slice is decoded from the nearest checkpoint instead
+ * of from the start of the volume. Packed-bit AIM files are decoded row by
+ * row from the bytes of the requested slice.
+ *
+ * ReadSlice() may be called from several threads.
+ *
+ * \ingroup IOScanco
+ */
+class IOScanco_EXPORT ScancoSliceReader : public Object
+{
+public:
+  ITK_DISALLOW_COPY_AND_MOVE(ScancoSliceReader);
+
+  /** Standard class typedefs. */
+  using Self = ScancoSliceReader;
+  using Superclass = Object;
+  using Pointer = SmartPointer<Self>;
+  using ConstPointer = SmartPointer<const Self>;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(ScancoSliceReader, Object);
+
+  using HeaderPointer = ScancoImageIO::HeaderPointer;
+
+  /** The file to read. Setting a new name closes the previous file and
+   * clears the cache. */
+  void
+  SetFileName(const std::string & fileName);
+  itkGetStringMacro(FileName);
+
+  /** Parse the header of the file. ReadSlice() does this when needed. */
+  void
+  Open();
+
+  /** The header of the file, or nullptr if it has not been opened. */
+  HeaderPointer
+  GetHeader() const;
+
+  /** Size of the buffer that ReadSlice() fills. */
+  SizeValueType
+  GetSliceSizeInBytes() const;
+
+  /** Read slice z into the buffer, which must hold GetSliceSizeInBytes()
+   * bytes. */
+  void
+  ReadSlice(SizeValueType z, void * buffer);
+
+  /** Maximum number of decoded slices that are kept. Default is 16. */
+  itkSetMacro(MaximumNumberOfCachedSlices, SizeValueType);
+  itkGetConstMacro(MaximumNumberOfCachedSlices, SizeValueType);
+
+  /** Number of slices that are read ahead in the scroll direction. Zero
+   * turns prefetching off. Default is 2. */
+  itkSetMacro(NumberOfPrefetchedSlices, SizeValueType);
+  itkGetConstMacro(NumberOfPrefetchedSlices, SizeValueType);
+
+  /** Number of slices currently in the cache. */
+  SizeValueType
+  GetNumberOfCachedSlices() const;
+
+  /** Drop all cached slices. */
+  void
+  ClearCache();
+
+protected:
+  ScancoSliceReader();
+  ~ScancoSliceReader() override;
+
+  void
+  PrintSelf(std::ostream & os, Indent indent) const override;
+
+private:
+  using SlicePointer = std::shared_ptr<const std::vector<char>>;
+
+  /** Read a slice from the file. */
+  SlicePointer
+  LoadSlice(SizeValueType z);
+
+  /** Decode a slice of run-length compressed data. */
+  void
+  DecodeRunLengthSlice(SizeValueType z, unsigned char * buffer);
+
+  /** Decode count voxels from the state, loading more compressed data from
+   * the file as needed. */
+  void
+  DecodeRunLength(ScancoRunLengthDecoder::State & state, unsigned char * output, SizeValueType count);
+
+  /** Add a slice to the cache, dropping the least recently used ones. The
+   * mutex must be held. */
+  void
+  CacheSlice(SizeValueType z, const SlicePointer & slice);
+
+  /** Move the slices of finished prefetches into the cache. The mutex must
+   * be held. */
+  void
+  CollectPrefetches();
+
+  /** Start reading the slices after z in the direction of travel. The mutex
+   * must be held. */
+  void
+  Prefetch(SizeValueType z);
+
+  /** Wait for all prefetches that are still running. */
+  void
+  WaitForPrefetches();
+
+  /** Parse the header and reset the cache. The mutex must be held and no
+   * prefetches may be running. */
+  void
+  OpenFile();
+
+  std::string            m_FileName;
+  HeaderPointer          m_Header;
+  ScancoImageIO::Pointer m_ImageIO;
+  SizeValueType          m_SliceSizeInBytes{ 0 };
+
+  SizeValueType m_MaximumNumberOfCachedSlices{ 16 };
+  SizeValueType m_NumberOfPrefetchedSlices{ 2 };
+
+  // Cache of decoded slices and running prefetches, guarded by m_Mutex
+  using SliceOrderType = std::list<SizeValueType>;
+  using SliceMapType = std::map<SizeValueType, std::pair<SlicePointer, SliceOrderType::iterator>>;
+  using PrefetchMapType = std::map<SizeValueType, std::shared_future<SlicePointer>>;
+  mutable std::mutex m_Mutex;
+  SliceMapType       m_Slices;
+  SliceOrderType     m_SliceOrder;
+  PrefetchMapType    m_Prefetches;
+  SizeValueType      m_LastSlice{ 0 };
+
+  // Run-length decoding, guarded by m_DecoderMutex
+  std::mutex                                 m_DecoderMutex;
+  std::ifstream                              m_File;
+  std::vector<char>                          m_CompressedData;
+  SizeValueType                              m_CompressedSize{ 0 };
+  std::vector<ScancoRunLengthDecoder::State> m_Checkpoints;
+};
+} // end namespace itk
+
+#endif // itkScancoSliceReader_h
@@ -0,0 +1,70 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         https://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkScancoTemporaryFile_h
+#define itkScancoTemporaryFile_h
+#include "IOScancoExport.h"
+
+#include <string>
+
+namespace itk
+{
+/** \class ScancoTemporaryFile
+ *
+ * \brief Write a file by way of a temporary file that replaces it at once.
+ *
+ * The constructor creates an empty file with a unique name in the directory
+ * of the target, so that concurrent writers of the same target do not share
+ * it and the final rename stays within one file system. Write to
+ * GetFileName(), then call Commit() to rename it over the target, which
+ * keeps the permissions of a target that already exists. Until then the
+ * target is unchanged, and a temporary file that is not committed is
+ * removed by the destructor.
+ *
+ * All errors throw an ExceptionObject.
+ *
+ * \ingroup IOScanco
+ */
+class IOScanco_EXPORT ScancoTemporaryFile
+{
+public:
+  explicit ScancoTemporaryFile(const std::string & targetFileName);
+  ~ScancoTemporaryFile();
+  ScancoTemporaryFile(const ScancoTemporaryFile &) = delete;
+  ScancoTemporaryFile &
+  operator=(const ScancoTemporaryFile &) = delete;
+
+  /** The name of the temporary file. */
+  const std::string &
+  GetFileName() const
+  {
+    return this->m_FileName;
+  }
+
+  /** Replace the target with the temporary file. The temporary file must be
+   * closed. */
+  void
+  Commit();
+
+private:
+  std::string m_TargetFileName;
+  std::string m_FileName;
+  bool        m_Committed{ false };
+};
+} // end namespace itk
+
+#endif // itkScancoTemporaryFile_h
@@ -0,0 +1,128 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         https://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkScancoValueCounter_h
+#define itkScancoValueCounter_h
+#include "IOScancoExport.h"
+
+#include <array>
+#include <string>
+#include <vector>
+#include "itkObject.h"
+
+namespace itk
+{
+/** \class ScancoValueCounter
+ *
+ * \brief Voxel counts of each value of an 8-bit Scanco file.
+ *
+ * Compute() counts the voxels of each value of an 8-bit scalar file, such
+ * as a binary or label AIM file, over the image and per slice, without
+ * decoding the image. Values are the stored values, without rescaling.
+ *
+ * Run-length compressed data is read with ScancoRunLengthDecoder and split
+ * into chunks of runs that are counted in parallel: a first pass finds the
+ * number of voxels in each chunk, which gives the position where the next
+ * chunk starts, and a second pass adds the runs of each chunk to the
+ * slices they fall in. Uncompressed and packed-bit data is counted in
+ * parallel by slabs of slices. Voxels after the end of truncated
+ * run-length data count as zero, as in ScancoImageIO::Read().
+ *
+ * \ingroup IOScanco
+ */
+class IOScanco_EXPORT ScancoValueCounter : public Object
+{
+public:
+  ITK_DISALLOW_COPY_AND_MOVE(ScancoValueCounter);
+
+  /** Standard class typedefs. */
+  using Self = ScancoValueCounter;
+  using Superclass = Object;
+  using Pointer = SmartPointer<Self>;
+  using ConstPointer = SmartPointer<const Self>;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(ScancoValueCounter, Object);
+
+  /** Number of voxels of each value, indexed by the stored byte, so that in
+   * signed images -1 is counted at 255. */
+  using HistogramType = std::array<SizeValueType, 256>;
+
+  /** The file, which must hold 8-bit scalar data. */
+  itkSetStringMacro(FileName);
+  itkGetStringMacro(FileName);
+
+  /** Number of work units used to count chunks and slabs. Defaults to the
+   * global default number of threads. */
+  itkSetMacro(NumberOfWorkUnits, ThreadIdType);
+  itkGetConstMacro(NumberOfWorkUnits, ThreadIdType);
+
+  /** Read the file and count its values. */
+  void
+  Compute();
+
+  /** The histogram of the whole image. */
+  const HistogramType &
+  GetHistogram() const
+  {
+    return this->m_Histogram;
+  }
+
+  /** The histogram of each slice, 256 counts per slice. */
+  const std::vector<SizeValueType> &
+  GetSliceHistograms() const
+  {
+    return this->m_SliceHistograms;
+  }
+
+  SizeValueType
+  GetSliceCount(SizeValueType z, unsigned char value) const
+  {
+    return this->m_SliceHistograms[z * 256 + value];
+  }
+
+  itkGetConstMacro(NumberOfVoxels, SizeValueType);
+
+  /** Fraction of the voxels that are not zero, such as BV/TV of a binary
+   * segmentation. */
+  double
+  GetNonZeroFraction() const
+  {
+    return (this->m_NumberOfVoxels == 0 ? 0.0
+                                        : 1.0 - static_cast<double>(this->m_Histogram[0]) / this->m_NumberOfVoxels);
+  }
+
+protected:
+  ScancoValueCounter();
+  ~ScancoValueCounter() override = default;
+
+  void
+  PrintSelf(std::ostream & os, Indent indent) const override;
+
+private:
+  std::string                m_FileName;
+  ThreadIdType               m_NumberOfWorkUnits;
+  HistogramType              m_Histogram{};
+  std::vector<SizeValueType> m_SliceHistograms;
+  SizeValueType              m_NumberOfVoxels{ 0 };
+};
+} // end namespace itk
+
+#endif // itkScancoValueCounter_h
@@ -15,6 +15,8 @@ itk_module(IOScanco
   TEST_DEPENDS
     ITKTestKernel
     ITKIOMeta
+    ITKLabelMap
+    ITKThresholding
   FACTORY_NAMES
     ImageIO::Scanco
   DESCRIPTION
@@ -0,0 +1,462 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         https://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkScancoArchiveIndexer.h"
+#include "itkScancoImageIO.h"
+#include "itkScancoTemporaryFile.h"
+#include "itkMultiThreaderBase.h"
+#include "itksys/Directory.hxx"
+#include "itksys/SystemTools.hxx"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <sstream>
+
+namespace itk
+{
+namespace
+{
+
+// The length of the UTF-8 sequence that starts at text, or 0 if it is not
+// a valid one
+int
+GetUTF8SequenceLength(const unsigned char * text)
+{
+  int           length = 0;
+  unsigned char low = 0x80;
+  unsigned char high = 0xbf;
+  if (text[0] >= 0xc2 && text[0] <= 0xdf)
+  {
+    length = 2;
+  }
+  else if (text[0] >= 0xe0 && text[0] <= 0xef)
+  {
+    length = 3;
+    low = (text[0] == 0xe0 ? 0xa0 : 0x80);
+    high = (text[0] == 0xed ? 0x9f : 0xbf);
+  }
+  else if (text[0] >= 0xf0 && text[0] <= 0xf4)
+  {
+    length = 4;
+    low = (text[0] == 0xf0 ? 0x90 : 0x80);
+    high = (text[0] == 0xf4 ? 0x8f : 0xbf);
+  }
+  for (int i = 1; i < length; ++i)
+  {
+    if (text[i] < (i == 1 ? low : 0x80) || text[i] > (i == 1 ? high : 0xbf))
+    {
+      return 0;
+    }
+  }
+  return length;
+}
+
+
+// Append a code point of the Basic Multilingual Plane as UTF-8
+void
+AppendUTF8(std::string & text, unsigned int codePoint)
+{
+  if (codePoint < 0x80)
+  {
+    text += static_cast<char>(codePoint);
+  }
+  else if (codePoint < 0x800)
+  {
+    text += static_cast<char>(0xc0 | (codePoint >> 6));
+    text += static_cast<char>(0x80 | (codePoint & 0x3f));
+  }
+  else
+  {
+    text += static_cast<char>(0xe0 | (codePoint >> 12));
+    text += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3f));
+    text += static_cast<char>(0x80 | (codePoint & 0x3f));
+  }
+}
+
+
+// Append a JSON string. File names are taken as UTF-8, and the rare bytes
+// that are not part of a valid UTF-8 sequence are written as \u00XX, which
+// ParseJSONString() reads back as the same byte. Header text is Latin-1,
+// which is converted to UTF-8.
+void
+AppendJSONString(std::ostream & os, const char * text, bool latin1)
+{
+  static const char hexDigits[] = "0123456789abcdef";
+  os << '"';
+  for (const auto * cp = reinterpret_cast<const unsigned char *>(text); *cp != '\0'; ++cp)
+  {
+    if (*cp == '"' || *cp == '\\')
+    {
+      os << '\\' << static_cast<char>(*cp);
+    }
+    else if (*cp < 0x20 || (*cp >= 0x80 && !latin1 && GetUTF8SequenceLength(cp) == 0))
+    {
+      os << "\\u00" << hexDigits[*cp >> 4] << hexDigits[*cp & 0xf];
+    }
+    else if (*cp >= 0x80 && latin1)
+    {
+      std::string character;
+      AppendUTF8(character, *cp);
+      os << character;
+    }
+    else
+    {
+      const int length = (*cp >= 0x80 ? GetUTF8SequenceLength(cp) : 1);
+      os.write(reinterpret_cast<const char *>(cp), length);
+      cp += length - 1;
+    }
+  }
+  os << '"';
+}
+
+
+void
+AppendJSONNumber(std::ostream & os, double value)
+{
+  if (std::isfinite(value))
+  {
+    os << value;
+  }
+  else
+  {
+    os << "null";
+  }
+}
+
+
+// Extract the string value of a key from a catalog line written by
+// FormatCatalogEntry().
+bool
+ParseJSONString(const std::string & line, const std::string & key, std::string & value)
+{
+  const std::string pattern = "\"" + key + "\":\"";
+  size_t            pos = line.find(pattern);
+  if (pos == std::string::npos)
+  {
+    return false;
+  }
+  value.clear();
+  for (pos += pattern.size(); pos < line.size() && line[pos] != '"'; ++pos)
+  {
+    if (line[pos] != '\\' || pos + 1 >= line.size())
+    {
+      value += line[pos];
+    }
+    else if (line[++pos] == 'u' && pos + 4 < line.size())
+    {
+      // \u0000 to \u00ff are bytes, see AppendJSONString()
+      const auto codePoint = static_cast<unsigned int>(std::stoi(line.substr(pos + 1, 4), nullptr, 16));
+      if (codePoint < 0x100)
+      {
+        value += static_cast<char>(codePoint);
+      }
+      else
+      {
+        AppendUTF8(value, codePoint);
+      }
+      pos += 4;
+    }
+    else
+    {
+      value += line[pos];
+    }
+  }
+  return pos < line.size();
+}
+
+
+bool
+ParseJSONInteger(const std::string & line, const std::string & key, long long & value)
+{
+  const std::string pattern = "\"" + key + "\":";
+  const size_t      pos = line.find(pattern);
+  if (pos == std::string::npos)
+  {
+    return false;
+  }
+  char * end = nullptr;
+  value = std::strtoll(line.c_str() + pos + pattern.size(), &end, 10);
+  return end != line.c_str() + pos + pattern.size();
+}
+
+
+struct CatalogEntry
+{
+  long long   ModifiedTime;
+  long long   Size;
+  std::string Line;
+};
+
+} // end anonymous namespace
+
+
+ScancoArchiveIndexer::ScancoArchiveIndexer()
+  : m_NumberOfWorkUnits(MultiThreaderBase::GetGlobalDefaultNumberOfThreads())
+{}
+
+
+void
+ScancoArchiveIndexer::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "Directories:" << std::endl;
+  for (const auto & directory : this->m_Directories)
+  {
+    os << indent.GetNextIndent() << directory << std::endl;
+  }
+  os << indent << "CatalogFileName: " << this->m_CatalogFileName << std::endl;
+  os << indent << "NumberOfWorkUnits: " << this->m_NumberOfWorkUnits << std::endl;
+  os << indent << "NumberOfParsedFiles: " << this->m_NumberOfParsedFiles << std::endl;
+  os << indent << "NumberOfUnchangedFiles: " << this->m_NumberOfUnchangedFiles << std::endl;
+  os << indent << "NumberOfFailedFiles: " << this->m_NumberOfFailedFiles << std::endl;
+}
+
+
+void
+ScancoArchiveIndexer::AddDirectory(const std::string & directory)
+{
+  this->m_Directories.push_back(directory);
+  this->Modified();
+}
+
+
+void
+ScancoArchiveIndexer::ClearDirectories()
+{
+  this->m_Directories.clear();
+  this->Modified();
+}
+
+
+void
+ScancoArchiveIndexer::FindFiles(const std::string & directory, std::vector<std::string> & files)
+{
+  itksys::Directory dir;
+  if (!dir.Load(directory))
+  {
+    return;
+  }
+
+  for (unsigned long i = 0; i < dir.GetNumberOfFiles(); ++i)
+  {
+    const std::string name = dir.GetFile(i);
+    if (name == "." || name == "..")
+    {
+      continue;
+    }
+    const std::string path = directory + "/" + name;
+    if (itksys::SystemTools::FileIsDirectory(path))
+    {
+      // do not follow links, which might form cycles
+      if (!itksys::SystemTools::FileIsSymlink(path))
+      {
+        ScancoArchiveIndexer::FindFiles(path, files);
+      }
+      continue;
+    }
+
+    const std::string extension =
+      itksys::SystemTools::LowerCase(itksys::SystemTools::GetFilenameLastExtension(name));
+    if (extension == ".isq" || extension == ".rsq" || extension == ".rad" || extension == ".aim")
+    {
+      files.push_back(path);
+    }
+  }
+}
+
+
+std::string
+ScancoArchiveIndexer::FormatCatalogEntry(const std::string &  path,
+                                         long                 modifiedTime,
+                                         SizeValueType        size,
+                                         const ScancoHeader & header)
+{
+  std::ostringstream os;
+  os.precision(std::numeric_limits<double>::max_digits10);
+
+  static const char * fileTypes[] = { "Unknown", "ISQ", "AIM", "AIM" };
+
+  os << "{\"Path\":";
+  AppendJSONString(os, path.c_str(), false);
+  os << ",\"MTime\":" << modifiedTime;
+  os << ",\"Size\":" << size;
+  os << ",\"FileType\":\"" << fileTypes[(header.FileType >= 0 && header.FileType <= 3) ? header.FileType : 0]
+     << '"';
+  os << ",\"Version\":";
+  AppendJSONString(os, header.Version, true);
+  os << ",\"PatientName\":";
+  AppendJSONString(os, header.PatientName, true);
+  os << ",\"PatientIndex\":" << header.PatientIndex;
+  os << ",\"MeasurementIndex\":" << header.MeasurementIndex;
+  os << ",\"Site\":" << header.Site;
+  os << ",\"ScannerID\":" << header.ScannerID;
+  os << ",\"ScannerType\":" << header.ScannerType;
+  os << ",\"CreationDate\":";
+  AppendJSONString(os, header.CreationDate, true);
+  os << ",\"ModificationDate\":";
+  AppendJSONString(os, header.ModificationDate, true);
+  os << ",\"Energy\":";
+  AppendJSONNumber(os, header.Energy);
+  os << ",\"Intensity\":";
+  AppendJSONNumber(os, header.Intensity);
+  os << ",\"MuScaling\":";
+  AppendJSONNumber(os, header.MuScaling);
+  os << ",\"MuWater\":";
+  AppendJSONNumber(os, header.MuWater);
+  os << ",\"RescaleType\":" << header.RescaleType;
+  os << ",\"RescaleUnits\":";
+  AppendJSONString(os, header.RescaleUnits, true);
+  os << ",\"RescaleSlope\":";
+  AppendJSONNumber(os, header.RescaleSlope);
+  os << ",\"RescaleIntercept\":";
+  AppendJSONNumber(os, header.RescaleIntercept);
+  os << ",\"CalibrationData\":";
+  AppendJSONString(os, header.CalibrationData, true);
+  os << ",\"Dimensions\":[" << header.Dimensions[0] << ',' << header.Dimensions[1] << ',' << header.Dimensions[2]
+     << ']';
+  os << ",\"Spacing\":[";
+  for (int i = 0; i < 3; ++i)
+  {
+    os << (i > 0 ? "," : "");
+    AppendJSONNumber(os, header.Spacing[i]);
+  }
+  os << "],\"Origin\":[";
+  for (int i = 0; i < 3; ++i)
+  {
+    os << (i > 0 ? "," : "");
+    AppendJSONNumber(os, header.Origin[i]);
+  }
+  os << "],\"ComponentType\":\"" << ImageIOBase::GetComponentTypeAsString(header.ComponentType) << '"';
+  os << ",\"Compression\":" << header.Compression;
+  os << '}';
+
+  return os.str();
+}
+
+
+void
+ScancoArchiveIndexer::Update()
+{
+  if (this->m_CatalogFileName.empty())
+  {
+    itkExceptionMacro("CatalogFileName has not been set.");
+  }
+
+  // Entries of the previous run, by path
+  std::map<std::string, CatalogEntry> previousEntries;
+  {
+    std::ifstream catalog(this->m_CatalogFileName.c_str());
+    std::string   line;
+    while (std::getline(catalog, line))
+    {
+      std::string  path;
+      CatalogEntry entry;
+      if (ParseJSONString(line, "Path", path) && ParseJSONInteger(line, "MTime", entry.ModifiedTime) &&
+          ParseJSONInteger(line, "Size", entry.Size))
+      {
+        entry.Line = line;
+        previousEntries[path] = std::move(entry);
+      }
+    }
+  }
+
+  std::vector<std::string> files;
+  for (const auto & directory : this->m_Directories)
+  {
+    ScancoArchiveIndexer::FindFiles(directory, files);
+  }
+  std::sort(files.begin(), files.end());
+  files.erase(std::unique(files.begin(), files.end()), files.end());
+
+  // Reuse the entries of unchanged files, and collect the ones to parse
+  std::vector<std::string>   lines(files.size());
+  std::vector<SizeValueType> toParse;
+  std::vector<long>          modifiedTimes(files.size());
+  std::vector<SizeValueType> sizes(files.size());
+  for (SizeValueType i = 0; i < files.size(); ++i)
+  {
+    modifiedTimes[i] = itksys::SystemTools::ModifiedTime(files[i]);
+    sizes[i] = itksys::SystemTools::FileLength(files[i]);
+    const auto previous = previousEntries.find(files[i]);
+    if (previous != previousEntries.end() && previous->second.ModifiedTime == modifiedTimes[i] &&
+        previous->second.Size == static_cast<long long>(sizes[i]))
+    {
+      lines[i] = std::move(previous->second.Line);
+    }
+    else
+    {
+      toParse.push_back(i);
+    }
+  }
+
+  std::atomic<SizeValueType> failedFiles(0);
+  MultiThreaderBase::Pointer threader = MultiThreaderBase::New();
+  threader->SetNumberOfWorkUnits(this->m_NumberOfWorkUnits);
+  threader->ParallelizeArray(
+    0,
+    toParse.size(),
+    [&](SizeValueType j) {
+      const SizeValueType i = toParse[j];
+      try
+      {
+        const ScancoImageIO::HeaderPointer header = ScancoImageIO::ReadHeader(files[i]);
+        lines[i] = ScancoArchiveIndexer::FormatCatalogEntry(files[i], modifiedTimes[i], sizes[i], *header);
+      }
+      catch (const std::exception &)
+      {
+        // ExceptionObject, or e.g. std::bad_alloc for a corrupt header
+        ++failedFiles;
+      }
+    },
+    nullptr);
+
+  this->m_NumberOfParsedFiles = toParse.size() - failedFiles;
+  this->m_NumberOfUnchangedFiles = files.size() - toParse.size();
+  this->m_NumberOfFailedFiles = failedFiles;
+
+  // Write to a temporary file first, so the previous catalog survives errors
+  ScancoTemporaryFile temporaryFile(this->m_CatalogFileName);
+  {
+    std::ofstream catalog(temporaryFile.GetFileName().c_str(), std::ios::out | std::ios::trunc);
+    if (!catalog.is_open())
+    {
+      itkExceptionMacro("Could not open catalog for writing: " << temporaryFile.GetFileName());
+    }
+    for (const auto & line : lines)
+    {
+      if (!line.empty())
+      {
+        catalog << line << '\n';
+      }
+    }
+    catalog.close();
+    if (catalog.fail())
+    {
+      itkExceptionMacro("Could not write catalog: " << temporaryFile.GetFileName());
+    }
+  }
+  temporaryFile.Commit();
+}
+
+} // end namespace itk
@@ -0,0 +1,151 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         https://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkScancoBitMask.h"
+
+#include <algorithm>
+
+namespace itk
+{
+
+namespace
+{
+// The number of set bits of a word
+inline unsigned int
+CountBits(ScancoBitMask::WordType word)
+{
+  word = word - ((word >> 1) & 0x5555555555555555ull);
+  word = (word & 0x3333333333333333ull) + ((word >> 2) & 0x3333333333333333ull);
+  word = (word + (word >> 4)) & 0x0f0f0f0f0f0f0f0full;
+  return static_cast<unsigned int>((word * 0x0101010101010101ull) >> 56);
+}
+} // end anonymous namespace
+
+
+ScancoBitMask::ScancoBitMask()
+{
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    this->m_Spacing[i] = 1.0;
+    this->m_Origin[i] = 0.0;
+  }
+}
+
+
+void
+ScancoBitMask::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "Size: " << this->m_Region.GetSize(0) << " " << this->m_Region.GetSize(1) << " "
+     << this->m_Region.GetSize(2) << std::endl;
+  os << indent << "Spacing: " << this->m_Spacing[0] << " " << this->m_Spacing[1] << " " << this->m_Spacing[2]
+     << std::endl;
+  os << indent << "Origin: " << this->m_Origin[0] << " " << this->m_Origin[1] << " " << this->m_Origin[2] << std::endl;
+  os << indent << "WordsPerRow: " << this->m_WordsPerRow << std::endl;
+}
+
+
+void
+ScancoBitMask::Allocate(const SizeType & size)
+{
+  RegionType region;
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    region.SetIndex(i, 0);
+    region.SetSize(i, size[i]);
+  }
+  this->m_Region = region;
+  this->m_WordsPerRow = (size[0] + BitsPerWord - 1) / BitsPerWord;
+  this->m_Words.assign(this->m_WordsPerRow * size[1] * size[2], 0);
+  this->Modified();
+}
+
+
+void
+ScancoBitMask::CheckRegion(const RegionType & region) const
+{
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    if (region.GetIndex(i) < 0 ||
+        region.GetIndex(i) + static_cast<IndexValueType>(region.GetSize(i)) >
+          static_cast<IndexValueType>(this->m_Region.GetSize(i)))
+    {
+      itkExceptionMacro("Region is outside of the mask: " << region);
+    }
+  }
+}
+
+
+void
+ScancoBitMask::SetRun(SizeValueType x, SizeValueType y, SizeValueType z, SizeValueType length, bool value)
+{
+  if (length == 0)
+  {
+    return;
+  }
+  WordType *          row = this->GetRow(y, z);
+  const SizeValueType first = x / BitsPerWord;
+  const SizeValueType last = (x + length - 1) / BitsPerWord;
+  // the bits of the run in its first and last word
+  const WordType firstBits = ~WordType{ 0 } << (x % BitsPerWord);
+  const WordType lastBits = ~WordType{ 0 } >> (BitsPerWord - 1 - (x + length - 1) % BitsPerWord);
+  if (first == last)
+  {
+    row[first] = (value ? row[first] | (firstBits & lastBits) : row[first] & ~(firstBits & lastBits));
+    return;
+  }
+  row[first] = (value ? row[first] | firstBits : row[first] & ~firstBits);
+  std::fill(row + first + 1, row + last, value ? ~WordType{ 0 } : WordType{ 0 });
+  row[last] = (value ? row[last] | lastBits : row[last] & ~lastBits);
+}
+
+
+void
+ScancoBitMask::FillBuffer(bool value)
+{
+  const SizeValueType xsize = this->m_Region.GetSize(0);
+  if (!value || xsize == 0)
+  {
+    std::fill(this->m_Words.begin(), this->m_Words.end(), WordType{ 0 });
+    return;
+  }
+  for (SizeValueType z = 0; z < this->m_Region.GetSize(2); ++z)
+  {
+    for (SizeValueType y = 0; y < this->m_Region.GetSize(1); ++y)
+    {
+      // the bits past the end of the row stay clear
+      WordType * row = this->GetRow(y, z);
+      std::fill(row, row + this->m_WordsPerRow, WordType{ 0 });
+      this->SetRun(0, y, z, xsize, true);
+    }
+  }
+}
+
+
+SizeValueType
+ScancoBitMask::CountSetVoxels() const
+{
+  SizeValueType count = 0;
+  for (const WordType word : this->m_Words)
+  {
+    count += CountBits(word);
+  }
+  return count;
+}
+
+} // end namespace itk
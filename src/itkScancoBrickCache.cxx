@@ -0,0 +1,429 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         https://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkScancoBrickCache.h"
+#include "itkScancoImageIO.h"
+#include "itkScancoTemporaryFile.h"
+#include "itksys/SystemTools.hxx"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <type_traits>
+
+namespace itk
+{
+namespace
+{
+
+const char          brickFileMagic[8] = { 'S', 'C', 'A', 'N', 'C', 'O', 'B', 'C' };
+const std::uint32_t brickFileVersion = 1;
+
+// The fixed part at the start of a brick cache file. It is followed by the
+// BrickInformation of every brick and then by the data of the bricks.
+struct BrickFileHeader
+{
+  char          Magic[8];
+  std::uint32_t Version;
+  std::uint32_t BrickSize;
+  std::uint64_t Dimensions[3];
+  std::int32_t  ComponentType;
+  std::uint32_t ComponentSize;
+  std::uint64_t SourceSize;
+  std::int64_t  SourceModifiedTime;
+};
+
+static_assert(sizeof(BrickFileHeader) == 64, "BrickFileHeader must not be padded");
+static_assert(sizeof(ScancoBrickCache::BrickInformation) == 24, "BrickInformation must not be padded");
+
+template <typename T>
+void
+WriteValue(std::ostream & os, const T & value)
+{
+  os.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template <typename T>
+bool
+ReadValue(std::istream & is, T & value)
+{
+  return static_cast<bool>(is.read(reinterpret_cast<char *>(&value), sizeof(T)));
+}
+
+
+template <typename TPixel>
+void
+ComputeRange(const char * data, SizeValueType numberOfPixels, double & minimum, double & maximum)
+{
+  const auto * pixels = reinterpret_cast<const TPixel *>(data);
+  const auto   range = std::minmax_element(pixels, pixels + numberOfPixels);
+  minimum = static_cast<double>(*range.first);
+  maximum = static_cast<double>(*range.second);
+}
+
+
+template <typename TPixel>
+void
+FillPixels(char * data, SizeValueType numberOfPixels, double value)
+{
+  auto * pixels = reinterpret_cast<TPixel *>(data);
+  std::fill(pixels, pixels + numberOfPixels, static_cast<TPixel>(value));
+}
+
+
+// Call ComputeRange or FillPixels for the pixel type of the data
+template <typename TFunctor>
+void
+DispatchComponentType(IOComponentEnum componentType, TFunctor && functor)
+{
+  switch (componentType)
+  {
+    case IOComponentEnum::CHAR:
+      functor(static_cast<char *>(nullptr));
+      break;
+    case IOComponentEnum::UCHAR:
+      functor(static_cast<unsigned char *>(nullptr));
+      break;
+    case IOComponentEnum::SHORT:
+      functor(static_cast<short *>(nullptr));
+      break;
+    case IOComponentEnum::USHORT:
+      functor(static_cast<unsigned short *>(nullptr));
+      break;
+    case IOComponentEnum::INT:
+      functor(static_cast<int *>(nullptr));
+      break;
+    case IOComponentEnum::UINT:
+      functor(static_cast<unsigned int *>(nullptr));
+      break;
+    case IOComponentEnum::FLOAT:
+      functor(static_cast<float *>(nullptr));
+      break;
+    default:
+      itkGenericExceptionMacro("Unrecognized data type: " << componentType);
+  }
+}
+
+
+bool
+ReadBrickFileHeader(std::istream & file, BrickFileHeader & fileHeader)
+{
+  return ReadValue(file, fileHeader) && std::memcmp(fileHeader.Magic, brickFileMagic, sizeof(brickFileMagic)) == 0 &&
+         fileHeader.Version == brickFileVersion && fileHeader.BrickSize > 0;
+}
+
+
+bool
+MatchesSourceFile(const BrickFileHeader & fileHeader, const std::string & fileName)
+{
+  return itksys::SystemTools::FileExists(fileName, true) &&
+         fileHeader.SourceSize == itksys::SystemTools::FileLength(fileName) &&
+         fileHeader.SourceModifiedTime == itksys::SystemTools::ModifiedTime(fileName);
+}
+
+} // end anonymous namespace
+
+
+constexpr unsigned int ScancoBrickCache::DefaultBrickSize;
+
+
+std::string
+ScancoBrickCache::GetCacheFileName(const std::string & fileName)
+{
+  return fileName + ".bricks";
+}
+
+
+void
+ScancoBrickCache::Transcode(const std::string & fileName, const std::string & cacheFileName, unsigned int brickSize)
+{
+  if (brickSize == 0)
+  {
+    itkGenericExceptionMacro("Brick size must be positive.");
+  }
+
+  const ScancoImageIO::HeaderPointer header = ScancoImageIO::ReadHeader(fileName);
+  ScancoImageIO::Pointer             imageIO = ScancoImageIO::New();
+  imageIO->SetFileName(fileName);
+  imageIO->SetHeader(header);
+
+  BrickFileHeader fileHeader{};
+  std::memcpy(fileHeader.Magic, brickFileMagic, sizeof(brickFileMagic));
+  fileHeader.Version = brickFileVersion;
+  fileHeader.BrickSize = brickSize;
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    fileHeader.Dimensions[i] = header->Dimensions[i];
+  }
+  fileHeader.ComponentType = static_cast<std::int32_t>(header->ComponentType);
+  fileHeader.ComponentSize = static_cast<std::uint32_t>(imageIO->GetComponentSize());
+  fileHeader.SourceSize = itksys::SystemTools::FileLength(fileName);
+  fileHeader.SourceModifiedTime = itksys::SystemTools::ModifiedTime(fileName);
+
+  const SizeValueType pixelSize = fileHeader.ComponentSize;
+  const SizeValueType xsize = header->Dimensions[0];
+  const SizeValueType ysize = header->Dimensions[1];
+  const SizeValueType zsize = header->Dimensions[2];
+  SizeValueType       numberOfBricks[3];
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    numberOfBricks[i] = (header->Dimensions[i] + brickSize - 1) / brickSize;
+  }
+  std::vector<BrickInformation> bricks(numberOfBricks[0] * numberOfBricks[1] * numberOfBricks[2]);
+
+  // Write to a temporary file first, so that a stale cache is never used
+  ScancoTemporaryFile temporaryFile(cacheFileName);
+  std::ofstream       file(temporaryFile.GetFileName().c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!file.is_open())
+  {
+    itkGenericExceptionMacro("Could not open brick cache for writing: " << temporaryFile.GetFileName());
+  }
+  WriteValue(file, fileHeader);
+  file.write(reinterpret_cast<const char *>(bricks.data()), bricks.size() * sizeof(BrickInformation));
+  std::uint64_t dataOffset = sizeof(BrickFileHeader) + bricks.size() * sizeof(BrickInformation);
+
+  // Uncompressed data is read one layer of bricks at a time, compressed data
+  // has to be decoded in full anyway
+  const SizeValueType slabSlices = (header->Compression == 0 ? std::min<SizeValueType>(brickSize, zsize) : zsize);
+  std::vector<char>   slab(xsize * ysize * slabSlices * pixelSize);
+  std::vector<char>   brick(static_cast<SizeValueType>(brickSize) * brickSize * brickSize * pixelSize);
+  SizeValueType       slabStart = 0;
+  SizeValueType       slabEnd = 0;
+
+  for (SizeValueType bz = 0; bz < numberOfBricks[2]; ++bz)
+  {
+    const SizeValueType z0 = bz * brickSize;
+    const SizeValueType nz = std::min<SizeValueType>(brickSize, zsize - z0);
+    if (z0 + nz > slabEnd)
+    {
+      ImageIORegion region(3);
+      region.SetIndex(2, z0);
+      region.SetSize(0, xsize);
+      region.SetSize(1, ysize);
+      region.SetSize(2, std::min(slabSlices, zsize - z0));
+      imageIO->ReadRegion(region, slab.data());
+      slabStart = z0;
+      slabEnd = z0 + region.GetSize(2);
+    }
+
+    for (SizeValueType by = 0; by < numberOfBricks[1]; ++by)
+    {
+      const SizeValueType y0 = by * brickSize;
+      const SizeValueType ny = std::min<SizeValueType>(brickSize, ysize - y0);
+      for (SizeValueType bx = 0; bx < numberOfBricks[0]; ++bx)
+      {
+        const SizeValueType x0 = bx * brickSize;
+        const SizeValueType nx = std::min<SizeValueType>(brickSize, xsize - x0);
+
+        // Gather the rows of the brick
+        const SizeValueType rowSize = nx * pixelSize;
+        for (SizeValueType z = 0; z < nz; ++z)
+        {
+          for (SizeValueType y = 0; y < ny; ++y)
+          {
+            std::memcpy(brick.data() + (z * ny + y) * rowSize,
+                        slab.data() + (((z0 - slabStart + z) * ysize + y0 + y) * xsize + x0) * pixelSize,
+                        rowSize);
+          }
+        }
+
+        BrickInformation & information = bricks[(bz * numberOfBricks[1] + by) * numberOfBricks[0] + bx];
+        DispatchComponentType(header->ComponentType, [&](auto * pixelType) {
+          using PixelType = typename std::remove_pointer<decltype(pixelType)>::type;
+          ComputeRange<PixelType>(brick.data(), nx * ny * nz, information.Minimum, information.Maximum);
+        });
+        if (information.Minimum == information.Maximum)
+        {
+          // uniform bricks are not stored
+          information.Offset = 0;
+          continue;
+        }
+        information.Offset = dataOffset;
+        file.write(brick.data(), rowSize * ny * nz);
+        dataOffset += rowSize * ny * nz;
+      }
+    }
+  }
+
+  file.seekp(sizeof(BrickFileHeader));
+  file.write(reinterpret_cast<const char *>(bricks.data()), bricks.size() * sizeof(BrickInformation));
+  file.close();
+  if (file.fail())
+  {
+    itkGenericExceptionMacro("Could not write brick cache: " << temporaryFile.GetFileName());
+  }
+  temporaryFile.Commit();
+}
+
+
+bool
+ScancoBrickCache::IsUpToDate(const std::string & cacheFileName, const std::string & fileName)
+{
+  std::ifstream   file(cacheFileName.c_str(), std::ios::in | std::ios::binary);
+  BrickFileHeader fileHeader;
+  return file.is_open() && ReadBrickFileHeader(file, fileHeader) && MatchesSourceFile(fileHeader, fileName);
+}
+
+
+void
+ScancoBrickCache::ReadBrickInformation(const std::string &             cacheFileName,
+                                       unsigned int &                  brickSize,
+                                       std::vector<BrickInformation> & bricks)
+{
+  std::ifstream   file(cacheFileName.c_str(), std::ios::in | std::ios::binary);
+  BrickFileHeader fileHeader;
+  if (!file.is_open() || !ReadBrickFileHeader(file, fileHeader))
+  {
+    itkGenericExceptionMacro("Not a valid brick cache: " << cacheFileName);
+  }
+
+  brickSize = fileHeader.BrickSize;
+  SizeValueType numberOfBricks = 1;
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    numberOfBricks *= (fileHeader.Dimensions[i] + brickSize - 1) / brickSize;
+  }
+  bricks.resize(numberOfBricks);
+  if (!file.read(reinterpret_cast<char *>(bricks.data()), numberOfBricks * sizeof(BrickInformation)))
+  {
+    itkGenericExceptionMacro("Brick cache is truncated: " << cacheFileName);
+  }
+}
+
+
+bool
+ScancoBrickCache::ReadRegion(const std::string &   cacheFileName,
+                             const std::string &   fileName,
+                             const ScancoHeader &  header,
+                             const ImageIORegion & region,
+                             void *                buffer)
+{
+  std::ifstream   file(cacheFileName.c_str(), std::ios::in | std::ios::binary);
+  BrickFileHeader fileHeader;
+  if (!file.is_open() || !ReadBrickFileHeader(file, fileHeader) ||
+      fileHeader.ComponentType != static_cast<std::int32_t>(header.ComponentType) ||
+      !MatchesSourceFile(fileHeader, fileName))
+  {
+    return false;
+  }
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    if (fileHeader.Dimensions[i] != header.Dimensions[i])
+    {
+      return false;
+    }
+  }
+
+  if (region.GetImageDimension() != 3)
+  {
+    itkGenericExceptionMacro("Requested region must be three-dimensional.");
+  }
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    if (region.GetIndex(i) < 0 || region.GetIndex(i) + region.GetSize(i) > header.Dimensions[i])
+    {
+      itkGenericExceptionMacro("Requested region is outside of the image: " << region);
+    }
+  }
+  if (region.GetNumberOfPixels() == 0)
+  {
+    return true;
+  }
+
+  const SizeValueType brickSize = fileHeader.BrickSize;
+  const SizeValueType pixelSize = fileHeader.ComponentSize;
+  SizeValueType       numberOfBricks[3];
+  SizeValueType       start[3];
+  SizeValueType       end[3];
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    numberOfBricks[i] = (header.Dimensions[i] + brickSize - 1) / brickSize;
+    start[i] = region.GetIndex(i);
+    end[i] = start[i] + region.GetSize(i);
+  }
+
+  char *            out = static_cast<char *>(buffer);
+  std::vector<char> brick;
+  for (SizeValueType bz = start[2] / brickSize; bz <= (end[2] - 1) / brickSize; ++bz)
+  {
+    for (SizeValueType by = start[1] / brickSize; by <= (end[1] - 1) / brickSize; ++by)
+    {
+      for (SizeValueType bx = start[0] / brickSize; bx <= (end[0] - 1) / brickSize; ++bx)
+      {
+        const SizeValueType brickIndex = (bz * numberOfBricks[1] + by) * numberOfBricks[0] + bx;
+        BrickInformation    information;
+        file.seekg(static_cast<std::streamoff>(sizeof(BrickFileHeader) + brickIndex * sizeof(BrickInformation)));
+        if (!ReadValue(file, information))
+        {
+          return false;
+        }
+
+        // The brick, and its intersection with the region
+        const SizeValueType origin[3] = { bx * brickSize, by * brickSize, bz * brickSize };
+        SizeValueType       brickExtent[3];
+        SizeValueType       first[3];
+        SizeValueType       last[3];
+        for (unsigned int i = 0; i < 3; ++i)
+        {
+          brickExtent[i] = std::min<SizeValueType>(brickSize, header.Dimensions[i] - origin[i]);
+          first[i] = std::max(start[i], origin[i]);
+          last[i] = std::min(end[i], origin[i] + brickExtent[i]);
+        }
+        const SizeValueType rowSize = (last[0] - first[0]) * pixelSize;
+
+        // Uniform bricks are filled from a single row
+        const SizeValueType brickBytes = brickExtent[0] * brickExtent[1] * brickExtent[2] * pixelSize;
+        brick.resize(std::max(brickBytes, rowSize));
+        if (information.Offset == 0)
+        {
+          DispatchComponentType(header.ComponentType, [&](auto * pixelType) {
+            using PixelType = typename std::remove_pointer<decltype(pixelType)>::type;
+            FillPixels<PixelType>(brick.data(), last[0] - first[0], information.Minimum);
+          });
+        }
+        else
+        {
+          file.seekg(static_cast<std::streamoff>(information.Offset));
+          if (!file.read(brick.data(), brickBytes))
+          {
+            return false;
+          }
+        }
+
+        for (SizeValueType z = first[2]; z < last[2]; ++z)
+        {
+          for (SizeValueType y = first[1]; y < last[1]; ++y)
+          {
+            const SizeValueType outIndex =
+              ((z - start[2]) * region.GetSize(1) + (y - start[1])) * region.GetSize(0) + (first[0] - start[0]);
+            const SizeValueType brickOffset =
+              (information.Offset == 0)
+                ? 0
+                : (((z - origin[2]) * brickExtent[1] + (y - origin[1])) * brickExtent[0] + (first[0] - origin[0])) *
+                    pixelSize;
+            std::memcpy(out + outIndex * pixelSize, brick.data() + brickOffset, rowSize);
+          }
+        }
+      }
+    }
+  }
+
+  return true;
+}
+
+} // end namespace itk
@@ -0,0 +1,248 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         https://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkScancoCompositeReader.h"
+#include "itkMath.h"
+#include "itkMultiThreaderBase.h"
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+
+namespace itk
+{
+
+ScancoCompositeReader::ScancoCompositeReader()
+  : m_NumberOfWorkUnits(MultiThreaderBase::GetGlobalDefaultNumberOfThreads())
+{}
+
+
+void
+ScancoCompositeReader::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "FileNames: " << this->m_FileNames.size() << std::endl;
+  os << indent << "NumberOfWorkUnits: " << this->m_NumberOfWorkUnits << std::endl;
+  os << indent << "ComponentType: " << ImageIOBase::GetComponentTypeAsString(this->m_ComponentType) << std::endl;
+  os << indent << "Dimensions: " << this->m_Dimensions[0] << ' ' << this->m_Dimensions[1] << ' '
+     << this->m_Dimensions[2] << std::endl;
+}
+
+
+void
+ScancoCompositeReader::SetFileNames(const FileNamesContainer & fileNames)
+{
+  this->m_FileNames = fileNames;
+  this->m_Headers.clear();
+  this->Modified();
+}
+
+
+void
+ScancoCompositeReader::AddFileName(const std::string & fileName)
+{
+  this->m_FileNames.push_back(fileName);
+  this->m_Headers.clear();
+  this->Modified();
+}
+
+
+ScancoCompositeReader::HeaderPointer
+ScancoCompositeReader::GetHeader(SizeValueType file) const
+{
+  return (file < this->m_Headers.size() ? this->m_Headers[file] : nullptr);
+}
+
+
+void
+ScancoCompositeReader::UpdateInformation()
+{
+  if (this->m_Headers.empty())
+  {
+    this->ReadInformation();
+  }
+}
+
+
+void
+ScancoCompositeReader::ReadInformation()
+{
+  this->m_Headers.clear();
+  if (this->m_FileNames.empty())
+  {
+    itkExceptionMacro("No file names have been set.");
+  }
+
+  const SizeValueType        numberOfFiles = this->m_FileNames.size();
+  std::vector<HeaderPointer> headers(numberOfFiles);
+  std::mutex                 errorMutex;
+  std::string                errorMessage;
+  MultiThreaderBase::Pointer threader = MultiThreaderBase::New();
+  threader->SetNumberOfWorkUnits(this->m_NumberOfWorkUnits);
+  threader->ParallelizeArray(
+    0,
+    numberOfFiles,
+    [&](SizeValueType i) {
+      try
+      {
+        headers[i] = ScancoImageIO::ReadHeader(this->m_FileNames[i]);
+      }
+      catch (const ExceptionObject & error)
+      {
+        std::lock_guard<std::mutex> lock(errorMutex);
+        errorMessage = error.GetDescription();
+      }
+    },
+    nullptr);
+  if (!errorMessage.empty())
+  {
+    itkExceptionMacro(<< errorMessage);
+  }
+
+  // Place each file in the voxel grid: AIM files by the position of their
+  // crop, ISQ files by the start position of their first slice
+  const ScancoHeader &   first = *headers[0];
+  std::vector<IndexType> indices(numberOfFiles);
+  IndexType              lower;
+  IndexType              upper;
+  for (SizeValueType f = 0; f < numberOfFiles; ++f)
+  {
+    const ScancoHeader & header = *headers[f];
+    bool                 matches = (header.ComponentType == first.ComponentType);
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+      matches = matches && itk::Math::abs(header.Spacing[i] - first.Spacing[i]) <= 1e-4 * first.Spacing[i];
+      if (header.FileType == 1)
+      {
+        indices[f][i] = (i == 2 ? Math::Round<IndexValueType>(header.StartPosition / header.Spacing[2]) : 0);
+      }
+      else
+      {
+        indices[f][i] = Math::Round<IndexValueType>(header.Origin[i] / header.Spacing[i]);
+      }
+      const IndexValueType end = indices[f][i] + static_cast<IndexValueType>(header.Dimensions[i]);
+      lower[i] = (f == 0 ? indices[f][i] : std::min(lower[i], indices[f][i]));
+      upper[i] = (f == 0 ? end : std::max(upper[i], end));
+    }
+    if (!matches)
+    {
+      itkExceptionMacro("The spacing or pixel type of " << this->m_FileNames[f] << " differ from those of "
+                                                         << this->m_FileNames[0]);
+    }
+  }
+
+  ScancoImageIO::Pointer imageIO = ScancoImageIO::New();
+  imageIO->SetFileName(this->m_FileNames[0]);
+  imageIO->SetHeader(headers[0]);
+  this->m_ComponentType = first.ComponentType;
+  this->m_ComponentSize = imageIO->GetComponentSize();
+  this->m_ImageSizeInBytes = this->m_ComponentSize;
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    this->m_Dimensions[i] = static_cast<SizeValueType>(upper[i] - lower[i]);
+    this->m_Spacing[i] = first.Spacing[i];
+    this->m_Origin[i] = lower[i] * first.Spacing[i];
+    this->m_ImageSizeInBytes *= this->m_Dimensions[i];
+    for (IndexType & index : indices)
+    {
+      index[i] -= lower[i];
+    }
+  }
+  this->m_FileIndices = std::move(indices);
+  this->m_Headers = std::move(headers);
+}
+
+
+void
+ScancoCompositeReader::Read(void * buffer)
+{
+  this->UpdateInformation();
+
+  // Files that overlap an earlier file are decoded in a later wave than it
+  const SizeValueType        numberOfFiles = this->m_Headers.size();
+  std::vector<SizeValueType> waves(numberOfFiles, 0);
+  for (SizeValueType f = 1; f < numberOfFiles; ++f)
+  {
+    for (SizeValueType g = 0; g < f; ++g)
+    {
+      bool overlaps = true;
+      for (unsigned int i = 0; i < 3; ++i)
+      {
+        overlaps = overlaps &&
+                   this->m_FileIndices[f][i] <
+                     this->m_FileIndices[g][i] + static_cast<IndexValueType>(this->m_Headers[g]->Dimensions[i]) &&
+                   this->m_FileIndices[g][i] <
+                     this->m_FileIndices[f][i] + static_cast<IndexValueType>(this->m_Headers[f]->Dimensions[i]);
+      }
+      if (overlaps)
+      {
+        waves[f] = std::max(waves[f], waves[g] + 1);
+      }
+    }
+  }
+
+  std::memset(buffer, 0, this->m_ImageSizeInBytes);
+
+  const SizeValueType        rowStride = this->m_Dimensions[0];
+  const SizeValueType        sliceStride = rowStride * this->m_Dimensions[1];
+  std::mutex                 errorMutex;
+  std::string                errorMessage;
+  MultiThreaderBase::Pointer threader = MultiThreaderBase::New();
+  threader->SetNumberOfWorkUnits(this->m_NumberOfWorkUnits);
+  const SizeValueType numberOfWaves = *std::max_element(waves.begin(), waves.end()) + 1;
+  for (SizeValueType wave = 0; wave < numberOfWaves && errorMessage.empty(); ++wave)
+  {
+    std::vector<SizeValueType> files;
+    for (SizeValueType f = 0; f < numberOfFiles; ++f)
+    {
+      if (waves[f] == wave)
+      {
+        files.push_back(f);
+      }
+    }
+    threader->ParallelizeArray(
+      0,
+      files.size(),
+      [&](SizeValueType i) {
+        const SizeValueType f = files[i];
+        const IndexType &   index = this->m_FileIndices[f];
+        const SizeValueType offset = index[2] * sliceStride + index[1] * rowStride + index[0];
+        char *              target = static_cast<char *>(buffer) + offset * this->m_ComponentSize;
+        try
+        {
+          ScancoImageIO::Pointer imageIO = ScancoImageIO::New();
+          imageIO->SetFileName(this->m_FileNames[f]);
+          imageIO->SetHeader(this->m_Headers[f]);
+          imageIO->ReadStrided(target, rowStride, sliceStride);
+        }
+        catch (const ExceptionObject & error)
+        {
+          std::lock_guard<std::mutex> lock(errorMutex);
+          errorMessage = error.GetDescription();
+        }
+      },
+      nullptr);
+  }
+  if (!errorMessage.empty())
+  {
+    itkExceptionMacro(<< errorMessage);
+  }
+}
+
+} // end namespace itk
@@ -0,0 +1,337 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         https://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkScancoDensityStatisticsCalculator.h"
+#include "itkByteSwapper.h"
+#include "itkMath.h"
+#include "itkMultiThreaderBase.h"
+#include "itkScancoSliceReader.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <mutex>
+
+namespace itk
+{
+
+namespace
+{
+
+// Sums of the stored values of one label in one slab, which are exact
+struct SlabSums
+{
+  SizeValueType Count{ 0 };
+  std::int64_t  Sum{ 0 };
+  std::uint64_t SumOfSquares{ 0 };
+  int           Minimum{ std::numeric_limits<short>::max() };
+  int           Maximum{ std::numeric_limits<short>::min() };
+};
+
+} // end anonymous namespace
+
+
+ScancoDensityStatisticsCalculator::ScancoDensityStatisticsCalculator()
+  : m_NumberOfWorkUnits(MultiThreaderBase::GetGlobalDefaultNumberOfThreads())
+{}
+
+
+void
+ScancoDensityStatisticsCalculator::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "FileName: " << this->m_FileName << std::endl;
+  os << indent << "MaskFileName: " << this->m_MaskFileName << std::endl;
+  os << indent << "UseCalibration: " << (this->m_UseCalibration ? "On" : "Off") << std::endl;
+  os << indent << "NumberOfHistogramBins: " << this->m_NumberOfHistogramBins << std::endl;
+  os << indent << "HistogramMinimum: " << this->m_HistogramMinimum << std::endl;
+  os << indent << "HistogramMaximum: " << this->m_HistogramMaximum << std::endl;
+  os << indent << "NumberOfSlicesPerSlab: " << this->m_NumberOfSlicesPerSlab << std::endl;
+  os << indent << "NumberOfWorkUnits: " << this->m_NumberOfWorkUnits << std::endl;
+  os << indent << "DensitySlope: " << this->m_DensitySlope << std::endl;
+  os << indent << "DensityIntercept: " << this->m_DensityIntercept << std::endl;
+  os << indent << "Labels: " << this->m_Statistics.size() << std::endl;
+}
+
+
+const ScancoDensityStatisticsCalculator::LabelStatistics &
+ScancoDensityStatisticsCalculator::GetStatistics(int label) const
+{
+  const auto found = this->m_Statistics.find(label);
+  if (found == this->m_Statistics.end())
+  {
+    itkExceptionMacro("Label " << label << " was not found.");
+  }
+  return found->second;
+}
+
+
+void
+ScancoDensityStatisticsCalculator::Compute()
+{
+  this->m_Statistics.clear();
+  if (this->m_FileName.empty() || this->m_MaskFileName.empty())
+  {
+    itkExceptionMacro("FileName and MaskFileName must be set.");
+  }
+  if (this->m_NumberOfHistogramBins == 0 || !(this->m_HistogramMaximum > this->m_HistogramMinimum))
+  {
+    itkExceptionMacro("Invalid histogram of " << this->m_NumberOfHistogramBins << " bins from "
+                                              << this->m_HistogramMinimum << " to " << this->m_HistogramMaximum);
+  }
+  if (this->m_NumberOfSlicesPerSlab == 0)
+  {
+    itkExceptionMacro("NumberOfSlicesPerSlab must not be 0.");
+  }
+
+  const ScancoImageIO::HeaderPointer header = ScancoImageIO::ReadHeader(this->m_FileName);
+  if (header->PixelType != IOPixelEnum::SCALAR || header->ComponentType != IOComponentEnum::SHORT ||
+      header->Compression != 0)
+  {
+    itkExceptionMacro("The gray scale file must hold uncompressed short data: " << this->m_FileName);
+  }
+
+  // The mask is read one slice at a time, run-length data from checkpoints
+  ScancoSliceReader::Pointer maskReader = ScancoSliceReader::New();
+  maskReader->SetFileName(this->m_MaskFileName);
+  maskReader->SetMaximumNumberOfCachedSlices(1);
+  maskReader->SetNumberOfPrefetchedSlices(0);
+  maskReader->Open();
+  const ScancoImageIO::HeaderPointer maskHeader = maskReader->GetHeader();
+  if (maskHeader->PixelType != IOPixelEnum::SCALAR || (maskHeader->ComponentType != IOComponentEnum::CHAR &&
+                                                        maskHeader->ComponentType != IOComponentEnum::UCHAR))
+  {
+    itkExceptionMacro("The mask must hold 8-bit data: " << this->m_MaskFileName);
+  }
+
+  // Place the mask in the grid of the gray scale file
+  IndexValueType maskIndex[3];
+  IndexValueType maskEnd[3];
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    if (std::abs(maskHeader->Spacing[i] - header->Spacing[i]) > 1e-4 * std::abs(header->Spacing[i]))
+    {
+      itkExceptionMacro("The spacing of " << this->m_MaskFileName << " does not match that of "
+                                          << this->m_FileName);
+    }
+    maskIndex[i] = Math::Round<IndexValueType>(maskHeader->Origin[i] / maskHeader->Spacing[i]) -
+                   Math::Round<IndexValueType>(header->Origin[i] / header->Spacing[i]);
+    maskEnd[i] = maskIndex[i] + static_cast<IndexValueType>(maskHeader->Dimensions[i]);
+  }
+  const bool isSigned = (maskHeader->ComponentType == IOComponentEnum::CHAR);
+
+  this->m_DensitySlope = 1.0;
+  this->m_DensityIntercept = 0.0;
+  if (this->m_UseCalibration)
+  {
+    this->m_DensitySlope = header->DensitySlope;
+    if (header->MuScaling > 1.0)
+    {
+      this->m_DensitySlope /= header->MuScaling;
+    }
+    this->m_DensityIntercept = header->DensityIntercept;
+  }
+  const double slope = this->m_DensitySlope;
+  const double intercept = this->m_DensityIntercept;
+
+  // The histogram bin of every stored value
+  const SizeValueType        numberOfBins = this->m_NumberOfHistogramBins;
+  const double               binWidth = (this->m_HistogramMaximum - this->m_HistogramMinimum) / numberOfBins;
+  std::vector<SizeValueType> binOfValue(65536);
+  for (int value = std::numeric_limits<short>::min(); value <= std::numeric_limits<short>::max(); ++value)
+  {
+    const double bin = std::floor((slope * value + intercept - this->m_HistogramMinimum) / binWidth);
+    binOfValue[value + 32768] =
+      (bin < 0.0 ? 0 : (bin >= numberOfBins ? numberOfBins - 1 : static_cast<SizeValueType>(bin)));
+  }
+
+  const SizeValueType xsize = header->Dimensions[0];
+  const SizeValueType ysize = header->Dimensions[1];
+  const SizeValueType zsize = header->Dimensions[2];
+  const SizeValueType sliceVoxels = xsize * ysize;
+  const SizeValueType maskXSize = maskHeader->Dimensions[0];
+  const SizeValueType slabSize = this->m_NumberOfSlicesPerSlab;
+  const SizeValueType numberOfSlabs = (zsize + slabSize - 1) / slabSize;
+  // the columns of gray rows that the mask covers
+  const SizeValueType maskBegin = static_cast<SizeValueType>(std::max<IndexValueType>(0, maskIndex[0]));
+  const SizeValueType maskStop =
+    static_cast<SizeValueType>(std::max<IndexValueType>(0, std::min<IndexValueType>(maskEnd[0], xsize)));
+  const SizeValueType maskFirstColumn =
+    static_cast<SizeValueType>(static_cast<IndexValueType>(maskBegin) - maskIndex[0]);
+
+  std::vector<std::vector<SlabSums>>      slabSums(numberOfSlabs);
+  std::vector<std::vector<SizeValueType>> histograms(256);
+  std::mutex                              mutex;
+  std::string                             errorMessage;
+  MultiThreaderBase::Pointer              threader = MultiThreaderBase::New();
+  threader->SetNumberOfWorkUnits(this->m_NumberOfWorkUnits);
+  threader->ParallelizeArray(
+    0,
+    numberOfSlabs,
+    [&](SizeValueType slab) {
+      const SizeValueType firstSlice = slab * slabSize;
+      const SizeValueType endSlice = std::min(zsize, firstSlice + slabSize);
+
+      std::vector<SlabSums>                   sums(256);
+      std::vector<std::vector<SizeValueType>> slabHistograms(256);
+      auto                                    add = [&](unsigned char label, short value) {
+        SlabSums & labelSums = sums[label];
+        if (labelSums.Count++ == 0)
+        {
+          slabHistograms[label].assign(numberOfBins, 0);
+        }
+        labelSums.Sum += value;
+        labelSums.SumOfSquares += static_cast<std::uint64_t>(static_cast<std::int64_t>(value) * value);
+        labelSums.Minimum = std::min<int>(labelSums.Minimum, value);
+        labelSums.Maximum = std::max<int>(labelSums.Maximum, value);
+        ++slabHistograms[label][binOfValue[value + 32768]];
+      };
+
+      try
+      {
+        std::ifstream grayFile(this->m_FileName.c_str(), std::ios::in | std::ios::binary);
+        if (!grayFile.is_open())
+        {
+          itkExceptionMacro("Could not open file for reading: " << this->m_FileName);
+        }
+        std::vector<short> gray(sliceVoxels * (endSlice - firstSlice));
+        grayFile.seekg(static_cast<std::streamoff>(header->HeaderSize + firstSlice * sliceVoxels * sizeof(short)));
+        grayFile.read(reinterpret_cast<char *>(gray.data()), gray.size() * sizeof(short));
+        if (static_cast<SizeValueType>(grayFile.gcount()) != gray.size() * sizeof(short))
+        {
+          itkExceptionMacro("File is truncated: " << this->m_FileName);
+        }
+        ByteSwapper<short>::SwapRangeFromSystemToLittleEndian(gray.data(), gray.size());
+
+        std::vector<unsigned char> maskSlice(maskXSize * maskHeader->Dimensions[1]);
+        for (SizeValueType z = firstSlice; z < endSlice; ++z)
+        {
+          const short *        graySlice = gray.data() + (z - firstSlice) * sliceVoxels;
+          const IndexValueType maskZ = static_cast<IndexValueType>(z) - maskIndex[2];
+          const bool           sliceInMask = (maskZ >= 0 && static_cast<IndexValueType>(z) < maskEnd[2]);
+          if (sliceInMask)
+          {
+            maskReader->ReadSlice(maskZ, maskSlice.data());
+          }
+          for (SizeValueType y = 0; y < ysize; ++y)
+          {
+            const short *        row = graySlice + y * xsize;
+            const IndexValueType maskY = static_cast<IndexValueType>(y) - maskIndex[1];
+            const bool rowInMask = (sliceInMask && maskY >= 0 && static_cast<IndexValueType>(y) < maskEnd[1]);
+            if (!rowInMask || maskBegin >= maskStop)
+            {
+              for (SizeValueType x = 0; x < xsize; ++x)
+              {
+                add(0, row[x]);
+              }
+              continue;
+            }
+            const unsigned char * maskRow = maskSlice.data() + maskY * maskXSize + maskFirstColumn;
+            for (SizeValueType x = 0; x < maskBegin; ++x)
+            {
+              add(0, row[x]);
+            }
+            for (SizeValueType x = maskBegin; x < maskStop; ++x)
+            {
+              add(maskRow[x - maskBegin], row[x]);
+            }
+            for (SizeValueType x = maskStop; x < xsize; ++x)
+            {
+              add(0, row[x]);
+            }
+          }
+        }
+      }
+      catch (const ExceptionObject & error)
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        errorMessage = error.GetDescription();
+        return;
+      }
+
+      std::lock_guard<std::mutex> lock(mutex);
+      for (unsigned int label = 0; label < 256; ++label)
+      {
+        if (slabHistograms[label].empty())
+        {
+          continue;
+        }
+        if (histograms[label].empty())
+        {
+          histograms[label].swap(slabHistograms[label]);
+          continue;
+        }
+        for (SizeValueType bin = 0; bin < numberOfBins; ++bin)
+        {
+          histograms[label][bin] += slabHistograms[label][bin];
+        }
+      }
+      slabSums[slab].swap(sums);
+    },
+    nullptr);
+  if (!errorMessage.empty())
+  {
+    itkExceptionMacro(<< errorMessage);
+  }
+
+  // Combine the slabs in order, so that the result does not depend on
+  // which work unit finished first (Chan et al.)
+  for (unsigned int label = 0; label < 256; ++label)
+  {
+    SizeValueType count = 0;
+    double        mean = 0.0;
+    double        sumOfSquaredDeviations = 0.0;
+    int           minimum = std::numeric_limits<short>::max();
+    int           maximum = std::numeric_limits<short>::min();
+    for (const std::vector<SlabSums> & sums : slabSums)
+    {
+      const SlabSums & labelSums = sums[label];
+      if (labelSums.Count == 0)
+      {
+        continue;
+      }
+      const double        slabMean = static_cast<double>(labelSums.Sum) / labelSums.Count;
+      const double        slabDeviations = static_cast<double>(labelSums.SumOfSquares) - labelSums.Sum * slabMean;
+      const SizeValueType total = count + labelSums.Count;
+      const double        delta = slabMean - mean;
+      mean += delta * labelSums.Count / total;
+      sumOfSquaredDeviations += slabDeviations + delta * delta * (static_cast<double>(count) * labelSums.Count / total);
+      count = total;
+      minimum = std::min(minimum, labelSums.Minimum);
+      maximum = std::max(maximum, labelSums.Maximum);
+    }
+    if (count == 0)
+    {
+      continue;
+    }
+
+    LabelStatistics & statistics =
+      this->m_Statistics[isSigned ? static_cast<int>(static_cast<signed char>(label)) : static_cast<int>(label)];
+    statistics.Count = count;
+    statistics.Mean = slope * mean + intercept;
+    statistics.Variance =
+      (count > 1 ? slope * slope * std::max(0.0, sumOfSquaredDeviations) / static_cast<double>(count - 1) : 0.0);
+    statistics.Minimum = slope * (slope < 0.0 ? maximum : minimum) + intercept;
+    statistics.Maximum = slope * (slope < 0.0 ? minimum : maximum) + intercept;
+    statistics.Histogram.swap(histograms[label]);
+  }
+}
+
+} // end namespace itk
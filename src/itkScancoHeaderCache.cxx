@@ -0,0 +1,510 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         https://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkScancoHeaderCache.h"
+#include "itkScancoImageIO.h"
+#include "itkScancoTemporaryFile.h"
+#include "itksys/SystemTools.hxx"
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <type_traits>
+#include <vector>
+
+namespace itk
+{
+namespace
+{
+const char          cacheFileMagic[8] = { 'S', 'C', 'A', 'N', 'C', 'O', 'H', 'C' };
+const std::uint32_t cacheFileVersion = 2;
+
+template <typename T>
+void
+WriteValue(std::ostream & os, const T & value)
+{
+  os.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template <typename T>
+bool
+ReadValue(std::istream & is, T & value)
+{
+  return static_cast<bool>(is.read(reinterpret_cast<char *>(&value), sizeof(T)));
+}
+
+// Call visitor(name, member) for each member of the header that is stored in
+// a cache file. A member that is added to ScancoHeader must be added here.
+template <typename THeader, typename TVisitor>
+void
+VisitHeaderFields(THeader & header, TVisitor & visitor)
+{
+  visitor("FileType", header.FileType);
+  visitor("Version", header.Version);
+  visitor("PatientName", header.PatientName);
+  visitor("PatientIndex", header.PatientIndex);
+  visitor("ScannerID", header.ScannerID);
+  visitor("CreationDate", header.CreationDate);
+  visitor("ModificationDate", header.ModificationDate);
+  visitor("ScanDimensionsPixels", header.ScanDimensionsPixels);
+  visitor("ScanDimensionsPhysical", header.ScanDimensionsPhysical);
+  visitor("SliceThickness", header.SliceThickness);
+  visitor("SliceIncrement", header.SliceIncrement);
+  visitor("StartPosition", header.StartPosition);
+  visitor("EndPosition", header.EndPosition);
+  visitor("ZPosition", header.ZPosition);
+  visitor("DataRange", header.DataRange);
+  visitor("MuScaling", header.MuScaling);
+  visitor("NumberOfSamples", header.NumberOfSamples);
+  visitor("NumberOfProjections", header.NumberOfProjections);
+  visitor("ScanDistance", header.ScanDistance);
+  visitor("SampleTime", header.SampleTime);
+  visitor("ScannerType", header.ScannerType);
+  visitor("MeasurementIndex", header.MeasurementIndex);
+  visitor("Site", header.Site);
+  visitor("ReconstructionAlg", header.ReconstructionAlg);
+  visitor("ReferenceLine", header.ReferenceLine);
+  visitor("Energy", header.Energy);
+  visitor("Intensity", header.Intensity);
+  visitor("RescaleType", header.RescaleType);
+  visitor("RescaleUnits", header.RescaleUnits);
+  visitor("CalibrationData", header.CalibrationData);
+  visitor("RescaleSlope", header.RescaleSlope);
+  visitor("RescaleIntercept", header.RescaleIntercept);
+  visitor("MuWater", header.MuWater);
+  visitor("DensitySlope", header.DensitySlope);
+  visitor("DensityIntercept", header.DensityIntercept);
+  visitor("Dimensions", header.Dimensions);
+  visitor("Spacing", header.Spacing);
+  visitor("Origin", header.Origin);
+  visitor("ComponentType", header.ComponentType);
+  visitor("PixelType", header.PixelType);
+  visitor("Compression", header.Compression);
+  visitor("HeaderSize", header.HeaderSize);
+}
+
+// Each field is stored with a fixed size: text as its characters, integers
+// and enumerations as 64-bit integers, and reals as doubles.
+void
+WriteField(std::ostream & os, double value)
+{
+  WriteValue(os, value);
+}
+
+template <typename T>
+typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value>::type
+WriteField(std::ostream & os, T value)
+{
+  WriteValue(os, static_cast<std::int64_t>(value));
+}
+
+template <size_t N>
+void
+WriteField(std::ostream & os, const char (&value)[N])
+{
+  os.write(value, N);
+}
+
+template <typename T, size_t N>
+void
+WriteField(std::ostream & os, const T (&value)[N])
+{
+  for (const T & element : value)
+  {
+    WriteField(os, element);
+  }
+}
+
+bool
+ReadField(std::istream & is, double & value)
+{
+  return ReadValue(is, value);
+}
+
+template <typename T>
+typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value, bool>::type
+ReadField(std::istream & is, T & value)
+{
+  std::int64_t stored = 0;
+  if (!ReadValue(is, stored))
+  {
+    return false;
+  }
+  value = static_cast<T>(stored);
+  return true;
+}
+
+template <size_t N>
+bool
+ReadField(std::istream & is, char (&value)[N])
+{
+  return is.read(value, N) && value[N - 1] == '\0';
+}
+
+template <typename T, size_t N>
+bool
+ReadField(std::istream & is, T (&value)[N])
+{
+  for (T & element : value)
+  {
+    if (!ReadField(is, element))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+// The number of bytes that a field takes in a cache file
+template <typename T>
+std::uint32_t
+GetFieldSize(const T &)
+{
+  return 8;
+}
+
+template <size_t N>
+std::uint32_t
+GetFieldSize(const char (&)[N])
+{
+  return N;
+}
+
+template <typename T, size_t N>
+std::uint32_t
+GetFieldSize(const T (&value)[N])
+{
+  return N * GetFieldSize(value[0]);
+}
+
+struct FieldWriter
+{
+  std::ostream & Stream;
+
+  template <typename T>
+  void
+  operator()(const char *, const T & value)
+  {
+    WriteField(this->Stream, value);
+  }
+};
+
+struct FieldReader
+{
+  std::istream & Stream;
+  bool           Good;
+
+  template <typename T>
+  void
+  operator()(const char *, T & value)
+  {
+    this->Good = this->Good && ReadField(this->Stream, value);
+  }
+};
+
+// A hash of the names and stored sizes of the fields, so that files written
+// with a different field list are rejected
+struct FieldSignature
+{
+  std::uint64_t Hash;
+
+  void
+  Add(const char * bytes, size_t size)
+  {
+    for (size_t i = 0; i < size; ++i)
+    {
+      this->Hash = (this->Hash ^ static_cast<unsigned char>(bytes[i])) * 1099511628211ULL;
+    }
+  }
+
+  template <typename T>
+  void
+  operator()(const char * name, const T & value)
+  {
+    const std::uint32_t size = GetFieldSize(value);
+    this->Add(name, std::strlen(name) + 1);
+    this->Add(reinterpret_cast<const char *>(&size), sizeof(size));
+  }
+};
+
+std::uint64_t
+GetFieldSignature()
+{
+  const ScancoHeader header;
+  FieldSignature     signature{ 14695981039346656037ULL };
+  VisitHeaderFields(header, signature);
+  return signature.Hash;
+}
+} // end anonymous namespace
+
+
+ScancoHeaderCache &
+ScancoHeaderCache::GetInstance()
+{
+  static ScancoHeaderCache instance;
+  return instance;
+}
+
+
+bool
+ScancoHeaderCache::GetFileKey(const std::string & fileName,
+                              std::string &       path,
+                              SizeValueType &     size,
+                              long &              modifiedTime)
+{
+  if (!itksys::SystemTools::FileExists(fileName, true))
+  {
+    return false;
+  }
+  path = itksys::SystemTools::GetRealPath(fileName);
+  size = itksys::SystemTools::FileLength(fileName);
+  modifiedTime = itksys::SystemTools::ModifiedTime(fileName);
+  return true;
+}
+
+
+ScancoHeaderCache::HeaderPointer
+ScancoHeaderCache::GetHeader(const std::string & fileName)
+{
+  std::string   path;
+  SizeValueType size;
+  long          modifiedTime;
+  if (!ScancoHeaderCache::GetFileKey(fileName, path, size, modifiedTime))
+  {
+    return nullptr;
+  }
+
+  std::lock_guard<std::mutex> lock(this->m_Mutex);
+  const auto                  it = this->m_Entries.find(path);
+  if (it == this->m_Entries.end())
+  {
+    return nullptr;
+  }
+  if (it->second.Size != size || it->second.ModifiedTime != modifiedTime)
+  {
+    this->m_Order.erase(it->second.Position);
+    this->m_Entries.erase(it);
+    return nullptr;
+  }
+  this->m_Order.splice(this->m_Order.begin(), this->m_Order, it->second.Position);
+  return it->second.Header;
+}
+
+
+void
+ScancoHeaderCache::AddHeader(const std::string & fileName, const HeaderPointer & header)
+{
+  std::string   path;
+  SizeValueType size;
+  long          modifiedTime;
+  if (header == nullptr || !ScancoHeaderCache::GetFileKey(fileName, path, size, modifiedTime))
+  {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(this->m_Mutex);
+  this->AddEntry(path, size, modifiedTime, header);
+  this->Prune();
+}
+
+
+ScancoHeaderCache::HeaderPointer
+ScancoHeaderCache::ReadHeader(const std::string & fileName)
+{
+  HeaderPointer header = this->GetHeader(fileName);
+  if (header == nullptr)
+  {
+    header = ScancoImageIO::ReadHeader(fileName);
+    this->AddHeader(fileName, header);
+  }
+  return header;
+}
+
+
+void
+ScancoHeaderCache::AddEntry(const std::string & path,
+                            SizeValueType       size,
+                            long                modifiedTime,
+                            const HeaderPointer & header)
+{
+  auto it = this->m_Entries.find(path);
+  if (it == this->m_Entries.end())
+  {
+    this->m_Order.push_front(path);
+    it = this->m_Entries.emplace(path, Entry{ size, modifiedTime, header, this->m_Order.begin() }).first;
+  }
+  else
+  {
+    it->second.Size = size;
+    it->second.ModifiedTime = modifiedTime;
+    it->second.Header = header;
+    this->m_Order.splice(this->m_Order.begin(), this->m_Order, it->second.Position);
+  }
+}
+
+
+void
+ScancoHeaderCache::Prune()
+{
+  while (this->m_Entries.size() > this->m_MaximumNumberOfEntries)
+  {
+    this->m_Entries.erase(this->m_Order.back());
+    this->m_Order.pop_back();
+  }
+}
+
+
+void
+ScancoHeaderCache::SetMaximumNumberOfEntries(SizeValueType maximumNumberOfEntries)
+{
+  std::lock_guard<std::mutex> lock(this->m_Mutex);
+  this->m_MaximumNumberOfEntries = maximumNumberOfEntries;
+  this->Prune();
+}
+
+
+SizeValueType
+ScancoHeaderCache::GetMaximumNumberOfEntries() const
+{
+  std::lock_guard<std::mutex> lock(this->m_Mutex);
+  return this->m_MaximumNumberOfEntries;
+}
+
+
+SizeValueType
+ScancoHeaderCache::GetNumberOfEntries() const
+{
+  std::lock_guard<std::mutex> lock(this->m_Mutex);
+  return this->m_Entries.size();
+}
+
+
+void
+ScancoHeaderCache::Clear()
+{
+  std::lock_guard<std::mutex> lock(this->m_Mutex);
+  this->m_Entries.clear();
+  this->m_Order.clear();
+}
+
+
+void
+ScancoHeaderCache::Save(const std::string & fileName) const
+{
+  // Write to a temporary file first, so that a cache file is never left
+  // half written
+  ScancoTemporaryFile temporaryFile(fileName);
+  std::ofstream       file(temporaryFile.GetFileName().c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!file.is_open())
+  {
+    itkGenericExceptionMacro("Could not open header cache for writing: " << temporaryFile.GetFileName());
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(this->m_Mutex);
+    file.write(cacheFileMagic, sizeof(cacheFileMagic));
+    WriteValue(file, cacheFileVersion);
+    WriteValue(file, GetFieldSignature());
+    WriteValue(file, static_cast<std::uint64_t>(this->m_Order.size()));
+    for (const auto & path : this->m_Order)
+    {
+      const Entry & entry = this->m_Entries.find(path)->second;
+      WriteValue(file, static_cast<std::uint32_t>(path.size()));
+      file.write(path.data(), path.size());
+      WriteValue(file, static_cast<std::uint64_t>(entry.Size));
+      WriteValue(file, static_cast<std::int64_t>(entry.ModifiedTime));
+      FieldWriter writer{ file };
+      VisitHeaderFields(*entry.Header, writer);
+    }
+  }
+
+  file.close();
+  if (file.fail())
+  {
+    itkGenericExceptionMacro("Could not write header cache: " << temporaryFile.GetFileName());
+  }
+  temporaryFile.Commit();
+}
+
+
+void
+ScancoHeaderCache::Load(const std::string & fileName)
+{
+  std::ifstream file(fileName.c_str(), std::ios::in | std::ios::binary);
+  if (!file.is_open())
+  {
+    itkGenericExceptionMacro("Could not open header cache for reading: " << fileName);
+  }
+
+  char          magic[sizeof(cacheFileMagic)];
+  std::uint32_t version = 0;
+  std::uint64_t signature = 0;
+  std::uint64_t numberOfEntries = 0;
+  if (!file.read(magic, sizeof(magic)) || std::memcmp(magic, cacheFileMagic, sizeof(magic)) != 0 ||
+      !ReadValue(file, version) || version != cacheFileVersion || !ReadValue(file, signature) ||
+      signature != GetFieldSignature() || !ReadValue(file, numberOfEntries))
+  {
+    itkGenericExceptionMacro("Not a header cache written by this version of IOScanco: " << fileName);
+  }
+
+  struct LoadedEntry
+  {
+    std::string   Path;
+    std::uint64_t Size;
+    std::int64_t  ModifiedTime;
+    HeaderPointer Header;
+  };
+  std::vector<LoadedEntry> entries;
+  for (std::uint64_t i = 0; i < numberOfEntries; ++i)
+  {
+    LoadedEntry   entry;
+    std::uint32_t pathLength = 0;
+    auto          header = std::make_shared<ScancoHeader>();
+    if (!ReadValue(file, pathLength))
+    {
+      break;
+    }
+    entry.Path.resize(pathLength);
+    if (!file.read(&entry.Path[0], pathLength) || !ReadValue(file, entry.Size) || !ReadValue(file, entry.ModifiedTime))
+    {
+      break;
+    }
+    FieldReader reader{ file, true };
+    VisitHeaderFields(*header, reader);
+    if (!reader.Good)
+    {
+      break;
+    }
+    entry.Header = header;
+    entries.push_back(std::move(entry));
+  }
+  if (entries.size() != numberOfEntries)
+  {
+    itkGenericExceptionMacro("Header cache is truncated: " << fileName);
+  }
+
+  // Add the least recently used first, so that the order is kept
+  std::lock_guard<std::mutex> lock(this->m_Mutex);
+  for (auto it = entries.rbegin(); it != entries.rend(); ++it)
+  {
+    this->AddEntry(it->Path, it->Size, static_cast<long>(it->ModifiedTime), it->Header);
+  }
+  this->Prune();
+}
+
+} // end namespace itk
@@ -30,6 +30,11 @@
 =========================================================================*/
 
 #include "itkScancoImageIO.h"
+#include "itkScancoBrickCache.h"
+#include "itkScancoHeaderCache.h"
+#include "itkScancoRawFile.h"
+#include "itkScancoRunLengthDecoder.h"
+#include "itkScancoTemporaryFile.h"
 #include "itkSpatialOrientationAdapter.h"
 #include "itkIOCommon.h"
 #include "itksys/SystemTools.hxx"
@@ -37,12 +42,582 @@
 #include "itkIntTypes.h"
 #include "itkByteSwapper.h"
 #include "itkMetaDataObject.h"
+#include "itkMultiThreaderBase.h"
 
 #include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <cstddef>
 #include <ctime>
+#include <deque>
+#include <limits>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <type_traits>
 
 namespace itk
 {
+namespace
+{
+// The field tables address ScancoHeader members by their offset
+static_assert(std::is_standard_layout<ScancoHeader>::value, "ScancoHeader must be standard layout");
+
+using Encoding = ScancoImageIO::FieldEncoding;
+
+// Fields at the start of every ISQ and RAD header. The data type, the size,
+// the date, the dimensions and the data offset are handled separately.
+constexpr ScancoImageIO::HeaderField isqCommonFields[] = {
+  { 0, Encoding::Text, offsetof(ScancoHeader, Version), 16 },
+  { 28, Encoding::Integer, offsetof(ScancoHeader, PatientIndex), 0 },
+  { 32, Encoding::Integer, offsetof(ScancoHeader, ScannerID), 0 },
+};
+
+// The rest of the ISQ and RSQ header
+constexpr ScancoImageIO::HeaderField isqFields[] = {
+  { 68, Encoding::Micro, offsetof(ScancoHeader, SliceThickness), 0 },
+  { 72, Encoding::Micro, offsetof(ScancoHeader, SliceIncrement), 0 },
+  { 76, Encoding::Micro, offsetof(ScancoHeader, StartPosition), 0 },
+  { 80, Encoding::Real, offsetof(ScancoHeader, DataRange), 0 },
+  { 84, Encoding::Real, offsetof(ScancoHeader, DataRange) + sizeof(double), 0 },
+  { 88, Encoding::Real, offsetof(ScancoHeader, MuScaling), 0 },
+  { 92, Encoding::Integer, offsetof(ScancoHeader, NumberOfSamples), 0 },
+  { 96, Encoding::Integer, offsetof(ScancoHeader, NumberOfProjections), 0 },
+  { 100, Encoding::Micro, offsetof(ScancoHeader, ScanDistance), 0 },
+  { 104, Encoding::Integer, offsetof(ScancoHeader, ScannerType), 0 },
+  { 108, Encoding::Micro, offsetof(ScancoHeader, SampleTime), 0 },
+  { 112, Encoding::Integer, offsetof(ScancoHeader, MeasurementIndex), 0 },
+  { 116, Encoding::Integer, offsetof(ScancoHeader, Site), 0 },
+  { 120, Encoding::Micro, offsetof(ScancoHeader, ReferenceLine), 0 },
+  { 124, Encoding::Integer, offsetof(ScancoHeader, ReconstructionAlg), 0 },
+  { 128, Encoding::Text, offsetof(ScancoHeader, PatientName), 40 },
+  { 168, Encoding::Micro, offsetof(ScancoHeader, Energy), 0 },
+  { 172, Encoding::Micro, offsetof(ScancoHeader, Intensity), 0 },
+};
+
+// The rest of the RAD header
+constexpr ScancoImageIO::HeaderField radFields[] = {
+  { 68, Encoding::Integer, offsetof(ScancoHeader, MeasurementIndex), 0 },
+  { 72, Encoding::Real, offsetof(ScancoHeader, DataRange), 0 },
+  { 76, Encoding::Real, offsetof(ScancoHeader, DataRange) + sizeof(double), 0 },
+  { 80, Encoding::Real, offsetof(ScancoHeader, MuScaling), 0 },
+  { 84, Encoding::Text, offsetof(ScancoHeader, PatientName), 40 },
+  { 124, Encoding::Micro, offsetof(ScancoHeader, ZPosition), 0 },
+  { 132, Encoding::Micro, offsetof(ScancoHeader, SampleTime), 0 },
+  { 136, Encoding::Micro, offsetof(ScancoHeader, Energy), 0 },
+  { 140, Encoding::Micro, offsetof(ScancoHeader, Intensity), 0 },
+  { 144, Encoding::Micro, offsetof(ScancoHeader, ReferenceLine), 0 },
+  { 148, Encoding::Micro, offsetof(ScancoHeader, StartPosition), 0 },
+  { 152, Encoding::Micro, offsetof(ScancoHeader, EndPosition), 0 },
+};
+
+// The data range of ISQ and of RAD files, which writing a region in place
+// updates
+constexpr ScancoImageIO::HeaderField isqDataRangeFields[] = {
+  { 80, Encoding::Real, offsetof(ScancoHeader, DataRange), 0 },
+  { 84, Encoding::Real, offsetof(ScancoHeader, DataRange) + sizeof(double), 0 },
+};
+constexpr ScancoImageIO::HeaderField radDataRangeFields[] = {
+  { 72, Encoding::Real, offsetof(ScancoHeader, DataRange), 0 },
+  { 76, Encoding::Real, offsetof(ScancoHeader, DataRange) + sizeof(double), 0 },
+};
+
+// Offsets in the 512 byte ISQ header block
+constexpr unsigned int isqDataTypeOffset = 16;
+constexpr unsigned int isqNumberOfBytesOffset = 20;
+constexpr unsigned int isqNumberOfBlocksOffset = 24;
+constexpr unsigned int isqPatientIndexOffset = 28;
+constexpr unsigned int isqDateOffset = 36;
+constexpr unsigned int isqPixelDimensionsOffset = 44;
+constexpr unsigned int isqPhysicalDimensionsOffset = 56;
+constexpr unsigned int isqStartPositionOffset = 76;
+constexpr unsigned int isqPatientNameOffset = 128;
+constexpr unsigned int radPatientNameOffset = 84;
+constexpr unsigned int isqDataOffsetOffset = 508;
+
+// The calibration block of the ISQ extended header
+constexpr ScancoImageIO::HeaderField isqCalibrationFields[] = {
+  { 28, Encoding::Text, offsetof(ScancoHeader, CalibrationData), 64 },
+  { 632, Encoding::Integer, offsetof(ScancoHeader, RescaleType), 0 },
+  { 648, Encoding::Text, offsetof(ScancoHeader, RescaleUnits), 16 },
+  { 664, Encoding::Double, offsetof(ScancoHeader, DensitySlope), 0 },
+  { 672, Encoding::Double, offsetof(ScancoHeader, DensityIntercept), 0 },
+  { 688, Encoding::Double, offsetof(ScancoHeader, MuWater), 0 },
+};
+
+// The extended ISQ header that is written with a calibration: a MultiHeader
+// block, a directory block and the calibration block
+constexpr unsigned int isqMultiHeaderOffset = 512;
+constexpr unsigned int isqDirectoryOffset = 1024;
+constexpr unsigned int isqCalibrationOffset = 1536;
+constexpr unsigned int isqCalibrationBlocks = 2;
+constexpr unsigned int isqCalibratedHeaderSize = isqCalibrationOffset + isqCalibrationBlocks * 512;
+
+// The keys of the AIM processing log that are decoded
+constexpr ScancoImageIO::AIMLogField aimLogFields[] = {
+  { "Time", Encoding::Text, offsetof(ScancoHeader, ModificationDate), 31 },
+  { "Original Creation-Date", Encoding::Text, offsetof(ScancoHeader, CreationDate), 31 },
+  { "Orig-ISQ-Dim-p", Encoding::Integer, offsetof(ScancoHeader, ScanDimensionsPixels), 3 },
+  { "Orig-ISQ-Dim-um", Encoding::Micro, offsetof(ScancoHeader, ScanDimensionsPhysical), 3 },
+  { "Patient Name", Encoding::Text, offsetof(ScancoHeader, PatientName), 41 },
+  { "Index Patient", Encoding::Integer, offsetof(ScancoHeader, PatientIndex), 1 },
+  { "Index Measurement", Encoding::Integer, offsetof(ScancoHeader, MeasurementIndex), 1 },
+  { "Site", Encoding::Integer, offsetof(ScancoHeader, Site), 1 },
+  { "Scanner ID", Encoding::Integer, offsetof(ScancoHeader, ScannerID), 1 },
+  { "Scanner type", Encoding::Integer, offsetof(ScancoHeader, ScannerType), 1 },
+  { "Position Slice 1 [um]", Encoding::Micro, offsetof(ScancoHeader, StartPosition), 1 },
+  { "No. samples", Encoding::Integer, offsetof(ScancoHeader, NumberOfSamples), 1 },
+  { "No. projections per 180", Encoding::Integer, offsetof(ScancoHeader, NumberOfProjections), 1 },
+  { "Scan Distance [um]", Encoding::Micro, offsetof(ScancoHeader, ScanDistance), 1 },
+  { "Integration time [us]", Encoding::Micro, offsetof(ScancoHeader, SampleTime), 1 },
+  { "Reference line [um]", Encoding::Micro, offsetof(ScancoHeader, ReferenceLine), 1 },
+  { "Reconstruction-Alg.", Encoding::Integer, offsetof(ScancoHeader, ReconstructionAlg), 1 },
+  { "Energy [V]", Encoding::Micro, offsetof(ScancoHeader, Energy), 1 },
+  { "Intensity [uA]", Encoding::Micro, offsetof(ScancoHeader, Intensity), 1 },
+  { "Mu_Scaling", Encoding::Real, offsetof(ScancoHeader, MuScaling), 1 },
+  { "Minimum data value", Encoding::Real, offsetof(ScancoHeader, DataRange), 1 },
+  { "Maximum data value", Encoding::Real, offsetof(ScancoHeader, DataRange) + sizeof(double), 1 },
+  { "Calib. default unit type", Encoding::Integer, offsetof(ScancoHeader, RescaleType), 1 },
+  { "Calibration Data", Encoding::Text, offsetof(ScancoHeader, CalibrationData), 64 },
+  { "Density: unit", Encoding::Text, offsetof(ScancoHeader, RescaleUnits), 16 },
+  { "Density: slope", Encoding::Real, offsetof(ScancoHeader, DensitySlope), 1 },
+  { "Density: intercept", Encoding::Real, offsetof(ScancoHeader, DensityIntercept), 1 },
+  { "HU: mu water", Encoding::Real, offsetof(ScancoHeader, MuWater), 1 },
+};
+constexpr int numberOfAIMLogFields = sizeof(aimLogFields) / sizeof(aimLogFields[0]);
+
+// The log keys are found through a perfect hash: a seeded FNV-1a hash that
+// puts every key in its own slot. If keys are added and the static_assert
+// below fails, search for another seed.
+constexpr unsigned int aimLogSlotCount = 64;
+constexpr uint32_t     aimLogHashSeed = 307;
+
+constexpr unsigned int
+HashAIMLogKey(const char * key, size_t length)
+{
+  uint32_t hash = aimLogHashSeed;
+  for (size_t i = 0; i < length; ++i)
+  {
+    hash = (hash ^ static_cast<unsigned char>(key[i])) * 16777619u;
+  }
+  return (hash >> 8) % aimLogSlotCount;
+}
+
+constexpr size_t
+StringLength(const char * text)
+{
+  size_t length = 0;
+  while (text[length] != '\0')
+  {
+    ++length;
+  }
+  return length;
+}
+
+struct AIMLogSlots
+{
+  // index into aimLogFields, or -1
+  int Field[aimLogSlotCount];
+};
+
+constexpr AIMLogSlots
+MakeAIMLogSlots()
+{
+  AIMLogSlots slots{};
+  for (unsigned int slot = 0; slot < aimLogSlotCount; ++slot)
+  {
+    slots.Field[slot] = -1;
+  }
+  for (int field = 0; field < numberOfAIMLogFields; ++field)
+  {
+    const char * key = aimLogFields[field].Key;
+    slots.Field[HashAIMLogKey(key, StringLength(key))] = field;
+  }
+  return slots;
+}
+
+constexpr AIMLogSlots aimLogSlots = MakeAIMLogSlots();
+
+constexpr bool
+AIMLogSlotsArePerfect()
+{
+  for (int field = 0; field < numberOfAIMLogFields; ++field)
+  {
+    const char * key = aimLogFields[field].Key;
+    if (aimLogSlots.Field[HashAIMLogKey(key, StringLength(key))] != field)
+    {
+      return false;
+    }
+  }
+  return true;
+}
+static_assert(AIMLogSlotsArePerfect(), "AIM log keys collide in the hash, change aimLogHashSeed");
+
+
+// The value that reading gives for a stored ISQ value, see RescaleToHU()
+inline short
+ReadBackISQValue(short stored, double slope, double intercept)
+{
+  float value = static_cast<float>(stored);
+  value = value * slope + intercept;
+  return static_cast<short>(value);
+}
+
+
+// Convert pixels to the values stored in an ISQ file. With rescaling, the
+// rescaling that reading applies is inverted. Reading truncates, so the
+// stored value that is nearest to the exact inverse does not always read back
+// as the pixel, and its neighbors are tried as well.
+template <typename TPixel>
+void
+ConvertToISQ(const TPixel * source, short * target, SizeValueType size, double slope, double intercept, bool rescale)
+{
+  constexpr double minimum = NumericTraits<short>::min();
+  constexpr double maximum = NumericTraits<short>::max();
+  for (SizeValueType i = 0; i < size; ++i)
+  {
+    const double value = static_cast<double>(source[i]);
+    double       stored = std::round(rescale ? (value - intercept) / slope : value);
+    if (!(stored >= minimum))
+    {
+      stored = minimum;
+    }
+    else if (stored > maximum)
+    {
+      stored = maximum;
+    }
+    target[i] = static_cast<short>(stored);
+    if (rescale && ReadBackISQValue(target[i], slope, intercept) != value)
+    {
+      if (stored < maximum && ReadBackISQValue(static_cast<short>(target[i] + 1), slope, intercept) == value)
+      {
+        ++target[i];
+      }
+      else if (stored > minimum && ReadBackISQValue(static_cast<short>(target[i] - 1), slope, intercept) == value)
+      {
+        --target[i];
+      }
+    }
+  }
+}
+
+
+bool
+CanConvertToISQ(IOComponentEnum componentType)
+{
+  switch (componentType)
+  {
+    case IOComponentEnum::CHAR:
+    case IOComponentEnum::UCHAR:
+    case IOComponentEnum::SHORT:
+    case IOComponentEnum::USHORT:
+    case IOComponentEnum::INT:
+    case IOComponentEnum::UINT:
+    case IOComponentEnum::FLOAT:
+    case IOComponentEnum::DOUBLE:
+      return true;
+    default:
+      return false;
+  }
+}
+
+
+// Convert size pixels of the buffer, starting at pixel first
+void
+ConvertToISQ(IOComponentEnum componentType,
+             const void *    buffer,
+             SizeValueType   first,
+             short *         target,
+             SizeValueType   size,
+             double          slope,
+             double          intercept,
+             bool            rescale)
+{
+  switch (componentType)
+  {
+    case IOComponentEnum::CHAR:
+      ConvertToISQ(static_cast<const char *>(buffer) + first, target, size, slope, intercept, rescale);
+      break;
+    case IOComponentEnum::UCHAR:
+      ConvertToISQ(static_cast<const unsigned char *>(buffer) + first, target, size, slope, intercept, rescale);
+      break;
+    case IOComponentEnum::SHORT:
+      ConvertToISQ(static_cast<const short *>(buffer) + first, target, size, slope, intercept, rescale);
+      break;
+    case IOComponentEnum::USHORT:
+      ConvertToISQ(static_cast<const unsigned short *>(buffer) + first, target, size, slope, intercept, rescale);
+      break;
+    case IOComponentEnum::INT:
+      ConvertToISQ(static_cast<const int *>(buffer) + first, target, size, slope, intercept, rescale);
+      break;
+    case IOComponentEnum::UINT:
+      ConvertToISQ(static_cast<const unsigned int *>(buffer) + first, target, size, slope, intercept, rescale);
+      break;
+    case IOComponentEnum::FLOAT:
+      ConvertToISQ(static_cast<const float *>(buffer) + first, target, size, slope, intercept, rescale);
+      break;
+    case IOComponentEnum::DOUBLE:
+      ConvertToISQ(static_cast<const double *>(buffer) + first, target, size, slope, intercept, rescale);
+      break;
+    default:
+      itkGenericExceptionMacro("Cannot convert data of type " << componentType << " to ISQ.");
+  }
+}
+
+
+void
+UpdateISQRange(const short * values, SizeValueType size, short & minimum, short & maximum)
+{
+  for (SizeValueType i = 0; i < size; ++i)
+  {
+    minimum = std::min(minimum, values[i]);
+    maximum = std::max(maximum, values[i]);
+  }
+}
+
+
+// Month names of the dates in headers, with a placeholder for invalid months
+const char * const monthNames[] = { "XXX", "JAN", "FEB", "MAR", "APR", "MAY", "JUN",
+                                    "JUL", "AUG", "SEP", "OCT", "NOV", "DEC" };
+
+
+// Parse a date in the format of ScancoHeader::CreationDate, where the time
+// may be left out
+bool
+ParseDate(const std::string & text,
+          int &               year,
+          int &               month,
+          int &               day,
+          int &               hour,
+          int &               minute,
+          int &               second,
+          int &               millis)
+{
+  char monthName[4] = {};
+  hour = 0;
+  minute = 0;
+  second = 0;
+  millis = 0;
+  const int count =
+    sscanf(text.c_str(), "%d-%3[A-Za-z]-%d %d:%d:%d.%d", &day, monthName, &year, &hour, &minute, &second, &millis);
+  if (count != 3 && count < 6)
+  {
+    return false;
+  }
+  for (char & c : monthName)
+  {
+    c = static_cast<char>(toupper(static_cast<unsigned char>(c)));
+  }
+  month = 0;
+  for (int i = 1; i <= 12; ++i)
+  {
+    if (strcmp(monthName, monthNames[i]) == 0)
+    {
+      month = i;
+    }
+  }
+  if (month == 0)
+  {
+    return false;
+  }
+  const bool isLeapYear = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+  const int  daysInMonth[] = { 0, 31, isLeapYear ? 29 : 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+  return day >= 1 && day <= daysInMonth[month] && year >= 1859 && year <= 9999 && hour >= 0 && hour < 24 &&
+         minute >= 0 && minute < 60 && second >= 0 && second < 60 && millis >= 0 && millis < 1000;
+}
+
+
+// Replace the values of keys in the text of an AIM processing log. Lines are
+// split into key and value like ReadAIMHeader() does, and only the value is
+// replaced, so that the alignment of the log is kept.
+std::string
+ReplaceAIMLogValues(const std::string & log, const std::vector<std::pair<std::string, std::string>> & values)
+{
+  std::string result;
+  size_t      lineStart = 0;
+  while (lineStart < log.size())
+  {
+    const size_t lineEnd = std::min(log.find('\n', lineStart), log.size());
+    const size_t next = std::min(lineEnd + 1, log.size());
+    const size_t keyEnd = log.find("  ", lineStart);
+    auto         value = values.end();
+    if (log[lineStart] != '!' && keyEnd < lineEnd)
+    {
+      const std::string key = log.substr(lineStart, keyEnd - lineStart);
+      value = std::find_if(values.begin(), values.end(), [&key](const std::pair<std::string, std::string> & entry) {
+        return entry.first == key;
+      });
+    }
+    if (value != values.end())
+    {
+      const size_t valueStart = std::min(log.find_first_not_of(' ', keyEnd), lineEnd);
+      size_t       valueEnd = lineEnd;
+      while (valueEnd > valueStart && (log[valueEnd - 1] == ' ' || log[valueEnd - 1] == '\r'))
+      {
+        --valueEnd;
+      }
+      result.append(log, lineStart, valueStart - lineStart);
+      result.append(value->second);
+      result.append(log, valueEnd, next - valueEnd);
+    }
+    else
+    {
+      result.append(log, lineStart, next - lineStart);
+    }
+    lineStart = next;
+  }
+  return result;
+}
+
+
+// The background thread of ScancoImageIO::WriteAsync(). Writes run one at a
+// time, and the bytes of the queued and running writes are limited.
+class AsyncWriteQueue
+{
+public:
+  static AsyncWriteQueue &
+  GetInstance()
+  {
+    static AsyncWriteQueue instance;
+    return instance;
+  }
+
+  ~AsyncWriteQueue()
+  {
+    {
+      std::lock_guard<std::mutex> lock(this->m_Mutex);
+      this->m_Stop = true;
+    }
+    this->m_TaskAdded.notify_all();
+    if (this->m_Thread.joinable())
+    {
+      this->m_Thread.join();
+    }
+  }
+
+  // Block until the bytes fit in the limit, then count them as in flight
+  void
+  Acquire(SizeValueType numberOfBytes)
+  {
+    std::unique_lock<std::mutex> lock(this->m_Mutex);
+    this->m_TaskDone.wait(lock, [&] {
+      return this->m_BytesInFlight == 0 || this->m_BytesInFlight + numberOfBytes <= this->m_MaximumBytes;
+    });
+    this->m_BytesInFlight += numberOfBytes;
+  }
+
+  void
+  Release(SizeValueType numberOfBytes)
+  {
+    {
+      std::lock_guard<std::mutex> lock(this->m_Mutex);
+      this->m_BytesInFlight -= numberOfBytes;
+    }
+    this->m_TaskDone.notify_all();
+  }
+
+  void
+  Push(std::function<void()> task)
+  {
+    {
+      std::lock_guard<std::mutex> lock(this->m_Mutex);
+      this->m_Tasks.push_back(std::move(task));
+      ++this->m_NumberOfPendingTasks;
+      if (!this->m_Thread.joinable())
+      {
+        this->m_Thread = std::thread(&AsyncWriteQueue::Run, this);
+      }
+    }
+    this->m_TaskAdded.notify_one();
+  }
+
+  void
+  Wait()
+  {
+    std::unique_lock<std::mutex> lock(this->m_Mutex);
+    this->m_TaskDone.wait(lock, [&] { return this->m_NumberOfPendingTasks == 0; });
+  }
+
+  void
+  SetMaximumBytes(SizeValueType maximumBytes)
+  {
+    {
+      std::lock_guard<std::mutex> lock(this->m_Mutex);
+      this->m_MaximumBytes = maximumBytes;
+    }
+    this->m_TaskDone.notify_all();
+  }
+
+  SizeValueType
+  GetMaximumBytes()
+  {
+    std::lock_guard<std::mutex> lock(this->m_Mutex);
+    return this->m_MaximumBytes;
+  }
+
+private:
+  AsyncWriteQueue()
+  {
+    // Create the global thread pool first, so that it outlives the queue
+    MultiThreaderBase::New();
+  }
+
+  void
+  Run()
+  {
+    std::unique_lock<std::mutex> lock(this->m_Mutex);
+    for (;;)
+    {
+      this->m_TaskAdded.wait(lock, [&] { return this->m_Stop || !this->m_Tasks.empty(); });
+      if (this->m_Tasks.empty())
+      {
+        // only stop once everything that was queued has been written
+        return;
+      }
+      std::function<void()> task = std::move(this->m_Tasks.front());
+      this->m_Tasks.pop_front();
+      lock.unlock();
+      task();
+      lock.lock();
+      --this->m_NumberOfPendingTasks;
+      this->m_TaskDone.notify_all();
+    }
+  }
+
+  std::mutex                        m_Mutex;
+  std::condition_variable           m_TaskAdded;
+  std::condition_variable           m_TaskDone;
+  std::deque<std::function<void()>> m_Tasks;
+  std::thread                       m_Thread;
+  SizeValueType                     m_NumberOfPendingTasks{ 0 };
+  SizeValueType                     m_BytesInFlight{ 0 };
+  SizeValueType                     m_MaximumBytes{ SizeValueType{ 1 } << 30 };
+  bool                              m_Stop{ false };
+};
+// The size of a stream whose first bytesRead bytes have been read, or the
+// largest size if the stream cannot seek. A short first read has already
+// hit the end.
+std::uint64_t
+GetStreamSize(std::istream & file, SizeValueType bytesRead)
+{
+  if (!file.good())
+  {
+    return bytesRead;
+  }
+  const std::streampos position = file.tellg();
+  if (position < 0)
+  {
+    return NumericTraits<std::uint64_t>::max();
+  }
+  file.seekg(0, std::ios::end);
+  const std::streampos end = file.tellg();
+  file.clear();
+  file.seekg(position);
+  return (end < 0 ? NumericTraits<std::uint64_t>::max() : static_cast<std::uint64_t>(end));
+}
+
+} // end anonymous namespace
+
 
 ScancoImageIO::ScancoImageIO()
 
@@ -56,14 +631,46 @@ ScancoImageIO::ScancoImageIO()
   this->AddSupportedReadExtension(".rsq");
   this->AddSupportedReadExtension(".rad");
   this->AddSupportedReadExtension(".aim");
+}
+
+
+ScancoImageIO::~ScancoImageIO() = default;
 
-  this->m_RawHeader = nullptr;
+
+void
+ScancoImageIO::SetServiceMode(bool serviceMode)
+{
+  if (this->m_ServiceMode == serviceMode)
+  {
+    return;
+  }
+  this->m_ServiceMode = serviceMode;
+  if (!serviceMode)
+  {
+    // give back everything that was kept for reuse
+    this->m_ServiceFile.close();
+    std::vector<char>().swap(this->m_RawHeader);
+    std::vector<char>().swap(this->m_InputBuffer);
+    std::vector<char>().swap(this->m_VolumeBuffer);
+    this->m_ServiceHeader.reset();
+  }
+  this->Modified();
 }
 
 
-ScancoImageIO::~ScancoImageIO()
+void
+ScancoImageIO::SetThresholdOnRead(bool thresholdOnRead)
 {
-  delete[] this->m_RawHeader;
+  if (this->m_ThresholdOnRead == thresholdOnRead)
+  {
+    return;
+  }
+  this->m_ThresholdOnRead = thresholdOnRead;
+  if (this->m_Header != nullptr)
+  {
+    this->SetComponentType(thresholdOnRead ? IOComponentEnum::UCHAR : this->m_Header->ComponentType);
+  }
+  this->Modified();
 }
 
 
@@ -71,6 +678,16 @@ void
 ScancoImageIO::PrintSelf(std::ostream & os, Indent indent) const
 {
   Superclass::PrintSelf(os, indent);
+
+  os << indent << "ServiceMode: " << (this->m_ServiceMode ? "On" : "Off") << std::endl;
+  os << indent << "UseHeaderCache: " << (this->m_UseHeaderCache ? "On" : "Off") << std::endl;
+  os << indent << "UseBrickCache: " << (this->m_UseBrickCache ? "On" : "Off") << std::endl;
+  os << indent << "UseDirectIO: " << (this->m_UseDirectIO ? "On" : "Off") << std::endl;
+  os << indent << "ThrottleWriteBack: " << (this->m_ThrottleWriteBack ? "On" : "Off") << std::endl;
+  os << indent << "ThresholdOnRead: " << (this->m_ThresholdOnRead ? "On" : "Off") << std::endl;
+  os << indent << "LowerThreshold: " << this->m_LowerThreshold << std::endl;
+  os << indent << "UpperThreshold: " << this->m_UpperThreshold << std::endl;
+  os << indent << "ThresholdInsideValue: " << static_cast<int>(this->m_ThresholdInsideValue) << std::endl;
 }
 
 
@@ -120,6 +737,23 @@ ScancoImageIO::EncodeInt(int data, void * target)
 }
 
 
+std::int64_t
+ScancoImageIO::DecodeInt64(const void * data)
+{
+  const auto * cp = static_cast<const unsigned char *>(data);
+  const auto   low = static_cast<std::uint32_t>(ScancoImageIO::DecodeInt(cp));
+  const auto   high = static_cast<std::uint32_t>(ScancoImageIO::DecodeInt(cp + 4));
+  return static_cast<std::int64_t>(low | (static_cast<std::uint64_t>(high) << 32));
+}
+
+
+std::int64_t
+ScancoImageIO::DecodeAIMInt(const void * data, SizeValueType intSize)
+{
+  return (intSize == 8 ? ScancoImageIO::DecodeInt64(data) : ScancoImageIO::DecodeInt(data));
+}
+
+
 float
 ScancoImageIO::DecodeFloat(const void * data)
 {
@@ -153,6 +787,30 @@ ScancoImageIO::DecodeDouble(const void * data)
 }
 
 
+void
+ScancoImageIO::EncodeDouble(double data, void * target)
+{
+  // inverse of DecodeDouble()
+  auto * cp = static_cast<unsigned char *>(target);
+  union
+  {
+    double   d;
+    uint64_t l;
+  } v;
+  v.d = data * 4.0;
+  const auto l1 = static_cast<unsigned int>(v.l >> 32);
+  const auto l2 = static_cast<unsigned int>(v.l);
+  cp[0] = static_cast<unsigned char>(l1 >> 16);
+  cp[1] = static_cast<unsigned char>(l1 >> 24);
+  cp[2] = static_cast<unsigned char>(l1);
+  cp[3] = static_cast<unsigned char>(l1 >> 8);
+  cp[4] = static_cast<unsigned char>(l2 >> 16);
+  cp[5] = static_cast<unsigned char>(l2 >> 24);
+  cp[6] = static_cast<unsigned char>(l2);
+  cp[7] = static_cast<unsigned char>(l2 >> 8);
+}
+
+
 void
 ScancoImageIO::DecodeDate(const void * data,
                           int &        year,
@@ -173,9 +831,9 @@ ScancoImageIO::DecodeDate(const void * data,
   const uint64_t millisPerDay = 3600 * 24 * 1000;
 
   // Read the date as a long integer with units of 1e-7 seconds
-  int      d1 = ScancoImageIO::DecodeInt(data);
-  int      d2 = ScancoImageIO::DecodeInt(static_cast<const char *>(data) + 4);
-  uint64_t tVMS = d1 + (static_cast<uint64_t>(d2) << 32);
+  const auto d1 = static_cast<uint32_t>(ScancoImageIO::DecodeInt(data));
+  const auto d2 = static_cast<uint32_t>(ScancoImageIO::DecodeInt(static_cast<const char *>(data) + 4));
+  uint64_t   tVMS = d1 + (static_cast<uint64_t>(d2) << 32);
   uint64_t time = tVMS / 10000 + julianOffset * millisPerDay;
 
   int y, m, d;
@@ -224,9 +882,58 @@ ScancoImageIO::EncodeDate(void * target)
 }
 
 
+void
+ScancoImageIO::EncodeDate(void * target, int year, int month, int day, int hour, int minute, int second, int millis)
+{
+  // November 17, 1858, as in DecodeDate()
+  const int64_t julianOffset = 2400001;
+  const int64_t millisPerDay = 3600 * 24 * 1000;
+
+  // The inverse of the algorithm of Fliegel and Van Flandern in DecodeDate()
+  const int64_t a = (month - 14) / 12;
+  const int64_t julianDay = day - 32075 + 1461 * (year + 4800 + a) / 4 + 367 * (month - 2 - 12 * a) / 12 -
+                            3 * ((year + 4900 + a) / 100) / 4;
+  const int64_t time = (julianDay - julianOffset) * millisPerDay + ((hour * 60 + minute) * 60 + second) * 1000 + millis;
+  const auto    tVMS = static_cast<uint64_t>(time) * 10000;
+
+  ScancoImageIO::EncodeInt(static_cast<int>(tVMS), target);
+  ScancoImageIO::EncodeInt(static_cast<int>(tVMS >> 32), static_cast<char *>(target) + 4);
+}
+
+
+bool
+ScancoImageIO::IsRADHeader(const char * block)
+{
+  return ScancoImageIO::DecodeInt(block + isqDataTypeOffset) == 9 ||
+         ScancoImageIO::DecodeInt(block + isqPhysicalDimensionsOffset + 8) == 0;
+}
+
+
+void
+ScancoImageIO::EncodeDataRange(const double dataRange[2], char * block)
+{
+  ScancoHeader rangeHeader;
+  rangeHeader.DataRange[0] = dataRange[0];
+  rangeHeader.DataRange[1] = dataRange[1];
+  if (ScancoImageIO::IsRADHeader(block))
+  {
+    ScancoImageIO::EncodeHeaderFields(rangeHeader, std::begin(radDataRangeFields), std::end(radDataRangeFields), block);
+  }
+  else
+  {
+    ScancoImageIO::EncodeHeaderFields(rangeHeader, std::begin(isqDataRangeFields), std::end(isqDataRangeFields), block);
+  }
+}
+
+
 bool
 ScancoImageIO::CanReadFile(const char * filename)
 {
+  if (this->m_UseHeaderCache && ScancoHeaderCache::GetInstance().GetHeader(filename) != nullptr)
+  {
+    return true;
+  }
+
   try
   {
     std::ifstream infile;
@@ -256,229 +963,467 @@ ScancoImageIO::CanReadFile(const char * filename)
 }
 
 
-void
-ScancoImageIO::InitializeHeader()
+ScancoImageIO::ProbeInformation
+ScancoImageIO::Probe(const std::string & fileName)
 {
-  memset(this->m_Version, 0, 18);
-  memset(this->m_PatientName, 0, 42);
-  this->m_PatientIndex = 0;
-  this->m_ScannerID = 0;
-  memset(this->m_CreationDate, 0, 32);
-  memset(this->m_ModificationDate, 0, 32);
-  this->ScanDimensionsPixels[0] = 0;
-  this->ScanDimensionsPixels[1] = 0;
-  this->ScanDimensionsPixels[2] = 0;
-  this->ScanDimensionsPhysical[0] = 0;
-  this->ScanDimensionsPhysical[1] = 0;
-  this->ScanDimensionsPhysical[2] = 0;
-  this->m_SliceThickness = 0;
-  this->m_SliceIncrement = 0;
-  this->m_StartPosition = 0;
-  this->m_EndPosition = 0;
-  this->m_ZPosition = 0;
-  this->m_DataRange[0] = 0;
-  this->m_DataRange[1] = 0;
-  this->m_MuScaling = 1.0;
-  this->m_NumberOfSamples = 0;
-  this->m_NumberOfProjections = 0;
-  this->m_ScanDistance = 0;
-  this->m_SampleTime = 0;
-  this->m_ScannerType = 0;
-  this->m_MeasurementIndex = 0;
-  this->m_Site = 0;
-  this->m_ReconstructionAlg = 0;
-  this->m_ReferenceLine = 0;
-  this->m_Energy = 0;
-  this->m_Intensity = 0;
-
-  this->m_RescaleType = 0;
-  memset(this->m_RescaleUnits, 0, 18);
-  memset(this->m_CalibrationData, 0, 66);
-  this->m_RescaleSlope = 1.0;
-  this->m_RescaleIntercept = 0.0;
-  this->m_MuWater = 0.70329999923706055;
-
-  this->m_Compression = 0;
-  this->m_HeaderInitialized = true;
-}
-
+  ProbeInformation info;
+  info.ActualFileSize = itksys::SystemTools::FileLength(fileName);
 
-void
-ScancoImageIO::StripString(char * dest, const char * source, size_t length)
-{
-  char * dp = dest;
-  for (size_t i = 0; i < length && *source != '\0'; ++i)
-  {
-    *dp++ = *source++;
-  }
-  while (dp != dest && dp[-1] == ' ')
+  std::ifstream infile(fileName.c_str(), std::ios::in | std::ios::binary);
+  if (!infile.is_open())
   {
-    --dp;
+    return info;
   }
-  *dp = '\0';
-}
 
-
-void
-ScancoImageIO::PadString(char * dest, const char * source, size_t length)
-{
-  for (size_t i = 0; i < length && *source != '\0'; ++i)
+  // header is a 512 byte block, which holds everything but the size of
+  // compressed data
+  char buffer[512] = {};
+  infile.read(buffer, 512);
+  const auto bytesRead = static_cast<SizeValueType>(infile.gcount());
+  if (bytesRead < 16)
   {
-    *dest++ = *source++;
+    return info;
   }
-  for (size_t i = 0; i < length; ++i)
+  info.FileType = ScancoImageIO::CheckVersion(buffer);
+
+  ScancoHeader header;
+  if (info.FileType == 1)
   {
-    *dest++ = ' ';
-  }
+    if (bytesRead < 512)
+    {
+      return info;
+    }
+    // ReadISQHeader() rejects a negative data offset as well
+    const int dataOffset = ScancoImageIO::DecodeInt(buffer + isqDataOffsetOffset);
+    if (dataOffset < 0)
+    {
+      info.FileType = 0;
+      return info;
+    }
+    ScancoImageIO::StripString(info.Version, buffer, 16);
+    for (int i = 0; i < 3; ++i)
+    {
+      const int pixdim = ScancoImageIO::DecodeInt(buffer + 44 + 4 * i);
+      info.Dimensions[i] = (pixdim < 1 ? 1 : pixdim);
+    }
+    info.ComponentType = IOComponentEnum::SHORT;
+    info.DataOffset = (static_cast<SizeValueType>(dataOffset) + 1) * 512;
+  }
+  else if (info.FileType == 2 || info.FileType == 3)
+  {
+    const bool          versionV030 = (info.FileType == 3);
+    const SizeValueType intSize = (versionV030 ? 8 : 4);
+    const char *        preheader = buffer;
+    if (versionV030)
+    {
+      strcpy(info.Version, buffer);
+      preheader += 16;
+    }
+    else
+    {
+      strcpy(info.Version, "AIMDATA_V020   ");
+    }
+    const std::int64_t preheaderSize = ScancoImageIO::DecodeAIMInt(preheader, intSize);
+    const std::int64_t structSize = ScancoImageIO::DecodeAIMInt(preheader + intSize, intSize);
+    const std::int64_t logSize = ScancoImageIO::DecodeAIMInt(preheader + 2 * intSize, intSize);
+    if (preheaderSize < 0 || preheaderSize > 512 || structSize < 0 || logSize < 0)
+    {
+      return info;
+    }
+    info.DataOffset = (preheader - buffer) + static_cast<SizeValueType>(preheaderSize) +
+                      static_cast<SizeValueType>(structSize) + static_cast<SizeValueType>(logSize);
+
+    // the datatype is followed by the position and the dimensions
+    const SizeValueType typeOffset = (preheader - buffer) + preheaderSize + (versionV030 ? 12 : 20);
+    if (typeOffset + 4 + 6 * intSize > bytesRead)
+    {
+      return info;
+    }
+    if (!ScancoImageIO::DecodeAIMDataType(ScancoImageIO::DecodeInt(buffer + typeOffset), header))
+    {
+      return info;
+    }
+    info.ComponentType = header.ComponentType;
+    info.PixelType = header.PixelType;
+    info.Compression = header.Compression;
+    for (int i = 0; i < 3; ++i)
+    {
+      const std::int64_t dim = ScancoImageIO::DecodeAIMInt(buffer + typeOffset + 4 + (3 + i) * intSize, intSize);
+      info.Dimensions[i] = (dim < 0 ? 0 : static_cast<SizeValueType>(dim));
+    }
+  }
+  else
+  {
+    return info;
+  }
+
+  // compute the size the file must have to hold all of the data
+  header.ComponentType = info.ComponentType;
+  SizeValueType dataSize = info.Dimensions[0] * info.Dimensions[1] * info.Dimensions[2];
+  if (info.Compression == 0)
+  {
+    dataSize *= ScancoImageIO::GetHeaderComponentSize(header);
+  }
+  else if (info.Compression == 0x00b1)
+  {
+    dataSize = ((info.Dimensions[0] + 1) / 2) * ((info.Dimensions[1] + 1) / 2) * ((info.Dimensions[2] + 1) / 2) + 1;
+  }
+  else
+  {
+    // run-length data starts with its own size
+    const auto intSize = static_cast<SizeValueType>(info.FileType == 3 ? 8 : 4);
+    dataSize = 0;
+    if (info.DataOffset + intSize <= info.ActualFileSize)
+    {
+      char head[8];
+      infile.clear();
+      infile.seekg(info.DataOffset);
+      infile.read(head, intSize);
+      const std::int64_t size = ScancoImageIO::DecodeAIMInt(head, intSize);
+      dataSize = (size < 0 ? 0 : static_cast<SizeValueType>(size));
+    }
+    else
+    {
+      dataSize = intSize;
+    }
+  }
+  info.ExpectedFileSize = info.DataOffset + dataSize;
+
+  return info;
+}
+
+
+void
+ScancoImageIO::InitializeHeader()
+{
+  this->CopyHeaderToMembers(ScancoHeader());
+  this->m_HeaderInitialized = true;
+}
+
+
+void
+ScancoImageIO::CopyHeaderToMembers(const ScancoHeader & header)
+{
+  memcpy(this->m_Version, header.Version, 18);
+  memcpy(this->m_PatientName, header.PatientName, 42);
+  this->m_PatientIndex = header.PatientIndex;
+  this->m_ScannerID = header.ScannerID;
+  memcpy(this->m_CreationDate, header.CreationDate, 32);
+  memcpy(this->m_ModificationDate, header.ModificationDate, 32);
+  for (int i = 0; i < 3; ++i)
+  {
+    this->ScanDimensionsPixels[i] = header.ScanDimensionsPixels[i];
+    this->ScanDimensionsPhysical[i] = header.ScanDimensionsPhysical[i];
+  }
+  this->m_SliceThickness = header.SliceThickness;
+  this->m_SliceIncrement = header.SliceIncrement;
+  this->m_StartPosition = header.StartPosition;
+  this->m_EndPosition = header.EndPosition;
+  this->m_ZPosition = header.ZPosition;
+  this->m_DataRange[0] = header.DataRange[0];
+  this->m_DataRange[1] = header.DataRange[1];
+  this->m_MuScaling = header.MuScaling;
+  this->m_NumberOfSamples = header.NumberOfSamples;
+  this->m_NumberOfProjections = header.NumberOfProjections;
+  this->m_ScanDistance = header.ScanDistance;
+  this->m_SampleTime = header.SampleTime;
+  this->m_ScannerType = header.ScannerType;
+  this->m_MeasurementIndex = header.MeasurementIndex;
+  this->m_Site = header.Site;
+  this->m_ReconstructionAlg = header.ReconstructionAlg;
+  this->m_ReferenceLine = header.ReferenceLine;
+  this->m_Energy = header.Energy;
+  this->m_Intensity = header.Intensity;
+
+  this->m_RescaleType = header.RescaleType;
+  memcpy(this->m_RescaleUnits, header.RescaleUnits, 18);
+  memcpy(this->m_CalibrationData, header.CalibrationData, 66);
+  this->m_RescaleSlope = header.RescaleSlope;
+  this->m_RescaleIntercept = header.RescaleIntercept;
+  this->m_MuWater = header.MuWater;
+  this->m_DensitySlope = header.DensitySlope;
+  this->m_DensityIntercept = header.DensityIntercept;
+
+  this->m_Compression = header.Compression;
+  this->m_HeaderSize = header.HeaderSize;
+}
+
+
+void
+ScancoImageIO::CopyMembersToHeader(ScancoHeader & header) const
+{
+  header.FileType = ScancoImageIO::CheckVersion(this->m_Version);
+  memcpy(header.Version, this->m_Version, 18);
+  memcpy(header.PatientName, this->m_PatientName, 42);
+  header.PatientIndex = this->m_PatientIndex;
+  header.ScannerID = this->m_ScannerID;
+  memcpy(header.CreationDate, this->m_CreationDate, 32);
+  memcpy(header.ModificationDate, this->m_ModificationDate, 32);
+  for (int i = 0; i < 3; ++i)
+  {
+    header.ScanDimensionsPixels[i] = this->ScanDimensionsPixels[i];
+    header.ScanDimensionsPhysical[i] = this->ScanDimensionsPhysical[i];
+  }
+  header.SliceThickness = this->m_SliceThickness;
+  header.SliceIncrement = this->m_SliceIncrement;
+  header.StartPosition = this->m_StartPosition;
+  header.EndPosition = this->m_EndPosition;
+  header.ZPosition = this->m_ZPosition;
+  header.DataRange[0] = this->m_DataRange[0];
+  header.DataRange[1] = this->m_DataRange[1];
+  header.MuScaling = this->m_MuScaling;
+  header.NumberOfSamples = this->m_NumberOfSamples;
+  header.NumberOfProjections = this->m_NumberOfProjections;
+  header.ScanDistance = this->m_ScanDistance;
+  header.SampleTime = this->m_SampleTime;
+  header.ScannerType = this->m_ScannerType;
+  header.MeasurementIndex = this->m_MeasurementIndex;
+  header.Site = this->m_Site;
+  header.ReconstructionAlg = this->m_ReconstructionAlg;
+  header.ReferenceLine = this->m_ReferenceLine;
+  header.Energy = this->m_Energy;
+  header.Intensity = this->m_Intensity;
+
+  header.RescaleType = this->m_RescaleType;
+  memcpy(header.RescaleUnits, this->m_RescaleUnits, 18);
+  memcpy(header.CalibrationData, this->m_CalibrationData, 66);
+  header.RescaleSlope = this->m_RescaleSlope;
+  header.RescaleIntercept = this->m_RescaleIntercept;
+  header.MuWater = this->m_MuWater;
+  header.DensitySlope = this->m_DensitySlope;
+  header.DensityIntercept = this->m_DensityIntercept;
+
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    header.Dimensions[i] = this->GetDimensions(i);
+    header.Spacing[i] = this->GetSpacing(i);
+    header.Origin[i] = this->GetOrigin(i);
+  }
+  header.ComponentType = this->GetComponentType();
+  header.PixelType = this->GetPixelType();
+
+  header.Compression = this->m_Compression;
+  header.HeaderSize = this->m_HeaderSize;
+}
+
+
+void
+ScancoImageIO::StripString(char * dest, const char * source, size_t length)
+{
+  char * dp = dest;
+  for (size_t i = 0; i < length && *source != '\0'; ++i)
+  {
+    *dp++ = *source++;
+  }
+  while (dp != dest && dp[-1] == ' ')
+  {
+    --dp;
+  }
+  *dp = '\0';
+}
+
+
+void
+ScancoImageIO::PadString(char * dest, const char * source, size_t length)
+{
+  size_t i = 0;
+  for (; i < length && *source != '\0'; ++i)
+  {
+    *dest++ = *source++;
+  }
+  for (; i < length; ++i)
+  {
+    *dest++ = ' ';
+  }
+}
+
+
+void
+ScancoImageIO::DecodeHeaderFields(const char *        block,
+                                  const HeaderField * first,
+                                  const HeaderField * last,
+                                  ScancoHeader &      header)
+{
+  char * fields = reinterpret_cast<char *>(&header);
+  for (const HeaderField * field = first; field != last; ++field)
+  {
+    const char * source = block + field->Offset;
+    char *       member = fields + field->Member;
+    switch (field->Encoding)
+    {
+      case FieldEncoding::Integer:
+        *reinterpret_cast<int *>(member) = ScancoImageIO::DecodeInt(source);
+        break;
+      case FieldEncoding::Real:
+        *reinterpret_cast<double *>(member) = ScancoImageIO::DecodeInt(source);
+        break;
+      case FieldEncoding::Micro:
+        *reinterpret_cast<double *>(member) = ScancoImageIO::DecodeInt(source) * 1e-3;
+        break;
+      case FieldEncoding::Double:
+        *reinterpret_cast<double *>(member) = ScancoImageIO::DecodeDouble(source);
+        break;
+      case FieldEncoding::Text:
+        ScancoImageIO::StripString(member, source, field->Length);
+        break;
+    }
+  }
+}
+
+
+void
+ScancoImageIO::EncodeHeaderFields(const ScancoHeader & header,
+                                  const HeaderField *  first,
+                                  const HeaderField *  last,
+                                  char *               block)
+{
+  const char * fields = reinterpret_cast<const char *>(&header);
+  for (const HeaderField * field = first; field != last; ++field)
+  {
+    char *       target = block + field->Offset;
+    const char * member = fields + field->Member;
+    switch (field->Encoding)
+    {
+      case FieldEncoding::Integer:
+        ScancoImageIO::EncodeInt(*reinterpret_cast<const int *>(member), target);
+        break;
+      case FieldEncoding::Real:
+        ScancoImageIO::EncodeInt(static_cast<int>(*reinterpret_cast<const double *>(member)), target);
+        break;
+      case FieldEncoding::Micro:
+        ScancoImageIO::EncodeInt(static_cast<int>(*reinterpret_cast<const double *>(member) * 1e3), target);
+        break;
+      case FieldEncoding::Double:
+        ScancoImageIO::EncodeDouble(*reinterpret_cast<const double *>(member), target);
+        break;
+      case FieldEncoding::Text:
+        ScancoImageIO::PadString(target, member, field->Length);
+        break;
+    }
+  }
+}
+
+
+const ScancoImageIO::AIMLogField *
+ScancoImageIO::FindAIMLogField(const char * key, size_t length)
+{
+  const int field = aimLogSlots.Field[HashAIMLogKey(key, length)];
+  if (field < 0 || strncmp(aimLogFields[field].Key, key, length) != 0 || aimLogFields[field].Key[length] != '\0')
+  {
+    return nullptr;
+  }
+  return &aimLogFields[field];
+}
+
+
+void
+ScancoImageIO::DecodeAIMLogValue(const AIMLogField & field,
+                                 const char *        value,
+                                 size_t              length,
+                                 ScancoHeader &      header)
+{
+  char * member = reinterpret_cast<char *>(&header) + field.Member;
+  char * end = nullptr;
+  switch (field.Encoding)
+  {
+    case FieldEncoding::Integer:
+      for (unsigned int i = 0; i < field.Length; ++i, value = end)
+      {
+        reinterpret_cast<int *>(member)[i] = strtol(value, &end, 10);
+      }
+      break;
+    case FieldEncoding::Real:
+    case FieldEncoding::Double:
+      for (unsigned int i = 0; i < field.Length; ++i, value = end)
+      {
+        reinterpret_cast<double *>(member)[i] = strtod(value, &end);
+      }
+      break;
+    case FieldEncoding::Micro:
+      for (unsigned int i = 0; i < field.Length; ++i, value = end)
+      {
+        reinterpret_cast<double *>(member)[i] = strtod(value, &end) * 1e-3;
+      }
+      break;
+    case FieldEncoding::Text:
+      length = std::min<size_t>(length, field.Length);
+      memcpy(member, value, length);
+      member[length] = '\0';
+      break;
+  }
 }
 
 
 int
-ScancoImageIO::ReadISQHeader(std::ifstream * file, unsigned long bytesRead)
+ScancoImageIO::ReadISQHeader(std::istream *      file,
+                             SizeValueType       bytesRead,
+                             std::vector<char> & rawHeader,
+                             ScancoHeader &      header)
 {
   if (bytesRead < 512)
   {
     return 0;
   }
 
-  char * h = this->m_RawHeader;
-  ScancoImageIO::StripString(this->m_Version, h, 16);
-  h += 16;
-  int dataType = ScancoImageIO::DecodeInt(h);
-  h += 4;
-  const int numBytes = ScancoImageIO::DecodeInt(h);
-  h += 4;
-  (void)numBytes;
-  const int numBlocks = ScancoImageIO::DecodeInt(h);
-  h += 4;
-  (void)numBlocks;
-  this->m_PatientIndex = ScancoImageIO::DecodeInt(h);
-  h += 4;
-  this->m_ScannerID = ScancoImageIO::DecodeInt(h);
-  h += 4;
-  int year, month, day, hour, minute, second, milli;
-  ScancoImageIO::DecodeDate(h, year, month, day, hour, minute, second, milli);
-  h += 8;
+  const char * h = rawHeader.data();
+  ScancoImageIO::DecodeHeaderFields(h, std::begin(isqCommonFields), std::end(isqCommonFields), header);
+  const int dataType = ScancoImageIO::DecodeInt(h + isqDataTypeOffset);
+  int       year, month, day, hour, minute, second, milli;
+  ScancoImageIO::DecodeDate(h + isqDateOffset, year, month, day, hour, minute, second, milli);
   int pixdim[3], physdim[3];
-  pixdim[0] = ScancoImageIO::DecodeInt(h);
-  h += 4;
-  pixdim[1] = ScancoImageIO::DecodeInt(h);
-  h += 4;
-  pixdim[2] = ScancoImageIO::DecodeInt(h);
-  h += 4;
-  physdim[0] = ScancoImageIO::DecodeInt(h);
-  h += 4;
-  physdim[1] = ScancoImageIO::DecodeInt(h);
-  h += 4;
-  physdim[2] = ScancoImageIO::DecodeInt(h);
-  h += 4;
+  for (int i = 0; i < 3; ++i)
+  {
+    pixdim[i] = ScancoImageIO::DecodeInt(h + isqPixelDimensionsOffset + 4 * i);
+    physdim[i] = ScancoImageIO::DecodeInt(h + isqPhysicalDimensionsOffset + 4 * i);
+  }
 
   const bool isRAD = (dataType == 9 || physdim[2] == 0);
 
   if (isRAD) // RAD file
   {
-    this->m_MeasurementIndex = ScancoImageIO::DecodeInt(h);
-    h += 4;
-    this->m_DataRange[0] = ScancoImageIO::DecodeInt(h);
-    h += 4;
-    this->m_DataRange[1] = ScancoImageIO::DecodeInt(h);
-    h += 4;
-    this->m_MuScaling = ScancoImageIO::DecodeInt(h);
-    h += 4;
-    ScancoImageIO::StripString(this->m_PatientName, h, 40);
-    h += 40;
-    this->m_ZPosition = ScancoImageIO::DecodeInt(h) * 1e-3;
-    h += 4;
-    /* unknown */ h += 4;
-    this->m_SampleTime = ScancoImageIO::DecodeInt(h) * 1e-3;
-    h += 4;
-    this->m_Energy = ScancoImageIO::DecodeInt(h) * 1e-3;
-    h += 4;
-    this->m_Intensity = ScancoImageIO::DecodeInt(h) * 1e-3;
-    h += 4;
-    this->m_ReferenceLine = ScancoImageIO::DecodeInt(h) * 1e-3;
-    h += 4;
-    this->m_StartPosition = ScancoImageIO::DecodeInt(h) * 1e-3;
-    h += 4;
-    this->m_EndPosition = ScancoImageIO::DecodeInt(h) * 1e-3;
-    h += 4;
-    h += 88 * 4;
+    ScancoImageIO::DecodeHeaderFields(h, std::begin(radFields), std::end(radFields), header);
   }
   else // ISQ file or RSQ file
   {
-    this->m_SliceThickness = ScancoImageIO::DecodeInt(h) * 1e-3;
-    h += 4;
-    this->m_SliceIncrement = ScancoImageIO::DecodeInt(h) * 1e-3;
-    h += 4;
-    this->m_StartPosition = ScancoImageIO::DecodeInt(h) * 1e-3;
-    h += 4;
-    this->m_EndPosition = this->m_StartPosition + physdim[2] * 1e-3 * (pixdim[2] - 1) / pixdim[2];
-    this->m_DataRange[0] = ScancoImageIO::DecodeInt(h);
-    h += 4;
-    this->m_DataRange[1] = ScancoImageIO::DecodeInt(h);
-    h += 4;
-    this->m_MuScaling = ScancoImageIO::DecodeInt(h);
-    h += 4;
-    this->m_NumberOfSamples = ScancoImageIO::DecodeInt(h);
-    h += 4;
-    this->m_NumberOfProjections = ScancoImageIO::DecodeInt(h);
-    h += 4;
-    this->m_ScanDistance = ScancoImageIO::DecodeInt(h) * 1e-3;
-    h += 4;
-    this->m_ScannerType = ScancoImageIO::DecodeInt(h);
-    h += 4;
-    this->m_SampleTime = ScancoImageIO::DecodeInt(h) * 1e-3;
-    h += 4;
-    this->m_MeasurementIndex = ScancoImageIO::DecodeInt(h);
-    h += 4;
-    this->m_Site = ScancoImageIO::DecodeInt(h);
-    h += 4;
-    this->m_ReferenceLine = ScancoImageIO::DecodeInt(h) * 1e-3;
-    h += 4;
-    this->m_ReconstructionAlg = ScancoImageIO::DecodeInt(h);
-    h += 4;
-    ScancoImageIO::StripString(this->m_PatientName, h, 40);
-    h += 40;
-    this->m_Energy = ScancoImageIO::DecodeInt(h) * 1e-3;
-    h += 4;
-    this->m_Intensity = ScancoImageIO::DecodeInt(h) * 1e-3;
-    h += 4;
-    h += 83 * 4;
-  }
-
-  int dataOffset = ScancoImageIO::DecodeInt(h);
+    ScancoImageIO::DecodeHeaderFields(h, std::begin(isqFields), std::end(isqFields), header);
+    header.EndPosition = header.StartPosition + physdim[2] * 1e-3 * (pixdim[2] - 1) / pixdim[2];
+  }
+
+  const int dataOffset = ScancoImageIO::DecodeInt(h + isqDataOffsetOffset);
+  if (dataOffset < 0)
+  {
+    return 0;
+  }
 
   // fix m_SliceThickness and m_SliceIncrement if they were truncated
   if (physdim[2] != 0)
   {
     double computedSpacing = physdim[2] * 1e-3 / pixdim[2];
-    if (itk::Math::abs(computedSpacing - this->m_SliceThickness) < 1.1e-3)
+    if (itk::Math::abs(computedSpacing - header.SliceThickness) < 1.1e-3)
     {
-      this->m_SliceThickness = computedSpacing;
+      header.SliceThickness = computedSpacing;
     }
-    if (itk::Math::abs(computedSpacing - this->m_SliceIncrement) < 1.1e-3)
+    if (itk::Math::abs(computedSpacing - header.SliceIncrement) < 1.1e-3)
     {
-      this->m_SliceIncrement = computedSpacing;
+      header.SliceIncrement = computedSpacing;
     }
   }
 
   // Convert date information into a string
   month = ((month > 12 || month < 1) ? 0 : month);
-  static const char * months[] = { "XXX", "JAN", "FEB", "MAR", "APR", "MAY", "JUN",
-                                   "JUL", "AUG", "SEP", "OCT", "NOV", "DEC" };
-  sprintf(this->m_CreationDate,
+  sprintf(header.CreationDate,
           "%d-%s-%d %02d:%02d:%02d.%03d",
           (day % 100),
-          months[month],
+          monthNames[month],
           (year % 10000),
           (hour % 100),
           (minute % 100),
           (second % 100),
           (milli % 1000));
-  sprintf(this->m_ModificationDate,
+  sprintf(header.ModificationDate,
           "%d-%s-%d %02d:%02d:%02d.%03d",
           (day % 100),
-          months[month],
+          monthNames[month],
           (year % 10000),
           (hour % 100),
           (minute % 100),
@@ -488,56 +1433,58 @@ ScancoImageIO::ReadISQHeader(std::ifstream * file, unsigned long bytesRead)
   // Perform a sanity check on the dimensions
   for (int i = 0; i < 3; ++i)
   {
-    this->ScanDimensionsPixels[i] = pixdim[i];
+    header.ScanDimensionsPixels[i] = pixdim[i];
     if (pixdim[i] < 1)
     {
       pixdim[i] = 1;
     }
-    this->ScanDimensionsPhysical[i] = (isRAD ? physdim[i] * 1e-6 : physdim[i] * 1e-3);
+    header.ScanDimensionsPhysical[i] = (isRAD ? physdim[i] * 1e-6 : physdim[i] * 1e-3);
     if (physdim[i] == 0)
     {
       physdim[i] = 1.0;
     }
   }
 
-  this->SetNumberOfDimensions(3);
-  for (unsigned int i = 0; i < m_NumberOfDimensions; ++i)
+  for (unsigned int i = 0; i < 3; ++i)
   {
-    this->SetDimensions(i, pixdim[i]);
+    header.Dimensions[i] = pixdim[i];
     if (isRAD) // RAD file
     {
       if (i == 2)
       {
-        this->SetSpacing(i, 1.0);
+        header.Spacing[i] = 1.0;
       }
       else
       {
-        this->SetSpacing(i, physdim[i] * 1e-6 / pixdim[i]);
+        header.Spacing[i] = physdim[i] * 1e-6 / pixdim[i];
       }
     }
     else
     {
-      this->SetSpacing(i, physdim[i] * 1e-3 / pixdim[i]);
+      header.Spacing[i] = physdim[i] * 1e-3 / pixdim[i];
     }
-    this->SetOrigin(i, 0.0);
+    header.Origin[i] = 0.0;
   }
 
-  this->SetPixelType(IOPixelEnum::SCALAR);
-  this->SetComponentType(IOComponentEnum::SHORT);
+  header.PixelType = IOPixelEnum::SCALAR;
+  header.ComponentType = IOComponentEnum::SHORT;
 
   // total header size
   const SizeValueType headerSize = static_cast<SizeValueType>(dataOffset + 1) * 512;
-  this->m_HeaderSize = headerSize;
+  header.HeaderSize = headerSize;
 
   // read the rest of the header
   if (headerSize > bytesRead)
   {
-    h = new char[headerSize];
-    memcpy(h, this->m_RawHeader, bytesRead);
-    delete[] this->m_RawHeader;
-    this->m_RawHeader = h;
-    file->read(h + bytesRead, headerSize - bytesRead);
-    if (static_cast<unsigned long>(file->gcount()) < headerSize - bytesRead)
+    // a corrupt header can claim any size, check it before allocating it
+    const std::uint64_t fileSize = GetStreamSize(*file, bytesRead);
+    if (headerSize > fileSize)
+    {
+      itkGenericExceptionMacro("The ISQ header size " << headerSize << " exceeds the file size " << fileSize);
+    }
+    rawHeader.resize(headerSize);
+    file->read(rawHeader.data() + bytesRead, headerSize - bytesRead);
+    if (static_cast<SizeValueType>(file->gcount()) < headerSize - bytesRead)
     {
       return 0;
     }
@@ -546,20 +1493,20 @@ ScancoImageIO::ReadISQHeader(std::ifstream * file, unsigned long bytesRead)
   // decode the extended header (lots of guesswork)
   if (headerSize >= 2048)
   {
-    char * calHeader = nullptr;
-    int    calHeaderSize = 0;
-    h = this->m_RawHeader + 512;
-    unsigned long hskip = 1;
-    char *        headerName = h + 8;
+    const char *  calHeader = nullptr;
+    SizeValueType calHeaderSize = 0;
+    h = rawHeader.data() + 512;
+    SizeValueType hskip = 1;
+    const char *  headerName = h + 8;
     if (strncmp(headerName, "MultiHeader     ", 16) == 0)
     {
       h += 512;
       hskip += 1;
     }
-    unsigned long hsize = 0;
+    SizeValueType hsize = 0;
     for (int i = 0; i < 4; ++i)
     {
-      hsize = ScancoImageIO::DecodeInt(h + i * 128 + 24);
+      hsize = static_cast<std::uint32_t>(ScancoImageIO::DecodeInt(h + i * 128 + 24));
       if ((1 + hskip + hsize) * 512 > headerSize)
       {
         break;
@@ -567,7 +1514,7 @@ ScancoImageIO::ReadISQHeader(std::ifstream * file, unsigned long bytesRead)
       headerName = h + i * 128 + 8;
       if (strncmp(headerName, "Calibration     ", 16) == 0)
       {
-        calHeader = this->m_RawHeader + (1 + hskip) * 512;
+        calHeader = rawHeader.data() + (1 + hskip) * 512;
         calHeaderSize = hsize * 512;
       }
       hskip += hsize;
@@ -575,41 +1522,90 @@ ScancoImageIO::ReadISQHeader(std::ifstream * file, unsigned long bytesRead)
 
     if (calHeader && calHeaderSize >= 1024)
     {
-      h = calHeader;
-      ScancoImageIO::StripString(this->m_CalibrationData, h + 28, 64);
-      // std::string calFile(h + 112, 256);
-      // std::string s3(h + 376, 256);
-      this->m_RescaleType = ScancoImageIO::DecodeInt(h + 632);
-      ScancoImageIO::StripString(this->m_RescaleUnits, h + 648, 16);
-      // std::string s5(h + 700, 16);
-      // std::string calFilter(h + 772, 16);
-      this->m_RescaleSlope = ScancoImageIO::DecodeDouble(h + 664);
-      this->m_RescaleIntercept = ScancoImageIO::DecodeDouble(h + 672);
-      this->m_MuWater = ScancoImageIO::DecodeDouble(h + 688);
+      // not decoded: calibration file name at 112, filter at 772
+      ScancoImageIO::DecodeHeaderFields(
+        calHeader, std::begin(isqCalibrationFields), std::end(isqCalibrationFields), header);
     }
   }
 
-  // Include conversion to linear att coeff in the rescaling
-  if (this->m_MuScaling > 1.0)
+  return 1;
+}
+
+
+bool
+ScancoImageIO::DecodeAIMDataType(int dataType, ScancoHeader & header)
+{
+  // number of components per pixel is 1 by default
+  header.PixelType = IOPixelEnum::SCALAR;
+  header.Compression = 0;
+
+  // a limited selection of data types are supported
+  // (only 0x00010001 (char) and 0x00020002 (short) are fully tested)
+  switch (dataType)
   {
-    this->m_RescaleSlope /= this->m_MuScaling;
+    case 0x00160001:
+      header.ComponentType = IOComponentEnum::UCHAR;
+      break;
+    case 0x000d0001:
+      header.ComponentType = IOComponentEnum::UCHAR;
+      break;
+    case 0x00120003:
+      header.ComponentType = IOComponentEnum::UCHAR;
+      header.PixelType = IOPixelEnum::VECTOR;
+      break;
+    case 0x00010001:
+      header.ComponentType = IOComponentEnum::CHAR;
+      break;
+    case 0x00060003:
+      header.ComponentType = IOComponentEnum::CHAR;
+      header.PixelType = IOPixelEnum::VECTOR;
+      break;
+    case 0x00170002:
+      header.ComponentType = IOComponentEnum::USHORT;
+      break;
+    case 0x00020002:
+      header.ComponentType = IOComponentEnum::SHORT;
+      break;
+    case 0x00030004:
+      header.ComponentType = IOComponentEnum::INT;
+      break;
+    case 0x001a0004:
+      header.ComponentType = IOComponentEnum::FLOAT;
+      break;
+    case 0x00150001:
+      header.Compression = 0x00b2; // run-length compressed bits
+      header.ComponentType = IOComponentEnum::CHAR;
+      break;
+    case 0x00080002:
+      header.Compression = 0x00c2; // run-length compressed signed char
+      header.ComponentType = IOComponentEnum::CHAR;
+      break;
+    case 0x00060001:
+      header.Compression = 0x00b1; // packed bits
+      header.ComponentType = IOComponentEnum::CHAR;
+      break;
+    default:
+      return false;
   }
 
-  return 1;
+  return true;
 }
 
 
 int
-ScancoImageIO::ReadAIMHeader(std::ifstream * file, unsigned long bytesRead)
+ScancoImageIO::ReadAIMHeader(std::istream *      file,
+                             SizeValueType       bytesRead,
+                             std::vector<char> & rawHeader,
+                             ScancoHeader &      header)
 {
   if (bytesRead < 160)
   {
     return 0;
   }
 
-  char *        h = this->m_RawHeader;
-  int           intSize = 0;
-  unsigned long headerSize = 0;
+  char *        h = rawHeader.data();
+  SizeValueType intSize = 0;
+  SizeValueType headerSize = 0;
 
   // True for AIM v030, False for AIM v020
   bool versionV030 = !strcmp(h, "AIMDATA_V030   ");
@@ -619,7 +1615,7 @@ ScancoImageIO::ReadAIMHeader(std::ifstream * file, unsigned long bytesRead)
     // All header data is saved as 64-bit ints (8 bytes), except for the datatype which is a 32-bit int
     // AIMDATA_V030 data has 16-bits (2 bytes) extra at the front of the header for a string containing "AIMDATA_V030"
     intSize = 8;
-    strcpy(this->m_Version, h);
+    strcpy(header.Version, h);
     headerSize = 16;
     h += headerSize;
   }
@@ -627,32 +1623,47 @@ ScancoImageIO::ReadAIMHeader(std::ifstream * file, unsigned long bytesRead)
   {
     // All header data is saved as 32-bit ints (4 bytes), except for element size which is saved as a float
     intSize = 4;
-    strcpy(this->m_Version, "AIMDATA_V020   ");
+    strcpy(header.Version, "AIMDATA_V020   ");
   }
 
   // Read the pre-header
   // AIM header is divided into 3 sections: a preheader, a struct containing volume info, and a processing log
-  char * preheader = h;
-  int    preheaderSize = ScancoImageIO::DecodeInt(h);
+  char *             preheader = h;
+  const std::int64_t preheaderSize = ScancoImageIO::DecodeAIMInt(h, intSize);
   h += intSize;
-  int structSize = ScancoImageIO::DecodeInt(h);
+  const std::int64_t structSize = ScancoImageIO::DecodeAIMInt(h, intSize);
   h += intSize;
-  int logSize = ScancoImageIO::DecodeInt(h);
+  const std::int64_t logSize = ScancoImageIO::DecodeAIMInt(h, intSize);
   h += intSize;
 
+  // the struct holds the datatype, the position, the dimensions and the element size
+  const SizeValueType minimumStructSize = (versionV030 ? 16 + 24 * intSize : 24 + 24 * intSize);
+  if (preheaderSize < static_cast<std::int64_t>(3 * intSize) || preheaderSize > 512 ||
+      structSize < static_cast<std::int64_t>(minimumStructSize) || logSize < 0 ||
+      static_cast<std::uint64_t>(structSize) > NumericTraits<SizeValueType>::max() / 4 ||
+      static_cast<std::uint64_t>(logSize) > NumericTraits<SizeValueType>::max() / 4)
+  {
+    return 0;
+  }
+
   // read the rest of the header
-  headerSize += preheaderSize + structSize + logSize;
-  this->m_HeaderSize = headerSize;
+  headerSize += static_cast<SizeValueType>(preheaderSize + structSize + logSize);
+  header.HeaderSize = headerSize;
 
   if (headerSize > bytesRead)
   {
-    h = new char[headerSize];
-    memcpy(h, this->m_RawHeader, bytesRead);
-    preheader = h + (preheader - this->m_RawHeader);
-    delete[] this->m_RawHeader;
-    this->m_RawHeader = h;
-    file->read(h + bytesRead, headerSize - bytesRead);
-    if (static_cast<unsigned long>(file->gcount()) < headerSize - bytesRead)
+    // a corrupt header can claim any size, check it before allocating it
+    const std::uint64_t fileSize = GetStreamSize(*file, bytesRead);
+    if (headerSize > fileSize)
+    {
+      itkGenericExceptionMacro("The AIM header size " << headerSize << " exceeds the file size " << fileSize);
+    }
+
+    const std::ptrdiff_t preheaderOffset = preheader - rawHeader.data();
+    rawHeader.resize(headerSize);
+    preheader = rawHeader.data() + preheaderOffset;
+    file->read(rawHeader.data() + bytesRead, headerSize - bytesRead);
+    if (static_cast<SizeValueType>(file->gcount()) < headerSize - bytesRead)
     {
       return 0;
     }
@@ -681,10 +1692,10 @@ ScancoImageIO::ReadAIMHeader(std::ifstream * file, unsigned long bytesRead)
   // structValues[0] to structValues[2] = image position
   // structValues[3] to structValues[5] = image dimensions
   // structValues[6] to structValues[21] = 15 blocks of zeros
-  int structValues[21];
-  for (int & structValue : structValues)
+  std::int64_t structValues[21];
+  for (std::int64_t & structValue : structValues)
   {
-    structValue = ScancoImageIO::DecodeInt(h);
+    structValue = ScancoImageIO::DecodeAIMInt(h, intSize);
     h += intSize;
   }
 
@@ -695,7 +1706,7 @@ ScancoImageIO::ReadAIMHeader(std::ifstream * file, unsigned long bytesRead)
     // AIMDATA_V030
     for (float & i : elementSize)
     {
-      i = 1e-6 * ScancoImageIO::DecodeInt(h);
+      i = 1e-6 * ScancoImageIO::DecodeInt64(h);
       if (i == 0)
       {
         i = 1.0;
@@ -717,68 +1728,17 @@ ScancoImageIO::ReadAIMHeader(std::ifstream * file, unsigned long bytesRead)
     }
   }
 
-  // number of components per pixel is 1 by default
-  this->SetPixelType(IOPixelEnum::SCALAR);
-  this->m_Compression = 0;
-
-  // a limited selection of data types are supported
-  // (only 0x00010001 (char) and 0x00020002 (short) are fully tested)
-  switch (dataType)
+  if (!ScancoImageIO::DecodeAIMDataType(dataType, header))
   {
-    case 0x00160001:
-      this->SetComponentType(IOComponentEnum::UCHAR);
-      break;
-    case 0x000d0001:
-      this->SetComponentType(IOComponentEnum::UCHAR);
-      break;
-    case 0x00120003:
-      this->SetComponentType(IOComponentEnum::UCHAR);
-      this->SetPixelType(IOPixelEnum::VECTOR);
-      this->SetNumberOfDimensions(3);
-      break;
-    case 0x00010001:
-      this->SetComponentType(IOComponentEnum::CHAR);
-      break;
-    case 0x00060003:
-      this->SetComponentType(IOComponentEnum::CHAR);
-      this->SetPixelType(IOPixelEnum::VECTOR);
-      this->SetNumberOfDimensions(3);
-      break;
-    case 0x00170002:
-      this->SetComponentType(IOComponentEnum::USHORT);
-      break;
-    case 0x00020002:
-      this->SetComponentType(IOComponentEnum::SHORT);
-      break;
-    case 0x00030004:
-      this->SetComponentType(IOComponentEnum::INT);
-      break;
-    case 0x001a0004:
-      this->SetComponentType(IOComponentEnum::FLOAT);
-      break;
-    case 0x00150001:
-      this->m_Compression = 0x00b2; // run-length compressed bits
-      this->SetComponentType(IOComponentEnum::CHAR);
-      break;
-    case 0x00080002:
-      this->m_Compression = 0x00c2; // run-length compressed signed char
-      this->SetComponentType(IOComponentEnum::CHAR);
-      break;
-    case 0x00060001:
-      this->m_Compression = 0x00b1; // packed bits
-      this->SetComponentType(IOComponentEnum::CHAR);
-      break;
-    default:
-      itkExceptionMacro("Unrecognized data type in AIM file: " << dataType);
+    itkGenericExceptionMacro("Unrecognized data type in AIM file: " << dataType);
   }
 
-  this->SetNumberOfDimensions(3);
-  for (unsigned int i = 0; i < m_NumberOfDimensions; ++i)
+  for (unsigned int i = 0; i < 3; ++i)
   {
-    this->SetDimensions(i, structValues[3 + i]);
-    this->SetSpacing(i, elementSize[i]);
+    header.Dimensions[i] = (structValues[3 + i] < 0 ? 0 : static_cast<SizeValueType>(structValues[3 + i]));
+    header.Spacing[i] = elementSize[i];
     // the origin will reflect the cropping of the data
-    this->SetOrigin(i, elementSize[i] * structValues[i]);
+    header.Origin[i] = elementSize[i] * structValues[i];
   }
 
   // decode the processing log
@@ -825,210 +1785,410 @@ ScancoImageIO::ReadAIMHeader(std::ifstream * file, unsigned long bytesRead)
         --valuelen;
       }
 
-      // convert into a std::string for convenience
-      std::string skey(key, keylen);
-
       // check for known keys
-      if (skey == "Time")
-      {
-        valuelen = (valuelen > 31 ? 31 : valuelen);
-        strncpy(this->m_ModificationDate, value, valuelen);
-        this->m_ModificationDate[valuelen] = '\0';
-      }
-      else if (skey == "Original Creation-Date")
-      {
-        valuelen = (valuelen > 31 ? 31 : valuelen);
-        strncpy(this->m_CreationDate, value, valuelen);
-        this->m_CreationDate[valuelen] = '\0';
-      }
-      else if (skey == "Orig-ISQ-Dim-p")
-      {
-        for (int & ScanDimensionsPixel : this->ScanDimensionsPixels)
-        {
-          ScanDimensionsPixel = strtol(value, &value, 10);
-        }
-      }
-      else if (skey == "Orig-ISQ-Dim-um")
+      const AIMLogField * field = ScancoImageIO::FindAIMLogField(key, keylen);
+      if (field != nullptr)
       {
-        for (double & i : this->ScanDimensionsPhysical)
+        ScancoImageIO::DecodeAIMLogValue(*field, value, valuelen, header);
+        if (field->Member == offsetof(ScancoHeader, StartPosition))
         {
-          i = strtod(value, &value) * 1e-3;
+          header.EndPosition = header.StartPosition + elementSize[2] * (structValues[5] - 1);
         }
       }
-      else if (skey == "Patient Name")
-      {
-        valuelen = (valuelen > 41 ? 41 : valuelen);
-        strncpy(this->m_PatientName, value, valuelen);
-        this->m_PatientName[valuelen] = '\0';
-      }
-      else if (skey == "Index Patient")
-      {
-        this->m_PatientIndex = strtol(value, nullptr, 10);
-      }
-      else if (skey == "Index Measurement")
-      {
-        this->m_MeasurementIndex = strtol(value, nullptr, 10);
-      }
-      else if (skey == "Site")
-      {
-        this->m_Site = strtol(value, nullptr, 10);
-      }
-      else if (skey == "Scanner ID")
-      {
-        this->m_ScannerID = strtol(value, nullptr, 10);
-      }
-      else if (skey == "Scanner type")
-      {
-        this->m_ScannerType = strtol(value, nullptr, 10);
-      }
-      else if (skey == "Position Slice 1 [um]")
-      {
-        this->m_StartPosition = strtod(value, nullptr) * 1e-3;
-        this->m_EndPosition = this->m_StartPosition + elementSize[2] * (structValues[5] - 1);
-      }
-      else if (skey == "No. samples")
-      {
-        this->m_NumberOfSamples = strtol(value, nullptr, 10);
-      }
-      else if (skey == "No. projections per 180")
-      {
-        this->m_NumberOfProjections = strtol(value, nullptr, 10);
-      }
-      else if (skey == "Scan Distance [um]")
-      {
-        this->m_ScanDistance = strtod(value, nullptr) * 1e-3;
-      }
-      else if (skey == "Integration time [us]")
-      {
-        this->m_SampleTime = strtod(value, nullptr) * 1e-3;
-      }
-      else if (skey == "Reference line [um]")
-      {
-        this->m_ReferenceLine = strtod(value, nullptr) * 1e-3;
-      }
-      else if (skey == "Reconstruction-Alg.")
-      {
-        this->m_ReconstructionAlg = strtol(value, nullptr, 10);
-      }
-      else if (skey == "Energy [V]")
-      {
-        this->m_Energy = strtod(value, nullptr) * 1e-3;
-      }
-      else if (skey == "Intensity [uA]")
-      {
-        this->m_Intensity = strtod(value, nullptr) * 1e-3;
-      }
-      else if (skey == "Mu_Scaling")
-      {
-        this->m_MuScaling = strtol(value, nullptr, 10);
-      }
-      else if (skey == "Minimum data value")
-      {
-        this->m_DataRange[0] = strtod(value, nullptr);
-      }
-      else if (skey == "Maximum data value")
-      {
-        this->m_DataRange[1] = strtod(value, nullptr);
-      }
-      else if (skey == "Calib. default unit type")
-      {
-        this->m_RescaleType = strtol(value, nullptr, 10);
-      }
-      else if (skey == "Calibration Data")
-      {
-        valuelen = (valuelen > 64 ? 64 : valuelen);
-        strncpy(this->m_CalibrationData, value, valuelen);
-        this->m_CalibrationData[valuelen] = '\0';
-      }
-      else if (skey == "Density: unit")
-      {
-        valuelen = (valuelen > 16 ? 16 : valuelen);
-        strncpy(this->m_RescaleUnits, value, valuelen);
-        this->m_RescaleUnits[valuelen] = '\0';
-      }
-      else if (skey == "Density: slope")
-      {
-        this->m_RescaleSlope = strtod(value, nullptr);
-      }
-      else if (skey == "Density: intercept")
-      {
-        this->m_RescaleIntercept = strtod(value, nullptr);
-      }
-      else if (skey == "HU: mu water")
-      {
-        this->m_MuWater = strtod(value, nullptr);
-      }
     }
     // skip to the end of the line
     h = lineEnd;
   }
 
+  // these items are not in the processing log
+  header.SliceThickness = elementSize[2];
+  header.SliceIncrement = elementSize[2];
+
+  return 1;
+}
+
+
+bool
+ScancoImageIO::ReadHeader(std::istream & file, std::vector<char> & rawHeader, ScancoHeader & header)
+{
+  header = ScancoHeader();
+
+  // header is a 512 byte block
+  rawHeader.resize(512);
+  file.read(rawHeader.data(), 512);
+  SizeValueType bytesRead = 0;
+  if (!file.bad())
+  {
+    bytesRead = static_cast<SizeValueType>(file.gcount());
+    header.FileType = ScancoImageIO::CheckVersion(rawHeader.data());
+  }
+
+  if (header.FileType == 0)
+  {
+    return false;
+  }
+
+  const int parsed = (header.FileType == 1 ? ScancoImageIO::ReadISQHeader(&file, bytesRead, rawHeader, header)
+                                            : ScancoImageIO::ReadAIMHeader(&file, bytesRead, rawHeader, header));
+  if (parsed == 0)
+  {
+    return false;
+  }
+
+  ScancoImageIO::ComputeRescale(header);
+
+  return true;
+}
+
+
+void
+ScancoImageIO::ComputeRescale(ScancoHeader & header)
+{
   // Include conversion to linear att coeff in the rescaling
-  if (this->m_MuScaling > 1.0)
+  header.RescaleSlope = header.DensitySlope;
+  header.RescaleIntercept = header.DensityIntercept;
+  if (header.MuScaling > 1.0)
   {
-    this->m_RescaleSlope /= this->m_MuScaling;
+    header.RescaleSlope /= header.MuScaling;
   }
 
-  // these items are not in the processing log
-  this->m_SliceThickness = elementSize[2];
-  this->m_SliceIncrement = elementSize[2];
+  // This code causes rescaling to Hounsfield units
+  if (header.MuScaling > 1.0 && header.MuWater > 0)
+  {
+    // mu(voxel) = intensity(voxel) / m_MuScaling
+    // HU(voxel) = mu(voxel) * 1000/m_MuWater - 1000
+    // Or, HU(voxel) = intensity(voxel) * (1000 / m_MuWater * m_MuScaling) - 1000
+    header.RescaleSlope = 1000.0 / (header.MuWater * header.MuScaling);
+    header.RescaleIntercept = -1000.0;
+  }
+}
 
-  return 1;
+
+ScancoImageIO::HeaderPointer
+ScancoImageIO::ReadHeader(const std::string & fileName)
+{
+  std::ifstream infile(fileName.c_str(), std::ios::in | std::ios::binary);
+  if (!infile.is_open())
+  {
+    itkGenericExceptionMacro("Could not open file for reading: " << fileName);
+  }
+
+  std::vector<char> rawHeader;
+  auto              header = std::make_shared<ScancoHeader>();
+  if (!ScancoImageIO::ReadHeader(infile, rawHeader, *header))
+  {
+    itkGenericExceptionMacro("Unrecognized header in: " << fileName);
+  }
+
+  return header;
+}
+
+
+void
+ScancoImageIO::PatchHeader(const std::string & fileName, const HeaderPatch & patch)
+{
+  int year = 0, month = 0, day = 0, hour = 0, minute = 0, second = 0, millis = 0;
+  if (patch.ReplaceDate && !ParseDate(patch.Date, year, month, day, hour, minute, second, millis))
+  {
+    itkGenericExceptionMacro("Invalid date: " << patch.Date);
+  }
+
+  ScancoRawFile file;
+  file.OpenForUpdate(fileName);
+  char block[512];
+  file.Read(block, sizeof(block), 0);
+  const int fileType = ScancoImageIO::CheckVersion(block);
+
+  if (fileType == 1)
+  {
+    // everything is in the first block
+    if (patch.ReplacePatientName)
+    {
+      const unsigned int offset = (ScancoImageIO::IsRADHeader(block) ? radPatientNameOffset : isqPatientNameOffset);
+      ScancoImageIO::PadString(block + offset, patch.PatientName.c_str(), 40);
+    }
+    if (patch.ReplacePatientIndex)
+    {
+      ScancoImageIO::EncodeInt(patch.PatientIndex, block + isqPatientIndexOffset);
+    }
+    if (patch.ReplaceDate)
+    {
+      ScancoImageIO::EncodeDate(block + isqDateOffset, year, month, day, hour, minute, second, millis);
+    }
+    file.Write(block, sizeof(block), 0);
+    file.Close();
+    return;
+  }
+  if (fileType != 2 && fileType != 3)
+  {
+    itkGenericExceptionMacro("Unrecognized header in: " << fileName);
+  }
+
+  // The AIM log follows the version, the pre-header and the struct
+  const SizeValueType intSize = (fileType == 3 ? 8 : 4);
+  const SizeValueType preheaderOffset = (fileType == 3 ? 16 : 0);
+  const std::int64_t  preheaderSize = ScancoImageIO::DecodeAIMInt(block + preheaderOffset, intSize);
+  const std::int64_t  structSize = ScancoImageIO::DecodeAIMInt(block + preheaderOffset + intSize, intSize);
+  const std::int64_t  logSize = ScancoImageIO::DecodeAIMInt(block + preheaderOffset + 2 * intSize, intSize);
+  if (preheaderSize < static_cast<std::int64_t>(3 * intSize) || preheaderSize > 256 || structSize < 0 ||
+      structSize > (1 << 20) || logSize < 0 || logSize > (1 << 30))
+  {
+    itkGenericExceptionMacro("Invalid AIM header in: " << fileName);
+  }
+  const SizeValueType logOffset = preheaderOffset + preheaderSize + structSize;
+  std::string         log(static_cast<size_t>(logSize), '\0');
+  file.Read(&log[0], log.size(), logOffset);
+  log.resize(std::min(log.find('\0'), log.size()));
+
+  std::vector<std::pair<std::string, std::string>> values;
+  if (patch.ReplacePatientName)
+  {
+    values.emplace_back("Patient Name", patch.PatientName);
+  }
+  if (patch.ReplacePatientIndex)
+  {
+    values.emplace_back("Index Patient", std::to_string(patch.PatientIndex));
+  }
+  if (patch.ReplaceDate)
+  {
+    char date[32];
+    snprintf(
+      date, sizeof(date), "%d-%s-%d %02d:%02d:%02d.%03d", day, monthNames[month], year, hour, minute, second, millis);
+    values.emplace_back("Time", date);
+    values.emplace_back("Original Creation-Date", date);
+  }
+  std::string newLog = ReplaceAIMLogValues(log, values);
+
+  if (newLog.size() <= static_cast<size_t>(logSize))
+  {
+    // the rest of the space of the log is cleared
+    newLog.resize(static_cast<size_t>(logSize), '\0');
+    file.Write(newLog.data(), newLog.size(), logOffset);
+    file.Close();
+    return;
+  }
+
+  // Build the file again in a temporary file, with a larger log
+  newLog.push_back('\0');
+  std::vector<char> header(logOffset);
+  file.Read(header.data(), header.size(), 0);
+  for (SizeValueType i = 0; i < intSize; ++i)
+  {
+    header[preheaderOffset + 2 * intSize + i] = static_cast<char>(static_cast<std::uint64_t>(newLog.size()) >> (8 * i));
+  }
+  const SizeValueType dataOffset = logOffset + logSize;
+  const SizeValueType fileSize = file.GetSize();
+  if (fileSize < dataOffset)
+  {
+    itkGenericExceptionMacro("File is truncated: " << fileName);
+  }
+
+  ScancoTemporaryFile temporaryFile(fileName);
+  {
+    ScancoRawFile output;
+    output.Open(temporaryFile.GetFileName(), true);
+    output.Write(header.data(), header.size(), 0);
+    output.Write(newLog.data(), newLog.size(), logOffset);
+    output.CopyFrom(file, dataOffset, fileSize - dataOffset, logOffset + newLog.size());
+    output.Close();
+    file.Close();
+  }
+  temporaryFile.Commit();
+}
+
+
+void
+ScancoImageIO::CopySlices(const std::vector<SliceRange> & ranges, const std::string & outputFileName)
+{
+  if (ranges.empty())
+  {
+    itkGenericExceptionMacro("No slices to copy to: " << outputFileName);
+  }
+
+  // Check all of the files before anything is written
+  std::vector<char>          header;
+  std::vector<SliceRange>    sources(ranges);
+  std::vector<SizeValueType> dataOffsets;
+  HeaderPointer              firstHeader;
+  ScancoHeader               dataRange;
+  SizeValueType              numberOfSlices = 0;
+  for (SliceRange & source : sources)
+  {
+    ScancoRawFile file;
+    file.Open(source.FileName, false);
+    char block[512];
+    file.Read(block, sizeof(block), 0);
+    if (ScancoImageIO::CheckVersion(block) != 1 || ScancoImageIO::IsRADHeader(block))
+    {
+      itkGenericExceptionMacro("Slices can only be copied from ISQ files: " << source.FileName);
+    }
+    const HeaderPointer sourceHeader = ScancoImageIO::ReadHeader(source.FileName);
+    const SizeValueType sourceSlices = sourceHeader->Dimensions[2];
+    if (source.NumberOfSlices == 0 && source.FirstSlice < sourceSlices)
+    {
+      source.NumberOfSlices = sourceSlices - source.FirstSlice;
+    }
+    if (source.NumberOfSlices == 0 || source.FirstSlice + source.NumberOfSlices > sourceSlices)
+    {
+      itkGenericExceptionMacro("Slices " << source.FirstSlice << " to " << source.FirstSlice + source.NumberOfSlices
+                                         << " are not in the " << sourceSlices << " slices of: " << source.FileName);
+    }
+    dataOffsets.push_back(sourceHeader->HeaderSize);
+    numberOfSlices += source.NumberOfSlices;
+
+    if (firstHeader == nullptr)
+    {
+      firstHeader = sourceHeader;
+      header.resize(sourceHeader->HeaderSize);
+      file.Read(header.data(), header.size(), 0);
+      ScancoImageIO::DecodeHeaderFields(
+        header.data(), std::begin(isqDataRangeFields), std::end(isqDataRangeFields), dataRange);
+      continue;
+    }
+
+    bool matches = (sourceHeader->RescaleSlope == firstHeader->RescaleSlope &&
+                    sourceHeader->RescaleIntercept == firstHeader->RescaleIntercept);
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+      matches = matches && (i == 2 || sourceHeader->Dimensions[i] == firstHeader->Dimensions[i]) &&
+                itk::Math::abs(sourceHeader->Spacing[i] - firstHeader->Spacing[i]) <= 1e-4 * firstHeader->Spacing[i];
+    }
+    if (!matches)
+    {
+      itkGenericExceptionMacro("The dimensions, spacing or calibration of "
+                               << source.FileName << " differ from those of " << sources[0].FileName);
+    }
+    ScancoHeader sourceDataRange;
+    ScancoImageIO::DecodeHeaderFields(
+      block, std::begin(isqDataRangeFields), std::end(isqDataRangeFields), sourceDataRange);
+    dataRange.DataRange[0] = std::min(dataRange.DataRange[0], sourceDataRange.DataRange[0]);
+    dataRange.DataRange[1] = std::max(dataRange.DataRange[1], sourceDataRange.DataRange[1]);
+  }
+  if (numberOfSlices > static_cast<SizeValueType>(NumericTraits<int>::max()))
+  {
+    itkGenericExceptionMacro("Too many slices for an ISQ file: " << numberOfSlices);
+  }
+
+  // Only the fields that depend on the slices are changed. The physical
+  // size and the start position are in micrometers.
+  char *              block = header.data();
+  const auto          sliceCount = static_cast<std::int64_t>(firstHeader->Dimensions[2]);
+  const std::int64_t  sliceSize = ScancoImageIO::DecodeInt(block + isqPhysicalDimensionsOffset + 8);
+  const SizeValueType sliceBytes = firstHeader->Dimensions[0] * firstHeader->Dimensions[1] * sizeof(short);
+  ScancoImageIO::EncodeInt(static_cast<int>(numberOfSlices), block + isqPixelDimensionsOffset + 8);
+  ScancoImageIO::EncodeInt(static_cast<int>(sliceSize * static_cast<std::int64_t>(numberOfSlices) / sliceCount),
+                           block + isqPhysicalDimensionsOffset + 8);
+  ScancoImageIO::EncodeInt(
+    ScancoImageIO::DecodeInt(block + isqStartPositionOffset) +
+      static_cast<int>(sliceSize * static_cast<std::int64_t>(sources[0].FirstSlice) / sliceCount),
+    block + isqStartPositionOffset);
+  ScancoImageIO::EncodeISQDataSize(numberOfSlices * sliceBytes, block);
+  ScancoImageIO::EncodeHeaderFields(dataRange, std::begin(isqDataRangeFields), std::end(isqDataRangeFields), block);
+
+  ScancoTemporaryFile temporaryFile(outputFileName);
+  {
+    ScancoRawFile output;
+    output.Open(temporaryFile.GetFileName(), true);
+    output.Write(header.data(), header.size(), 0);
+    SizeValueType offset = header.size();
+    for (size_t i = 0; i < sources.size(); ++i)
+    {
+      ScancoRawFile file;
+      file.Open(sources[i].FileName, false);
+      const SizeValueType size = sources[i].NumberOfSlices * sliceBytes;
+      output.CopyFrom(file, dataOffsets[i] + sources[i].FirstSlice * sliceBytes, size, offset);
+      offset += size;
+    }
+    output.Close();
+  }
+  temporaryFile.Commit();
+}
+
+
+void
+ScancoImageIO::SetHeader(const HeaderPointer & header)
+{
+  if (header == nullptr)
+  {
+    itkExceptionMacro("Header must not be null.");
+  }
+
+  this->m_Header = header;
+  this->CopyHeaderToMembers(*header);
+  this->m_HeaderInitialized = true;
+
+  this->SetNumberOfDimensions(3);
+  for (unsigned int i = 0; i < m_NumberOfDimensions; ++i)
+  {
+    this->SetDimensions(i, header->Dimensions[i]);
+    this->SetSpacing(i, header->Spacing[i]);
+    this->SetOrigin(i, header->Origin[i]);
+  }
+  this->SetPixelType(header->PixelType);
+  this->SetComponentType(this->m_ThresholdOnRead ? IOComponentEnum::UCHAR : header->ComponentType);
+
+  this->PopulateMetaDataDictionary();
+  this->Modified();
 }
 
 
 void
 ScancoImageIO::ReadImageInformation()
 {
+  // A read that fails leaves no header behind
   this->InitializeHeader();
+  this->m_Header.reset();
 
   if (this->m_FileName.empty())
   {
     itkExceptionMacro("FileName has not been set.");
   }
 
-  std::ifstream infile;
-  this->OpenFileForReading(infile, this->m_FileName);
-
-  // header is a 512 byte block
-  this->m_RawHeader = new char[512];
-  infile.read(this->m_RawHeader, 512);
-  int           fileType = 0;
-  unsigned long bytesRead = 0;
-  if (!infile.bad())
+  if (this->m_UseHeaderCache)
   {
-    bytesRead = static_cast<unsigned long>(infile.gcount());
-    fileType = ScancoImageIO::CheckVersion(this->m_RawHeader);
+    // Read() opens the file when it is needed
+    this->m_ServiceFile.close();
+    this->SetHeader(ScancoHeaderCache::GetInstance().ReadHeader(this->m_FileName));
+    return;
   }
 
-  if (fileType == 0)
-  {
-    infile.close();
-    itkExceptionMacro("Unrecognized header in: " << m_FileName);
-  }
+  std::ifstream   localFile;
+  std::ifstream & infile = this->m_ServiceMode ? this->m_ServiceFile : localFile;
+  this->OpenFileForReading(infile, this->m_FileName);
 
-  if (fileType == 1)
+  // In service mode, parse into the previous header unless someone else
+  // still holds on to it
+  std::shared_ptr<ScancoHeader> header;
+  if (this->m_ServiceMode && this->m_ServiceHeader != nullptr && this->m_ServiceHeader.use_count() == 1)
   {
-    this->ReadISQHeader(&infile, bytesRead);
+    header = this->m_ServiceHeader;
   }
   else
   {
-    this->ReadAIMHeader(&infile, bytesRead);
+    header = std::make_shared<ScancoHeader>();
   }
 
-  infile.close();
+  const bool recognized = ScancoImageIO::ReadHeader(infile, this->m_RawHeader, *header);
+  if (!this->m_ServiceMode)
+  {
+    infile.close();
+    // the raw header is only needed during parsing
+    std::vector<char>().swap(this->m_RawHeader);
+  }
 
-  // This code causes rescaling to Hounsfield units
-  if (this->m_MuScaling > 1.0 && this->m_MuWater > 0)
+  if (!recognized)
   {
-    // mu(voxel) = intensity(voxel) / m_MuScaling
-    // HU(voxel) = mu(voxel) * 1000/m_MuWater - 1000
-    // Or, HU(voxel) = intensity(voxel) * (1000 / m_MuWater * m_MuScaling) - 1000
-    this->m_RescaleSlope = 1000.0 / (this->m_MuWater * this->m_MuScaling);
-    this->m_RescaleIntercept = -1000.0;
+    infile.close();
+    itkExceptionMacro("Unrecognized header in: " << m_FileName);
   }
 
-  this->PopulateMetaDataDictionary();
+  if (this->m_ServiceMode)
+  {
+    this->m_ServiceHeader = header;
+    // the stream stays open, positioned for Read()
+    infile.clear();
+  }
+  this->SetHeader(header);
 }
 
 void
@@ -1065,6 +2225,8 @@ ScancoImageIO::PopulateMetaDataDictionary()
   EncapsulateMetaData<double>(thisDic, "RescaleSlope", this->m_RescaleSlope);
   EncapsulateMetaData<double>(thisDic, "RescaleIntercept", this->m_RescaleIntercept);
   EncapsulateMetaData<double>(thisDic, "MuWater", this->m_MuWater);
+  EncapsulateMetaData<double>(thisDic, "DensitySlope", this->m_DensitySlope);
+  EncapsulateMetaData<double>(thisDic, "DensityIntercept", this->m_DensityIntercept);
 }
 
 void
@@ -1131,6 +2293,8 @@ ScancoImageIO::SetHeaderFromMetaDataDictionary()
   ExposeMetaData<double>(metaData, "RescaleSlope", this->m_RescaleSlope);
   ExposeMetaData<double>(metaData, "RescaleIntercept", this->m_RescaleIntercept);
   ExposeMetaData<double>(metaData, "MuWater", this->m_MuWater);
+  ExposeMetaData<double>(metaData, "DensitySlope", this->m_DensitySlope);
+  ExposeMetaData<double>(metaData, "DensityIntercept", this->m_DensityIntercept);
 }
 
 template <typename TBufferType>
@@ -1145,213 +2309,1015 @@ RescaleToHU(TBufferType * buffer, size_t size, double slope, double intercept)
   }
 }
 
+
+namespace
+{
+// The largest slab that a mask is read in at a time, in bytes
+constexpr SizeValueType maskSlabBytes = 16 * 1024 * 1024;
+
+// The calibration that thresholds are applied with: the density calibration,
+// except for run-length encoded data, which holds segmentations and is never
+// calibrated
 void
-ScancoImageIO::Read(void * buffer)
+GetMaskCalibration(const ScancoHeader & header, double & slope, double & intercept)
 {
-  std::ifstream infile;
-  this->OpenFileForReading(infile, this->m_FileName);
+  slope = 1.0;
+  intercept = 0.0;
+  if (header.Compression != 0x00b2 && header.Compression != 0x00c2)
+  {
+    slope = header.DensitySlope;
+    if (header.MuScaling > 1.0)
+    {
+      slope /= header.MuScaling;
+    }
+    intercept = header.DensityIntercept;
+  }
+}
+
+
+// Set the mask to insideValue where slope * value + intercept lies within
+// [lower, upper], and to zero elsewhere. Values of at most 16 bits are looked
+// up in a table of all of their values. The mask may alias the buffer.
+template <typename TBufferType>
+void
+ThresholdValuesToMask(const TBufferType * buffer,
+                      SizeValueType       size,
+                      double              slope,
+                      double              intercept,
+                      double              lower,
+                      double              upper,
+                      unsigned char       insideValue,
+                      unsigned char *     mask)
+{
+  const auto maskValue = [=](double value) -> unsigned char {
+    value = value * slope + intercept;
+    return (value >= lower && value <= upper) ? insideValue : 0;
+  };
+  if (std::is_integral<TBufferType>::value && sizeof(TBufferType) <= 2)
+  {
+    const int64_t              lowest = static_cast<int64_t>(std::numeric_limits<TBufferType>::lowest());
+    std::vector<unsigned char> table(size_t{ 1 } << (8 * std::min<size_t>(sizeof(TBufferType), 2)));
+    for (size_t i = 0; i < table.size(); ++i)
+    {
+      table[i] = maskValue(static_cast<double>(lowest + static_cast<int64_t>(i)));
+    }
+    for (SizeValueType i = 0; i < size; ++i)
+    {
+      mask[i] = table[static_cast<size_t>(static_cast<int64_t>(buffer[i]) - lowest)];
+    }
+    return;
+  }
+  for (SizeValueType i = 0; i < size; ++i)
+  {
+    mask[i] = maskValue(static_cast<double>(buffer[i]));
+  }
+}
+
+
+void
+ThresholdToMask(IOComponentEnum componentType,
+                const void *    buffer,
+                SizeValueType   size,
+                double          slope,
+                double          intercept,
+                double          lower,
+                double          upper,
+                unsigned char   insideValue,
+                unsigned char * mask)
+{
+  switch (componentType)
+  {
+    case IOComponentEnum::CHAR:
+      ThresholdValuesToMask(static_cast<const char *>(buffer), size, slope, intercept, lower, upper, insideValue, mask);
+      break;
+    case IOComponentEnum::UCHAR:
+      ThresholdValuesToMask(
+        static_cast<const unsigned char *>(buffer), size, slope, intercept, lower, upper, insideValue, mask);
+      break;
+    case IOComponentEnum::SHORT:
+      ThresholdValuesToMask(
+        static_cast<const short *>(buffer), size, slope, intercept, lower, upper, insideValue, mask);
+      break;
+    case IOComponentEnum::USHORT:
+      ThresholdValuesToMask(
+        static_cast<const unsigned short *>(buffer), size, slope, intercept, lower, upper, insideValue, mask);
+      break;
+    case IOComponentEnum::INT:
+      ThresholdValuesToMask(static_cast<const int *>(buffer), size, slope, intercept, lower, upper, insideValue, mask);
+      break;
+    case IOComponentEnum::UINT:
+      ThresholdValuesToMask(
+        static_cast<const unsigned int *>(buffer), size, slope, intercept, lower, upper, insideValue, mask);
+      break;
+    case IOComponentEnum::FLOAT:
+      ThresholdValuesToMask(
+        static_cast<const float *>(buffer), size, slope, intercept, lower, upper, insideValue, mask);
+      break;
+    default:
+      itkGenericExceptionMacro("Unrecognized data type in file: " << componentType);
+  }
+}
+} // end anonymous namespace
+
+
+SizeValueType
+ScancoImageIO::GetHeaderComponentSize(const ScancoHeader & header)
+{
+  switch (header.ComponentType)
+  {
+    case IOComponentEnum::CHAR:
+    case IOComponentEnum::UCHAR:
+      return 1;
+    case IOComponentEnum::SHORT:
+    case IOComponentEnum::USHORT:
+      return 2;
+    case IOComponentEnum::INT:
+    case IOComponentEnum::UINT:
+    case IOComponentEnum::FLOAT:
+      return 4;
+    default:
+      itkGenericExceptionMacro("Unrecognized data type in file: " << header.ComponentType);
+  }
+}
 
+
+SizeValueType
+ScancoImageIO::ReadCompressedData(std::istream & file, const ScancoHeader & header, std::vector<char> & inputBuffer)
+{
   // seek to the data
-  infile.seekg(this->m_HeaderSize);
+  file.seekg(header.HeaderSize);
 
   // get the size of the compressed data
-  int intSize = 4;
-  if (strcmp(this->m_Version, "AIMDATA_V030   ") == 0)
+  SizeValueType intSize = 4;
+  if (header.FileType == 3)
   {
     // header uses 64-bit ints (8 bytes)
     intSize = 8;
   }
 
-  // Dimensions of the data
-  const int xsize = this->GetDimensions(0);
-  const int ysize = this->GetDimensions(1);
-  const int zsize = this->GetDimensions(2);
-  size_t    outSize = xsize;
-  outSize *= ysize;
-  outSize *= zsize;
-  outSize *= this->GetComponentSize();
-
-  // For the input (compressed) data
-  char * input = nullptr;
   size_t size = 0;
-
-  if (this->m_Compression == 0)
-  {
-    infile.read(reinterpret_cast<char *>(buffer), outSize);
-    size = outSize;
-  }
-  else if (this->m_Compression == 0x00b1)
+  if (header.Compression == 0x00b1)
   {
     // Compute the size of the binary packed data
-    size_t xinc = (xsize + 1) / 2;
-    size_t yinc = (ysize + 1) / 2;
-    size_t zinc = (zsize + 1) / 2;
+    size_t xinc = (header.Dimensions[0] + 1) / 2;
+    size_t yinc = (header.Dimensions[1] + 1) / 2;
+    size_t zinc = (header.Dimensions[2] + 1) / 2;
     size = xinc * yinc * zinc + 1;
-    input = new char[size];
-    infile.read(input, size);
+    inputBuffer.resize(size);
+    file.read(inputBuffer.data(), size);
   }
-  else if (this->m_Compression == 0x00b2 || this->m_Compression == 0x00c2)
+  else if (header.Compression == 0x00b2 || header.Compression == 0x00c2)
   {
     // Get the size of the compressed data
     char head[8];
-    infile.read(head, intSize);
-    size = static_cast<unsigned int>(ScancoImageIO::DecodeInt(head));
-    if (intSize == 8)
+    file.read(head, intSize);
+    const std::int64_t totalSize = ScancoImageIO::DecodeAIMInt(head, intSize);
+    if (totalSize < static_cast<std::int64_t>(intSize))
     {
-      // Read the high word of a 64-bit int
-      unsigned int high = ScancoImageIO::DecodeInt(head + 4);
-      size += (static_cast<uint64_t>(high) << 32);
+      itkGenericExceptionMacro("Invalid size of compressed data: " << totalSize);
     }
-    input = new char[size - intSize];
-    size -= intSize;
-    infile.read(input, size);
+    size = static_cast<size_t>(totalSize) - intSize;
+    inputBuffer.resize(size);
+    file.read(inputBuffer.data(), size);
   }
 
   // confirm that enough data was read
-  size_t shortread = size - infile.gcount();
+  size_t shortread = size - file.gcount();
   if (shortread != 0)
   {
-    itkExceptionMacro("File is truncated, " << shortread << " bytes are missing");
+    itkGenericExceptionMacro("File is truncated, " << shortread << " bytes are missing");
   }
 
-  // Close the file
-  infile.close();
+  return size;
+}
 
-  auto * dataPtr = reinterpret_cast<unsigned char *>(buffer);
 
-  if (this->m_Compression == 0x00b1)
-  {
-    // Unpack binary data, each byte becomes a 2x2x2 block of voxels
-    size_t        xinc = (xsize + 1) / 2;
-    size_t        yinc = (ysize + 1) / 2;
-    unsigned char v = input[size - 1];
-    v = (v == 0 ? 0x7f : v);
-    unsigned char bit = 0;
-    for (int i = 0; i < zsize; i++)
-    {
-      bit ^= (bit & 2);
-      for (int j = 0; j < ysize; j++)
-      {
-        char * inPtr = input + (i * yinc + j) * xinc;
-        bit ^= (bit & 1);
-        for (int k = 0; k < xsize; k++)
-        {
-          unsigned char c = *inPtr;
-          *dataPtr++ = ((c >> bit) & 1) * v;
-          inPtr += (bit & 1);
-          bit ^= 1;
-        }
-        bit ^= 2;
-      }
-      bit ^= 4;
-    }
+void
+ScancoImageIO::DecodePackedRow(const char *         input,
+                               SizeValueType        size,
+                               const ScancoHeader & header,
+                               SizeValueType        y,
+                               SizeValueType        z,
+                               unsigned char *      row)
+{
+  // The bits of a byte are the voxels of a 2x2x2 block, and the last byte
+  // of the data is the value of the set voxels
+  const SizeValueType xinc = (header.Dimensions[0] + 1) / 2;
+  const SizeValueType yinc = (header.Dimensions[1] + 1) / 2;
+  unsigned char       v = input[size - 1];
+  v = (v == 0 ? 0x7f : v);
+  const char *  inPtr = input + ((z / 2) * yinc + y / 2) * xinc;
+  unsigned char bit = static_cast<unsigned char>(((z & 1) << 2) | ((y & 1) << 1));
+  for (SizeValueType k = 0; k < header.Dimensions[0]; k++)
+  {
+    unsigned char c = *inPtr;
+    *row++ = ((c >> bit) & 1) * v;
+    inPtr += (bit & 1);
+    bit ^= 1;
   }
-  else if (this->m_Compression == 0x00b2)
+}
+
+
+void
+ScancoImageIO::DecodeCompressedData(std::istream &      file,
+                                    const ScancoHeader & header,
+                                    void *               buffer,
+                                    std::vector<char> &  inputBuffer)
+{
+  // Dimensions of the data
+  const SizeValueType xsize = header.Dimensions[0];
+  const SizeValueType ysize = header.Dimensions[1];
+  const SizeValueType zsize = header.Dimensions[2];
+  size_t              outSize = xsize;
+  outSize *= ysize;
+  outSize *= zsize;
+  outSize *= ScancoImageIO::GetHeaderComponentSize(header);
+
+  // For the input (compressed) data
+  const size_t size = ScancoImageIO::ReadCompressedData(file, header, inputBuffer);
+  char *       input = inputBuffer.data();
+
+  auto * dataPtr = reinterpret_cast<unsigned char *>(buffer);
+
+  if (header.Compression == 0x00b1)
   {
-    // Decompress binary run-lengths
-    bool          flip = false;
-    unsigned char v = input[flip];
-    char *        inPtr = input + 2;
-    size -= 2;
-    if (size > 0)
+    // Unpack binary data, each byte becomes a 2x2x2 block of voxels
+    for (SizeValueType i = 0; i < zsize; i++)
     {
-      do
+      for (SizeValueType j = 0; j < ysize; j++)
       {
-        unsigned char l = *inPtr++;
-        if (l == 255)
+        ScancoImageIO::DecodePackedRow(input, size, header, j, i, dataPtr);
+        dataPtr += xsize;
+      }
+    }
+  }
+  else if (ScancoRunLengthDecoder::IsRunLength(header.Compression))
+  {
+    // Decompress binary or 8-bit run-lengths, zero the rest if the data ends early
+    const ScancoRunLengthDecoder  decoder(header.Compression, input, size);
+    ScancoRunLengthDecoder::State state = decoder.GetInitialState();
+    const SizeValueType           produced = decoder.Decode(state, dataPtr, outSize);
+    memset(dataPtr + produced, 0, outSize - produced);
+  }
+}
+
+
+void
+ScancoImageIO::Read(void * buffer)
+{
+  ImageIORegion region = this->m_IORegion;
+  if (region.GetImageDimension() != 3)
+  {
+    // no region was requested, read the whole image
+    region = ImageIORegion(3);
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+      region.SetIndex(i, 0);
+      region.SetSize(i, this->GetDimensions(i));
+    }
+  }
+
+  if (!this->m_ServiceMode && !this->m_ThresholdOnRead)
+  {
+    this->ReadRegion(region, buffer);
+    return;
+  }
+
+  // hold a reference, so that the header outlives this call
+  const HeaderPointer header = this->m_Header;
+  if (header == nullptr)
+  {
+    itkExceptionMacro("ReadImageInformation() or SetHeader() must be called before reading.");
+  }
+
+  // in service mode, continue with the stream that the header was read from
+  std::ifstream       localFile;
+  std::vector<char>   localInputBuffer;
+  std::vector<char>   localVolumeBuffer;
+  std::ifstream &     infile = this->m_ServiceMode ? this->m_ServiceFile : localFile;
+  std::vector<char> & inputBuffer = this->m_ServiceMode ? this->m_InputBuffer : localInputBuffer;
+  std::vector<char> & volumeBuffer = this->m_ServiceMode ? this->m_VolumeBuffer : localVolumeBuffer;
+  if (!infile.is_open())
+  {
+    this->OpenFileForReading(infile, this->m_FileName);
+  }
+  infile.clear();
+  if (this->m_ThresholdOnRead)
+  {
+    this->ReadMaskFromStream(infile,
+                             *header,
+                             region,
+                             static_cast<unsigned char *>(buffer),
+                             this->m_ThresholdInsideValue,
+                             inputBuffer,
+                             volumeBuffer);
+  }
+  else
+  {
+    ScancoImageIO::ReadRegionFromStream(infile, *header, region, buffer, inputBuffer, volumeBuffer);
+  }
+  infile.close();
+}
+
+
+void
+ScancoImageIO::ReadRegion(const ImageIORegion & region, void * buffer) const
+{
+  // hold a reference, so that the header outlives this call
+  const HeaderPointer header = this->m_Header;
+  if (header == nullptr)
+  {
+    itkExceptionMacro("ReadImageInformation() or SetHeader() must be called before reading.");
+  }
+
+  if (this->m_UseBrickCache &&
+      ScancoBrickCache::ReadRegion(
+        ScancoBrickCache::GetCacheFileName(this->m_FileName), this->m_FileName, *header, region, buffer))
+  {
+    return;
+  }
+
+  std::ifstream infile(this->m_FileName.c_str(), std::ios::in | std::ios::binary);
+  if (!infile.is_open())
+  {
+    itkExceptionMacro("Could not open file for reading: " << this->m_FileName);
+  }
+
+  std::vector<char> inputBuffer;
+  std::vector<char> volumeBuffer;
+  ScancoImageIO::ReadRegionFromStream(infile, *header, region, buffer, inputBuffer, volumeBuffer);
+}
+
+
+void
+ScancoImageIO::ReadOrthogonalSlice(unsigned int axis, SizeValueType index, void * buffer) const
+{
+  const HeaderPointer header = this->m_Header;
+  if (header == nullptr)
+  {
+    itkExceptionMacro("ReadImageInformation() or SetHeader() must be called before reading.");
+  }
+  if (axis > 2)
+  {
+    itkExceptionMacro("Axis must be 0, 1 or 2, not " << axis << ".");
+  }
+  if (index >= header->Dimensions[axis])
+  {
+    itkExceptionMacro("Slice " << index << " is outside of the image along axis " << axis << ".");
+  }
+
+  ImageIORegion region(3);
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    region.SetSize(i, header->Dimensions[i]);
+  }
+  region.SetIndex(axis, index);
+  region.SetSize(axis, 1);
+
+  if (axis == 2 || header->Compression != 0)
+  {
+    // xy planes are contiguous, and ReadRegion() decodes compressed data
+    this->ReadRegion(region, buffer);
+    return;
+  }
+
+  const SizeValueType pixelSize = ScancoImageIO::GetHeaderComponentSize(*header);
+  const SizeValueType xsize = header->Dimensions[0];
+  const SizeValueType ysize = header->Dimensions[1];
+  const SizeValueType zsize = header->Dimensions[2];
+
+  // Each slice of the volume contributes one row of the plane. An xz plane
+  // row is a contiguous row of the slice. A yz plane row is a column of the
+  // slice, with one pixel per row of the slice. Pixels whose rows are close
+  // together are read as one span and gathered, pixels of wide rows are read
+  // one by one, so that only a little more than the plane is read.
+  constexpr SizeValueType maximumGap = 64 * 1024;
+  constexpr SizeValueType maximumSpanSize = 1024 * 1024;
+  const SizeValueType     rowPitch = xsize * pixelSize;
+  const SizeValueType     sliceSize = rowPitch * ysize;
+  const SizeValueType     planeRowSize = (axis == 0 ? ysize : xsize) * pixelSize;
+  SizeValueType           rowsPerSpan = 1;
+  if (axis == 0 && rowPitch - pixelSize <= maximumGap)
+  {
+    rowsPerSpan = std::min(ysize, std::max<SizeValueType>(1, maximumSpanSize / rowPitch));
+  }
+
+  ScancoRawFile file;
+  file.Open(this->m_FileName, false);
+
+  MultiThreaderBase::Pointer threader = MultiThreaderBase::New();
+  const SizeValueType        numberOfSlabs = std::min<SizeValueType>(zsize, threader->GetNumberOfWorkUnits());
+
+  std::mutex  errorMutex;
+  std::string errorMessage;
+  threader->ParallelizeArray(
+    0,
+    numberOfSlabs,
+    [&](SizeValueType slab) {
+      const SizeValueType firstSlice = slab * zsize / numberOfSlabs;
+      const SizeValueType endSlice = (slab + 1) * zsize / numberOfSlabs;
+
+      try
+      {
+        std::vector<char> span(rowsPerSpan > 1 ? ((rowsPerSpan - 1) * xsize + 1) * pixelSize : 0);
+        for (SizeValueType z = firstSlice; z < endSlice; ++z)
         {
-          l = 254;
-          flip = !flip;
+          char *              row = static_cast<char *>(buffer) + z * planeRowSize;
+          const std::uint64_t sliceOffset = header->HeaderSize + z * sliceSize;
+          if (axis == 1)
+          {
+            file.Read(row, planeRowSize, sliceOffset + index * rowPitch);
+            continue;
+          }
+          for (SizeValueType y = 0; y < ysize; y += rowsPerSpan)
+          {
+            const SizeValueType rows = std::min(rowsPerSpan, ysize - y);
+            const std::uint64_t offset = sliceOffset + y * rowPitch + index * pixelSize;
+            if (rows == 1)
+            {
+              file.Read(row + y * pixelSize, pixelSize, offset);
+              continue;
+            }
+            file.Read(span.data(), ((rows - 1) * xsize + 1) * pixelSize, offset);
+            for (SizeValueType i = 0; i < rows; ++i)
+            {
+              memcpy(row + (y + i) * pixelSize, span.data() + i * rowPitch, pixelSize);
+            }
+          }
         }
-        if (l > outSize)
+      }
+      catch (const ExceptionObject & e)
+      {
+        std::lock_guard<std::mutex> lock(errorMutex);
+        errorMessage = e.GetDescription();
+      }
+    },
+    nullptr);
+
+  if (!errorMessage.empty())
+  {
+    itkExceptionMacro(<< errorMessage);
+  }
+
+  ScancoImageIO::RescaleBuffer(*header, buffer, region.GetNumberOfPixels());
+}
+
+
+void
+ScancoImageIO::ReadStrided(void * buffer, SizeValueType rowStride, SizeValueType sliceStride) const
+{
+  // hold a reference, so that the header outlives this call
+  const HeaderPointer header = this->m_Header;
+  if (header == nullptr)
+  {
+    itkExceptionMacro("ReadImageInformation() or SetHeader() must be called before reading.");
+  }
+
+  const SizeValueType pixelSize = ScancoImageIO::GetHeaderComponentSize(*header);
+  const SizeValueType xsize = header->Dimensions[0];
+  const SizeValueType ysize = header->Dimensions[1];
+  const SizeValueType zsize = header->Dimensions[2];
+  const SizeValueType rowSize = xsize * pixelSize;
+  const SizeValueType sliceSize = rowSize * ysize;
+  if (rowStride < xsize || sliceStride < rowStride * ysize)
+  {
+    itkExceptionMacro("Strides " << rowStride << ", " << sliceStride << " are too small for the image.");
+  }
+
+  std::ifstream infile(this->m_FileName.c_str(), std::ios::in | std::ios::binary);
+  if (!infile.is_open())
+  {
+    itkExceptionMacro("Could not open file for reading: " << this->m_FileName);
+  }
+
+  // Rows are written at their place in the buffer and then rescaled there
+  auto rowPointer = [&](SizeValueType y, SizeValueType z) {
+    return static_cast<char *>(buffer) + (z * sliceStride + y * rowStride) * pixelSize;
+  };
+  std::vector<char> slice;
+  std::vector<char> inputBuffer;
+
+  if (header->Compression == 0)
+  {
+    // whole slices are read, into the buffer when their rows are contiguous there
+    slice.resize(rowStride == xsize ? 0 : sliceSize);
+    infile.seekg(static_cast<std::streamoff>(header->HeaderSize));
+    for (SizeValueType z = 0; z < zsize; ++z)
+    {
+      char * target = (slice.empty() ? rowPointer(0, z) : slice.data());
+      infile.read(target, sliceSize);
+      const SizeValueType shortread = sliceSize - static_cast<SizeValueType>(infile.gcount());
+      if (shortread != 0)
+      {
+        itkExceptionMacro("File is truncated, " << shortread << " bytes are missing");
+      }
+      for (SizeValueType y = 0; y < ysize; ++y)
+      {
+        if (!slice.empty())
         {
-          l = static_cast<unsigned char>(outSize);
+          memcpy(rowPointer(y, z), slice.data() + y * rowSize, rowSize);
         }
-        outSize -= l;
-        if (l > 0)
+        ScancoImageIO::RescaleBuffer(*header, rowPointer(y, z), xsize);
+      }
+    }
+  }
+  else if (ScancoRunLengthDecoder::IsRunLength(header->Compression))
+  {
+    // run-lengths are decoded row by row, zero the rest if the data ends early
+    const SizeValueType           size = ScancoImageIO::ReadCompressedData(infile, *header, inputBuffer);
+    const ScancoRunLengthDecoder  decoder(header->Compression, inputBuffer.data(), size);
+    ScancoRunLengthDecoder::State state = decoder.GetInitialState();
+    for (SizeValueType z = 0; z < zsize; ++z)
+    {
+      for (SizeValueType y = 0; y < ysize; ++y)
+      {
+        auto *              row = reinterpret_cast<unsigned char *>(rowPointer(y, z));
+        const SizeValueType produced = decoder.Decode(state, row, xsize);
+        memset(row + produced, 0, xsize - produced);
+      }
+    }
+  }
+  else
+  {
+    // packed bits are decoded row by row too
+    const SizeValueType size = ScancoImageIO::ReadCompressedData(infile, *header, inputBuffer);
+    for (SizeValueType z = 0; z < zsize; ++z)
+    {
+      for (SizeValueType y = 0; y < ysize; ++y)
+      {
+        ScancoImageIO::DecodePackedRow(
+          inputBuffer.data(), size, *header, y, z, reinterpret_cast<unsigned char *>(rowPointer(y, z)));
+        ScancoImageIO::RescaleBuffer(*header, rowPointer(y, z), xsize);
+      }
+    }
+  }
+}
+
+
+void
+ScancoImageIO::ReadRuns(const RunFunction & runFunction) const
+{
+  // hold a reference, so that the header outlives this call
+  const HeaderPointer header = this->m_Header;
+  if (header == nullptr)
+  {
+    itkExceptionMacro("ReadImageInformation() or SetHeader() must be called before reading.");
+  }
+  if (header->PixelType != IOPixelEnum::SCALAR || ScancoImageIO::GetHeaderComponentSize(*header) != 1)
+  {
+    itkExceptionMacro("Runs can only be read from 8-bit scalar images, not from "
+                      << ImageIOBase::GetPixelTypeAsString(header->PixelType) << ' '
+                      << ImageIOBase::GetComponentTypeAsString(header->ComponentType));
+  }
+
+  const SizeValueType xsize = header->Dimensions[0];
+  const SizeValueType ysize = header->Dimensions[1];
+  const SizeValueType zsize = header->Dimensions[2];
+  const bool          isSigned = (header->ComponentType == IOComponentEnum::CHAR);
+
+  std::ifstream infile(this->m_FileName.c_str(), std::ios::in | std::ios::binary);
+  if (!infile.is_open())
+  {
+    itkExceptionMacro("Could not open file for reading: " << this->m_FileName);
+  }
+
+  // Pieces of a row are joined into the current run while their value stays
+  // the same, and the run is reported when the value changes
+  SizeValueType y = 0;
+  SizeValueType z = 0;
+  SizeValueType runStart = 0;
+  SizeValueType runLength = 0;
+  unsigned char runValue = 0;
+  auto          endRun = [&]() {
+    if (runLength != 0 && runValue != 0)
+    {
+      runFunction(runStart,
+                  y,
+                  z,
+                  runLength,
+                  isSigned ? static_cast<int>(static_cast<signed char>(runValue)) : static_cast<int>(runValue));
+    }
+    runLength = 0;
+  };
+  auto addPiece = [&](SizeValueType x, SizeValueType length, unsigned char value) {
+    if (runLength != 0 && value == runValue)
+    {
+      runLength += length;
+      return;
+    }
+    endRun();
+    runStart = x;
+    runLength = length;
+    runValue = value;
+  };
+  auto addRow = [&](const unsigned char * row) {
+    SizeValueType x = 0;
+    while (x < xsize)
+    {
+      SizeValueType length = 1;
+      while (x + length < xsize && row[x + length] == row[x])
+      {
+        ++length;
+      }
+      addPiece(x, length, row[x]);
+      x += length;
+    }
+    endRun();
+  };
+
+  std::vector<char> inputBuffer;
+  std::vector<char> slice;
+
+  if (header->Compression == 0)
+  {
+    // one slice at a time
+    const SizeValueType sliceSize = xsize * ysize;
+    slice.resize(sliceSize);
+    infile.seekg(static_cast<std::streamoff>(header->HeaderSize));
+    for (z = 0; z < zsize; ++z)
+    {
+      infile.read(slice.data(), sliceSize);
+      const SizeValueType shortread = sliceSize - static_cast<SizeValueType>(infile.gcount());
+      if (shortread != 0)
+      {
+        itkExceptionMacro("File is truncated, " << shortread << " bytes are missing");
+      }
+      for (y = 0; y < ysize; ++y)
+      {
+        addRow(reinterpret_cast<const unsigned char *>(slice.data()) + y * xsize);
+      }
+    }
+  }
+  else if (ScancoRunLengthDecoder::IsRunLength(header->Compression))
+  {
+    // run by run, the rest is zero if the data ends early
+    const SizeValueType           size = ScancoImageIO::ReadCompressedData(infile, *header, inputBuffer);
+    const ScancoRunLengthDecoder  decoder(header->Compression, inputBuffer.data(), size);
+    ScancoRunLengthDecoder::State state = decoder.GetInitialState();
+    for (z = 0; z < zsize; ++z)
+    {
+      for (y = 0; y < ysize; ++y)
+      {
+        SizeValueType x = 0;
+        unsigned char value = 0;
+        while (x < xsize)
         {
-          do
+          const SizeValueType length = decoder.DecodeRun(state, value, xsize - x);
+          if (length == 0)
           {
-            *dataPtr++ = v;
-          } while (--l);
+            break;
+          }
+          addPiece(x, length, value);
+          x += length;
         }
-        flip = !flip;
-        v = input[flip];
-      } while (--size != 0 && outSize != 0);
+        endRun();
+      }
     }
   }
-  else if (this->m_Compression == 0x00c2)
+  else
   {
-    // Decompress 8-bit run-lengths
-    char * inPtr = input;
-    size /= 2;
-    if (size > 0)
+    // packed bits, one row at a time
+    const SizeValueType size = ScancoImageIO::ReadCompressedData(infile, *header, inputBuffer);
+    slice.resize(xsize);
+    for (z = 0; z < zsize; ++z)
     {
-      do
+      for (y = 0; y < ysize; ++y)
       {
-        unsigned char l = inPtr[0];
-        unsigned char v = inPtr[1];
-        inPtr += 2;
-        if (l > outSize)
-        {
-          l = static_cast<unsigned char>(outSize);
-        }
-        outSize -= l;
-        if (l > 0)
+        ScancoImageIO::DecodePackedRow(
+          inputBuffer.data(), size, *header, y, z, reinterpret_cast<unsigned char *>(slice.data()));
+        addRow(reinterpret_cast<const unsigned char *>(slice.data()));
+      }
+    }
+  }
+}
+
+
+ScancoBitMask::Pointer
+ScancoImageIO::ReadBitMask() const
+{
+  // hold a reference, so that the header outlives this call
+  const HeaderPointer header = this->m_Header;
+  if (header == nullptr)
+  {
+    itkExceptionMacro("ReadImageInformation() or SetHeader() must be called before reading.");
+  }
+  const SizeValueType pixelSize = ScancoImageIO::GetHeaderComponentSize(*header);
+  if (pixelSize != 1 && !this->m_ThresholdOnRead)
+  {
+    itkExceptionMacro("Only 8-bit images can be read as a bit mask without ThresholdOnRead, not "
+                      << ImageIOBase::GetComponentTypeAsString(header->ComponentType));
+  }
+
+  const SizeValueType        xsize = header->Dimensions[0];
+  const SizeValueType        ysize = header->Dimensions[1];
+  const SizeValueType        zsize = header->Dimensions[2];
+  ScancoBitMask::SizeType    size;
+  ScancoBitMask::SpacingType spacing;
+  ScancoBitMask::PointType   origin;
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    size[i] = header->Dimensions[i];
+    spacing[i] = header->Spacing[i];
+    origin[i] = header->Origin[i];
+  }
+  ScancoBitMask::Pointer mask = ScancoBitMask::New();
+  mask->Allocate(size);
+  mask->SetSpacing(spacing);
+  mask->SetOrigin(origin);
+
+  if (pixelSize == 1)
+  {
+    double slope;
+    double intercept;
+    GetMaskCalibration(*header, slope, intercept);
+    const bool   thresholdOnRead = this->m_ThresholdOnRead;
+    const double lowerThreshold = this->m_LowerThreshold;
+    const double upperThreshold = this->m_UpperThreshold;
+    const auto   isInside = [=](int value) {
+      if (!thresholdOnRead)
+      {
+        return value != 0;
+      }
+      const double density = slope * value + intercept;
+      return density >= lowerThreshold && density <= upperThreshold;
+    };
+
+    // the runs are the non-zero voxels, the rest of the mask is zero
+    mask->FillBuffer(isInside(0));
+    this->ReadRuns([&](SizeValueType x, SizeValueType y, SizeValueType z, SizeValueType length, int value) {
+      mask->SetRun(x, y, z, length, isInside(value));
+    });
+    return mask;
+  }
+
+  std::ifstream infile(this->m_FileName.c_str(), std::ios::in | std::ios::binary);
+  if (!infile.is_open())
+  {
+    itkExceptionMacro("Could not open file for reading: " << this->m_FileName);
+  }
+
+  // Threshold slabs of slices and pack them. Compressed data has to be
+  // decoded in full anyway.
+  const SizeValueType sliceSize = xsize * ysize;
+  SizeValueType       slabSlices = std::max<SizeValueType>(zsize, 1);
+  if (header->Compression == 0)
+  {
+    slabSlices = std::max<SizeValueType>(1, maskSlabBytes / std::max<SizeValueType>(1, sliceSize));
+  }
+  std::vector<unsigned char> slab(std::min(slabSlices, zsize) * sliceSize);
+  std::vector<char>          inputBuffer;
+  std::vector<char>          volumeBuffer;
+  ImageIORegion              region(3);
+  region.SetSize(0, xsize);
+  region.SetSize(1, ysize);
+  for (SizeValueType z0 = 0; z0 < zsize; z0 += slabSlices)
+  {
+    const SizeValueType slices = std::min(slabSlices, zsize - z0);
+    region.SetIndex(2, static_cast<IndexValueType>(z0));
+    region.SetSize(2, slices);
+    this->ReadMaskFromStream(infile, *header, region, slab.data(), 1, inputBuffer, volumeBuffer);
+
+    const unsigned char * voxel = slab.data();
+    for (SizeValueType z = z0; z < z0 + slices; ++z)
+    {
+      for (SizeValueType y = 0; y < ysize; ++y)
+      {
+        ScancoBitMask::WordType * row = mask->GetRow(y, z);
+        for (SizeValueType x = 0; x < xsize; ++x, ++voxel)
         {
-          do
-          {
-            *dataPtr++ = v;
-          } while (--l);
+          row[x / ScancoBitMask::BitsPerWord] |= ScancoBitMask::WordType{ *voxel } << (x % ScancoBitMask::BitsPerWord);
         }
-      } while (--size != 0 && outSize != 0);
+      }
     }
   }
+  return mask;
+}
 
-  delete[] input;
 
-  // Convert the image to HU.
-  // Only SHORT images have been tested
-  IOComponentEnum dataType = this->m_ComponentType;
+void
+ScancoImageIO::ReadRegionFromStream(std::istream &        infile,
+                                    const ScancoHeader &  header,
+                                    const ImageIORegion & region,
+                                    void *                buffer,
+                                    std::vector<char> &   inputBuffer,
+                                    std::vector<char> &   volumeBuffer)
+{
+  ScancoImageIO::ReadRawRegionFromStream(infile, header, region, buffer, inputBuffer, volumeBuffer);
+  ScancoImageIO::RescaleBuffer(header, buffer, region.GetNumberOfPixels());
+}
 
-  // The size of the buffer will change depending on the data type
-  size_t bufferSize = outSize;
 
-  if (this->m_RescaleSlope != 1.0 || this->m_RescaleIntercept != 0.0)
+void
+ScancoImageIO::ReadRawRegionFromStream(std::istream &        infile,
+                                       const ScancoHeader &  header,
+                                       const ImageIORegion & region,
+                                       void *                buffer,
+                                       std::vector<char> &   inputBuffer,
+                                       std::vector<char> &   volumeBuffer)
+{
+  if (region.GetImageDimension() != 3)
+  {
+    itkGenericExceptionMacro("Requested region must be three-dimensional.");
+  }
+  for (unsigned int i = 0; i < 3; ++i)
   {
-    switch (dataType)
+    if (region.GetIndex(i) < 0 || region.GetIndex(i) + region.GetSize(i) > header.Dimensions[i])
+    {
+      itkGenericExceptionMacro("Requested region is outside of the image: " << region);
+    }
+  }
+  if (region.GetNumberOfPixels() == 0)
+  {
+    return;
+  }
+
+  const SizeValueType pixelSize = ScancoImageIO::GetHeaderComponentSize(header);
+  const SizeValueType xsize = header.Dimensions[0];
+  const SizeValueType ysize = header.Dimensions[1];
+  const SizeValueType x0 = region.GetIndex(0);
+  const SizeValueType y0 = region.GetIndex(1);
+  const SizeValueType z0 = region.GetIndex(2);
+  const SizeValueType nx = region.GetSize(0);
+  const SizeValueType ny = region.GetSize(1);
+  const SizeValueType nz = region.GetSize(2);
+
+  // Read whole slices or whole rows at once when the region allows it
+  SizeValueType chunkSize = nx * pixelSize;
+  SizeValueType rowsPerChunk = 1;
+  if (nx == xsize)
+  {
+    rowsPerChunk = ny;
+    chunkSize *= ny;
+    if (ny == ysize)
+    {
+      rowsPerChunk *= nz;
+      chunkSize *= nz;
+    }
+  }
+  const SizeValueType numberOfChunks = ny * nz / rowsPerChunk;
+
+  char * out = static_cast<char *>(buffer);
+
+  if (header.Compression == 0)
+  {
+    for (SizeValueType chunk = 0; chunk < numberOfChunks; ++chunk)
+    {
+      const SizeValueType row = chunk * rowsPerChunk;
+      const SizeValueType y = y0 + row % ny;
+      const SizeValueType z = z0 + row / ny;
+      const uint64_t      offset = header.HeaderSize + ((z * ysize + y) * xsize + x0) * pixelSize;
+      infile.seekg(static_cast<std::streamoff>(offset));
+      infile.read(out + chunk * chunkSize, chunkSize);
+      const SizeValueType shortread = chunkSize - static_cast<SizeValueType>(infile.gcount());
+      if (shortread != 0)
+      {
+        itkGenericExceptionMacro("File is truncated, " << shortread << " bytes are missing");
+      }
+    }
+  }
+  else if (header.Compression == 0x00b1)
+  {
+    // Packed bits are decoded row by row. A slice needs the bytes of its
+    // rows within the plane of 2x2x2 blocks, and the value byte at the end.
+    const SizeValueType        xinc = (xsize + 1) / 2;
+    const SizeValueType        yinc = (ysize + 1) / 2;
+    const SizeValueType        dataSize = xinc * yinc * ((header.Dimensions[2] + 1) / 2);
+    const SizeValueType        planeSize = ((y0 + ny - 1) / 2 + 1) * xinc;
+    std::vector<unsigned char> row(xsize);
+    inputBuffer.resize(planeSize + 1);
+    for (SizeValueType z = z0; z < z0 + nz; ++z)
+    {
+      infile.seekg(static_cast<std::streamoff>(header.HeaderSize + (z / 2) * yinc * xinc));
+      infile.read(inputBuffer.data(), planeSize);
+      SizeValueType bytesRead = static_cast<SizeValueType>(infile.gcount());
+      infile.seekg(static_cast<std::streamoff>(header.HeaderSize + dataSize));
+      infile.read(inputBuffer.data() + planeSize, 1);
+      bytesRead += static_cast<SizeValueType>(infile.gcount());
+      if (bytesRead != planeSize + 1)
+      {
+        itkGenericExceptionMacro("File is truncated, " << planeSize + 1 - bytesRead << " bytes are missing");
+      }
+      for (SizeValueType y = y0; y < y0 + ny; ++y)
+      {
+        // the buffer starts at the plane of z, as if it were the first one
+        ScancoImageIO::DecodePackedRow(inputBuffer.data(), planeSize + 1, header, y, z & 1, row.data());
+        memcpy(out, row.data() + x0, nx);
+        out += nx;
+      }
+    }
+  }
+  else if (numberOfChunks == 1 && nx == xsize && ny == ysize && nz == header.Dimensions[2])
+  {
+    // compressed data can be decoded directly into the output
+    ScancoImageIO::DecodeCompressedData(infile, header, buffer, inputBuffer);
+  }
+  else
+  {
+    // run-length data has to be decoded from the start of the volume
+    volumeBuffer.resize(xsize * ysize * header.Dimensions[2] * pixelSize);
+    ScancoImageIO::DecodeCompressedData(infile, header, volumeBuffer.data(), inputBuffer);
+    for (SizeValueType chunk = 0; chunk < numberOfChunks; ++chunk)
+    {
+      const SizeValueType row = chunk * rowsPerChunk;
+      const SizeValueType y = y0 + row % ny;
+      const SizeValueType z = z0 + row / ny;
+      memcpy(out + chunk * chunkSize, volumeBuffer.data() + ((z * ysize + y) * xsize + x0) * pixelSize, chunkSize);
+    }
+  }
+}
+
+
+void
+ScancoImageIO::ReadMaskFromStream(std::istream &        infile,
+                                  const ScancoHeader &  header,
+                                  const ImageIORegion & region,
+                                  unsigned char *       mask,
+                                  unsigned char         insideValue,
+                                  std::vector<char> &   inputBuffer,
+                                  std::vector<char> &   volumeBuffer) const
+{
+  double slope;
+  double intercept;
+  GetMaskCalibration(header, slope, intercept);
+
+  // 8-bit data is read straight into the mask and thresholded in place.
+  // Wider uncompressed data is read in slabs of slices. Compressed data has
+  // to be decoded in full anyway.
+  const SizeValueType pixelSize = ScancoImageIO::GetHeaderComponentSize(header);
+  const SizeValueType sliceSize = region.GetSize(0) * region.GetSize(1);
+  const SizeValueType nz = region.GetSize(2);
+  SizeValueType       slabSlices = std::max<SizeValueType>(nz, 1);
+  std::vector<char>   slab;
+  if (pixelSize > 1)
+  {
+    if (header.Compression == 0)
+    {
+      slabSlices = std::max<SizeValueType>(1, maskSlabBytes / std::max<SizeValueType>(1, sliceSize * pixelSize));
+    }
+    slab.resize(std::min(slabSlices, nz) * sliceSize * pixelSize);
+  }
+
+  ImageIORegion slabRegion = region;
+  SizeValueType z = 0;
+  do
+  {
+    const SizeValueType slices = std::min(slabSlices, nz - z);
+    slabRegion.SetIndex(2, region.GetIndex(2) + static_cast<IndexValueType>(z));
+    slabRegion.SetSize(2, slices);
+    unsigned char * slabMask = mask + z * sliceSize;
+    void *          values = (pixelSize == 1 ? static_cast<void *>(slabMask) : static_cast<void *>(slab.data()));
+    ScancoImageIO::ReadRawRegionFromStream(infile, header, slabRegion, values, inputBuffer, volumeBuffer);
+    ThresholdToMask(header.ComponentType,
+                    values,
+                    slices * sliceSize,
+                    slope,
+                    intercept,
+                    this->m_LowerThreshold,
+                    this->m_UpperThreshold,
+                    insideValue,
+                    slabMask);
+    z += slices;
+  } while (z < nz);
+}
+
+
+void
+ScancoImageIO::RescaleBuffer(const ScancoHeader & header, void * buffer, SizeValueType bufferSize)
+{
+  // Convert the image to HU.
+  // Only SHORT images have been tested.
+  // Run-length encoded data holds segmentations and is never rescaled.
+  if ((header.RescaleSlope != 1.0 || header.RescaleIntercept != 0.0) && header.Compression != 0x00b2 &&
+      header.Compression != 0x00c2)
+  {
+    switch (header.ComponentType)
     {
       case IOComponentEnum::CHAR:
-        RescaleToHU(reinterpret_cast<char *>(buffer), bufferSize, this->m_RescaleSlope, this->m_RescaleIntercept);
+        RescaleToHU(reinterpret_cast<char *>(buffer), bufferSize, header.RescaleSlope, header.RescaleIntercept);
         break;
       case IOComponentEnum::UCHAR:
         RescaleToHU(
-          reinterpret_cast<unsigned char *>(buffer), bufferSize, this->m_RescaleSlope, this->m_RescaleIntercept);
+          reinterpret_cast<unsigned char *>(buffer), bufferSize, header.RescaleSlope, header.RescaleIntercept);
         break;
       case IOComponentEnum::SHORT:
-        bufferSize /= 2;
-        RescaleToHU(reinterpret_cast<short *>(buffer), bufferSize, this->m_RescaleSlope, this->m_RescaleIntercept);
+        RescaleToHU(reinterpret_cast<short *>(buffer), bufferSize, header.RescaleSlope, header.RescaleIntercept);
         break;
       case IOComponentEnum::USHORT:
-        bufferSize /= 2;
         RescaleToHU(
-          reinterpret_cast<unsigned short *>(buffer), bufferSize, this->m_RescaleSlope, this->m_RescaleIntercept);
+          reinterpret_cast<unsigned short *>(buffer), bufferSize, header.RescaleSlope, header.RescaleIntercept);
         break;
       case IOComponentEnum::INT:
-        bufferSize /= 4;
-        RescaleToHU(reinterpret_cast<int *>(buffer), bufferSize, this->m_RescaleSlope, this->m_RescaleIntercept);
+        RescaleToHU(reinterpret_cast<int *>(buffer), bufferSize, header.RescaleSlope, header.RescaleIntercept);
         break;
       case IOComponentEnum::UINT:
-        bufferSize /= 4;
         RescaleToHU(
-          reinterpret_cast<unsigned int *>(buffer), bufferSize, this->m_RescaleSlope, this->m_RescaleIntercept);
+          reinterpret_cast<unsigned int *>(buffer), bufferSize, header.RescaleSlope, header.RescaleIntercept);
         break;
       case IOComponentEnum::FLOAT:
-        bufferSize /= 4;
-        RescaleToHU(reinterpret_cast<float *>(buffer), bufferSize, this->m_RescaleSlope, this->m_RescaleIntercept);
+        RescaleToHU(reinterpret_cast<float *>(buffer), bufferSize, header.RescaleSlope, header.RescaleIntercept);
         break;
       default:
-        itkExceptionMacro("Unrecognized data type in file: " << dataType);
+        itkGenericExceptionMacro("Unrecognized data type in file: " << header.ComponentType);
     }
   }
 }
@@ -1372,7 +3338,52 @@ ScancoImageIO::CanWriteFile(const char * name)
 
 
 void
-ScancoImageIO::WriteISQHeader(std::ofstream * file)
+ScancoImageIO::EncodeISQDataSize(SizeValueType numberOfBytes, char * block)
+{
+  // both counts are 32-bit, readers take the size of large files from the dimensions
+  const auto maximumInt = static_cast<SizeValueType>(NumericTraits<int>::max());
+  ScancoImageIO::EncodeInt(numberOfBytes > maximumInt ? 0 : static_cast<int>(numberOfBytes),
+                           block + isqNumberOfBytesOffset);
+  ScancoImageIO::EncodeInt(static_cast<int>(std::min(numberOfBytes / 512, maximumInt)),
+                           block + isqNumberOfBlocksOffset);
+}
+
+
+void
+ScancoImageIO::EncodeISQHeader(const ScancoHeader & header, char * block)
+{
+  std::memset(block, 0x00, header.HeaderSize);
+
+  ScancoImageIO::EncodeHeaderFields(header, std::begin(isqCommonFields), std::end(isqCommonFields), block);
+  // 3 -> ISQ data type
+  ScancoImageIO::EncodeInt(3, block + isqDataTypeOffset);
+  ScancoImageIO::EncodeISQDataSize(header.Dimensions[0] * header.Dimensions[1] * header.Dimensions[2] *
+                                     ScancoImageIO::GetHeaderComponentSize(header),
+                                   block);
+  ScancoImageIO::EncodeDate(block + isqDateOffset);
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    ScancoImageIO::EncodeInt(header.Dimensions[i], block + isqPixelDimensionsOffset + 4 * i);
+    ScancoImageIO::EncodeInt(header.Spacing[i] * header.Dimensions[i] * 1e3, block + isqPhysicalDimensionsOffset + 4 * i);
+  }
+  ScancoImageIO::EncodeHeaderFields(header, std::begin(isqFields), std::end(isqFields), block);
+  // the data follows the header
+  ScancoImageIO::EncodeInt(static_cast<int>(header.HeaderSize / 512) - 1, block + isqDataOffsetOffset);
+
+  if (header.HeaderSize >= isqCalibratedHeaderSize)
+  {
+    // the extended header, as read by ReadISQHeader()
+    memcpy(block + isqMultiHeaderOffset + 8, "MultiHeader     ", 16);
+    memcpy(block + isqDirectoryOffset + 8, "Calibration     ", 16);
+    ScancoImageIO::EncodeInt(isqCalibrationBlocks, block + isqDirectoryOffset + 24);
+    ScancoImageIO::EncodeHeaderFields(
+      header, std::begin(isqCalibrationFields), std::end(isqCalibrationFields), block + isqCalibrationOffset);
+  }
+}
+
+
+void
+ScancoImageIO::PrepareISQHeader(ScancoHeader & header, bool withCalibration)
 {
   if (!this->m_HeaderInitialized)
   {
@@ -1381,96 +3392,57 @@ ScancoImageIO::WriteISQHeader(std::ofstream * file)
   this->SetHeaderFromMetaDataDictionary();
   // now overwrite some values which we don't want taken from metadata
   this->SetVersion("CTDATA-HEADER_V1");
-  this->m_MuScaling = 1.0; // we don't want rescaling to occur on reading
-
-  delete[] this->m_RawHeader;
-  this->m_RawHeader = new char[512];
-  char * header = this->m_RawHeader;
+  this->m_Compression = 0;
 
-  ScancoImageIO::PadString(header, this->m_Version, 16);
-  header += 16;
-  // 3 -> ISQ data type
-  ScancoImageIO::EncodeInt(3, header);
-  header += 4;
-  const auto numberOfBytes = static_cast<SizeValueType>(this->GetImageSizeInBytes());
-  if (numberOfBytes > NumericTraits<int>::max())
+  this->CopyMembersToHeader(header);
+  header.ComponentType = IOComponentEnum::SHORT;
+  header.PixelType = IOPixelEnum::SCALAR;
+  ScancoImageIO::ComputeRescale(header);
+  if (withCalibration && header.RescaleSlope != 0.0 &&
+      (header.RescaleSlope != 1.0 || header.RescaleIntercept != 0.0))
   {
-    ScancoImageIO::EncodeInt(0, header);
-    header += 4;
+    header.HeaderSize = isqCalibratedHeaderSize;
   }
   else
   {
-    ScancoImageIO::EncodeInt(numberOfBytes, header);
-    header += 4;
-  }
-  ScancoImageIO::EncodeInt(numberOfBytes / 512, header);
-  header += 4;
-  ScancoImageIO::EncodeInt(this->m_PatientIndex, header);
-  header += 4;
-  ScancoImageIO::EncodeInt(this->m_ScannerID, header);
-  header += 4;
-  ScancoImageIO::EncodeDate(header);
-  header += 8;
-  for (unsigned int dimension = 0; dimension < 3; ++dimension)
-  {
-    // pixdim
-    ScancoImageIO::EncodeInt(this->GetDimensions(dimension), header);
-    header += 4;
-  }
-  for (unsigned int dimension = 0; dimension < 3; ++dimension)
-  {
-    // physdim
-    ScancoImageIO::EncodeInt(this->GetSpacing(dimension) * this->GetDimensions(dimension) * 1e3, header);
-    header += 4;
-  }
-  ScancoImageIO::EncodeInt((int)(this->m_SliceThickness * 1e3), header);
-  header += 4;
-  ScancoImageIO::EncodeInt((int)(this->m_SliceIncrement * 1e3), header);
-  header += 4;
-  ScancoImageIO::EncodeInt((int)(this->m_StartPosition * 1e3), header);
-  header += 4;
-  ScancoImageIO::EncodeInt((int)(this->m_DataRange[0]), header);
-  header += 4;
-  ScancoImageIO::EncodeInt((int)(this->m_DataRange[1]), header);
-  header += 4;
-  ScancoImageIO::EncodeInt((int)(this->m_MuScaling), header);
-  header += 4;
-  ScancoImageIO::EncodeInt(this->m_NumberOfSamples, header);
-  header += 4;
-  ScancoImageIO::EncodeInt(this->m_NumberOfProjections, header);
-  header += 4;
-  ScancoImageIO::EncodeInt((int)(this->m_ScanDistance * 1e3), header);
-  header += 4;
-  ScancoImageIO::EncodeInt((int)(this->m_ScannerType), header);
-  header += 4;
-  ScancoImageIO::EncodeInt((int)(this->m_SampleTime * 1e3), header);
-  header += 4;
-  ScancoImageIO::EncodeInt((int)(this->m_MeasurementIndex), header);
-  header += 4;
-  ScancoImageIO::EncodeInt((int)(this->m_Site), header);
-  header += 4;
-  ScancoImageIO::EncodeInt((int)(this->m_ReferenceLine * 1e3), header);
-  header += 4;
-  ScancoImageIO::EncodeInt((int)(this->m_ReconstructionAlg), header);
-  header += 4;
-  ScancoImageIO::PadString(header, this->m_PatientName, 40);
-  header += 40;
-  ScancoImageIO::EncodeInt((int)(this->m_Energy * 1e3), header);
-  header += 4;
-  ScancoImageIO::EncodeInt((int)(this->m_Intensity * 1e3), header);
-  header += 4;
-  const std::size_t fillSize = 83 * 4;
-  std::memset(header, 0x00, fillSize);
-  header += fillSize;
-  // dataOffset
-  const int dataOffset = 0;
-  ScancoImageIO::EncodeInt(dataOffset, header);
-  header += 4;
-
-  this->m_HeaderSize = static_cast<SizeValueType>(dataOffset + 1) * 512;
-  this->m_Compression = 0;
+    // we don't want rescaling to occur on reading
+    header.MuScaling = 1.0;
+    header.DensitySlope = 1.0;
+    header.DensityIntercept = 0.0;
+    ScancoImageIO::ComputeRescale(header);
+    header.HeaderSize = 512;
+  }
+  this->m_MuScaling = header.MuScaling;
+  this->m_HeaderSize = header.HeaderSize;
+}
+
+
+void
+ScancoImageIO::PrepareISQWrite(ScancoHeader & header)
+{
+  if (this->m_FileName.empty())
+  {
+    itkExceptionMacro("FileName has not been set.");
+  }
+  if (this->GetPixelType() != IOPixelEnum::SCALAR || !CanConvertToISQ(this->GetComponentType()))
+  {
+    itkExceptionMacro("ScancoImageIO cannot write pixels of type "
+                      << ImageIOBase::GetPixelTypeAsString(this->GetPixelType()) << ' '
+                      << ImageIOBase::GetComponentTypeAsString(this->GetComponentType()));
+  }
 
-  file->write(this->m_RawHeader, 512);
+  this->PrepareISQHeader(header, true);
+}
+
+
+void
+ScancoImageIO::WriteISQHeader(std::ofstream * file)
+{
+  ScancoHeader header;
+  this->PrepareISQHeader(header, false);
+  this->m_RawHeader.resize(header.HeaderSize);
+  ScancoImageIO::EncodeISQHeader(header, this->m_RawHeader.data());
+  file->write(this->m_RawHeader.data(), this->m_HeaderSize);
 }
 
 
@@ -1494,38 +3466,477 @@ ScancoImageIO::WriteImageInformation()
 void
 ScancoImageIO::Write(const void * buffer)
 {
-  this->WriteImageInformation();
+  if (this->RequestedToStream())
+  {
+    // ImageFileWriter streams whole slices, starting with the first one,
+    // which replaces the file instead of being pasted into an older one
+    bool firstPiece = true;
+    for (unsigned int i = 0; i < this->m_IORegion.GetImageDimension(); ++i)
+    {
+      firstPiece = firstPiece && this->m_IORegion.GetIndex(i) == 0 &&
+                   (i >= 2 || this->m_IORegion.GetSize(i) == this->GetDimensions(i));
+    }
+    this->WriteRegionToFile(this->m_IORegion, buffer, firstPiece);
+    return;
+  }
 
-  std::ofstream outFile;
-  this->OpenFileForWriting(outFile, m_FileName, false);
-  outFile.seekp(this->m_HeaderSize, std::ios::beg);
+  ScancoHeader header;
+  this->PrepareISQWrite(header);
+  ScancoImageIO::WriteISQFile(
+    this->m_FileName, header, buffer, this->GetComponentType(), this->m_UseDirectIO, this->m_ThrottleWriteBack);
+  this->m_DataRange[0] = header.DataRange[0];
+  this->m_DataRange[1] = header.DataRange[1];
+}
+
+
+void
+ScancoImageIO::WriteRegion(const ImageIORegion & region, const void * buffer)
+{
+  this->WriteRegionToFile(region, buffer, false);
+}
 
-  const auto numberOfBytes = static_cast<SizeValueType>(this->GetImageSizeInBytes());
-  const auto numberOfComponents = static_cast<SizeValueType>(this->GetImageSizeInComponents());
 
-  if (this->GetComponentType() != IOComponentEnum::SHORT)
+void
+ScancoImageIO::WriteRegionToFile(const ImageIORegion & region, const void * buffer, bool replaceFile)
+{
+  ScancoHeader newHeader;
+  this->PrepareISQWrite(newHeader);
+  if (region.GetImageDimension() != 3)
   {
-    itkExceptionMacro("ScancoImageIO only supports writing short files.");
+    itkExceptionMacro("Region must be three-dimensional.");
   }
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    if (region.GetIndex(i) < 0 || region.GetIndex(i) + region.GetSize(i) > this->GetDimensions(i))
+    {
+      itkExceptionMacro("Region is outside of the image: " << region);
+    }
+  }
+
+  if (replaceFile || !itksys::SystemTools::FileExists(this->m_FileName, true))
+  {
+    // a new file holds zeros until they are overwritten
+    newHeader.DataRange[0] = 0.0;
+    newHeader.DataRange[1] = 0.0;
+    std::vector<char> rawHeader(newHeader.HeaderSize);
+    ScancoImageIO::EncodeISQHeader(newHeader, rawHeader.data());
+    ScancoRawFile file;
+    file.Open(this->m_FileName, true);
+    file.Write(rawHeader.data(), newHeader.HeaderSize, 0);
+    file.SetSize(newHeader.HeaderSize + this->GetImageSizeInPixels() * sizeof(short));
+  }
+
+  const HeaderPointer header = ScancoImageIO::ReadHeader(this->m_FileName);
+  if (header->FileType != 1)
+  {
+    itkExceptionMacro("Regions can only be written into ISQ files: " << this->m_FileName);
+  }
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    if (header->Dimensions[i] != this->GetDimensions(i))
+    {
+      itkExceptionMacro("The dimensions of " << this->m_FileName << " do not match the image: " << header->Dimensions[0]
+                                             << 'x' << header->Dimensions[1] << 'x' << header->Dimensions[2]);
+    }
+  }
+
+  // The data is converted with the calibration of the file, so it has to be
+  // the one this IO would write. The new header is compared as it reads
+  // back, since the file stores rounded values.
+  std::vector<char> rawHeader(newHeader.HeaderSize);
+  ScancoImageIO::EncodeISQHeader(newHeader, rawHeader.data());
+  std::istringstream headerStream(std::string(rawHeader.data(), rawHeader.size()));
+  ScancoHeader       expectedHeader;
+  ScancoImageIO::ReadHeader(headerStream, rawHeader, expectedHeader);
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    if (header->Spacing[i] != expectedHeader.Spacing[i])
+    {
+      itkExceptionMacro("The spacing of " << this->m_FileName << " does not match the image: " << header->Spacing[0]
+                                          << ' ' << header->Spacing[1] << ' ' << header->Spacing[2]);
+    }
+  }
+  if (header->MuScaling != expectedHeader.MuScaling || header->DensitySlope != expectedHeader.DensitySlope ||
+      header->DensityIntercept != expectedHeader.DensityIntercept)
+  {
+    itkExceptionMacro("The calibration of " << this->m_FileName << " does not match the image: MuScaling "
+                                            << header->MuScaling << ", density slope " << header->DensitySlope
+                                            << ", density intercept " << header->DensityIntercept);
+  }
+  if (region.GetNumberOfPixels() == 0)
+  {
+    return;
+  }
+
+  const SizeValueType xsize = header->Dimensions[0];
+  const SizeValueType ysize = header->Dimensions[1];
+  const SizeValueType x0 = region.GetIndex(0);
+  const SizeValueType y0 = region.GetIndex(1);
+  const SizeValueType z0 = region.GetIndex(2);
+  const SizeValueType nx = region.GetSize(0);
+  const SizeValueType ny = region.GetSize(1);
+  const SizeValueType nz = region.GetSize(2);
+
+  // Write the rows of a slice at once when they are contiguous in the file
+  const SizeValueType   rowsPerChunk = (nx == xsize ? ny : 1);
+  const SizeValueType   chunkSize = nx * rowsPerChunk;
+  const SizeValueType   numberOfChunks = ny * nz / rowsPerChunk;
+  const IOComponentEnum componentType = this->GetComponentType();
+  const bool            rescale = (header->RescaleSlope != 1.0 || header->RescaleIntercept != 0.0);
+  const bool            swap = ByteSwapper<short>::SystemIsBigEndian();
+
+  ScancoRawFile file;
+  file.OpenForUpdate(this->m_FileName);
+
+  MultiThreaderBase::Pointer threader = MultiThreaderBase::New();
+  const SizeValueType        numberOfSlabs = std::min<SizeValueType>(numberOfChunks, threader->GetNumberOfWorkUnits());
+
+  std::mutex  mutex;
+  std::string errorMessage;
+  short       minimum = NumericTraits<short>::max();
+  short       maximum = NumericTraits<short>::min();
+  threader->ParallelizeArray(
+    0,
+    numberOfSlabs,
+    [&](SizeValueType slab) {
+      std::vector<short> values(chunkSize);
+      short              slabMinimum = NumericTraits<short>::max();
+      short              slabMaximum = NumericTraits<short>::min();
+      try
+      {
+        for (SizeValueType chunk = slab * numberOfChunks / numberOfSlabs;
+             chunk < (slab + 1) * numberOfChunks / numberOfSlabs;
+             ++chunk)
+        {
+          const SizeValueType row = chunk * rowsPerChunk;
+          const SizeValueType y = y0 + row % ny;
+          const SizeValueType z = z0 + row / ny;
+          ConvertToISQ(componentType,
+                       buffer,
+                       chunk * chunkSize,
+                       values.data(),
+                       chunkSize,
+                       header->RescaleSlope,
+                       header->RescaleIntercept,
+                       rescale);
+          UpdateISQRange(values.data(), chunkSize, slabMinimum, slabMaximum);
+          if (swap)
+          {
+            ByteSwapper<short>::SwapRangeFromSystemToLittleEndian(values.data(), chunkSize);
+          }
+          file.Write(values.data(),
+                     chunkSize * sizeof(short),
+                     header->HeaderSize + ((z * ysize + y) * xsize + x0) * sizeof(short));
+        }
+      }
+      catch (const ExceptionObject & error)
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        errorMessage = error.GetDescription();
+      }
+      std::lock_guard<std::mutex> lock(mutex);
+      minimum = std::min(minimum, slabMinimum);
+      maximum = std::max(maximum, slabMaximum);
+    },
+    nullptr);
 
-  if (ByteSwapper<short>::SystemIsBigEndian())
+  if (!errorMessage.empty())
   {
-    char * tempmemory = new char[numberOfBytes];
-    memcpy(tempmemory, buffer, numberOfBytes);
+    itkExceptionMacro(<< errorMessage);
+  }
+
+  // Widen the data range of the header to the written values
+  const double dataRange[2] = { std::min(header->DataRange[0], static_cast<double>(minimum)),
+                                std::max(header->DataRange[1], static_cast<double>(maximum)) };
+  if (dataRange[0] != header->DataRange[0] || dataRange[1] != header->DataRange[1])
+  {
+    char block[512];
+    file.Read(block, sizeof(block), 0);
+    ScancoImageIO::EncodeDataRange(dataRange, block);
+    file.Write(block, sizeof(block), 0);
+  }
+  file.Close();
+
+  this->m_DataRange[0] = dataRange[0];
+  this->m_DataRange[1] = dataRange[1];
+  this->m_HeaderSize = header->HeaderSize;
+}
+
+
+void
+ScancoImageIO::WriteISQFile(const std::string & fileName,
+                            ScancoHeader &      header,
+                            const void *        buffer,
+                            IOComponentEnum     componentType,
+                            bool                useDirectIO,
+                            bool                throttleWriteBack)
+{
+  // The header is written again once the data range is known
+  std::vector<char> rawHeader(header.HeaderSize);
+  ScancoImageIO::EncodeISQHeader(header, rawHeader.data());
+
+  const std::uint64_t headerSize = header.HeaderSize;
+  const std::uint64_t numberOfPixels =
+    static_cast<std::uint64_t>(header.Dimensions[0]) * header.Dimensions[1] * header.Dimensions[2];
+  const std::uint64_t fileSize = headerSize + numberOfPixels * sizeof(short);
+
+  // Open the file once and reserve its full size before writing
+  ScancoRawFile file;
+  file.Open(fileName, true, useDirectIO);
+  file.Preallocate(fileSize);
+
+  // The file is split into slabs of whole blocks, which are written
+  // concurrently. Blocks are assembled in an aligned buffer of the work unit
+  // when they hold the header, when the data has to be converted or swapped
+  // to little-endian, and for direct I/O. Otherwise they are written straight
+  // from the image buffer.
+  constexpr std::uint64_t blockSize = 8 << 20;
+  constexpr std::uint64_t alignment = ScancoRawFile::DirectIOAlignment;
+  const bool              rescale = (header.RescaleSlope != 1.0 || header.RescaleIntercept != 0.0);
+  const bool              convert = rescale || componentType != IOComponentEnum::SHORT;
+  const bool              swap = ByteSwapper<short>::SystemIsBigEndian();
+  const bool              staged = convert || swap || file.IsDirectIO();
+  const auto *            data = static_cast<const char *>(buffer);
+
+  // Put the bytes of the file at offset into the staging buffer, and extend
+  // the range of the written values
+  auto stageBlock = [&](std::uint64_t offset, std::uint64_t size, char * staging, short & minimum, short & maximum) {
+    const std::uint64_t headerPart = (offset < headerSize ? std::min(size, headerSize - offset) : 0);
+    if (headerPart > 0)
     {
-      ByteSwapper<short>::SwapRangeFromSystemToBigEndian(reinterpret_cast<short *>(tempmemory), numberOfComponents);
+      memcpy(staging, rawHeader.data() + offset, headerPart);
     }
+    auto *              values = reinterpret_cast<short *>(staging + headerPart);
+    const std::uint64_t firstPixel = (offset + headerPart - headerSize) / sizeof(short);
+    const std::uint64_t count = (size - headerPart) / sizeof(short);
+    if (convert)
+    {
+      ConvertToISQ(
+        componentType, buffer, firstPixel, values, count, header.RescaleSlope, header.RescaleIntercept, rescale);
+    }
+    else
+    {
+      memcpy(values, data + firstPixel * sizeof(short), count * sizeof(short));
+    }
+    UpdateISQRange(values, count, minimum, maximum);
+    if (swap)
+    {
+      ByteSwapper<short>::SwapRangeFromSystemToLittleEndian(values, count);
+    }
+  };
+
+  MultiThreaderBase::Pointer threader = MultiThreaderBase::New();
+  const std::uint64_t        numberOfBlocks = (fileSize + blockSize - 1) / blockSize;
+  const std::uint64_t        numberOfSlabs = std::min<std::uint64_t>(numberOfBlocks, threader->GetNumberOfWorkUnits());
+
+  std::mutex  mutex;
+  std::string errorMessage;
+  short       minimum = NumericTraits<short>::max();
+  short       maximum = NumericTraits<short>::min();
+  threader->ParallelizeArray(
+    0,
+    numberOfSlabs,
+    [&](SizeValueType slab) {
+      const std::uint64_t firstBlock = slab * numberOfBlocks / numberOfSlabs;
+      const std::uint64_t endBlock = (slab + 1) * numberOfBlocks / numberOfSlabs;
+
+      std::vector<char> stagingBuffer;
+      char *            staging = nullptr;
+      std::uint64_t     previousOffset = 0;
+      std::uint64_t     previousSize = 0;
+      short             slabMinimum = NumericTraits<short>::max();
+      short             slabMaximum = NumericTraits<short>::min();
+      try
+      {
+        for (std::uint64_t offset = firstBlock * blockSize; offset < std::min(endBlock * blockSize, fileSize);
+             offset += blockSize)
+        {
+          const std::uint64_t size = std::min(blockSize, fileSize - offset);
+          const char *        block = nullptr;
+          std::uint64_t       writeSize = size;
+          if (offset < headerSize || staged)
+          {
+            if (staging == nullptr)
+            {
+              stagingBuffer.resize(blockSize + alignment);
+              staging = stagingBuffer.data() +
+                        (alignment - reinterpret_cast<std::uintptr_t>(stagingBuffer.data()) % alignment) % alignment;
+            }
+            stageBlock(offset, size, staging, slabMinimum, slabMaximum);
+            if (file.IsDirectIO())
+            {
+              // direct writes are whole blocks, the padding is truncated below
+              writeSize = (size + alignment - 1) / alignment * alignment;
+              memset(staging + size, 0, writeSize - size);
+            }
+            block = staging;
+          }
+          else
+          {
+            block = data + (offset - headerSize);
+            UpdateISQRange(
+              reinterpret_cast<const short *>(block), size / sizeof(short), slabMinimum, slabMaximum);
+          }
+          file.Write(block, writeSize, offset);
 
-    // Write the actual pixel data
-    outFile.write(static_cast<const char *>(tempmemory), numberOfBytes);
-    delete[] tempmemory;
+          if (throttleWriteBack)
+          {
+            file.StartWriteBack(offset, writeSize);
+            if (previousSize > 0)
+            {
+              file.FinishWriteBack(previousOffset, previousSize);
+            }
+            previousOffset = offset;
+            previousSize = writeSize;
+          }
+        }
+        if (previousSize > 0)
+        {
+          file.FinishWriteBack(previousOffset, previousSize);
+        }
+      }
+      catch (const ExceptionObject & error)
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        errorMessage = error.GetDescription();
+      }
+      std::lock_guard<std::mutex> lock(mutex);
+      minimum = std::min(minimum, slabMinimum);
+      maximum = std::max(maximum, slabMaximum);
+    },
+    nullptr);
+
+  if (!errorMessage.empty())
+  {
+    itkGenericExceptionMacro(<< errorMessage);
+  }
+
+  // Write the header again, with the range of the data
+  header.DataRange[0] = (numberOfPixels > 0 ? minimum : 0);
+  header.DataRange[1] = (numberOfPixels > 0 ? maximum : 0);
+  ScancoImageIO::EncodeISQHeader(header, rawHeader.data());
+  if (file.IsDirectIO())
+  {
+    // the data that shares the aligned blocks of the header is staged again
+    const std::uint64_t size = std::min(fileSize, (headerSize + alignment - 1) / alignment * alignment);
+    const std::uint64_t writeSize = (size + alignment - 1) / alignment * alignment;
+    std::vector<char>   stagingBuffer(writeSize + alignment);
+    char *              staging = stagingBuffer.data() +
+                     (alignment - reinterpret_cast<std::uintptr_t>(stagingBuffer.data()) % alignment) % alignment;
+    stageBlock(0, size, staging, minimum, maximum);
+    memset(staging + size, 0, writeSize - size);
+    file.Write(staging, writeSize, 0);
+    file.SetSize(fileSize);
   }
   else
   {
-    outFile.write(static_cast<const char *>(buffer), numberOfBytes);
+    file.Write(rawHeader.data(), headerSize, 0);
   }
+  file.Close();
+}
 
-  outFile.close();
+
+std::shared_future<void>
+ScancoImageIO::WriteAsync(const void * buffer, WriteCallback callback)
+{
+  return this->StartAsyncWrite(buffer, nullptr, std::move(callback));
+}
+
+
+std::shared_future<void>
+ScancoImageIO::WriteAsync(std::shared_ptr<const void> buffer, WriteCallback callback)
+{
+  const void * data = buffer.get();
+  return this->StartAsyncWrite(data, std::move(buffer), std::move(callback));
+}
+
+
+std::shared_future<void>
+ScancoImageIO::StartAsyncWrite(const void * buffer, std::shared_ptr<const void> owner, WriteCallback callback)
+{
+  // Everything the write needs from the IO is taken now
+  ScancoHeader header;
+  this->PrepareISQWrite(header);
+  const std::string     fileName = this->m_FileName;
+  const IOComponentEnum componentType = this->GetComponentType();
+  const SizeValueType   dataSize = this->GetImageSizeInBytes();
+  const bool            useDirectIO = this->m_UseDirectIO;
+  const bool            throttleWriteBack = this->m_ThrottleWriteBack;
+
+  AsyncWriteQueue & queue = AsyncWriteQueue::GetInstance();
+  queue.Acquire(dataSize);
+  if (owner == nullptr)
+  {
+    try
+    {
+      auto copy = std::make_shared<std::vector<char>>(static_cast<const char *>(buffer),
+                                                      static_cast<const char *>(buffer) + dataSize);
+      buffer = copy->data();
+      owner = std::move(copy);
+    }
+    catch (...)
+    {
+      queue.Release(dataSize);
+      throw;
+    }
+  }
+
+  auto                     promise = std::make_shared<std::promise<void>>();
+  std::shared_future<void> future = promise->get_future().share();
+  queue.Push([=, &queue]() mutable {
+    std::exception_ptr error;
+    try
+    {
+      ScancoImageIO::WriteISQFile(fileName, header, buffer, componentType, useDirectIO, throttleWriteBack);
+    }
+    catch (...)
+    {
+      error = std::current_exception();
+    }
+    owner.reset();
+    queue.Release(dataSize);
+    if (callback)
+    {
+      try
+      {
+        callback(error);
+      }
+      catch (...)
+      {
+        // there is nobody to report an error of the callback to
+      }
+    }
+    if (error)
+    {
+      promise->set_exception(error);
+    }
+    else
+    {
+      promise->set_value();
+    }
+  });
+  return future;
+}
+
+
+void
+ScancoImageIO::SetMaximumAsyncWriteBytes(SizeValueType maximumBytes)
+{
+  AsyncWriteQueue::GetInstance().SetMaximumBytes(maximumBytes);
+}
+
+
+SizeValueType
+ScancoImageIO::GetMaximumAsyncWriteBytes()
+{
+  return AsyncWriteQueue::GetInstance().GetMaximumBytes();
+}
+
+
+void
+ScancoImageIO::WaitForAsyncWrites()
+{
+  AsyncWriteQueue::GetInstance().Wait();
 }
 
 } // end namespace itk
@@ -0,0 +1,77 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         https://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkScancoLabelMapReader.h"
+
+namespace itk
+{
+
+void
+ScancoLabelMapReader::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "FileName: " << this->m_FileName << std::endl;
+}
+
+
+void
+ScancoLabelMapReader::SetFileName(const std::string & fileName)
+{
+  if (fileName != this->m_FileName)
+  {
+    this->m_FileName = fileName;
+    this->m_Header.reset();
+    this->Modified();
+  }
+}
+
+
+void
+ScancoLabelMapReader::UpdateInformation()
+{
+  if (this->m_Header == nullptr)
+  {
+    this->ReadInformation();
+  }
+}
+
+
+void
+ScancoLabelMapReader::ReadInformation()
+{
+  this->m_Header.reset();
+  if (this->m_FileName.empty())
+  {
+    itkExceptionMacro("No file name has been set.");
+  }
+  this->m_Header = ScancoImageIO::ReadHeader(this->m_FileName);
+}
+
+
+void
+ScancoLabelMapReader::ReadRuns(const RunFunction & runFunction)
+{
+  this->UpdateInformation();
+
+  ScancoImageIO::Pointer imageIO = ScancoImageIO::New();
+  imageIO->SetFileName(this->m_FileName);
+  imageIO->SetHeader(this->m_Header);
+  imageIO->ReadRuns(runFunction);
+}
+
+} // end namespace itk
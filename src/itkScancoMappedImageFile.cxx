@@ -0,0 +1,259 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         https://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkScancoMappedImageFile.h"
+#include "itkByteSwapper.h"
+#include "itkScancoImageIO.h"
+#include "itksys/SystemTools.hxx"
+
+#include <algorithm>
+
+#ifdef _WIN32
+#  define WIN32_LEAN_AND_MEAN
+#  include <windows.h>
+#else
+#  include <cerrno>
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <unistd.h>
+#endif
+
+namespace itk
+{
+
+ScancoMappedImageFile::~ScancoMappedImageFile()
+{
+  // a destructor must not throw, so errors of Close() are only reported
+  try
+  {
+    this->Close();
+  }
+  catch (const ExceptionObject & e)
+  {
+    itkWarningMacro("Could not close mapped file " << this->m_FileName << ": " << e.GetDescription());
+    this->Unmap();
+  }
+}
+
+
+void
+ScancoMappedImageFile::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "FileName: " << this->m_FileName << std::endl;
+  os << indent << "Mapped: " << (this->IsMapped() ? "Yes" : "No") << std::endl;
+  os << indent << "MappingSize: " << this->m_MappingSize << std::endl;
+}
+
+
+void
+ScancoMappedImageFile::Create(const ImageBase<3> * reference)
+{
+  if (this->m_FileName.empty())
+  {
+    itkExceptionMacro("FileName has not been set.");
+  }
+  if (reference == nullptr)
+  {
+    itkExceptionMacro("A reference image is required.");
+  }
+  if (ByteSwapper<PixelType>::SystemIsBigEndian())
+  {
+    itkExceptionMacro("Mapping ISQ files requires a little-endian system.");
+  }
+  this->Close();
+
+  // Write the header as ScancoImageIO::WriteImageInformation() does, for
+  // data that is stored without calibration
+  const ImageBase<3>::RegionType region = reference->GetLargestPossibleRegion();
+  ScancoImageIO::Pointer         imageIO = ScancoImageIO::New();
+  imageIO->SetFileName(this->m_FileName);
+  imageIO->SetNumberOfDimensions(3);
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    imageIO->SetDimensions(i, region.GetSize(i));
+    imageIO->SetSpacing(i, reference->GetSpacing()[i]);
+    imageIO->SetOrigin(i, reference->GetOrigin()[i]);
+  }
+  imageIO->SetComponentType(IOComponentEnum::SHORT);
+  imageIO->SetPixelType(IOPixelEnum::SCALAR);
+  imageIO->SetMetaDataDictionary(reference->GetMetaDataDictionary());
+  imageIO->WriteImageInformation();
+
+  const std::uint64_t dataOffset = imageIO->GetHeaderSize();
+  const std::uint64_t dataSize = static_cast<std::uint64_t>(region.GetNumberOfPixels()) * sizeof(PixelType);
+  const std::uint64_t fileSize = dataOffset + dataSize;
+
+#ifdef _WIN32
+  HANDLE file = CreateFileA(this->m_FileName.c_str(),
+                            GENERIC_READ | GENERIC_WRITE,
+                            0,
+                            nullptr,
+                            OPEN_EXISTING,
+                            FILE_ATTRIBUTE_NORMAL,
+                            nullptr);
+  if (file == INVALID_HANDLE_VALUE)
+  {
+    itkExceptionMacro("Could not open file for mapping: " << this->m_FileName);
+  }
+  this->m_FileHandle = file;
+
+  // the mapping extends the file to its full size
+  HANDLE mapping = CreateFileMappingA(file,
+                                      nullptr,
+                                      PAGE_READWRITE,
+                                      static_cast<DWORD>(fileSize >> 32),
+                                      static_cast<DWORD>(fileSize & 0xffffffff),
+                                      nullptr);
+  if (mapping == nullptr)
+  {
+    this->Unmap();
+    itkExceptionMacro("Could not create file mapping of " << fileSize << " bytes: " << this->m_FileName);
+  }
+  this->m_MappingHandle = mapping;
+
+  void * view = MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, static_cast<SIZE_T>(fileSize));
+  if (view == nullptr)
+  {
+    this->Unmap();
+    itkExceptionMacro("Could not map " << fileSize << " bytes of file: " << this->m_FileName);
+  }
+  this->m_Mapping = static_cast<char *>(view);
+#else
+  this->m_FileDescriptor = open(this->m_FileName.c_str(), O_RDWR);
+  if (this->m_FileDescriptor < 0)
+  {
+    itkExceptionMacro("Could not open file for mapping: " << this->m_FileName);
+  }
+  if (ftruncate(this->m_FileDescriptor, static_cast<off_t>(fileSize)) != 0)
+  {
+    this->Unmap();
+    itkExceptionMacro("Could not resize file to " << fileSize << " bytes: " << this->m_FileName);
+  }
+#  ifdef __linux__
+  // Reserve the blocks now, so that running out of space is an error here
+  // rather than a signal when a page is written. File systems that cannot
+  // preallocate leave the file sparse.
+  if (fallocate(this->m_FileDescriptor, 0, static_cast<off_t>(dataOffset), static_cast<off_t>(dataSize)) != 0 &&
+      errno == ENOSPC)
+  {
+    this->Unmap();
+    itkExceptionMacro("Not enough space for " << dataSize << " bytes of data: " << this->m_FileName);
+  }
+#  endif
+  void * mapping =
+    mmap(nullptr, static_cast<size_t>(fileSize), PROT_READ | PROT_WRITE, MAP_SHARED, this->m_FileDescriptor, 0);
+  if (mapping == MAP_FAILED)
+  {
+    this->Unmap();
+    itkExceptionMacro("Could not map " << fileSize << " bytes of file: " << this->m_FileName);
+  }
+  this->m_Mapping = static_cast<char *>(mapping);
+#endif
+  this->m_MappingSize = fileSize;
+
+  this->m_PixelContainer = PixelContainerType::New();
+  this->m_PixelContainer->SetImportPointer(
+    reinterpret_cast<PixelType *>(this->m_Mapping + dataOffset), region.GetNumberOfPixels(), false);
+
+  this->m_Image = ImageType::New();
+  this->m_Image->CopyInformation(reference);
+  this->m_Image->SetBufferedRegion(region);
+  this->m_Image->SetRequestedRegion(region);
+  this->m_Image->SetPixelContainer(this->m_PixelContainer);
+  this->Modified();
+}
+
+
+void
+ScancoMappedImageFile::Flush()
+{
+  if (this->m_Mapping == nullptr)
+  {
+    return;
+  }
+#ifdef _WIN32
+  if (!FlushViewOfFile(this->m_Mapping, 0) || !FlushFileBuffers(static_cast<HANDLE>(this->m_FileHandle)))
+#else
+  if (msync(this->m_Mapping, static_cast<size_t>(this->m_MappingSize), MS_SYNC) != 0)
+#endif
+  {
+    itkExceptionMacro("Could not write mapped data to file: " << this->m_FileName);
+  }
+}
+
+
+void
+ScancoMappedImageFile::Close()
+{
+  if (this->m_Mapping != nullptr && this->m_PixelContainer->Size() > 0)
+  {
+    // Set the data range of the header to that of the voxels
+    const PixelType * first = this->m_PixelContainer->GetBufferPointer();
+    const auto        range = std::minmax_element(first, first + this->m_PixelContainer->Size());
+    const double      dataRange[2] = { static_cast<double>(*range.first), static_cast<double>(*range.second) };
+    ScancoImageIO::EncodeDataRange(dataRange, this->m_Mapping);
+  }
+  this->Flush();
+  this->Unmap();
+}
+
+
+void
+ScancoMappedImageFile::Unmap()
+{
+  // the image must not be used to reach the unmapped memory
+  if (this->m_PixelContainer)
+  {
+    this->m_PixelContainer->SetImportPointer(nullptr, 0, false);
+    this->m_PixelContainer = nullptr;
+  }
+  this->m_Image = nullptr;
+
+#ifdef _WIN32
+  if (this->m_Mapping != nullptr)
+  {
+    UnmapViewOfFile(this->m_Mapping);
+  }
+  if (this->m_MappingHandle != nullptr)
+  {
+    CloseHandle(static_cast<HANDLE>(this->m_MappingHandle));
+    this->m_MappingHandle = nullptr;
+  }
+  if (this->m_FileHandle != nullptr)
+  {
+    CloseHandle(static_cast<HANDLE>(this->m_FileHandle));
+    this->m_FileHandle = nullptr;
+  }
+#else
+  if (this->m_Mapping != nullptr)
+  {
+    munmap(this->m_Mapping, static_cast<size_t>(this->m_MappingSize));
+  }
+  if (this->m_FileDescriptor >= 0)
+  {
+    close(this->m_FileDescriptor);
+    this->m_FileDescriptor = -1;
+  }
+#endif
+  this->m_Mapping = nullptr;
+  this->m_MappingSize = 0;
+}
+
+} // end namespace itk
@@ -0,0 +1,394 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         https://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkScancoRawFile.h"
+#include "itkMacro.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#ifdef _WIN32
+#  define WIN32_LEAN_AND_MEAN
+#  include <windows.h>
+#else
+#  include <cerrno>
+#  include <fcntl.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+namespace itk
+{
+
+constexpr SizeValueType ScancoRawFile::DirectIOAlignment;
+
+namespace
+{
+// Largest single read or write request, which keeps each request within
+// the limits of all platforms
+constexpr std::uint64_t maximumRequestSize = 1 << 30;
+} // end anonymous namespace
+
+
+ScancoRawFile::~ScancoRawFile()
+{
+  try
+  {
+    this->Close();
+  }
+  catch (const ExceptionObject &)
+  {
+    // destructors must not throw
+  }
+}
+
+
+bool
+ScancoRawFile::IsOpen() const
+{
+#ifdef _WIN32
+  return this->m_Handle != nullptr;
+#else
+  return this->m_FileDescriptor >= 0;
+#endif
+}
+
+
+void
+ScancoRawFile::Open(const std::string & fileName, bool forWriting, bool directIO)
+{
+  this->Close();
+  this->m_FileName = fileName;
+  this->m_DirectIO = false;
+
+#ifdef _WIN32
+  const DWORD access = (forWriting ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ);
+  const DWORD creation = (forWriting ? CREATE_ALWAYS : OPEN_EXISTING);
+  HANDLE      handle = INVALID_HANDLE_VALUE;
+  if (directIO)
+  {
+    handle = CreateFileA(fileName.c_str(),
+                         access,
+                         FILE_SHARE_READ,
+                         nullptr,
+                         creation,
+                         FILE_ATTRIBUTE_NORMAL | FILE_FLAG_NO_BUFFERING | FILE_FLAG_WRITE_THROUGH,
+                         nullptr);
+    this->m_DirectIO = (handle != INVALID_HANDLE_VALUE);
+  }
+  if (handle == INVALID_HANDLE_VALUE)
+  {
+    handle = CreateFileA(fileName.c_str(), access, FILE_SHARE_READ, nullptr, creation, FILE_ATTRIBUTE_NORMAL, nullptr);
+  }
+  if (handle == INVALID_HANDLE_VALUE)
+  {
+    itkGenericExceptionMacro("Could not open file: " << fileName);
+  }
+  this->m_Handle = handle;
+#else
+  const int flags = (forWriting ? O_RDWR | O_CREAT | O_TRUNC : O_RDONLY);
+#  ifdef O_DIRECT
+  if (directIO)
+  {
+    // file systems without direct I/O reject the flag
+    this->m_FileDescriptor = open(fileName.c_str(), flags | O_DIRECT, 0644);
+    this->m_DirectIO = (this->m_FileDescriptor >= 0);
+  }
+#  endif
+  if (this->m_FileDescriptor < 0)
+  {
+    this->m_FileDescriptor = open(fileName.c_str(), flags, 0644);
+  }
+  if (this->m_FileDescriptor < 0)
+  {
+    itkGenericExceptionMacro("Could not open file: " << fileName << ": " << std::strerror(errno));
+  }
+#endif
+}
+
+
+void
+ScancoRawFile::OpenForUpdate(const std::string & fileName)
+{
+  this->Close();
+  this->m_FileName = fileName;
+  this->m_DirectIO = false;
+
+#ifdef _WIN32
+  HANDLE handle = CreateFileA(fileName.c_str(),
+                              GENERIC_READ | GENERIC_WRITE,
+                              FILE_SHARE_READ,
+                              nullptr,
+                              OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL,
+                              nullptr);
+  if (handle == INVALID_HANDLE_VALUE)
+  {
+    itkGenericExceptionMacro("Could not open file for update: " << fileName);
+  }
+  this->m_Handle = handle;
+#else
+  this->m_FileDescriptor = open(fileName.c_str(), O_RDWR);
+  if (this->m_FileDescriptor < 0)
+  {
+    itkGenericExceptionMacro("Could not open file for update: " << fileName << ": " << std::strerror(errno));
+  }
+#endif
+}
+
+
+void
+ScancoRawFile::Close()
+{
+  if (!this->IsOpen())
+  {
+    return;
+  }
+#ifdef _WIN32
+  const bool closed = CloseHandle(static_cast<HANDLE>(this->m_Handle)) != 0;
+  this->m_Handle = nullptr;
+#else
+  const bool closed = (close(this->m_FileDescriptor) == 0);
+  this->m_FileDescriptor = -1;
+#endif
+  if (!closed)
+  {
+    // delayed write errors can be reported on close
+    itkGenericExceptionMacro("Could not close file: " << this->m_FileName);
+  }
+}
+
+
+void
+ScancoRawFile::Read(void * buffer, std::uint64_t size, std::uint64_t offset) const
+{
+  auto * out = static_cast<char *>(buffer);
+  while (size > 0)
+  {
+    const std::uint64_t request = std::min(size, maximumRequestSize);
+#ifdef _WIN32
+    OVERLAPPED overlapped{};
+    overlapped.Offset = static_cast<DWORD>(offset & 0xffffffff);
+    overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+    DWORD count = 0;
+    if (!ReadFile(static_cast<HANDLE>(this->m_Handle), out, static_cast<DWORD>(request), &count, &overlapped))
+    {
+      count = 0;
+    }
+    const std::int64_t result = count;
+#else
+    const std::int64_t result = pread(this->m_FileDescriptor, out, request, static_cast<off_t>(offset));
+    if (result < 0 && errno == EINTR)
+    {
+      continue;
+    }
+#endif
+    if (result <= 0)
+    {
+      itkGenericExceptionMacro("File is truncated, " << size << " bytes are missing: " << this->m_FileName);
+    }
+    out += result;
+    offset += result;
+    size -= result;
+  }
+}
+
+
+void
+ScancoRawFile::Write(const void * buffer, std::uint64_t size, std::uint64_t offset) const
+{
+  const auto * in = static_cast<const char *>(buffer);
+  while (size > 0)
+  {
+    const std::uint64_t request = std::min(size, maximumRequestSize);
+#ifdef _WIN32
+    OVERLAPPED overlapped{};
+    overlapped.Offset = static_cast<DWORD>(offset & 0xffffffff);
+    overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+    DWORD count = 0;
+    if (!WriteFile(static_cast<HANDLE>(this->m_Handle), in, static_cast<DWORD>(request), &count, &overlapped))
+    {
+      count = 0;
+    }
+    const std::int64_t result = count;
+#else
+    const std::int64_t result = pwrite(this->m_FileDescriptor, in, request, static_cast<off_t>(offset));
+    if (result < 0 && errno == EINTR)
+    {
+      continue;
+    }
+#endif
+    if (result <= 0)
+    {
+      itkGenericExceptionMacro("Could not write " << size << " bytes at offset " << offset << ": " << this->m_FileName);
+    }
+    in += result;
+    offset += result;
+    size -= result;
+  }
+}
+
+
+void
+ScancoRawFile::CopyFrom(const ScancoRawFile & source,
+                        std::uint64_t         sourceOffset,
+                        std::uint64_t         size,
+                        std::uint64_t         offset) const
+{
+#if defined(__linux__) && defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 27))
+  if (!source.m_DirectIO && !this->m_DirectIO)
+  {
+    auto sourcePosition = static_cast<off_t>(sourceOffset);
+    auto position = static_cast<off_t>(offset);
+    while (size > 0)
+    {
+      const ssize_t result = copy_file_range(source.m_FileDescriptor,
+                                             &sourcePosition,
+                                             this->m_FileDescriptor,
+                                             &position,
+                                             static_cast<size_t>(std::min(size, maximumRequestSize)),
+                                             0);
+      if (result < 0 && errno == EINTR)
+      {
+        continue;
+      }
+      if (result < 0 && (errno == ENOSYS || errno == EXDEV || errno == EINVAL || errno == EOPNOTSUPP))
+      {
+        // not supported between these files, copy the rest through memory
+        break;
+      }
+      if (result <= 0)
+      {
+        itkGenericExceptionMacro("Could not copy " << size << " bytes from " << source.m_FileName << " to "
+                                                   << this->m_FileName);
+      }
+      size -= result;
+    }
+    sourceOffset = static_cast<std::uint64_t>(sourcePosition);
+    offset = static_cast<std::uint64_t>(position);
+  }
+#endif
+
+  constexpr std::uint64_t bufferSize = 8 << 20;
+  std::vector<char>       buffer(static_cast<size_t>(std::min(size, bufferSize)));
+  while (size > 0)
+  {
+    const std::uint64_t request = std::min(size, bufferSize);
+    source.Read(buffer.data(), request, sourceOffset);
+    this->Write(buffer.data(), request, offset);
+    sourceOffset += request;
+    offset += request;
+    size -= request;
+  }
+}
+
+
+std::uint64_t
+ScancoRawFile::GetSize() const
+{
+#ifdef _WIN32
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(static_cast<HANDLE>(this->m_Handle), &size))
+  {
+    itkGenericExceptionMacro("Could not get the size of file: " << this->m_FileName);
+  }
+  return static_cast<std::uint64_t>(size.QuadPart);
+#else
+  struct stat status;
+  if (fstat(this->m_FileDescriptor, &status) != 0)
+  {
+    itkGenericExceptionMacro("Could not get the size of file: " << this->m_FileName << ": " << std::strerror(errno));
+  }
+  return static_cast<std::uint64_t>(status.st_size);
+#endif
+}
+
+
+void
+ScancoRawFile::SetSize(std::uint64_t size) const
+{
+#ifdef _WIN32
+  LARGE_INTEGER position;
+  position.QuadPart = static_cast<LONGLONG>(size);
+  const bool resized = SetFilePointerEx(static_cast<HANDLE>(this->m_Handle), position, nullptr, FILE_BEGIN) &&
+                       SetEndOfFile(static_cast<HANDLE>(this->m_Handle));
+#else
+  const bool resized = (ftruncate(this->m_FileDescriptor, static_cast<off_t>(size)) == 0);
+#endif
+  if (!resized)
+  {
+    itkGenericExceptionMacro("Could not resize file to " << size << " bytes: " << this->m_FileName);
+  }
+}
+
+
+void
+ScancoRawFile::Preallocate(std::uint64_t size) const
+{
+#if defined(__linux__)
+  if (fallocate(this->m_FileDescriptor, 0, 0, static_cast<off_t>(size)) == 0)
+  {
+    return;
+  }
+  if (errno == ENOSPC)
+  {
+    itkGenericExceptionMacro("Not enough space for " << size << " bytes: " << this->m_FileName);
+  }
+#elif defined(_WIN32)
+  FILE_ALLOCATION_INFO allocation;
+  allocation.AllocationSize.QuadPart = static_cast<LONGLONG>(size);
+  SetFileInformationByHandle(static_cast<HANDLE>(this->m_Handle), FileAllocationInfo, &allocation, sizeof(allocation));
+#endif
+  // file systems that cannot reserve blocks get a sparse file
+  this->SetSize(size);
+}
+
+
+void
+ScancoRawFile::StartWriteBack(std::uint64_t offset, std::uint64_t size) const
+{
+#if defined(__linux__)
+  sync_file_range(this->m_FileDescriptor, static_cast<off_t>(offset), static_cast<off_t>(size), SYNC_FILE_RANGE_WRITE);
+#else
+  (void)offset;
+  (void)size;
+#endif
+}
+
+
+void
+ScancoRawFile::FinishWriteBack(std::uint64_t offset, std::uint64_t size) const
+{
+#if defined(__linux__)
+  if (sync_file_range(this->m_FileDescriptor,
+                      static_cast<off_t>(offset),
+                      static_cast<off_t>(size),
+                      SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER) != 0)
+  {
+    itkGenericExceptionMacro("Could not write back " << size << " bytes at offset " << offset << ": "
+                                                     << this->m_FileName);
+  }
+  posix_fadvise(this->m_FileDescriptor, static_cast<off_t>(offset), static_cast<off_t>(size), POSIX_FADV_DONTNEED);
+#else
+  (void)offset;
+  (void)size;
+#endif
+}
+
+} // end namespace itk
@@ -0,0 +1,131 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         https://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkScancoRunLengthDecoder.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace itk
+{
+
+ScancoRunLengthDecoder::ScancoRunLengthDecoder(int compression, const char * data, SizeValueType size)
+  : m_Compression(compression)
+  , m_Data(reinterpret_cast<const unsigned char *>(data))
+  , m_Size(size)
+{}
+
+
+ScancoRunLengthDecoder::State
+ScancoRunLengthDecoder::GetInitialState() const
+{
+  State state;
+  if (this->m_Compression == 0x00b2)
+  {
+    // the runs follow the two voxel values
+    state.Position = 2;
+  }
+  return state;
+}
+
+
+bool
+ScancoRunLengthDecoder::StartRun(State & state) const
+{
+  if (this->m_Compression == 0x00b2)
+  {
+    if (state.Position >= this->m_Size || this->m_Size < 2)
+    {
+      return false;
+    }
+    unsigned int length = this->m_Data[state.Position++];
+    state.Value = this->m_Data[state.Flip];
+    if (length == 255)
+    {
+      // the run continues with the same value
+      length = 254;
+      state.Flip = !state.Flip;
+    }
+    state.Flip = !state.Flip;
+    state.Remaining = length;
+  }
+  else
+  {
+    if (state.Position + 1 >= this->m_Size)
+    {
+      return false;
+    }
+    state.Remaining = this->m_Data[state.Position];
+    state.Value = this->m_Data[state.Position + 1];
+    state.Position += 2;
+  }
+  return true;
+}
+
+
+SizeValueType
+ScancoRunLengthDecoder::Decode(State & state, unsigned char * output, SizeValueType count) const
+{
+  SizeValueType produced = 0;
+  while (produced < count)
+  {
+    if (state.Remaining == 0)
+    {
+      // start the next run
+      if (!this->StartRun(state))
+      {
+        break;
+      }
+      continue;
+    }
+
+    const SizeValueType n = std::min(state.Remaining, count - produced);
+    if (output != nullptr)
+    {
+      memset(output + produced, state.Value, n);
+    }
+    produced += n;
+    state.Remaining -= n;
+  }
+  return produced;
+}
+
+
+SizeValueType
+ScancoRunLengthDecoder::DecodeRun(State & state, unsigned char & value, SizeValueType count) const
+{
+  if (count == 0)
+  {
+    return 0;
+  }
+  // runs can be empty
+  while (state.Remaining == 0)
+  {
+    if (!this->StartRun(state))
+    {
+      return 0;
+    }
+  }
+
+  const SizeValueType n = std::min(state.Remaining, count);
+  value = state.Value;
+  state.Remaining -= n;
+  return n;
+}
+
+} // end namespace itk
@@ -0,0 +1,188 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         https://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkScancoSeriesReader.h"
+#include "itkMath.h"
+#include "itkMultiThreaderBase.h"
+
+#include <mutex>
+
+namespace itk
+{
+
+ScancoSeriesReader::ScancoSeriesReader()
+  : m_NumberOfWorkUnits(MultiThreaderBase::GetGlobalDefaultNumberOfThreads())
+{}
+
+
+void
+ScancoSeriesReader::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "FileNames: " << this->m_FileNames.size() << std::endl;
+  os << indent << "TimeSpacing: " << this->m_TimeSpacing << std::endl;
+  os << indent << "NumberOfWorkUnits: " << this->m_NumberOfWorkUnits << std::endl;
+  os << indent << "ComponentType: " << ImageIOBase::GetComponentTypeAsString(this->m_ComponentType) << std::endl;
+}
+
+
+void
+ScancoSeriesReader::SetFileNames(const FileNamesContainer & fileNames)
+{
+  this->m_FileNames = fileNames;
+  this->m_Headers.clear();
+  this->Modified();
+}
+
+
+void
+ScancoSeriesReader::AddFileName(const std::string & fileName)
+{
+  this->m_FileNames.push_back(fileName);
+  this->m_Headers.clear();
+  this->Modified();
+}
+
+
+ScancoSeriesReader::HeaderPointer
+ScancoSeriesReader::GetHeader(SizeValueType timepoint) const
+{
+  return (timepoint < this->m_Headers.size() ? this->m_Headers[timepoint] : nullptr);
+}
+
+
+void
+ScancoSeriesReader::UpdateInformation()
+{
+  if (this->m_Headers.empty())
+  {
+    this->ReadInformation();
+  }
+}
+
+
+void
+ScancoSeriesReader::ReadInformation()
+{
+  this->m_Headers.clear();
+  if (this->m_FileNames.empty())
+  {
+    itkExceptionMacro("No file names have been set.");
+  }
+
+  const SizeValueType        numberOfFiles = this->m_FileNames.size();
+  std::vector<HeaderPointer> headers(numberOfFiles);
+  std::mutex                 errorMutex;
+  std::string                errorMessage;
+  MultiThreaderBase::Pointer threader = MultiThreaderBase::New();
+  threader->SetNumberOfWorkUnits(this->m_NumberOfWorkUnits);
+  threader->ParallelizeArray(
+    0,
+    numberOfFiles,
+    [&](SizeValueType i) {
+      try
+      {
+        headers[i] = ScancoImageIO::ReadHeader(this->m_FileNames[i]);
+      }
+      catch (const ExceptionObject & error)
+      {
+        std::lock_guard<std::mutex> lock(errorMutex);
+        errorMessage = error.GetDescription();
+      }
+    },
+    nullptr);
+  if (!errorMessage.empty())
+  {
+    itkExceptionMacro(<< errorMessage);
+  }
+
+  // All timepoints must fit the slots of the first one
+  const ScancoHeader & first = *headers[0];
+  for (SizeValueType t = 1; t < numberOfFiles; ++t)
+  {
+    const ScancoHeader & header = *headers[t];
+    bool                 matches = (header.ComponentType == first.ComponentType);
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+      matches = matches && header.Dimensions[i] == first.Dimensions[i] &&
+                itk::Math::abs(header.Spacing[i] - first.Spacing[i]) <= 1e-4 * first.Spacing[i];
+    }
+    if (!matches)
+    {
+      itkExceptionMacro("The dimensions, spacing or pixel type of " << this->m_FileNames[t] << " differ from those of "
+                                                                     << this->m_FileNames[0]);
+    }
+  }
+
+  this->m_ComponentType = first.ComponentType;
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    this->m_Dimensions[i] = first.Dimensions[i];
+  }
+  this->m_Dimensions[3] = numberOfFiles;
+  ScancoImageIO::Pointer imageIO = ScancoImageIO::New();
+  imageIO->SetFileName(this->m_FileNames[0]);
+  imageIO->SetHeader(headers[0]);
+  this->m_TimepointSizeInBytes = imageIO->GetImageSizeInBytes();
+  this->m_Headers = std::move(headers);
+}
+
+
+void
+ScancoSeriesReader::Read(void * buffer)
+{
+  this->UpdateInformation();
+
+  ImageIORegion region(3);
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    region.SetIndex(i, 0);
+    region.SetSize(i, this->m_Dimensions[i]);
+  }
+
+  // Each file is decoded into its own slot, with an ImageIO of its own
+  std::mutex                 errorMutex;
+  std::string                errorMessage;
+  MultiThreaderBase::Pointer threader = MultiThreaderBase::New();
+  threader->SetNumberOfWorkUnits(this->m_NumberOfWorkUnits);
+  threader->ParallelizeArray(
+    0,
+    this->m_Headers.size(),
+    [&](SizeValueType t) {
+      try
+      {
+        ScancoImageIO::Pointer imageIO = ScancoImageIO::New();
+        imageIO->SetFileName(this->m_FileNames[t]);
+        imageIO->SetHeader(this->m_Headers[t]);
+        imageIO->ReadRegion(region, static_cast<char *>(buffer) + t * this->m_TimepointSizeInBytes);
+      }
+      catch (const ExceptionObject & error)
+      {
+        std::lock_guard<std::mutex> lock(errorMutex);
+        errorMessage = error.GetDescription();
+      }
+    },
+    nullptr);
+  if (!errorMessage.empty())
+  {
+    itkExceptionMacro(<< errorMessage);
+  }
+}
+
+} // end namespace itk
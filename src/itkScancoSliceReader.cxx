@@ -0,0 +1,395 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         https://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkScancoSliceReader.h"
+#include "itkByteSwapper.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace itk
+{
+
+ScancoSliceReader::ScancoSliceReader() = default;
+
+
+ScancoSliceReader::~ScancoSliceReader()
+{
+  this->WaitForPrefetches();
+}
+
+
+void
+ScancoSliceReader::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "FileName: " << this->m_FileName << std::endl;
+  os << indent << "MaximumNumberOfCachedSlices: " << this->m_MaximumNumberOfCachedSlices << std::endl;
+  os << indent << "NumberOfPrefetchedSlices: " << this->m_NumberOfPrefetchedSlices << std::endl;
+  os << indent << "NumberOfCachedSlices: " << this->GetNumberOfCachedSlices() << std::endl;
+}
+
+
+void
+ScancoSliceReader::SetFileName(const std::string & fileName)
+{
+  if (fileName == this->m_FileName)
+  {
+    return;
+  }
+  this->WaitForPrefetches();
+  std::lock_guard<std::mutex> lock(this->m_Mutex);
+  this->m_FileName = fileName;
+  this->m_Header.reset();
+  this->Modified();
+}
+
+
+void
+ScancoSliceReader::Open()
+{
+  this->WaitForPrefetches();
+  std::lock_guard<std::mutex> lock(this->m_Mutex);
+  this->OpenFile();
+}
+
+
+void
+ScancoSliceReader::OpenFile()
+{
+  if (this->m_FileName.empty())
+  {
+    itkExceptionMacro("FileName has not been set.");
+  }
+
+  this->m_Header = ScancoImageIO::ReadHeader(this->m_FileName);
+  this->m_ImageIO = ScancoImageIO::New();
+  this->m_ImageIO->SetFileName(this->m_FileName);
+  this->m_ImageIO->SetHeader(this->m_Header);
+  this->m_SliceSizeInBytes =
+    this->m_Header->Dimensions[0] * this->m_Header->Dimensions[1] * this->m_ImageIO->GetComponentSize();
+
+  this->m_Slices.clear();
+  this->m_SliceOrder.clear();
+  this->m_LastSlice = 0;
+
+  std::lock_guard<std::mutex> decoderLock(this->m_DecoderMutex);
+  this->m_File.close();
+  this->m_CompressedData.clear();
+  this->m_CompressedData.shrink_to_fit();
+  this->m_CompressedSize = 0;
+  this->m_Checkpoints.clear();
+}
+
+
+ScancoSliceReader::HeaderPointer
+ScancoSliceReader::GetHeader() const
+{
+  std::lock_guard<std::mutex> lock(this->m_Mutex);
+  return this->m_Header;
+}
+
+
+SizeValueType
+ScancoSliceReader::GetSliceSizeInBytes() const
+{
+  std::lock_guard<std::mutex> lock(this->m_Mutex);
+  return this->m_SliceSizeInBytes;
+}
+
+
+SizeValueType
+ScancoSliceReader::GetNumberOfCachedSlices() const
+{
+  std::lock_guard<std::mutex> lock(this->m_Mutex);
+  return this->m_Slices.size();
+}
+
+
+void
+ScancoSliceReader::ClearCache()
+{
+  this->WaitForPrefetches();
+  std::lock_guard<std::mutex> lock(this->m_Mutex);
+  this->m_Slices.clear();
+  this->m_SliceOrder.clear();
+}
+
+
+void
+ScancoSliceReader::ReadSlice(SizeValueType z, void * buffer)
+{
+  SlicePointer                     slice;
+  std::shared_future<SlicePointer> pending;
+  {
+    std::lock_guard<std::mutex> lock(this->m_Mutex);
+    if (!this->m_Header)
+    {
+      this->OpenFile();
+    }
+    if (z >= this->m_Header->Dimensions[2])
+    {
+      itkExceptionMacro("Slice " << z << " is outside of the image, which has " << this->m_Header->Dimensions[2]
+                                 << " slices.");
+    }
+
+    this->CollectPrefetches();
+    const auto cached = this->m_Slices.find(z);
+    if (cached != this->m_Slices.end())
+    {
+      slice = cached->second.first;
+      this->m_SliceOrder.splice(this->m_SliceOrder.begin(), this->m_SliceOrder, cached->second.second);
+    }
+    else
+    {
+      const auto prefetch = this->m_Prefetches.find(z);
+      if (prefetch != this->m_Prefetches.end())
+      {
+        pending = prefetch->second;
+      }
+    }
+  }
+
+  if (!slice)
+  {
+    if (pending.valid())
+    {
+      try
+      {
+        slice = pending.get();
+      }
+      catch (const ExceptionObject &)
+      {
+        // read again below, so that the error is reported to the caller
+      }
+    }
+    if (!slice)
+    {
+      slice = this->LoadSlice(z);
+    }
+  }
+
+  memcpy(buffer, slice->data(), slice->size());
+
+  std::lock_guard<std::mutex> lock(this->m_Mutex);
+  if (this->m_Slices.find(z) == this->m_Slices.end())
+  {
+    this->CacheSlice(z, slice);
+  }
+  this->Prefetch(z);
+}
+
+
+ScancoSliceReader::SlicePointer
+ScancoSliceReader::LoadSlice(SizeValueType z)
+{
+  auto slice = std::make_shared<std::vector<char>>(this->m_SliceSizeInBytes);
+  if (ScancoRunLengthDecoder::IsRunLength(this->m_Header->Compression))
+  {
+    this->DecodeRunLengthSlice(z, reinterpret_cast<unsigned char *>(slice->data()));
+  }
+  else
+  {
+    // uncompressed data is read directly, packed-bit data row by row
+    ImageIORegion region(3);
+    region.SetIndex(2, z);
+    region.SetSize(0, this->m_Header->Dimensions[0]);
+    region.SetSize(1, this->m_Header->Dimensions[1]);
+    region.SetSize(2, 1);
+    this->m_ImageIO->ReadRegion(region, slice->data());
+  }
+  return slice;
+}
+
+
+void
+ScancoSliceReader::DecodeRunLengthSlice(SizeValueType z, unsigned char * buffer)
+{
+  std::lock_guard<std::mutex> lock(this->m_DecoderMutex);
+
+  if (this->m_Checkpoints.empty())
+  {
+    this->m_File.open(this->m_FileName.c_str(), std::ios::in | std::ios::binary);
+    if (!this->m_File.is_open())
+    {
+      itkExceptionMacro("Could not open file for reading: " << this->m_FileName);
+    }
+
+    // the compressed data follows a size word, which is 64-bit in AIM 030
+    const SizeValueType intSize = (this->m_Header->FileType == 3 ? 8 : 4);
+    uint32_t            sizeWords[2] = { 0, 0 };
+    this->m_File.seekg(static_cast<std::streamoff>(this->m_Header->HeaderSize));
+    this->m_File.read(reinterpret_cast<char *>(sizeWords), intSize);
+    if (static_cast<SizeValueType>(this->m_File.gcount()) != intSize)
+    {
+      itkExceptionMacro("File is truncated: " << this->m_FileName);
+    }
+    ByteSwapper<uint32_t>::SwapRangeFromSystemToLittleEndian(sizeWords, 2);
+    const uint64_t size = sizeWords[0] + (static_cast<uint64_t>(sizeWords[1]) << 32);
+    this->m_CompressedSize = (size > intSize ? size - intSize : 0);
+    this->m_CompressedData.clear();
+
+    const ScancoRunLengthDecoder decoder(this->m_Header->Compression, nullptr, 0);
+    this->m_Checkpoints.push_back(decoder.GetInitialState());
+  }
+
+  // skip forward from the last checkpoint, keeping the state at each slice
+  const SizeValueType sliceVoxels = this->m_Header->Dimensions[0] * this->m_Header->Dimensions[1];
+  while (this->m_Checkpoints.size() <= z)
+  {
+    ScancoRunLengthDecoder::State state = this->m_Checkpoints.back();
+    this->DecodeRunLength(state, nullptr, sliceVoxels);
+    this->m_Checkpoints.push_back(state);
+  }
+
+  ScancoRunLengthDecoder::State state = this->m_Checkpoints[z];
+  this->DecodeRunLength(state, buffer, sliceVoxels);
+  if (this->m_Checkpoints.size() == z + 1)
+  {
+    this->m_Checkpoints.push_back(state);
+  }
+}
+
+
+void
+ScancoSliceReader::DecodeRunLength(ScancoRunLengthDecoder::State & state, unsigned char * output, SizeValueType count)
+{
+  // compressed data is loaded from the file in chunks, as far as it is needed
+  constexpr SizeValueType chunkSize = 1 << 20;
+
+  SizeValueType produced = 0;
+  while (true)
+  {
+    const ScancoRunLengthDecoder decoder(
+      this->m_Header->Compression, this->m_CompressedData.data(), this->m_CompressedData.size());
+    produced += decoder.Decode(state, (output != nullptr ? output + produced : nullptr), count - produced);
+    if (produced == count || this->m_CompressedData.size() == this->m_CompressedSize)
+    {
+      break;
+    }
+
+    const SizeValueType loaded = this->m_CompressedData.size();
+    const SizeValueType length = std::min(chunkSize, this->m_CompressedSize - loaded);
+    this->m_CompressedData.resize(loaded + length);
+    this->m_File.read(this->m_CompressedData.data() + loaded, length);
+    const SizeValueType shortread = length - static_cast<SizeValueType>(this->m_File.gcount());
+    if (shortread != 0)
+    {
+      // start over on the next request
+      this->m_File.close();
+      this->m_CompressedData.clear();
+      this->m_Checkpoints.clear();
+      itkExceptionMacro("File is truncated, " << shortread << " bytes are missing");
+    }
+  }
+
+  // like ScancoImageIO, zero the voxels past the end of the data
+  if (output != nullptr)
+  {
+    memset(output + produced, 0, count - produced);
+  }
+}
+
+
+void
+ScancoSliceReader::CacheSlice(SizeValueType z, const SlicePointer & slice)
+{
+  if (this->m_MaximumNumberOfCachedSlices == 0)
+  {
+    return;
+  }
+  while (this->m_Slices.size() >= this->m_MaximumNumberOfCachedSlices)
+  {
+    this->m_Slices.erase(this->m_SliceOrder.back());
+    this->m_SliceOrder.pop_back();
+  }
+  this->m_SliceOrder.push_front(z);
+  this->m_Slices[z] = std::make_pair(slice, this->m_SliceOrder.begin());
+}
+
+
+void
+ScancoSliceReader::CollectPrefetches()
+{
+  for (auto it = this->m_Prefetches.begin(); it != this->m_Prefetches.end();)
+  {
+    if (it->second.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+    {
+      ++it;
+      continue;
+    }
+    try
+    {
+      const SlicePointer slice = it->second.get();
+      if (this->m_Slices.find(it->first) == this->m_Slices.end())
+      {
+        this->CacheSlice(it->first, slice);
+      }
+    }
+    catch (const ExceptionObject &)
+    {
+      // the error is reported when the slice is requested
+    }
+    it = this->m_Prefetches.erase(it);
+  }
+}
+
+
+void
+ScancoSliceReader::Prefetch(SizeValueType z)
+{
+  const bool forward = (z >= this->m_LastSlice);
+  this->m_LastSlice = z;
+
+  // never prefetch more than the cache can keep next to the current slice
+  const SizeValueType count =
+    std::min(this->m_NumberOfPrefetchedSlices,
+             this->m_MaximumNumberOfCachedSlices > 0 ? this->m_MaximumNumberOfCachedSlices - 1 : 0);
+  for (SizeValueType i = 1; i <= count; ++i)
+  {
+    if (forward ? (z + i >= this->m_Header->Dimensions[2]) : (i > z))
+    {
+      break;
+    }
+    const SizeValueType next = (forward ? z + i : z - i);
+    if (this->m_Slices.find(next) != this->m_Slices.end() || this->m_Prefetches.find(next) != this->m_Prefetches.end())
+    {
+      continue;
+    }
+    this->m_Prefetches[next] = std::async(std::launch::async, [this, next]() { return this->LoadSlice(next); });
+  }
+}
+
+
+void
+ScancoSliceReader::WaitForPrefetches()
+{
+  PrefetchMapType prefetches;
+  {
+    std::lock_guard<std::mutex> lock(this->m_Mutex);
+    prefetches.swap(this->m_Prefetches);
+  }
+  for (auto & prefetch : prefetches)
+  {
+    prefetch.second.wait();
+  }
+}
+
+} // end namespace itk
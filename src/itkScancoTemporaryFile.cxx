@@ -0,0 +1,126 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         https://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkScancoTemporaryFile.h"
+#include "itkMacro.h"
+#include "itksys/SystemTools.hxx"
+
+#include <atomic>
+#include <sstream>
+
+#ifdef _WIN32
+#  define WIN32_LEAN_AND_MEAN
+#  include <windows.h>
+#else
+#  include <cerrno>
+#  include <cstring>
+#  include <fcntl.h>
+#  include <unistd.h>
+#endif
+
+namespace itk
+{
+namespace
+{
+// Distinguishes the temporary files of the threads of one process
+std::atomic<unsigned long> temporaryFileCounter{ 0 };
+
+// Create fileName if it does not exist yet. Returns false if it exists.
+bool
+CreateNewFile(const std::string & fileName)
+{
+#ifdef _WIN32
+  HANDLE handle =
+    CreateFileA(fileName.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_NEW, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (handle == INVALID_HANDLE_VALUE)
+  {
+    if (GetLastError() == ERROR_FILE_EXISTS)
+    {
+      return false;
+    }
+    itkGenericExceptionMacro("Could not create temporary file: " << fileName);
+  }
+  CloseHandle(handle);
+#else
+  const int fileDescriptor = open(fileName.c_str(), O_WRONLY | O_CREAT | O_EXCL, 0666);
+  if (fileDescriptor < 0)
+  {
+    if (errno == EEXIST)
+    {
+      return false;
+    }
+    itkGenericExceptionMacro("Could not create temporary file: " << fileName << ": " << std::strerror(errno));
+  }
+  close(fileDescriptor);
+#endif
+  return true;
+}
+
+unsigned long
+GetProcessID()
+{
+#ifdef _WIN32
+  return GetCurrentProcessId();
+#else
+  return static_cast<unsigned long>(getpid());
+#endif
+}
+} // end anonymous namespace
+
+
+ScancoTemporaryFile::ScancoTemporaryFile(const std::string & targetFileName)
+  : m_TargetFileName(targetFileName)
+{
+  // A hidden file next to the target, e.g. dir/.name.isq.1234.0.tmp
+  const std::string directory = itksys::SystemTools::GetFilenamePath(targetFileName);
+  const std::string prefix = (directory.empty() ? std::string() : directory + "/") + "." +
+                             itksys::SystemTools::GetFilenameName(targetFileName) + ".";
+  do
+  {
+    std::ostringstream name;
+    name << prefix << GetProcessID() << "." << temporaryFileCounter++ << ".tmp";
+    this->m_FileName = name.str();
+  } while (!CreateNewFile(this->m_FileName));
+}
+
+
+ScancoTemporaryFile::~ScancoTemporaryFile()
+{
+  if (!this->m_Committed)
+  {
+    itksys::SystemTools::RemoveFile(this->m_FileName);
+  }
+}
+
+
+void
+ScancoTemporaryFile::Commit()
+{
+  mode_t mode = 0;
+  if (itksys::SystemTools::GetPermissions(this->m_TargetFileName, mode))
+  {
+    itksys::SystemTools::SetPermissions(this->m_FileName, mode);
+  }
+  if (!itksys::SystemTools::RenameFile(this->m_FileName, this->m_TargetFileName))
+  {
+    itkGenericExceptionMacro("Could not rename " << this->m_FileName << " to " << this->m_TargetFileName);
+  }
+  this->m_Committed = true;
+}
+
+} // end namespace itk
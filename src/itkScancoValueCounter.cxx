@@ -0,0 +1,252 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         https://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkScancoValueCounter.h"
+#include "itkMultiThreaderBase.h"
+#include "itkScancoImageIO.h"
+#include "itkScancoRunLengthDecoder.h"
+
+#include <algorithm>
+#include <fstream>
+#include <limits>
+#include <mutex>
+
+namespace itk
+{
+
+ScancoValueCounter::ScancoValueCounter()
+  : m_NumberOfWorkUnits(MultiThreaderBase::GetGlobalDefaultNumberOfThreads())
+{}
+
+
+void
+ScancoValueCounter::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "FileName: " << this->m_FileName << std::endl;
+  os << indent << "NumberOfWorkUnits: " << this->m_NumberOfWorkUnits << std::endl;
+  os << indent << "NumberOfVoxels: " << this->m_NumberOfVoxels << std::endl;
+  os << indent << "NonZeroFraction: " << this->GetNonZeroFraction() << std::endl;
+}
+
+
+void
+ScancoValueCounter::Compute()
+{
+  this->m_Histogram.fill(0);
+  this->m_SliceHistograms.clear();
+  this->m_NumberOfVoxels = 0;
+  if (this->m_FileName.empty())
+  {
+    itkExceptionMacro("FileName must be set.");
+  }
+
+  const ScancoImageIO::HeaderPointer header = ScancoImageIO::ReadHeader(this->m_FileName);
+  if (header->PixelType != IOPixelEnum::SCALAR ||
+      (header->ComponentType != IOComponentEnum::CHAR && header->ComponentType != IOComponentEnum::UCHAR))
+  {
+    itkExceptionMacro("Values can only be counted in 8-bit scalar images, not in "
+                      << ImageIOBase::GetPixelTypeAsString(header->PixelType) << ' '
+                      << ImageIOBase::GetComponentTypeAsString(header->ComponentType) << ": " << this->m_FileName);
+  }
+
+  const SizeValueType xsize = header->Dimensions[0];
+  const SizeValueType ysize = header->Dimensions[1];
+  const SizeValueType zsize = header->Dimensions[2];
+  const SizeValueType sliceSize = xsize * ysize;
+  const SizeValueType numberOfVoxels = sliceSize * zsize;
+  this->m_SliceHistograms.assign(zsize * 256, 0);
+
+  MultiThreaderBase::Pointer threader = MultiThreaderBase::New();
+  threader->SetNumberOfWorkUnits(this->m_NumberOfWorkUnits);
+  std::vector<char> inputBuffer;
+  SizeValueType     size = 0;
+  if (header->Compression != 0)
+  {
+    std::ifstream infile(this->m_FileName.c_str(), std::ios::in | std::ios::binary);
+    if (!infile.is_open())
+    {
+      itkExceptionMacro("Could not open file for reading: " << this->m_FileName);
+    }
+    size = ScancoImageIO::ReadCompressedData(infile, *header, inputBuffer);
+  }
+
+  if (ScancoRunLengthDecoder::IsRunLength(header->Compression))
+  {
+    // Chunks start at run boundaries: every byte after the two values of
+    // binary runs, every second byte of 8-bit runs
+    const SizeValueType firstRun = (header->Compression == 0x00b2 ? 2 : 0);
+    const SizeValueType runSize = (header->Compression == 0x00b2 ? 1 : 2);
+    const SizeValueType numberOfRuns = (size > firstRun ? (size - firstRun) / runSize : 0);
+    const SizeValueType numberOfChunks =
+      std::max<SizeValueType>(1, std::min<SizeValueType>(numberOfRuns, threader->GetNumberOfWorkUnits()));
+    auto chunkStart = [&](SizeValueType chunk) {
+      return firstRun + (chunk * numberOfRuns / numberOfChunks) * runSize;
+    };
+
+    // The voxels in each chunk, and whether its binary runs end on the
+    // other value than they start with
+    std::vector<SizeValueType> chunkVoxels(numberOfChunks, 0);
+    std::vector<unsigned char> chunkFlips(numberOfChunks, 0);
+    threader->ParallelizeArray(
+      0,
+      numberOfChunks,
+      [&](SizeValueType chunk) {
+        const ScancoRunLengthDecoder  decoder(header->Compression, inputBuffer.data(), chunkStart(chunk + 1));
+        ScancoRunLengthDecoder::State state;
+        state.Position = chunkStart(chunk);
+        unsigned char value = 0;
+        SizeValueType n = 0;
+        while ((n = decoder.DecodeRun(state, value, std::numeric_limits<SizeValueType>::max())) != 0)
+        {
+          chunkVoxels[chunk] += n;
+        }
+        chunkFlips[chunk] = state.Flip;
+      },
+      nullptr);
+
+    std::vector<SizeValueType> chunkOffsets(numberOfChunks);
+    std::vector<unsigned char> chunkStartFlips(numberOfChunks);
+    SizeValueType              decodedVoxels = 0;
+    unsigned char              flip = 0;
+    for (SizeValueType chunk = 0; chunk < numberOfChunks; ++chunk)
+    {
+      chunkOffsets[chunk] = decodedVoxels;
+      chunkStartFlips[chunk] = flip;
+      decodedVoxels += chunkVoxels[chunk];
+      flip ^= chunkFlips[chunk];
+    }
+
+    // Slices at the ends of a chunk can be shared with its neighbours, so
+    // each chunk counts into its own histograms and adds them at the end
+    std::mutex countsMutex;
+    threader->ParallelizeArray(
+      0,
+      numberOfChunks,
+      [&](SizeValueType chunk) {
+        SizeValueType       voxel = chunkOffsets[chunk];
+        const SizeValueType endVoxel = std::min(numberOfVoxels, voxel + chunkVoxels[chunk]);
+        if (voxel >= endVoxel)
+        {
+          return;
+        }
+        const SizeValueType        firstSlice = voxel / sliceSize;
+        std::vector<SizeValueType> histograms(((endVoxel - 1) / sliceSize - firstSlice + 1) * 256, 0);
+
+        const ScancoRunLengthDecoder  decoder(header->Compression, inputBuffer.data(), chunkStart(chunk + 1));
+        ScancoRunLengthDecoder::State state;
+        state.Position = chunkStart(chunk);
+        state.Flip = (chunkStartFlips[chunk] != 0);
+        unsigned char value = 0;
+        while (voxel < endVoxel)
+        {
+          const SizeValueType z = voxel / sliceSize;
+          const SizeValueType n = decoder.DecodeRun(state, value, std::min(endVoxel, (z + 1) * sliceSize) - voxel);
+          if (n == 0)
+          {
+            break;
+          }
+          histograms[(z - firstSlice) * 256 + value] += n;
+          voxel += n;
+        }
+
+        std::lock_guard<std::mutex> lock(countsMutex);
+        for (SizeValueType i = 0; i < histograms.size(); ++i)
+        {
+          this->m_SliceHistograms[firstSlice * 256 + i] += histograms[i];
+        }
+      },
+      nullptr);
+
+    // the rest is zero if the data ends early
+    for (SizeValueType voxel = decodedVoxels; voxel < numberOfVoxels;)
+    {
+      const SizeValueType z = voxel / sliceSize;
+      const SizeValueType n = std::min(numberOfVoxels, (z + 1) * sliceSize) - voxel;
+      this->m_SliceHistograms[z * 256] += n;
+      voxel += n;
+    }
+  }
+  else
+  {
+    // Slabs of slices are read or unpacked one row at a time, and count
+    // into the histograms of their own slices
+    const SizeValueType numberOfSlabs = std::min<SizeValueType>(zsize, threader->GetNumberOfWorkUnits());
+    std::mutex          errorMutex;
+    std::string         errorMessage;
+    threader->ParallelizeArray(
+      0,
+      numberOfSlabs,
+      [&](SizeValueType slab) {
+        const SizeValueType firstSlice = slab * zsize / numberOfSlabs;
+        const SizeValueType endSlice = (slab + 1) * zsize / numberOfSlabs;
+
+        std::ifstream              slabFile;
+        std::vector<unsigned char> rows(header->Compression == 0 ? sliceSize : xsize);
+        if (header->Compression == 0)
+        {
+          slabFile.open(this->m_FileName.c_str(), std::ios::in | std::ios::binary);
+          slabFile.seekg(static_cast<std::streamoff>(header->HeaderSize + firstSlice * sliceSize));
+        }
+        for (SizeValueType z = firstSlice; z < endSlice; ++z)
+        {
+          SizeValueType * histogram = this->m_SliceHistograms.data() + z * 256;
+          if (header->Compression == 0)
+          {
+            slabFile.read(reinterpret_cast<char *>(rows.data()), sliceSize);
+            if (static_cast<SizeValueType>(slabFile.gcount()) != sliceSize)
+            {
+              std::lock_guard<std::mutex> lock(errorMutex);
+              errorMessage = "File is truncated: " + this->m_FileName;
+              return;
+            }
+            for (const unsigned char value : rows)
+            {
+              ++histogram[value];
+            }
+            continue;
+          }
+          for (SizeValueType y = 0; y < ysize; ++y)
+          {
+            ScancoImageIO::DecodePackedRow(inputBuffer.data(), size, *header, y, z, rows.data());
+            for (const unsigned char value : rows)
+            {
+              ++histogram[value];
+            }
+          }
+        }
+      },
+      nullptr);
+    if (!errorMessage.empty())
+    {
+      this->m_SliceHistograms.clear();
+      itkExceptionMacro(<< errorMessage);
+    }
+  }
+
+  for (SizeValueType z = 0; z < zsize; ++z)
+  {
+    for (unsigned int value = 0; value < 256; ++value)
+    {
+      this->m_Histogram[value] += this->m_SliceHistograms[z * 256 + value];
+    }
+  }
+  this->m_NumberOfVoxels = numberOfVoxels;
+}
+
+} // end namespace itk
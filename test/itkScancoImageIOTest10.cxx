@@ -0,0 +1,128 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         https://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <algorithm>
+#include "itkBinaryThresholdImageFilter.h"
+#include "itkImageFileReader.h"
+#include "itkScancoImageIO.h"
+#include "itkScancoMappedImageFile.h"
+#include "itkTestingMacros.h"
+
+
+#define SPECIFIC_IMAGEIO_MODULE_TEST
+
+int
+itkScancoImageIOTest10(int argc, char * argv[])
+{
+  if (argc < 3)
+  {
+    std::cerr << "Missing parameters." << std::endl;
+    std::cerr << "Usage: " << std::endl;
+    std::cerr << itkNameOfTestExecutableMacro(argv) << " Input Output" << std::endl;
+    return EXIT_FAILURE;
+  }
+  const std::string inputFileName = argv[1];
+  const std::string outputFileName = argv[2];
+
+  using MappedFileType = itk::ScancoMappedImageFile;
+  using ImageType = MappedFileType::ImageType;
+  using ReaderType = itk::ImageFileReader<ImageType>;
+
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetImageIO(itk::ScancoImageIO::New());
+  reader->SetFileName(inputFileName);
+  ITK_TRY_EXPECT_NO_EXCEPTION(reader->Update());
+  ImageType::Pointer       image = reader->GetOutput();
+  const itk::SizeValueType numberOfPixels = image->GetLargestPossibleRegion().GetNumberOfPixels();
+
+  MappedFileType::Pointer mappedFile = MappedFileType::New();
+
+  ITK_EXERCISE_BASIC_OBJECT_METHODS(mappedFile, ScancoMappedImageFile, Object);
+
+  // A file name is required
+  ITK_TRY_EXPECT_EXCEPTION(mappedFile->Create(image));
+
+  mappedFile->SetFileName(outputFileName);
+  ITK_TEST_SET_GET_VALUE(outputFileName, mappedFile->GetFileName());
+  ITK_TRY_EXPECT_NO_EXCEPTION(mappedFile->Create(image));
+  ITK_TEST_EXPECT_TRUE(mappedFile->IsMapped());
+
+  // The mapped image starts out zeroed, with the geometry of the reference
+  ImageType * mappedImage = mappedFile->GetImage();
+  ITK_TEST_EXPECT_TRUE(mappedImage != nullptr);
+  ITK_TEST_EXPECT_TRUE(mappedImage->GetBufferedRegion() == image->GetLargestPossibleRegion());
+  ITK_TEST_EXPECT_EQUAL(mappedImage->GetSpacing(), image->GetSpacing());
+  const MappedFileType::PixelType * mappedBuffer = mappedImage->GetBufferPointer();
+  ITK_TEST_EXPECT_TRUE(std::all_of(
+    mappedBuffer, mappedBuffer + numberOfPixels, [](MappedFileType::PixelType value) { return value == 0; }));
+
+  // Writing into the image writes into the file
+  std::copy(image->GetBufferPointer(), image->GetBufferPointer() + numberOfPixels, mappedImage->GetBufferPointer());
+  ITK_TRY_EXPECT_NO_EXCEPTION(mappedFile->Flush());
+  ITK_TRY_EXPECT_NO_EXCEPTION(mappedFile->Close());
+  ITK_TEST_EXPECT_TRUE(!mappedFile->IsMapped());
+  ITK_TEST_EXPECT_TRUE(mappedFile->GetImage() == nullptr);
+
+  ReaderType::Pointer outputReader = ReaderType::New();
+  outputReader->SetImageIO(itk::ScancoImageIO::New());
+  outputReader->SetFileName(outputFileName);
+  ITK_TRY_EXPECT_NO_EXCEPTION(outputReader->Update());
+  ImageType::Pointer outputImage = outputReader->GetOutput();
+  ITK_TEST_EXPECT_TRUE(outputImage->GetLargestPossibleRegion() == image->GetLargestPossibleRegion());
+  ITK_TEST_EXPECT_TRUE(
+    std::equal(image->GetBufferPointer(), image->GetBufferPointer() + numberOfPixels, outputImage->GetBufferPointer()));
+
+  // Closing sets the data range of the header to that of the voxels
+  const auto range = std::minmax_element(image->GetBufferPointer(), image->GetBufferPointer() + numberOfPixels);
+  const itk::ScancoImageIO::HeaderPointer header = itk::ScancoImageIO::ReadHeader(outputFileName);
+  ITK_TEST_EXPECT_EQUAL(header->DataRange[0], static_cast<double>(*range.first));
+  ITK_TEST_EXPECT_EQUAL(header->DataRange[1], static_cast<double>(*range.second));
+
+  // A filter produces its output directly into the file, with the pattern
+  // of the class documentation
+  using ThresholdType = itk::BinaryThresholdImageFilter<ImageType, ImageType>;
+  ThresholdType::Pointer threshold = ThresholdType::New();
+  threshold->SetInput(image);
+  threshold->SetLowerThreshold(static_cast<MappedFileType::PixelType>(*range.first / 2 + *range.second / 2));
+  threshold->SetInsideValue(1000);
+  threshold->SetOutsideValue(0);
+  ITK_TRY_EXPECT_NO_EXCEPTION(mappedFile->Create(image));
+  mappedBuffer = mappedFile->GetImage()->GetBufferPointer();
+  threshold->InPlaceOff();
+  threshold->ReleaseDataBeforeUpdateFlagOff();
+  threshold->GraftOutput(mappedFile->GetImage());
+  ITK_TRY_EXPECT_NO_EXCEPTION(threshold->Update());
+  ITK_TEST_EXPECT_TRUE(threshold->GetOutput()->GetBufferPointer() == mappedBuffer);
+  ITK_TRY_EXPECT_NO_EXCEPTION(mappedFile->Close());
+
+  outputReader->Modified();
+  ITK_TRY_EXPECT_NO_EXCEPTION(outputReader->Update());
+  outputImage = outputReader->GetOutput();
+  const MappedFileType::PixelType lowerThreshold = threshold->GetLowerThreshold();
+  ITK_TEST_EXPECT_TRUE(std::equal(image->GetBufferPointer(),
+                                  image->GetBufferPointer() + numberOfPixels,
+                                  outputImage->GetBufferPointer(),
+                                  [lowerThreshold](MappedFileType::PixelType input, MappedFileType::PixelType output) {
+                                    return output == (input >= lowerThreshold ? 1000 : 0);
+                                  }));
+  ITK_TEST_EXPECT_EQUAL(itk::ScancoImageIO::ReadHeader(outputFileName)->DataRange[1], 1000.0);
+
+
+  std::cout << "Test finished" << std::endl;
+  return EXIT_SUCCESS;
+}
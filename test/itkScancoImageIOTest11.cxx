@@ -0,0 +1,168 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         https://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <algorithm>
+#include <fstream>
+#include <vector>
+#include "itkByteSwapper.h"
+#include "itkMath.h"
+#include "itkScancoImageIO.h"
+#include "itkScancoTestHelpers.h"
+#include "itkTestingMacros.h"
+
+
+#define SPECIFIC_IMAGEIO_MODULE_TEST
+
+namespace
+{
+
+// Dimensions with more than 2^31 voxels and more than 4 GB of short data
+constexpr itk::SizeValueType largeDimensions[3] = { 2048, 2048, 600 };
+
+using itk::ScancoTestHelpers::AppendInt64;
+using itk::ScancoTestHelpers::EncodeAIMHeader;
+
+
+// Write the last row of the volume at the end of a file that is otherwise
+// left sparse, and check that it is read back at the right place
+int
+WriteAndReadLastRow(const std::string & fileName, itk::SizeValueType dataOffset)
+{
+  const itk::SizeValueType rowSize = largeDimensions[0];
+  std::vector<short>       row(rowSize);
+  for (itk::SizeValueType i = 0; i < rowSize; ++i)
+  {
+    row[i] = static_cast<short>(i * 7 - 3000);
+  }
+  std::vector<short> fileRow(row);
+  itk::ByteSwapper<short>::SwapRangeFromSystemToLittleEndian(fileRow.data(), rowSize);
+
+  const itk::SizeValueType numberOfPixels = largeDimensions[0] * largeDimensions[1] * largeDimensions[2];
+  {
+    std::fstream file(fileName.c_str(), std::ios::in | std::ios::out | std::ios::binary);
+    file.seekp(dataOffset + (numberOfPixels - rowSize) * sizeof(short));
+    file.write(reinterpret_cast<const char *>(fileRow.data()), rowSize * sizeof(short));
+    if (!file.good())
+    {
+      std::cerr << "Could not write " << fileName << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  const itk::ScancoImageIO::ProbeInformation info = itk::ScancoImageIO::Probe(fileName);
+  ITK_TEST_EXPECT_EQUAL(info.DataOffset, dataOffset);
+  ITK_TEST_EXPECT_EQUAL(info.ExpectedFileSize, dataOffset + numberOfPixels * sizeof(short));
+  ITK_TEST_EXPECT_TRUE(!info.IsTruncated());
+
+  itk::ScancoImageIO::Pointer scancoIO = itk::ScancoImageIO::New();
+  scancoIO->SetFileName(fileName);
+  ITK_TRY_EXPECT_NO_EXCEPTION(scancoIO->ReadImageInformation());
+  bool dimensionsMatch = true;
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    dimensionsMatch = dimensionsMatch && (scancoIO->GetDimensions(i) == largeDimensions[i]);
+  }
+  ITK_TEST_EXPECT_TRUE(dimensionsMatch);
+  ITK_TEST_EXPECT_EQUAL(scancoIO->GetImageSizeInPixels(), numberOfPixels);
+
+  itk::ImageIORegion region(3);
+  region.SetIndex(0, 0);
+  region.SetIndex(1, largeDimensions[1] - 1);
+  region.SetIndex(2, largeDimensions[2] - 1);
+  region.SetSize(0, rowSize);
+  region.SetSize(1, 1);
+  region.SetSize(2, 1);
+  std::vector<short> readRow(rowSize);
+  ITK_TRY_EXPECT_NO_EXCEPTION(scancoIO->ReadRegion(region, readRow.data()));
+
+  // the row before it was never written
+  region.SetIndex(1, largeDimensions[1] - 2);
+  std::vector<short> emptyRow(rowSize, 1);
+  ITK_TRY_EXPECT_NO_EXCEPTION(scancoIO->ReadRegion(region, emptyRow.data()));
+
+  ITK_TEST_EXPECT_TRUE(row == readRow);
+  ITK_TEST_EXPECT_TRUE(std::all_of(emptyRow.begin(), emptyRow.end(), [](short value) { return value == 0; }));
+  return EXIT_SUCCESS;
+}
+
+} // end anonymous namespace
+
+
+int
+itkScancoImageIOTest11(int argc, char * argv[])
+{
+  if (argc < 3)
+  {
+    std::cerr << "Missing parameters." << std::endl;
+    std::cerr << "Usage: " << std::endl;
+    std::cerr << itkNameOfTestExecutableMacro(argv) << " OutputISQ OutputAIM" << std::endl;
+    return EXIT_FAILURE;
+  }
+  const std::string isqFileName = argv[1];
+  const std::string aimFileName = argv[2];
+
+  // An ISQ header, followed by sparse data
+  itk::ScancoImageIO::Pointer writeIO = itk::ScancoImageIO::New();
+  writeIO->SetFileName(isqFileName);
+  writeIO->SetNumberOfDimensions(3);
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    writeIO->SetDimensions(i, largeDimensions[i]);
+    writeIO->SetSpacing(i, 0.01);
+    writeIO->SetOrigin(i, 0.0);
+  }
+  writeIO->SetPixelType(itk::IOPixelEnum::SCALAR);
+  writeIO->SetComponentType(itk::IOComponentEnum::SHORT);
+  ITK_TRY_EXPECT_NO_EXCEPTION(writeIO->WriteImageInformation());
+  ITK_TEST_EXPECT_EQUAL(WriteAndReadLastRow(isqFileName, 512), EXIT_SUCCESS);
+
+  // An AIM v030 header, where all sizes are 64-bit, followed by sparse data
+  constexpr int64_t position[3] = { 0, 0, 0 };
+  const int64_t     dataSize = largeDimensions[0] * largeDimensions[1] * largeDimensions[2] * sizeof(short);
+  // short data and 10 micrometers, in units of 1e-6 mm
+  std::vector<char> header = EncodeAIMHeader(0x00020002, largeDimensions, position, 10000, dataSize);
+  {
+    std::ofstream file(aimFileName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    file.write(header.data(), header.size());
+    ITK_TEST_EXPECT_TRUE(file.good());
+  }
+  ITK_TEST_EXPECT_EQUAL(WriteAndReadLastRow(aimFileName, header.size()), EXIT_SUCCESS);
+
+  itk::ScancoImageIO::Pointer aimIO = itk::ScancoImageIO::New();
+  aimIO->SetFileName(aimFileName);
+  ITK_TRY_EXPECT_NO_EXCEPTION(aimIO->ReadImageInformation());
+  ITK_TEST_EXPECT_TRUE(itk::Math::FloatAlmostEqual(aimIO->GetSpacing(0), 0.01, 4, 1e-6));
+
+  // A corrupt log size beyond the end of the file is reported, not allocated
+  std::vector<char> corruptHeader;
+  AppendInt64(corruptHeader, int64_t{ 1 } << 60);
+  std::copy(corruptHeader.begin(), corruptHeader.end(), header.begin() + 16 + 16);
+  const std::string corruptFileName = aimFileName + ".corrupt";
+  {
+    std::ofstream file(corruptFileName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    file.write(header.data(), header.size());
+    ITK_TEST_EXPECT_TRUE(file.good());
+  }
+  aimIO->SetFileName(corruptFileName);
+  ITK_TRY_EXPECT_EXCEPTION(aimIO->ReadImageInformation());
+  ITK_TRY_EXPECT_EXCEPTION(itk::ScancoImageIO::ReadHeader(corruptFileName));
+
+
+  std::cout << "Test finished" << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,148 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         https://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <algorithm>
+#include <fstream>
+#include "itkImage.h"
+#include "itkImageFileReader.h"
+#include "itkScancoImageIO.h"
+#include "itkTestingMacros.h"
+#include "itksys/SystemTools.hxx"
+
+
+#define SPECIFIC_IMAGEIO_MODULE_TEST
+
+namespace
+{
+
+using ImageType = itk::Image<float, 3>;
+
+ImageType::Pointer
+ReadImage(const std::string & fileName)
+{
+  using ReaderType = itk::ImageFileReader<ImageType>;
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetImageIO(itk::ScancoImageIO::New());
+  reader->SetFileName(fileName);
+  reader->Update();
+  return reader->GetOutput();
+}
+
+
+bool
+SamePixels(const ImageType * image1, const ImageType * image2)
+{
+  const itk::SizeValueType numberOfPixels = image1->GetLargestPossibleRegion().GetNumberOfPixels();
+  const ImageType::PixelType * buffer1 = image1->GetBufferPointer();
+  return image2->GetLargestPossibleRegion() == image1->GetLargestPossibleRegion() &&
+         std::equal(buffer1, buffer1 + numberOfPixels, image2->GetBufferPointer());
+}
+
+
+// Patch a copy of a file, and check the header fields and that the pixels
+// are unchanged
+int
+PatchAndCompare(const std::string & inputFileName, const std::string & outputFileName)
+{
+  ITK_TEST_EXPECT_TRUE(itksys::SystemTools::CopyFileAlways(inputFileName, outputFileName));
+  const ImageType::Pointer original = ReadImage(inputFileName);
+
+  itk::ScancoImageIO::HeaderPatch patch;
+  patch.ReplacePatientName = true;
+  patch.PatientName = "Doe";
+  patch.ReplacePatientIndex = true;
+  patch.PatientIndex = 42;
+  patch.ReplaceDate = true;
+  patch.Date = "3-mar-2021 04:05:06.007";
+  ITK_TRY_EXPECT_NO_EXCEPTION(itk::ScancoImageIO::PatchHeader(outputFileName, patch));
+
+  itk::ScancoImageIO::HeaderPointer header = itk::ScancoImageIO::ReadHeader(outputFileName);
+  ITK_TEST_EXPECT_EQUAL(std::string(header->PatientName), "Doe");
+  ITK_TEST_EXPECT_EQUAL(header->PatientIndex, 42);
+  ITK_TEST_EXPECT_EQUAL(std::string(header->CreationDate), "3-MAR-2021 04:05:06.007");
+  ITK_TEST_EXPECT_TRUE(SamePixels(original, ReadImage(outputFileName)));
+
+  // A name that is too long for the header of an AIM file makes the header
+  // be rebuilt in front of the data, which keeps the permissions of the file
+  mode_t mode = 0;
+  mode_t patchedMode = 0;
+  ITK_TEST_EXPECT_TRUE(itksys::SystemTools::SetPermissions(outputFileName, 0640));
+  ITK_TEST_EXPECT_TRUE(itksys::SystemTools::GetPermissions(outputFileName, mode));
+  patch.ReplaceDate = false;
+  patch.PatientName = "A Longer Patient Name Than The Original";
+  ITK_TRY_EXPECT_NO_EXCEPTION(itk::ScancoImageIO::PatchHeader(outputFileName, patch));
+  ITK_TEST_EXPECT_TRUE(itksys::SystemTools::GetPermissions(outputFileName, patchedMode));
+  ITK_TEST_EXPECT_EQUAL(patchedMode, mode);
+  header = itk::ScancoImageIO::ReadHeader(outputFileName);
+  ITK_TEST_EXPECT_EQUAL(std::string(header->PatientName), patch.PatientName);
+  ITK_TEST_EXPECT_EQUAL(std::string(header->CreationDate), "3-MAR-2021 04:05:06.007");
+  ITK_TEST_EXPECT_TRUE(SamePixels(original, ReadImage(outputFileName)));
+
+  patch.Anonymize();
+  ITK_TRY_EXPECT_NO_EXCEPTION(itk::ScancoImageIO::PatchHeader(outputFileName, patch));
+  header = itk::ScancoImageIO::ReadHeader(outputFileName);
+  ITK_TEST_EXPECT_EQUAL(std::string(header->PatientName), "");
+  ITK_TEST_EXPECT_EQUAL(header->PatientIndex, 0);
+  ITK_TEST_EXPECT_EQUAL(std::string(header->CreationDate), "1-JAN-2000 00:00:00.000");
+  ITK_TEST_EXPECT_TRUE(SamePixels(original, ReadImage(outputFileName)));
+
+  return EXIT_SUCCESS;
+}
+
+} // end anonymous namespace
+
+
+int
+itkScancoImageIOTest12(int argc, char * argv[])
+{
+  if (argc < 4)
+  {
+    std::cerr << "Missing parameters." << std::endl;
+    std::cerr << "Usage: " << std::endl;
+    std::cerr << itkNameOfTestExecutableMacro(argv) << " InputISQ InputAIM OutputPrefix" << std::endl;
+    return EXIT_FAILURE;
+  }
+  const std::string isqFileName = argv[1];
+  const std::string aimFileName = argv[2];
+  const std::string outputPrefix = argv[3];
+
+  ITK_TEST_EXPECT_EQUAL(PatchAndCompare(isqFileName, outputPrefix + ".isq"), EXIT_SUCCESS);
+  ITK_TEST_EXPECT_EQUAL(PatchAndCompare(aimFileName, outputPrefix + ".aim"), EXIT_SUCCESS);
+
+  // Invalid dates are rejected before the file is touched
+  itk::ScancoImageIO::HeaderPatch patch;
+  patch.ReplaceDate = true;
+  patch.Date = "30-FEB-2021";
+  ITK_TRY_EXPECT_EXCEPTION(itk::ScancoImageIO::PatchHeader(outputPrefix + ".isq", patch));
+  patch.Date = "1-FOO-2021 00:00:00.000";
+  ITK_TRY_EXPECT_EXCEPTION(itk::ScancoImageIO::PatchHeader(outputPrefix + ".isq", patch));
+
+  // Files that are not Scanco files are rejected
+  const std::string otherFileName = outputPrefix + ".txt";
+  {
+    std::ofstream file(otherFileName.c_str());
+    file << std::string(1024, 'x');
+  }
+  patch.Anonymize();
+  ITK_TRY_EXPECT_EXCEPTION(itk::ScancoImageIO::PatchHeader(otherFileName, patch));
+  ITK_TRY_EXPECT_EXCEPTION(itk::ScancoImageIO::PatchHeader(outputPrefix + ".missing", patch));
+
+
+  std::cout << "Test finished" << std::endl;
+  return EXIT_SUCCESS;
+}
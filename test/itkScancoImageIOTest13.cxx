@@ -0,0 +1,144 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         https://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <algorithm>
+#include <fstream>
+#include "itkImage.h"
+#include "itkImageFileReader.h"
+#include "itkMath.h"
+#include "itkScancoImageIO.h"
+#include "itkTestingMacros.h"
+
+
+#define SPECIFIC_IMAGEIO_MODULE_TEST
+
+namespace
+{
+
+using ImageType = itk::Image<float, 3>;
+
+ImageType::Pointer
+ReadImage(const std::string & fileName)
+{
+  using ReaderType = itk::ImageFileReader<ImageType>;
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetImageIO(itk::ScancoImageIO::New());
+  reader->SetFileName(fileName);
+  reader->Update();
+  return reader->GetOutput();
+}
+
+} // end anonymous namespace
+
+
+int
+itkScancoImageIOTest13(int argc, char * argv[])
+{
+  if (argc < 3)
+  {
+    std::cerr << "Missing parameters." << std::endl;
+    std::cerr << "Usage: " << std::endl;
+    std::cerr << itkNameOfTestExecutableMacro(argv) << " InputISQ OutputPrefix" << std::endl;
+    return EXIT_FAILURE;
+  }
+  const std::string inputFileName = argv[1];
+  const std::string outputPrefix = argv[2];
+  const std::string bottomFileName = outputPrefix + "Bottom.isq";
+  const std::string topFileName = outputPrefix + "Top.isq";
+  const std::string joinedFileName = outputPrefix + "Joined.isq";
+
+  const itk::ScancoImageIO::HeaderPointer header = itk::ScancoImageIO::ReadHeader(inputFileName);
+  const itk::SizeValueType                numberOfSlices = header->Dimensions[2];
+  const itk::SizeValueType                split = numberOfSlices / 2;
+  ITK_TEST_EXPECT_TRUE(split > 0);
+
+  // Split the file in two
+  ITK_TRY_EXPECT_NO_EXCEPTION(itk::ScancoImageIO::CopySlices({ { inputFileName, 0, split } }, bottomFileName));
+  ITK_TRY_EXPECT_NO_EXCEPTION(itk::ScancoImageIO::CopySlices({ { inputFileName, split, 0 } }, topFileName));
+
+  const itk::ScancoImageIO::HeaderPointer topHeader = itk::ScancoImageIO::ReadHeader(topFileName);
+  ITK_TEST_EXPECT_EQUAL(topHeader->Dimensions[0], header->Dimensions[0]);
+  ITK_TEST_EXPECT_EQUAL(topHeader->Dimensions[1], header->Dimensions[1]);
+  ITK_TEST_EXPECT_EQUAL(topHeader->Dimensions[2], numberOfSlices - split);
+  ITK_TEST_EXPECT_TRUE(itk::Math::FloatAlmostEqual(topHeader->Spacing[2], header->Spacing[2], 4, 1e-6));
+  ITK_TEST_EXPECT_TRUE(
+    itk::Math::FloatAlmostEqual(topHeader->StartPosition, header->StartPosition + split * header->Spacing[2], 4, 2e-3));
+  ITK_TEST_EXPECT_TRUE(itk::Math::FloatAlmostEqual(topHeader->RescaleSlope, header->RescaleSlope, 4, 1e-9));
+  ITK_TEST_EXPECT_EQUAL(std::string(topHeader->PatientName), std::string(header->PatientName));
+
+  // The slices of the top half are those of the input
+  const ImageType::Pointer input = ReadImage(inputFileName);
+  const ImageType::Pointer top = ReadImage(topFileName);
+  const itk::SizeValueType sliceSize = header->Dimensions[0] * header->Dimensions[1];
+  ITK_TEST_EXPECT_TRUE(std::equal(top->GetBufferPointer(),
+                                  top->GetBufferPointer() + (numberOfSlices - split) * sliceSize,
+                                  input->GetBufferPointer() + split * sliceSize));
+
+  // Joining the halves gives back the input
+  ITK_TRY_EXPECT_NO_EXCEPTION(
+    itk::ScancoImageIO::CopySlices({ { bottomFileName, 0, 0 }, { topFileName, 0, 0 } }, joinedFileName));
+  const itk::ScancoImageIO::HeaderPointer joinedHeader = itk::ScancoImageIO::ReadHeader(joinedFileName);
+  ITK_TEST_EXPECT_EQUAL(joinedHeader->Dimensions[2], numberOfSlices);
+  ITK_TEST_EXPECT_TRUE(itk::Math::FloatAlmostEqual(joinedHeader->StartPosition, header->StartPosition, 4, 1e-3));
+  ITK_TEST_EXPECT_TRUE(joinedHeader->DataRange[0] <= header->DataRange[0]);
+  ITK_TEST_EXPECT_TRUE(joinedHeader->DataRange[1] >= header->DataRange[1]);
+  const ImageType::Pointer joined = ReadImage(joinedFileName);
+  ITK_TEST_EXPECT_TRUE(joined->GetLargestPossibleRegion() == input->GetLargestPossibleRegion());
+  ITK_TEST_EXPECT_TRUE(std::equal(joined->GetBufferPointer(),
+                                  joined->GetBufferPointer() + numberOfSlices * sliceSize,
+                                  input->GetBufferPointer()));
+
+  // The output may be one of the inputs
+  ITK_TRY_EXPECT_NO_EXCEPTION(itk::ScancoImageIO::CopySlices({ { joinedFileName, split, 0 } }, joinedFileName));
+  ITK_TEST_EXPECT_EQUAL(itk::ScancoImageIO::ReadHeader(joinedFileName)->Dimensions[2], numberOfSlices - split);
+
+  // Slices that are not in the file
+  ITK_TRY_EXPECT_EXCEPTION(
+    itk::ScancoImageIO::CopySlices({ { inputFileName, numberOfSlices, 0 } }, outputPrefix + "Empty.isq"));
+  ITK_TRY_EXPECT_EXCEPTION(
+    itk::ScancoImageIO::CopySlices({ { inputFileName, split, numberOfSlices } }, outputPrefix + "Empty.isq"));
+  ITK_TRY_EXPECT_EXCEPTION(itk::ScancoImageIO::CopySlices({}, outputPrefix + "Empty.isq"));
+
+  // Files with other rows can not be joined
+  itk::ScancoImageIO::Pointer otherIO = itk::ScancoImageIO::New();
+  const std::string           otherFileName = outputPrefix + "Other.isq";
+  otherIO->SetFileName(otherFileName);
+  otherIO->SetNumberOfDimensions(3);
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    otherIO->SetDimensions(i, header->Dimensions[i] + 1);
+    otherIO->SetSpacing(i, header->Spacing[i]);
+  }
+  otherIO->SetComponentType(itk::IOComponentEnum::SHORT);
+  const std::vector<short> otherData(otherIO->GetImageSizeInPixels());
+  ITK_TRY_EXPECT_NO_EXCEPTION(otherIO->Write(otherData.data()));
+  ITK_TRY_EXPECT_EXCEPTION(
+    itk::ScancoImageIO::CopySlices({ { inputFileName, 0, 0 }, { otherFileName, 0, 0 } }, outputPrefix + "Mixed.isq"));
+
+  // Only ISQ files are supported
+  const std::string textFileName = outputPrefix + ".txt";
+  {
+    std::ofstream file(textFileName.c_str());
+    file << std::string(1024, 'x');
+  }
+  ITK_TRY_EXPECT_EXCEPTION(itk::ScancoImageIO::CopySlices({ { textFileName, 0, 0 } }, outputPrefix + "Text.isq"));
+
+
+  std::cout << "Test finished" << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,129 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         https://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <algorithm>
+#include <cstring>
+#include "itkScancoSeriesReader.h"
+#include "itkTestingMacros.h"
+
+
+#define SPECIFIC_IMAGEIO_MODULE_TEST
+
+namespace
+{
+
+// Read the series into a 4D image of the pixel type of the files, and check
+// that its buffer is the one that Read() gives
+template <typename TPixel>
+int
+CheckImage(itk::ScancoSeriesReader * reader, const std::vector<char> & expected)
+{
+  using ImageType = itk::Image<TPixel, 4>;
+  typename ImageType::Pointer image;
+  ITK_TRY_EXPECT_NO_EXCEPTION(image = reader->template ReadImage<TPixel>());
+  ITK_TEST_EXPECT_EQUAL(image->GetLargestPossibleRegion().GetSize(3), reader->GetDimensions(3));
+  ITK_TEST_EXPECT_EQUAL(image->GetSpacing()[3], reader->GetTimeSpacing());
+  ITK_TEST_EXPECT_EQUAL(image->GetSpacing()[0], reader->GetHeader(0)->Spacing[0]);
+  ITK_TEST_EXPECT_TRUE(std::memcmp(image->GetBufferPointer(), expected.data(), expected.size()) == 0);
+  return EXIT_SUCCESS;
+}
+
+} // end anonymous namespace
+
+
+int
+itkScancoImageIOTest14(int argc, char * argv[])
+{
+  if (argc < 4)
+  {
+    std::cerr << "Missing parameters." << std::endl;
+    std::cerr << "Usage: " << std::endl;
+    std::cerr << itkNameOfTestExecutableMacro(argv) << " InputISQ InputAIM OutputPrefix" << std::endl;
+    return EXIT_FAILURE;
+  }
+  const std::string isqFileName = argv[1];
+  const std::string aimFileName = argv[2];
+  const std::string outputPrefix = argv[3];
+
+  // Two timepoints of the same size, from the two halves of the input
+  const itk::SizeValueType numberOfSlices = itk::ScancoImageIO::ReadHeader(isqFileName)->Dimensions[2] / 2;
+  const std::string        firstFileName = outputPrefix + "1.isq";
+  const std::string        secondFileName = outputPrefix + "2.isq";
+  ITK_TRY_EXPECT_NO_EXCEPTION(itk::ScancoImageIO::CopySlices({ { isqFileName, 0, numberOfSlices } }, firstFileName));
+  ITK_TRY_EXPECT_NO_EXCEPTION(
+    itk::ScancoImageIO::CopySlices({ { isqFileName, numberOfSlices, numberOfSlices } }, secondFileName));
+  const std::vector<std::string> fileNames = { firstFileName, secondFileName, firstFileName };
+
+  itk::ScancoSeriesReader::Pointer reader = itk::ScancoSeriesReader::New();
+
+  ITK_EXERCISE_BASIC_OBJECT_METHODS(reader, ScancoSeriesReader, Object);
+
+  // File names are required
+  ITK_TRY_EXPECT_EXCEPTION(reader->ReadInformation());
+
+  reader->SetFileNames(fileNames);
+  ITK_TEST_EXPECT_TRUE(reader->GetFileNames() == fileNames);
+  ITK_TEST_SET_GET_VALUE(1.0, reader->GetTimeSpacing());
+  reader->SetTimeSpacing(7.0);
+  ITK_TEST_SET_GET_VALUE(7.0, reader->GetTimeSpacing());
+  reader->SetNumberOfWorkUnits(2);
+  ITK_TEST_SET_GET_VALUE(2, reader->GetNumberOfWorkUnits());
+
+  ITK_TRY_EXPECT_NO_EXCEPTION(reader->ReadInformation());
+  ITK_TEST_EXPECT_EQUAL(reader->GetDimensions(2), numberOfSlices);
+  ITK_TEST_EXPECT_EQUAL(reader->GetDimensions(3), fileNames.size());
+  ITK_TEST_EXPECT_TRUE(reader->GetHeader(fileNames.size()) == nullptr);
+
+  // Each timepoint is in its slot of the buffer
+  const itk::SizeValueType timepointSize = reader->GetTimepointSizeInBytes();
+  std::vector<char>        buffer(fileNames.size() * timepointSize);
+  ITK_TRY_EXPECT_NO_EXCEPTION(reader->Read(buffer.data()));
+  for (size_t t = 0; t < fileNames.size(); ++t)
+  {
+    itk::ScancoImageIO::Pointer imageIO = itk::ScancoImageIO::New();
+    imageIO->SetFileName(fileNames[t]);
+    ITK_TRY_EXPECT_NO_EXCEPTION(imageIO->ReadImageInformation());
+    ITK_TEST_EXPECT_EQUAL(imageIO->GetImageSizeInBytes(), timepointSize);
+    std::vector<char> timepoint(timepointSize);
+    ITK_TRY_EXPECT_NO_EXCEPTION(imageIO->Read(timepoint.data()));
+    ITK_TEST_EXPECT_TRUE(std::equal(timepoint.begin(), timepoint.end(), buffer.begin() + t * timepointSize));
+  }
+  ITK_TEST_EXPECT_TRUE(!std::equal(buffer.begin(), buffer.begin() + timepointSize, buffer.begin() + timepointSize));
+
+  // Images are read as the pixel type of the files only
+  if (reader->GetComponentType() == itk::IOComponentEnum::FLOAT)
+  {
+    ITK_TEST_EXPECT_EQUAL(CheckImage<float>(reader, buffer), EXIT_SUCCESS);
+  }
+  else
+  {
+    ITK_TEST_EXPECT_EQUAL(reader->GetComponentType(), itk::IOComponentEnum::SHORT);
+    ITK_TEST_EXPECT_EQUAL(CheckImage<short>(reader, buffer), EXIT_SUCCESS);
+  }
+  ITK_TRY_EXPECT_EXCEPTION(reader->ReadImage<double>());
+
+  // Files of other sizes can not be in the same series
+  reader->AddFileName(aimFileName);
+  ITK_TRY_EXPECT_EXCEPTION(reader->ReadInformation());
+  reader->SetFileNames({ firstFileName, outputPrefix + ".missing" });
+  ITK_TRY_EXPECT_EXCEPTION(reader->ReadInformation());
+
+
+  std::cout << "Test finished" << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,192 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         https://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <vector>
+#include "itkMath.h"
+#include "itkScancoCompositeReader.h"
+#include "itkTestingMacros.h"
+
+
+#define SPECIFIC_IMAGEIO_MODULE_TEST
+
+namespace
+{
+
+// Write an ISQ file of a single value
+void
+WriteStack(const std::string & fileName, itk::SizeValueType xsize, itk::SizeValueType ysize, itk::SizeValueType zsize,
+           short value, double spacing = 0.5)
+{
+  itk::ScancoImageIO::Pointer imageIO = itk::ScancoImageIO::New();
+  imageIO->SetFileName(fileName);
+  imageIO->SetNumberOfDimensions(3);
+  imageIO->SetDimensions(0, xsize);
+  imageIO->SetDimensions(1, ysize);
+  imageIO->SetDimensions(2, zsize);
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    imageIO->SetSpacing(i, spacing);
+  }
+  imageIO->SetComponentType(itk::IOComponentEnum::SHORT);
+  const std::vector<short> data(xsize * ysize * zsize, value);
+  imageIO->Write(data.data());
+}
+
+
+std::vector<char>
+ReadFile(const std::string & fileName)
+{
+  itk::ScancoImageIO::Pointer imageIO = itk::ScancoImageIO::New();
+  imageIO->SetFileName(fileName);
+  imageIO->ReadImageInformation();
+  std::vector<char> buffer(imageIO->GetImageSizeInBytes());
+  imageIO->Read(buffer.data());
+  return buffer;
+}
+
+} // end anonymous namespace
+
+
+int
+itkScancoImageIOTest15(int argc, char * argv[])
+{
+  if (argc < 4)
+  {
+    std::cerr << "Missing parameters." << std::endl;
+    std::cerr << "Usage: " << std::endl;
+    std::cerr << itkNameOfTestExecutableMacro(argv) << " InputISQ InputAIM OutputPrefix" << std::endl;
+    return EXIT_FAILURE;
+  }
+  const std::string isqFileName = argv[1];
+  const std::string aimFileName = argv[2];
+  const std::string outputPrefix = argv[3];
+
+  itk::ScancoCompositeReader::Pointer reader = itk::ScancoCompositeReader::New();
+
+  ITK_EXERCISE_BASIC_OBJECT_METHODS(reader, ScancoCompositeReader, Object);
+
+  // File names are required
+  ITK_TRY_EXPECT_EXCEPTION(reader->ReadInformation());
+
+  // The stacks of a split scan are put together by their start positions,
+  // in any order
+  const itk::ScancoImageIO::HeaderPointer header = itk::ScancoImageIO::ReadHeader(isqFileName);
+  const itk::SizeValueType                split = header->Dimensions[2] / 2;
+  const std::string                       bottomFileName = outputPrefix + "Bottom.isq";
+  const std::string                       topFileName = outputPrefix + "Top.isq";
+  ITK_TRY_EXPECT_NO_EXCEPTION(itk::ScancoImageIO::CopySlices({ { isqFileName, 0, split } }, bottomFileName));
+  ITK_TRY_EXPECT_NO_EXCEPTION(itk::ScancoImageIO::CopySlices({ { isqFileName, split, 0 } }, topFileName));
+  reader->SetFileNames({ topFileName, bottomFileName });
+  ITK_TEST_EXPECT_TRUE(reader->GetFileNames().size() == 2);
+  reader->SetNumberOfWorkUnits(2);
+  ITK_TEST_SET_GET_VALUE(2, reader->GetNumberOfWorkUnits());
+  ITK_TRY_EXPECT_NO_EXCEPTION(reader->ReadInformation());
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    ITK_TEST_EXPECT_EQUAL(reader->GetDimensions(i), header->Dimensions[i]);
+  }
+  ITK_TEST_EXPECT_EQUAL(reader->GetFileIndex(0)[2], static_cast<itk::IndexValueType>(split));
+  ITK_TEST_EXPECT_EQUAL(reader->GetFileIndex(1)[2], 0);
+  ITK_TEST_EXPECT_TRUE(itk::Math::FloatAlmostEqual(reader->GetOrigin(2), header->StartPosition, 4, 1e-3));
+  std::vector<char> buffer(reader->GetImageSizeInBytes());
+  ITK_TRY_EXPECT_NO_EXCEPTION(reader->Read(buffer.data()));
+  ITK_TEST_EXPECT_TRUE(buffer == ReadFile(isqFileName));
+
+  // A cropped AIM file keeps its origin
+  const itk::ScancoImageIO::HeaderPointer aimHeader = itk::ScancoImageIO::ReadHeader(aimFileName);
+  reader->SetFileNames({ aimFileName });
+  ITK_TRY_EXPECT_NO_EXCEPTION(reader->ReadInformation());
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    ITK_TEST_EXPECT_EQUAL(reader->GetDimensions(i), aimHeader->Dimensions[i]);
+    ITK_TEST_EXPECT_TRUE(itk::Math::FloatAlmostEqual(reader->GetOrigin(i), aimHeader->Origin[i], 4, 1e-4));
+  }
+  buffer.resize(reader->GetImageSizeInBytes());
+  ITK_TRY_EXPECT_NO_EXCEPTION(reader->Read(buffer.data()));
+  ITK_TEST_EXPECT_TRUE(buffer == ReadFile(aimFileName));
+
+  // Stacks of different sizes, with a gap and an overlap, placed by
+  // cutting them from the slices of taller stacks
+  const std::string firstFileName = outputPrefix + "1.isq";
+  const std::string secondFileName = outputPrefix + "2.isq";
+  const std::string thirdFileName = outputPrefix + "3.isq";
+  const std::string tallFileName = outputPrefix + "Tall.isq";
+  ITK_TRY_EXPECT_NO_EXCEPTION(WriteStack(firstFileName, 4, 3, 4, 1));
+  ITK_TRY_EXPECT_NO_EXCEPTION(WriteStack(tallFileName, 6, 5, 6, 2));
+  ITK_TRY_EXPECT_NO_EXCEPTION(itk::ScancoImageIO::CopySlices({ { tallFileName, 2, 4 } }, secondFileName));
+  ITK_TRY_EXPECT_NO_EXCEPTION(WriteStack(tallFileName, 4, 3, 12, 3));
+  ITK_TRY_EXPECT_NO_EXCEPTION(itk::ScancoImageIO::CopySlices({ { tallFileName, 10, 2 } }, thirdFileName));
+  reader->SetFileNames({ firstFileName, secondFileName });
+  reader->AddFileName(thirdFileName);
+  using ImageType = itk::Image<short, 3>;
+  ImageType::Pointer image;
+  ITK_TRY_EXPECT_NO_EXCEPTION(image = reader->ReadImage<short>());
+  ITK_TEST_EXPECT_EQUAL(image->GetLargestPossibleRegion().GetSize(0), 6);
+  ITK_TEST_EXPECT_EQUAL(image->GetLargestPossibleRegion().GetSize(1), 5);
+  ITK_TEST_EXPECT_EQUAL(image->GetLargestPossibleRegion().GetSize(2), 12);
+  ITK_TEST_EXPECT_EQUAL(image->GetSpacing()[2], 0.5);
+
+  // The expected value of each voxel, where the later file wins
+  auto expectedValue = [](itk::SizeValueType x, itk::SizeValueType y, itk::SizeValueType z, bool firstWins) -> short {
+    const bool inFirst = (x < 4 && y < 3 && z < 4);
+    const bool inSecond = (z >= 2 && z < 6);
+    const bool inThird = (x < 4 && y < 3 && z >= 10);
+    if (inFirst && (firstWins || !inSecond))
+    {
+      return 1;
+    }
+    return (inSecond ? 2 : (inThird ? 3 : 0));
+  };
+  bool matches = true;
+  for (itk::SizeValueType z = 0; z < 12; ++z)
+  {
+    for (itk::SizeValueType y = 0; y < 5; ++y)
+    {
+      for (itk::SizeValueType x = 0; x < 6; ++x)
+      {
+        matches = matches && image->GetBufferPointer()[(z * 5 + y) * 6 + x] == expectedValue(x, y, z, false);
+      }
+    }
+  }
+  ITK_TEST_EXPECT_TRUE(matches);
+
+  reader->SetFileNames({ thirdFileName, secondFileName, firstFileName });
+  ITK_TRY_EXPECT_NO_EXCEPTION(image = reader->ReadImage<short>());
+  for (itk::SizeValueType z = 0; z < 12; ++z)
+  {
+    for (itk::SizeValueType y = 0; y < 5; ++y)
+    {
+      for (itk::SizeValueType x = 0; x < 6; ++x)
+      {
+        matches = matches && image->GetBufferPointer()[(z * 5 + y) * 6 + x] == expectedValue(x, y, z, true);
+      }
+    }
+  }
+  ITK_TEST_EXPECT_TRUE(matches);
+  ITK_TRY_EXPECT_EXCEPTION(reader->ReadImage<float>());
+
+  // Files of another spacing can not be combined
+  const std::string fineFileName = outputPrefix + "Fine.isq";
+  ITK_TRY_EXPECT_NO_EXCEPTION(WriteStack(fineFileName, 4, 3, 2, 4, 0.25));
+  reader->AddFileName(fineFileName);
+  ITK_TRY_EXPECT_EXCEPTION(reader->ReadInformation());
+
+
+  std::cout << "Test finished" << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,262 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         https://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <algorithm>
+#include <fstream>
+#include <vector>
+#include "itkLabelMap.h"
+#include "itkLabelObject.h"
+#include "itkMath.h"
+#include "itkScancoLabelMapReader.h"
+#include "itkScancoTestHelpers.h"
+#include "itkScancoValueCounter.h"
+#include "itkTestingMacros.h"
+
+
+#define SPECIFIC_IMAGEIO_MODULE_TEST
+
+namespace
+{
+
+constexpr itk::SizeValueType dimensions[3] = { 30, 10, 4 };
+
+constexpr int64_t position[3] = { 0, 0, 0 };
+// 20 micrometers, in units of 1e-6 mm
+constexpr int64_t elementSize = 20000;
+
+using itk::ScancoTestHelpers::AppendInt64;
+using itk::ScancoTestHelpers::EncodeRunLengths;
+using itk::ScancoTestHelpers::WriteAIM;
+
+
+// Binary run-lengths, alternating between 0 and value after the 64-bit
+// size and the two values, where 255 continues a run
+std::vector<char>
+EncodeBinaryRunLengths(const std::vector<unsigned char> & voxels, unsigned char value)
+{
+  std::vector<char> data(8);
+  data.push_back(0);
+  data.push_back(static_cast<char>(value));
+  unsigned char current = 0;
+  for (size_t i = 0; i < voxels.size();)
+  {
+    size_t length = 0;
+    while (i + length < voxels.size() && (voxels[i + length] != 0) == (current != 0))
+    {
+      ++length;
+    }
+    i += length;
+    for (; length > 254; length -= 254)
+    {
+      data.push_back(static_cast<char>(255));
+    }
+    data.push_back(static_cast<char>(length));
+    current = (current == 0 ? value : 0);
+  }
+  std::vector<char> sizeWord;
+  AppendInt64(sizeWord, static_cast<int64_t>(data.size()));
+  std::copy(sizeWord.begin(), sizeWord.end(), data.begin());
+  return data;
+}
+
+
+// Compare the label map, the runs and the value counts of a file with its
+// dense voxels
+bool
+MatchesDenseRead(const std::string & fileName)
+{
+  itk::ScancoImageIO::Pointer imageIO = itk::ScancoImageIO::New();
+  imageIO->SetFileName(fileName);
+  imageIO->ReadImageInformation();
+  std::vector<unsigned char> voxels(imageIO->GetImageSizeInBytes());
+  imageIO->Read(voxels.data());
+
+  using LabelObjectType = itk::LabelObject<unsigned char, 3>;
+  using LabelMapType = itk::LabelMap<LabelObjectType>;
+  itk::ScancoLabelMapReader::Pointer reader = itk::ScancoLabelMapReader::New();
+  reader->SetFileName(fileName);
+  LabelMapType::Pointer labelMap = reader->ReadLabelMap<LabelMapType>();
+
+  bool                   matches = true;
+  LabelMapType::IndexType index;
+  for (itk::SizeValueType z = 0; z < dimensions[2]; ++z)
+  {
+    for (itk::SizeValueType y = 0; y < dimensions[1]; ++y)
+    {
+      for (itk::SizeValueType x = 0; x < dimensions[0]; ++x)
+      {
+        index[0] = x;
+        index[1] = y;
+        index[2] = z;
+        matches = matches && labelMap->GetPixel(index) == voxels[(z * dimensions[1] + y) * dimensions[0] + x];
+      }
+    }
+  }
+
+  // Runs stay within their rows and cover every non-zero voxel once
+  itk::SizeValueType numberOfVoxels = 0;
+  reader->ReadRuns([&](itk::SizeValueType x,
+                       itk::SizeValueType y,
+                       itk::SizeValueType z,
+                       itk::SizeValueType length,
+                       int                value) {
+    const unsigned char * row = voxels.data() + (z * dimensions[1] + y) * dimensions[0];
+    matches = matches && length > 0 && x + length <= dimensions[0];
+    for (itk::SizeValueType i = x; matches && i < x + length; ++i)
+    {
+      matches = static_cast<unsigned char>(value) == row[i];
+    }
+    numberOfVoxels += length;
+  });
+  for (const unsigned char voxel : voxels)
+  {
+    numberOfVoxels -= (voxel != 0);
+  }
+
+  // Counts of each value, per slice and in total
+  itk::ScancoValueCounter::Pointer counter = itk::ScancoValueCounter::New();
+  counter->SetFileName(fileName);
+  counter->Compute();
+  std::vector<itk::SizeValueType> sliceHistograms(dimensions[2] * 256, 0);
+  for (size_t i = 0; i < voxels.size(); ++i)
+  {
+    ++sliceHistograms[i / (dimensions[0] * dimensions[1]) * 256 + voxels[i]];
+  }
+  matches =
+    matches && counter->GetNumberOfVoxels() == voxels.size() && counter->GetSliceHistograms() == sliceHistograms;
+  for (unsigned int value = 0; value < 256; ++value)
+  {
+    itk::SizeValueType count = 0;
+    for (itk::SizeValueType z = 0; z < dimensions[2]; ++z)
+    {
+      count += counter->GetSliceCount(z, static_cast<unsigned char>(value));
+    }
+    matches = matches && counter->GetHistogram()[value] == count;
+  }
+  return matches && numberOfVoxels == 0;
+}
+
+} // end anonymous namespace
+
+
+int
+itkScancoImageIOTest16(int argc, char * argv[])
+{
+  if (argc < 3)
+  {
+    std::cerr << "Missing parameters." << std::endl;
+    std::cerr << "Usage: " << std::endl;
+    std::cerr << itkNameOfTestExecutableMacro(argv) << " InputAIM OutputPrefix" << std::endl;
+    return EXIT_FAILURE;
+  }
+  const std::string aimFileName = argv[1];
+  const std::string outputPrefix = argv[2];
+
+  itk::ScancoLabelMapReader::Pointer reader = itk::ScancoLabelMapReader::New();
+
+  ITK_EXERCISE_BASIC_OBJECT_METHODS(reader, ScancoLabelMapReader, Object);
+
+  // A file name is required
+  ITK_TRY_EXPECT_EXCEPTION(reader->ReadInformation());
+
+  // Labels in blocks, with runs that cross the ends of rows and a last
+  // slice that is one long run
+  std::vector<unsigned char> labels(dimensions[0] * dimensions[1] * dimensions[2]);
+  for (itk::SizeValueType z = 0; z < dimensions[2]; ++z)
+  {
+    for (itk::SizeValueType y = 0; y < dimensions[1]; ++y)
+    {
+      for (itk::SizeValueType x = 0; x < dimensions[0]; ++x)
+      {
+        const itk::SizeValueType block = x / 7 + y / 3 + z;
+        labels[(z * dimensions[1] + y) * dimensions[0] + x] =
+          static_cast<unsigned char>(z == 3 ? 200 : (block % 3 == 0 ? 0 : block % 4 + 1));
+      }
+    }
+  }
+  std::vector<unsigned char> mask(labels.size());
+  for (size_t i = 0; i < labels.size(); ++i)
+  {
+    mask[i] = (labels[i] != 0 ? 127 : 0);
+  }
+
+  // Uncompressed labels
+  const std::string labelFileName = outputPrefix + "Labels.aim";
+  ITK_TEST_EXPECT_TRUE(WriteAIM(
+    labelFileName, 0x00160001, dimensions, position, elementSize, std::vector<char>(labels.begin(), labels.end())));
+  ITK_TEST_EXPECT_TRUE(MatchesDenseRead(labelFileName));
+
+  // 8-bit run-lengths, read as signed char
+  const std::string runLengthFileName = outputPrefix + "RunLengths.aim";
+  ITK_TEST_EXPECT_TRUE(
+    WriteAIM(runLengthFileName, 0x00080002, dimensions, position, elementSize, EncodeRunLengths(labels)));
+  ITK_TEST_EXPECT_TRUE(MatchesDenseRead(runLengthFileName));
+
+  // Run-lengths that end early, the rest of the image is zero
+  const std::string shortFileName = outputPrefix + "ShortRunLengths.aim";
+  ITK_TEST_EXPECT_TRUE(WriteAIM(
+    shortFileName,
+    0x00080002,
+    dimensions,
+    position,
+    elementSize,
+    EncodeRunLengths(std::vector<unsigned char>(labels.begin(), labels.begin() + labels.size() / 2 + 5))));
+  ITK_TEST_EXPECT_TRUE(MatchesDenseRead(shortFileName));
+
+  // Binary run-lengths
+  const std::string binaryFileName = outputPrefix + "Binary.aim";
+  ITK_TEST_EXPECT_TRUE(
+    WriteAIM(binaryFileName, 0x00150001, dimensions, position, elementSize, EncodeBinaryRunLengths(mask, 127)));
+  ITK_TEST_EXPECT_TRUE(MatchesDenseRead(binaryFileName));
+
+  using LabelMapType = itk::LabelMap<itk::LabelObject<unsigned char, 3>>;
+  reader->SetFileName(binaryFileName);
+  ITK_TEST_SET_GET_VALUE(binaryFileName, std::string(reader->GetFileName()));
+  ITK_TRY_EXPECT_NO_EXCEPTION(reader->ReadInformation());
+  ITK_TEST_EXPECT_TRUE(reader->GetHeader() != nullptr);
+  LabelMapType::Pointer labelMap;
+  ITK_TRY_EXPECT_NO_EXCEPTION(labelMap = reader->ReadLabelMap<LabelMapType>());
+  ITK_TEST_EXPECT_EQUAL(labelMap->GetNumberOfLabelObjects(), 1);
+  itk::SizeValueType numberOfVoxels = 0;
+  for (const unsigned char voxel : mask)
+  {
+    numberOfVoxels += (voxel != 0);
+  }
+  ITK_TEST_EXPECT_EQUAL(labelMap->GetLabelObject(127)->Size(), numberOfVoxels);
+  itk::ScancoValueCounter::Pointer counter = itk::ScancoValueCounter::New();
+  ITK_EXERCISE_BASIC_OBJECT_METHODS(counter, ScancoValueCounter, Object);
+  ITK_TRY_EXPECT_EXCEPTION(counter->Compute());
+  counter->SetFileName(binaryFileName);
+  ITK_TEST_SET_GET_VALUE(binaryFileName, std::string(counter->GetFileName()));
+  ITK_TRY_EXPECT_NO_EXCEPTION(counter->Compute());
+  ITK_TEST_EXPECT_EQUAL(counter->GetNumberOfVoxels(), mask.size());
+  ITK_TEST_EXPECT_TRUE(itk::Math::FloatAlmostEqual(
+    counter->GetNonZeroFraction(), static_cast<double>(numberOfVoxels) / mask.size(), 4, 1e-9));
+  ITK_TEST_EXPECT_EQUAL(labelMap->GetLargestPossibleRegion().GetSize(0), dimensions[0]);
+  ITK_TEST_EXPECT_TRUE(itk::Math::FloatAlmostEqual(labelMap->GetSpacing()[0], 0.02, 4, 1e-6));
+
+  // Only 8-bit files hold labels
+  reader->SetFileName(aimFileName);
+  ITK_TRY_EXPECT_EXCEPTION(reader->ReadLabelMap<LabelMapType>());
+  counter->SetFileName(aimFileName);
+  ITK_TRY_EXPECT_EXCEPTION(counter->Compute());
+
+
+  std::cout << "Test finished" << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,236 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         https://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <map>
+#include <vector>
+#include "itkByteSwapper.h"
+#include "itkMath.h"
+#include "itkScancoDensityStatisticsCalculator.h"
+#include "itkScancoTestHelpers.h"
+#include "itkTestingMacros.h"
+
+
+#define SPECIFIC_IMAGEIO_MODULE_TEST
+
+using itk::ScancoTestHelpers::EncodePackedBits;
+using itk::ScancoTestHelpers::EncodeRunLengths;
+using itk::ScancoTestHelpers::WriteAIM;
+
+// The AIM data types of 8-bit run-lengths and of packed bits
+constexpr int runLengthDataType = 0x00080002;
+constexpr int packedBitsDataType = 0x00060001;
+
+
+int
+itkScancoImageIOTest17(int argc, char * argv[])
+{
+  if (argc < 3)
+  {
+    std::cerr << "Missing parameters." << std::endl;
+    std::cerr << "Usage: " << std::endl;
+    std::cerr << itkNameOfTestExecutableMacro(argv) << " InputISQ OutputPrefix" << std::endl;
+    return EXIT_FAILURE;
+  }
+  const std::string isqFileName = argv[1];
+  const std::string outputPrefix = argv[2];
+
+  using CalculatorType = itk::ScancoDensityStatisticsCalculator;
+  CalculatorType::Pointer calculator = CalculatorType::New();
+
+  ITK_EXERCISE_BASIC_OBJECT_METHODS(calculator, ScancoDensityStatisticsCalculator, Object);
+
+  // Both files are required
+  ITK_TRY_EXPECT_EXCEPTION(calculator->Compute());
+
+  // The stored values of the gray scale file
+  const itk::ScancoImageIO::HeaderPointer header = itk::ScancoImageIO::ReadHeader(isqFileName);
+  const itk::SizeValueType                xsize = header->Dimensions[0];
+  const itk::SizeValueType                ysize = header->Dimensions[1];
+  const itk::SizeValueType                zsize = header->Dimensions[2];
+  std::vector<short>                      gray(xsize * ysize * zsize);
+  {
+    std::ifstream file(isqFileName.c_str(), std::ios::in | std::ios::binary);
+    file.seekg(header->HeaderSize);
+    file.read(reinterpret_cast<char *>(gray.data()), gray.size() * sizeof(short));
+    ITK_TEST_EXPECT_TRUE(file.good());
+  }
+  itk::ByteSwapper<short>::SwapRangeFromSystemToLittleEndian(gray.data(), gray.size());
+
+  // A mask of half the size, in the middle of y and z, that runs past the
+  // end of the rows
+  const itk::SizeValueType maskDimensions[3] = { std::max<itk::SizeValueType>(1, xsize / 2),
+                                                 std::max<itk::SizeValueType>(1, ysize / 2),
+                                                 std::max<itk::SizeValueType>(1, zsize / 2) };
+  const int64_t            maskPosition[3] = { static_cast<int64_t>(xsize - maskDimensions[0] / 2),
+                                               static_cast<int64_t>(ysize / 4),
+                                               static_cast<int64_t>(zsize / 4) };
+  std::vector<unsigned char> mask(maskDimensions[0] * maskDimensions[1] * maskDimensions[2]);
+  for (itk::SizeValueType z = 0; z < maskDimensions[2]; ++z)
+  {
+    for (itk::SizeValueType y = 0; y < maskDimensions[1]; ++y)
+    {
+      for (itk::SizeValueType x = 0; x < maskDimensions[0]; ++x)
+      {
+        const itk::SizeValueType label = (x / 3 + y / 2 + z) % 4;
+        mask[(z * maskDimensions[1] + y) * maskDimensions[0] + x] =
+          static_cast<unsigned char>(label == 3 ? 200 : label);
+      }
+    }
+  }
+  const int64_t     elementSize = itk::Math::Round<int64_t>(header->Spacing[0] * 1e6);
+  const std::string maskFileName = outputPrefix + "Mask.aim";
+  ITK_TEST_EXPECT_TRUE(
+    WriteAIM(maskFileName, runLengthDataType, maskDimensions, maskPosition, elementSize, EncodeRunLengths(mask)));
+
+  // The expected statistics, where the mask is read as signed char
+  double slope = header->DensitySlope / (header->MuScaling > 1.0 ? header->MuScaling : 1.0);
+  double intercept = header->DensityIntercept;
+  constexpr itk::SizeValueType numberOfBins = 64;
+  const double                 histogramMinimum = slope * -2000 + intercept;
+  const double                 histogramMaximum = slope * 12000 + intercept;
+  auto                         expectedStatistics = [&]() {
+    std::map<int, CalculatorType::LabelStatistics> statistics;
+    std::map<int, double>                          sumsOfSquares;
+    const double binWidth = (histogramMaximum - histogramMinimum) / numberOfBins;
+    for (itk::SizeValueType z = 0; z < zsize; ++z)
+    {
+      for (itk::SizeValueType y = 0; y < ysize; ++y)
+      {
+        for (itk::SizeValueType x = 0; x < xsize; ++x)
+        {
+          const int64_t index[3] = { static_cast<int64_t>(x) - maskPosition[0],
+                                     static_cast<int64_t>(y) - maskPosition[1],
+                                     static_cast<int64_t>(z) - maskPosition[2] };
+          int           label = 0;
+          if (index[0] >= 0 && index[0] < static_cast<int64_t>(maskDimensions[0]) && index[1] >= 0 &&
+              index[1] < static_cast<int64_t>(maskDimensions[1]) && index[2] >= 0 &&
+              index[2] < static_cast<int64_t>(maskDimensions[2]))
+          {
+            label = static_cast<signed char>(
+              mask[(index[2] * maskDimensions[1] + index[1]) * maskDimensions[0] + index[0]]);
+          }
+          const short                       value = gray[(z * ysize + y) * xsize + x];
+          const double                      density = slope * value + intercept;
+          CalculatorType::LabelStatistics & labelStatistics = statistics[label];
+          if (labelStatistics.Count++ == 0)
+          {
+            labelStatistics.Histogram.assign(numberOfBins, 0);
+            labelStatistics.Minimum = density;
+            labelStatistics.Maximum = density;
+          }
+          labelStatistics.Mean += density;
+          sumsOfSquares[label] += density * density;
+          labelStatistics.Minimum = std::min(labelStatistics.Minimum, density);
+          labelStatistics.Maximum = std::max(labelStatistics.Maximum, density);
+          const double bin = std::floor((slope * value + intercept - histogramMinimum) / binWidth);
+          ++labelStatistics.Histogram[bin < 0.0 ? 0
+                                                : (bin >= numberOfBins ? numberOfBins - 1
+                                                                       : static_cast<itk::SizeValueType>(bin))];
+        }
+      }
+    }
+    for (auto & labelStatistics : statistics)
+    {
+      CalculatorType::LabelStatistics & s = labelStatistics.second;
+      s.Variance = (sumsOfSquares[labelStatistics.first] - s.Mean * s.Mean / s.Count) / (s.Count - 1);
+      s.Mean /= s.Count;
+    }
+    return statistics;
+  };
+  auto matchesExpected = [&]() {
+    const std::map<int, CalculatorType::LabelStatistics> expected = expectedStatistics();
+    bool matches = (calculator->GetStatistics().size() == expected.size());
+    for (const auto & labelStatistics : expected)
+    {
+      const CalculatorType::LabelStatistics & e = labelStatistics.second;
+      const CalculatorType::LabelStatistics & s = calculator->GetStatistics(labelStatistics.first);
+      const double                            scale = std::max(1.0, std::abs(e.Mean));
+      matches = matches && s.Count == e.Count && s.Histogram == e.Histogram;
+      matches = matches && std::abs(s.Mean - e.Mean) < 1e-9 * scale;
+      matches = matches && std::abs(s.Variance - e.Variance) < 1e-6 * std::max(1.0, e.Variance);
+      matches = matches && std::abs(s.Minimum - e.Minimum) < 1e-9 * scale;
+      matches = matches && std::abs(s.Maximum - e.Maximum) < 1e-9 * scale;
+    }
+    return matches;
+  };
+
+  calculator->SetFileName(isqFileName);
+  ITK_TEST_SET_GET_VALUE(isqFileName, std::string(calculator->GetFileName()));
+  calculator->SetMaskFileName(maskFileName);
+  ITK_TEST_SET_GET_VALUE(maskFileName, std::string(calculator->GetMaskFileName()));
+  ITK_TEST_SET_GET_BOOLEAN(calculator, UseCalibration, true);
+  calculator->SetNumberOfHistogramBins(numberOfBins);
+  ITK_TEST_SET_GET_VALUE(numberOfBins, calculator->GetNumberOfHistogramBins());
+  calculator->SetHistogramMinimum(histogramMinimum);
+  ITK_TEST_SET_GET_VALUE(histogramMinimum, calculator->GetHistogramMinimum());
+  calculator->SetHistogramMaximum(histogramMaximum);
+  ITK_TEST_SET_GET_VALUE(histogramMaximum, calculator->GetHistogramMaximum());
+  calculator->SetNumberOfSlicesPerSlab(3);
+  ITK_TEST_SET_GET_VALUE(3, calculator->GetNumberOfSlicesPerSlab());
+  calculator->SetNumberOfWorkUnits(3);
+  ITK_TEST_SET_GET_VALUE(3, calculator->GetNumberOfWorkUnits());
+  ITK_TRY_EXPECT_NO_EXCEPTION(calculator->Compute());
+  ITK_TEST_EXPECT_TRUE(itk::Math::FloatAlmostEqual(calculator->GetDensitySlope(), slope, 4, 1e-12));
+  ITK_TEST_EXPECT_TRUE(itk::Math::FloatAlmostEqual(calculator->GetDensityIntercept(), intercept, 4, 1e-12));
+  ITK_TEST_EXPECT_TRUE(calculator->HasLabel(-56));
+  ITK_TEST_EXPECT_TRUE(!calculator->HasLabel(200));
+  ITK_TEST_EXPECT_TRUE(matchesExpected());
+  ITK_TRY_EXPECT_EXCEPTION(calculator->GetStatistics(5));
+
+  // Statistics of the stored values, in one slab
+  slope = 1.0;
+  intercept = 0.0;
+  calculator->UseCalibrationOff();
+  calculator->SetNumberOfSlicesPerSlab(zsize);
+  ITK_TRY_EXPECT_NO_EXCEPTION(calculator->Compute());
+  ITK_TEST_EXPECT_TRUE(matchesExpected());
+
+  // A packed-bit mask, which is decoded one slice at a time
+  for (unsigned char & label : mask)
+  {
+    label = (label == 1 ? 100 : 0);
+  }
+  const std::string packedMaskFileName = outputPrefix + "PackedMask.aim";
+  ITK_TEST_EXPECT_TRUE(WriteAIM(packedMaskFileName,
+                                packedBitsDataType,
+                                maskDimensions,
+                                maskPosition,
+                                elementSize,
+                                EncodePackedBits(mask, maskDimensions, 100)));
+  calculator->SetMaskFileName(packedMaskFileName);
+  calculator->SetNumberOfSlicesPerSlab(2);
+  ITK_TRY_EXPECT_NO_EXCEPTION(calculator->Compute());
+  ITK_TEST_EXPECT_TRUE(calculator->HasLabel(100));
+  ITK_TEST_EXPECT_TRUE(matchesExpected());
+
+  // Masks must be 8-bit and have the same spacing
+  calculator->SetMaskFileName(isqFileName);
+  ITK_TRY_EXPECT_EXCEPTION(calculator->Compute());
+  const std::string coarseMaskFileName = outputPrefix + "CoarseMask.aim";
+  ITK_TEST_EXPECT_TRUE(WriteAIM(
+    coarseMaskFileName, runLengthDataType, maskDimensions, maskPosition, 2 * elementSize, EncodeRunLengths(mask)));
+  calculator->SetMaskFileName(coarseMaskFileName);
+  ITK_TRY_EXPECT_EXCEPTION(calculator->Compute());
+
+
+  std::cout << "Test finished" << std::endl;
+  return EXIT_SUCCESS;
+}
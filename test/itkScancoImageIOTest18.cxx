@@ -0,0 +1,189 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         https://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <algorithm>
+#include <fstream>
+#include <vector>
+#include "itkByteSwapper.h"
+#include "itkImage.h"
+#include "itkImageFileReader.h"
+#include "itkScancoImageIO.h"
+#include "itkScancoTestHelpers.h"
+#include "itkTestingMacros.h"
+
+
+#define SPECIFIC_IMAGEIO_MODULE_TEST
+
+using itk::ScancoTestHelpers::EncodeRunLengths;
+using itk::ScancoTestHelpers::WriteAIM;
+
+// The AIM data type of 8-bit run-lengths
+constexpr int runLengthDataType = 0x00080002;
+
+
+int
+itkScancoImageIOTest18(int argc, char * argv[])
+{
+  if (argc < 3)
+  {
+    std::cerr << "Missing parameters." << std::endl;
+    std::cerr << "Usage: " << std::endl;
+    std::cerr << itkNameOfTestExecutableMacro(argv) << " InputISQ OutputPrefix" << std::endl;
+    return EXIT_FAILURE;
+  }
+  const std::string isqFileName = argv[1];
+  const std::string outputPrefix = argv[2];
+
+  itk::ScancoImageIO::Pointer io = itk::ScancoImageIO::New();
+  ITK_TEST_SET_GET_BOOLEAN(io, ThresholdOnRead, false);
+
+  // The stored values of the gray scale file
+  const itk::ScancoImageIO::HeaderPointer header = itk::ScancoImageIO::ReadHeader(isqFileName);
+  const itk::SizeValueType                xsize = header->Dimensions[0];
+  const itk::SizeValueType                ysize = header->Dimensions[1];
+  const itk::SizeValueType                zsize = header->Dimensions[2];
+  std::vector<short>                      gray(xsize * ysize * zsize);
+  {
+    std::ifstream file(isqFileName.c_str(), std::ios::in | std::ios::binary);
+    file.seekg(header->HeaderSize);
+    file.read(reinterpret_cast<char *>(gray.data()), gray.size() * sizeof(short));
+    ITK_TEST_EXPECT_TRUE(file.good());
+  }
+  itk::ByteSwapper<short>::SwapRangeFromSystemToLittleEndian(gray.data(), gray.size());
+
+  // Thresholds at two stored values, so that both bounds are hit exactly
+  const double       slope = header->DensitySlope / (header->MuScaling > 1.0 ? header->MuScaling : 1.0);
+  const double       intercept = header->DensityIntercept;
+  std::vector<short> sorted = gray;
+  std::sort(sorted.begin(), sorted.end());
+  double lowerThreshold = slope * sorted[sorted.size() / 2] + intercept;
+  double upperThreshold = slope * sorted[sorted.size() * 9 / 10] + intercept;
+  io->SetLowerThreshold(lowerThreshold);
+  ITK_TEST_SET_GET_VALUE(lowerThreshold, io->GetLowerThreshold());
+  io->SetUpperThreshold(upperThreshold);
+  ITK_TEST_SET_GET_VALUE(upperThreshold, io->GetUpperThreshold());
+  ITK_TEST_SET_GET_VALUE(255, io->GetThresholdInsideValue());
+
+  // The mask of a region, with the stored values in a row-major volume
+  auto expectedMask = [&](const std::vector<short> & values,
+                          const itk::SizeValueType   dimensions[3],
+                          const itk::ImageIORegion & region,
+                          double                     valueSlope,
+                          double                     valueIntercept,
+                          unsigned char              insideValue) {
+    std::vector<unsigned char> mask;
+    for (itk::SizeValueType z = 0; z < region.GetSize(2); ++z)
+    {
+      for (itk::SizeValueType y = 0; y < region.GetSize(1); ++y)
+      {
+        for (itk::SizeValueType x = 0; x < region.GetSize(0); ++x)
+        {
+          const short value = values[((region.GetIndex(2) + z) * dimensions[1] + region.GetIndex(1) + y) *
+                                       dimensions[0] +
+                                     region.GetIndex(0) + x];
+          const double density = valueSlope * value + valueIntercept;
+          mask.push_back(density >= lowerThreshold && density <= upperThreshold ? insideValue : 0);
+        }
+      }
+    }
+    return mask;
+  };
+  itk::ImageIORegion wholeRegion(3);
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    wholeRegion.SetSize(i, header->Dimensions[i]);
+  }
+  const std::vector<unsigned char> expected =
+    expectedMask(gray, header->Dimensions, wholeRegion, slope, intercept, 255);
+  ITK_TEST_EXPECT_TRUE(std::count(expected.begin(), expected.end(), 0) != 0);
+  ITK_TEST_EXPECT_TRUE(std::count(expected.begin(), expected.end(), 255) != 0);
+
+  // Read the mask through the image reader
+  io->ThresholdOnReadOn();
+  using ImageType = itk::Image<unsigned char, 3>;
+  using ReaderType = itk::ImageFileReader<ImageType>;
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetImageIO(io);
+  reader->SetFileName(isqFileName);
+  ITK_TRY_EXPECT_NO_EXCEPTION(reader->Update());
+  ITK_TEST_EXPECT_EQUAL(io->GetComponentType(), itk::IOComponentEnum::UCHAR);
+  const ImageType * image = reader->GetOutput();
+  ITK_TEST_EXPECT_TRUE(std::equal(expected.begin(), expected.end(), image->GetBufferPointer()));
+
+  // A region, with another inside value
+  itk::ImageIORegion region(3);
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    region.SetIndex(i, header->Dimensions[i] / 4);
+    region.SetSize(i, std::max<itk::SizeValueType>(1, header->Dimensions[i] / 2));
+  }
+  io->SetThresholdInsideValue(1);
+  ITK_TEST_SET_GET_VALUE(1, io->GetThresholdInsideValue());
+  io->SetIORegion(region);
+  std::vector<unsigned char> regionMask(region.GetNumberOfPixels());
+  ITK_TRY_EXPECT_NO_EXCEPTION(io->Read(regionMask.data()));
+  ITK_TEST_EXPECT_TRUE(regionMask == expectedMask(gray, header->Dimensions, region, slope, intercept, 1));
+
+  // The same in service mode
+  io->ServiceModeOn();
+  ITK_TRY_EXPECT_NO_EXCEPTION(io->ReadImageInformation());
+  io->SetIORegion(region);
+  std::fill(regionMask.begin(), regionMask.end(), 0);
+  ITK_TRY_EXPECT_NO_EXCEPTION(io->Read(regionMask.data()));
+  ITK_TEST_EXPECT_TRUE(regionMask == expectedMask(gray, header->Dimensions, region, slope, intercept, 1));
+  io->ServiceModeOff();
+
+  // Turning the threshold off restores the pixel type of the file
+  io->ThresholdOnReadOff();
+  ITK_TEST_EXPECT_EQUAL(io->GetComponentType(), itk::IOComponentEnum::SHORT);
+
+  // Run-length encoded data is thresholded by its stored values, in place
+  const itk::SizeValueType   maskDimensions[3] = { 7, 5, 3 };
+  const int64_t              maskPosition[3] = { 0, 0, 0 };
+  std::vector<unsigned char> labels(maskDimensions[0] * maskDimensions[1] * maskDimensions[2]);
+  std::vector<short>         labelValues(labels.size());
+  for (size_t i = 0; i < labels.size(); ++i)
+  {
+    labels[i] = static_cast<unsigned char>(i / 4 % 5);
+    labelValues[i] = static_cast<signed char>(labels[i]);
+  }
+  const std::string labelFileName = outputPrefix + "Labels.aim";
+  ITK_TEST_EXPECT_TRUE(
+    WriteAIM(labelFileName, runLengthDataType, maskDimensions, maskPosition, 1000, EncodeRunLengths(labels)));
+  io->SetFileName(labelFileName);
+  lowerThreshold = 2;
+  upperThreshold = 3;
+  io->SetLowerThreshold(lowerThreshold);
+  io->SetUpperThreshold(upperThreshold);
+  io->ThresholdOnReadOn();
+  ITK_TRY_EXPECT_NO_EXCEPTION(io->ReadImageInformation());
+  ITK_TEST_EXPECT_EQUAL(io->GetComponentType(), itk::IOComponentEnum::UCHAR);
+  itk::ImageIORegion labelRegion(3);
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    labelRegion.SetSize(i, maskDimensions[i]);
+  }
+  io->SetIORegion(labelRegion);
+  std::vector<unsigned char> labelMask(labels.size());
+  ITK_TRY_EXPECT_NO_EXCEPTION(io->Read(labelMask.data()));
+  ITK_TEST_EXPECT_TRUE(labelMask == expectedMask(labelValues, maskDimensions, labelRegion, 1.0, 0.0, 1));
+
+
+  std::cout << "Test finished" << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,216 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         https://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <algorithm>
+#include <fstream>
+#include <vector>
+#include "itkByteSwapper.h"
+#include "itkImage.h"
+#include "itkScancoBitMask.h"
+#include "itkScancoImageIO.h"
+#include "itkScancoTestHelpers.h"
+#include "itkTestingMacros.h"
+
+
+#define SPECIFIC_IMAGEIO_MODULE_TEST
+
+using itk::ScancoTestHelpers::EncodeRunLengths;
+using itk::ScancoTestHelpers::WriteAIM;
+
+// The AIM data type of 8-bit run-lengths
+constexpr int runLengthDataType = 0x00080002;
+
+
+int
+itkScancoImageIOTest19(int argc, char * argv[])
+{
+  if (argc < 3)
+  {
+    std::cerr << "Missing parameters." << std::endl;
+    std::cerr << "Usage: " << std::endl;
+    std::cerr << itkNameOfTestExecutableMacro(argv) << " InputISQ OutputPrefix" << std::endl;
+    return EXIT_FAILURE;
+  }
+  const std::string isqFileName = argv[1];
+  const std::string outputPrefix = argv[2];
+
+  using MaskType = itk::ScancoBitMask;
+
+  // Whether a mask holds the voxels of an unsigned char mask, and keeps the
+  // bits past the end of its rows clear
+  auto matches = [](const MaskType * mask, const std::vector<unsigned char> & voxels) {
+    bool                     equal = (mask->GetLargestPossibleRegion().GetNumberOfPixels() == voxels.size());
+    itk::SizeValueType       i = 0;
+    const itk::SizeValueType xsize = mask->GetLargestPossibleRegion().GetSize(0);
+    const MaskType::WordType padding = (xsize % 64 == 0 ? 0 : ~MaskType::WordType{ 0 } << (xsize % 64));
+    for (MaskType::ConstIterator it(mask, mask->GetLargestPossibleRegion()); equal && !it.IsAtEnd(); ++it, ++i)
+    {
+      equal = (it.Get() == (voxels[i] != 0));
+      if (it.GetIndex()[0] == 0)
+      {
+        equal = equal && (mask->GetRow(it.GetIndex()[1], it.GetIndex()[2])[mask->GetWordsPerRow() - 1] & padding) == 0;
+      }
+    }
+    return equal && i == voxels.size() &&
+           mask->CountSetVoxels() ==
+             static_cast<itk::SizeValueType>(voxels.size() - std::count(voxels.begin(), voxels.end(), 0));
+  };
+
+  // A threshold on read of a gray scale file, compared with the unsigned
+  // char mask
+  itk::ScancoImageIO::Pointer io = itk::ScancoImageIO::New();
+  io->SetFileName(isqFileName);
+  ITK_TRY_EXPECT_NO_EXCEPTION(io->ReadImageInformation());
+  ITK_TRY_EXPECT_EXCEPTION(io->ReadBitMask());
+
+  const itk::ScancoImageIO::HeaderPointer header = io->GetHeader();
+  std::vector<short>                      gray(header->Dimensions[0] * header->Dimensions[1] * header->Dimensions[2]);
+  {
+    std::ifstream file(isqFileName.c_str(), std::ios::in | std::ios::binary);
+    file.seekg(header->HeaderSize);
+    file.read(reinterpret_cast<char *>(gray.data()), gray.size() * sizeof(short));
+    ITK_TEST_EXPECT_TRUE(file.good());
+  }
+  itk::ByteSwapper<short>::SwapRangeFromSystemToLittleEndian(gray.data(), gray.size());
+  const double       slope = header->DensitySlope / (header->MuScaling > 1.0 ? header->MuScaling : 1.0);
+  std::vector<short> sorted = gray;
+  std::sort(sorted.begin(), sorted.end());
+  io->ThresholdOnReadOn();
+  io->SetLowerThreshold(slope * sorted[sorted.size() / 2] + header->DensityIntercept);
+  io->SetUpperThreshold(slope * sorted[sorted.size() * 9 / 10] + header->DensityIntercept);
+
+  itk::ImageIORegion region(3);
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    region.SetSize(i, header->Dimensions[i]);
+  }
+  io->SetIORegion(region);
+  std::vector<unsigned char> expected(gray.size());
+  ITK_TRY_EXPECT_NO_EXCEPTION(io->Read(expected.data()));
+
+  MaskType::Pointer mask;
+  ITK_TRY_EXPECT_NO_EXCEPTION(mask = io->ReadBitMask());
+  ITK_EXERCISE_BASIC_OBJECT_METHODS(mask, ScancoBitMask, Object);
+  ITK_TEST_EXPECT_TRUE(matches(mask, expected));
+  ITK_TEST_EXPECT_EQUAL(mask->GetWordsPerRow(), (header->Dimensions[0] + 63) / 64);
+  ITK_TEST_EXPECT_EQUAL(mask->GetBufferSize(),
+                        mask->GetWordsPerRow() * header->Dimensions[1] * header->Dimensions[2] * sizeof(uint64_t));
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    ITK_TEST_EXPECT_EQUAL(mask->GetSpacing()[i], header->Spacing[i]);
+    ITK_TEST_EXPECT_EQUAL(mask->GetOrigin()[i], header->Origin[i]);
+  }
+
+  // Expand a block into an image and store it back into an empty mask
+  using ImageType = itk::Image<unsigned char, 3>;
+  MaskType::RegionType block;
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    block.SetIndex(i, header->Dimensions[i] / 4);
+    block.SetSize(i, std::max<itk::SizeValueType>(1, header->Dimensions[i] / 2));
+  }
+  ImageType::Pointer image = mask->GetImage<ImageType>(block, 255);
+  MaskType::Pointer  copy = MaskType::New();
+  copy->Allocate(mask->GetLargestPossibleRegion().GetSize());
+  copy->SetImage(image.GetPointer());
+  const unsigned char * pixel = image->GetBufferPointer();
+  bool                  blockMatches = true;
+  for (MaskType::ConstIterator it(mask, block); !it.IsAtEnd(); ++it, ++pixel)
+  {
+    blockMatches = blockMatches && *pixel == (it.Get() ? 255 : 0) && copy->GetPixel(it.GetIndex()) == it.Get();
+  }
+  ITK_TEST_EXPECT_TRUE(blockMatches);
+  ITK_TEST_EXPECT_EQUAL(copy->CountSetVoxels(),
+                        static_cast<itk::SizeValueType>(
+                          image->GetBufferedRegion().GetNumberOfPixels() -
+                          std::count(image->GetBufferPointer(),
+                                     image->GetBufferPointer() + image->GetBufferedRegion().GetNumberOfPixels(),
+                                     0)));
+  block.SetSize(0, header->Dimensions[0]);
+  ITK_TRY_EXPECT_EXCEPTION(MaskType::ConstIterator(mask, block));
+
+  // Runs that cross words, and single voxels
+  MaskType::SizeType runSize;
+  runSize[0] = 150;
+  runSize[1] = 3;
+  runSize[2] = 4;
+  MaskType::Pointer runs = MaskType::New();
+  runs->Allocate(runSize);
+  ITK_TEST_EXPECT_EQUAL(runs->GetWordsPerRow(), 3);
+  runs->SetRun(3, 1, 2, 140, true);
+  runs->SetRun(64, 1, 2, 2, false);
+  runs->SetRun(100, 1, 2, 1, false);
+  MaskType::IndexType index;
+  index[0] = 149;
+  index[1] = 0;
+  index[2] = 3;
+  runs->SetPixel(index, true);
+  ITK_TEST_EXPECT_TRUE(runs->GetPixel(index));
+  ITK_TEST_EXPECT_EQUAL(runs->CountSetVoxels(), 140 - 3 + 1);
+  index[0] = 64;
+  index[1] = 1;
+  index[2] = 2;
+  ITK_TEST_EXPECT_TRUE(!runs->GetPixel(index));
+  index[0] = 142;
+  ITK_TEST_EXPECT_TRUE(runs->GetPixel(index));
+  runs->SetPixel(index, false);
+  ITK_TEST_EXPECT_TRUE(!runs->GetPixel(index));
+  runs->FillBuffer(true);
+  std::vector<unsigned char> all(runSize[0] * runSize[1] * runSize[2], 1);
+  ITK_TEST_EXPECT_TRUE(matches(runs, all));
+  for (MaskType::Iterator it(runs, runs->GetLargestPossibleRegion()); !it.IsAtEnd(); ++it)
+  {
+    const MaskType::IndexType & runIndex = it.GetIndex();
+    it.Set(runIndex[0] % 3 == 0);
+    all[(runIndex[2] * runSize[1] + runIndex[1]) * runSize[0] + runIndex[0]] = (runIndex[0] % 3 == 0);
+  }
+  ITK_TEST_EXPECT_TRUE(matches(runs, all));
+  ITK_TEST_EXPECT_EQUAL(runs->CountSetVoxels(), 50 * runSize[1] * runSize[2]);
+
+  // Binary and label AIM files are read run by run, by their stored values
+  const itk::SizeValueType   labelDimensions[3] = { 70, 4, 3 };
+  const int64_t              labelPosition[3] = { 0, 0, 0 };
+  std::vector<unsigned char> labels(labelDimensions[0] * labelDimensions[1] * labelDimensions[2]);
+  for (size_t i = 0; i < labels.size(); ++i)
+  {
+    labels[i] = static_cast<unsigned char>(i / 5 % 7 < 3 ? 0 : i / 5 % 7);
+  }
+  const std::string labelFileName = outputPrefix + "Labels.aim";
+  ITK_TEST_EXPECT_TRUE(
+    WriteAIM(labelFileName, runLengthDataType, labelDimensions, labelPosition, 1000, EncodeRunLengths(labels)));
+  io = itk::ScancoImageIO::New();
+  io->SetFileName(labelFileName);
+  ITK_TRY_EXPECT_NO_EXCEPTION(io->ReadImageInformation());
+  ITK_TRY_EXPECT_NO_EXCEPTION(mask = io->ReadBitMask());
+  ITK_TEST_EXPECT_TRUE(matches(mask, labels));
+
+  // A threshold that includes the background
+  io->ThresholdOnReadOn();
+  io->SetLowerThreshold(-1.0);
+  io->SetUpperThreshold(4.0);
+  std::vector<unsigned char> thresholded(labels.size());
+  std::transform(labels.begin(), labels.end(), thresholded.begin(), [](unsigned char label) {
+    return static_cast<unsigned char>(label <= 4);
+  });
+  ITK_TRY_EXPECT_NO_EXCEPTION(mask = io->ReadBitMask());
+  ITK_TEST_EXPECT_TRUE(matches(mask, thresholded));
+
+
+  std::cout << "Test finished" << std::endl;
+  return EXIT_SUCCESS;
+}
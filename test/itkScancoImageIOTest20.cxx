@@ -0,0 +1,75 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         https://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <algorithm>
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+#include "itkScancoImageIO.h"
+#include "itkTestingMacros.h"
+#include "itksys/SystemTools.hxx"
+
+
+#define SPECIFIC_IMAGEIO_MODULE_TEST
+
+int
+itkScancoImageIOTest20(int argc, char * argv[])
+{
+  if (argc < 3)
+  {
+    std::cerr << "Missing parameters." << std::endl;
+    std::cerr << "Usage: " << std::endl;
+    std::cerr << itkNameOfTestExecutableMacro(argv) << " Input Output" << std::endl;
+    return EXIT_FAILURE;
+  }
+  const std::string inputFileName = argv[1];
+  const std::string outputFileName = argv[2];
+
+  using ImageType = itk::Image<short, 3>;
+  ImageType::Pointer image;
+  ITK_TRY_EXPECT_NO_EXCEPTION(image = itk::ReadImage<ImageType>(inputFileName));
+
+  // Write without the page cache, throttling write-back
+  itk::ScancoImageIO::Pointer scancoIO = itk::ScancoImageIO::New();
+  scancoIO->UseDirectIOOn();
+  ITK_TEST_EXPECT_TRUE(scancoIO->GetUseDirectIO());
+  scancoIO->ThrottleWriteBackOn();
+  ITK_TEST_EXPECT_TRUE(scancoIO->GetThrottleWriteBack());
+
+  using WriterType = itk::ImageFileWriter<ImageType>;
+  WriterType::Pointer writer = WriterType::New();
+  writer->SetImageIO(scancoIO);
+  writer->SetInput(image);
+  writer->SetFileName(outputFileName);
+  ITK_TRY_EXPECT_NO_EXCEPTION(writer->Update());
+
+  // The file holds exactly the header and the data, without the padding of
+  // the aligned writes
+  const itk::ScancoImageIO::HeaderPointer header = itk::ScancoImageIO::ReadHeader(outputFileName);
+  const itk::SizeValueType numberOfPixels = image->GetLargestPossibleRegion().GetNumberOfPixels();
+  ITK_TEST_EXPECT_EQUAL(itksys::SystemTools::FileLength(outputFileName),
+                        header->HeaderSize + numberOfPixels * sizeof(short));
+
+  ImageType::Pointer outputImage;
+  ITK_TRY_EXPECT_NO_EXCEPTION(outputImage = itk::ReadImage<ImageType>(outputFileName));
+  ITK_TEST_EXPECT_TRUE(
+    std::equal(image->GetBufferPointer(), image->GetBufferPointer() + numberOfPixels, outputImage->GetBufferPointer()));
+
+
+  std::cout << "Test finished" << std::endl;
+  return EXIT_SUCCESS;
+}
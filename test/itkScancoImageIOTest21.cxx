@@ -0,0 +1,74 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         https://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <algorithm>
+#include "itkImageFileReader.h"
+#include "itkScancoImageIO.h"
+#include "itkTestingMacros.h"
+
+
+#define SPECIFIC_IMAGEIO_MODULE_TEST
+
+int
+itkScancoImageIOTest21(int argc, char * argv[])
+{
+  if (argc < 3)
+  {
+    std::cerr << "Missing parameters." << std::endl;
+    std::cerr << "Usage: " << std::endl;
+    std::cerr << itkNameOfTestExecutableMacro(argv) << " Input Output" << std::endl;
+    return EXIT_FAILURE;
+  }
+  const std::string inputFileName = argv[1];
+  const std::string outputFileName = argv[2];
+
+  // Reading sets up the IO with the image information of the input
+  using ImageType = itk::Image<short, 3>;
+  using ReaderType = itk::ImageFileReader<ImageType>;
+  itk::ScancoImageIO::Pointer scancoIO = itk::ScancoImageIO::New();
+  ReaderType::Pointer         reader = ReaderType::New();
+  reader->SetImageIO(scancoIO);
+  reader->SetFileName(inputFileName);
+  ITK_TRY_EXPECT_NO_EXCEPTION(reader->Update());
+  ImageType::Pointer       image = reader->GetOutput();
+  const itk::SizeValueType numberOfPixels = image->GetLargestPossibleRegion().GetNumberOfPixels();
+
+  // Write the image in the background, and read it back
+  bool callbackCalled = false;
+  scancoIO->SetFileName(outputFileName);
+  std::shared_future<void> written = scancoIO->WriteAsync(image->GetBufferPointer(), [&](std::exception_ptr error) {
+    callbackCalled = (error == nullptr);
+  });
+  ITK_TRY_EXPECT_NO_EXCEPTION(written.get());
+  ITK_TEST_EXPECT_TRUE(callbackCalled);
+
+  ImageType::Pointer asyncImage;
+  ITK_TRY_EXPECT_NO_EXCEPTION(asyncImage = itk::ReadImage<ImageType>(outputFileName));
+  ITK_TEST_EXPECT_TRUE(
+    std::equal(image->GetBufferPointer(), image->GetBufferPointer() + numberOfPixels, asyncImage->GetBufferPointer()));
+
+  // Errors are passed on through the future
+  scancoIO->SetFileName(outputFileName + ".missing/async.isq");
+  written = scancoIO->WriteAsync(image->GetBufferPointer());
+  ITK_TRY_EXPECT_EXCEPTION(written.get());
+  itk::ScancoImageIO::WaitForAsyncWrites();
+
+
+  std::cout << "Test finished" << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,82 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         https://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <algorithm>
+#include <vector>
+#include "itkImageFileReader.h"
+#include "itkMath.h"
+#include "itkScancoImageIO.h"
+#include "itkTestingMacros.h"
+
+
+#define SPECIFIC_IMAGEIO_MODULE_TEST
+
+int
+itkScancoImageIOTest22(int argc, char * argv[])
+{
+  if (argc < 3)
+  {
+    std::cerr << "Missing parameters." << std::endl;
+    std::cerr << "Usage: " << std::endl;
+    std::cerr << itkNameOfTestExecutableMacro(argv) << " Input Output" << std::endl;
+    return EXIT_FAILURE;
+  }
+  const std::string inputFileName = argv[1];
+  const std::string outputFileName = argv[2];
+
+  // Reading sets up the IO with the image information and the calibration
+  // of the input
+  using ImageType = itk::Image<short, 3>;
+  using ReaderType = itk::ImageFileReader<ImageType>;
+  using IOType = itk::ScancoImageIO;
+  IOType::Pointer     scancoIO = IOType::New();
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetImageIO(scancoIO);
+  reader->SetFileName(inputFileName);
+  ITK_TRY_EXPECT_NO_EXCEPTION(reader->Update());
+  ImageType::Pointer       image = reader->GetOutput();
+  const itk::SizeValueType numberOfPixels = image->GetLargestPossibleRegion().GetNumberOfPixels();
+
+  // Float data is converted back to the values of the file, which keeps
+  // its calibration
+  std::vector<float> floatBuffer(image->GetBufferPointer(), image->GetBufferPointer() + numberOfPixels);
+  scancoIO->SetFileName(outputFileName);
+  scancoIO->SetComponentType(itk::IOComponentEnum::FLOAT);
+  ITK_TRY_EXPECT_NO_EXCEPTION(scancoIO->Write(floatBuffer.data()));
+
+  IOType::Pointer floatIO = IOType::New();
+  floatIO->SetFileName(outputFileName);
+  ITK_TRY_EXPECT_NO_EXCEPTION(floatIO->ReadImageInformation());
+  ITK_TEST_EXPECT_TRUE(itk::Math::FloatAlmostEqual(floatIO->GetMuScaling(), 4096.0, 6, 1e-3));
+  ITK_TEST_EXPECT_TRUE(itk::Math::FloatAlmostEqual(floatIO->GetMuWater(), 0.7033, 6, 1e-3));
+  ITK_TEST_EXPECT_EQUAL(floatIO->GetRescaleUnits(), std::string("mg HA/ccm"));
+  ITK_TEST_EXPECT_TRUE(floatIO->GetDataRange()[0] <= floatIO->GetDataRange()[1]);
+
+  ImageType::Pointer floatImage;
+  ITK_TRY_EXPECT_NO_EXCEPTION(floatImage = itk::ReadImage<ImageType>(outputFileName));
+  ITK_TEST_EXPECT_TRUE(
+    std::equal(image->GetBufferPointer(), image->GetBufferPointer() + numberOfPixels, floatImage->GetBufferPointer()));
+
+  // Only scalar pixels can be written
+  scancoIO->SetPixelType(itk::IOPixelEnum::RGB);
+  ITK_TRY_EXPECT_EXCEPTION(scancoIO->Write(floatBuffer.data()));
+
+
+  std::cout << "Test finished" << std::endl;
+  return EXIT_SUCCESS;
+}
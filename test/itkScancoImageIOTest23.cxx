@@ -0,0 +1,139 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         https://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <algorithm>
+#include <fstream>
+#include <vector>
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkMetaDataObject.h"
+#include "itkScancoImageIO.h"
+#include "itkTestingMacros.h"
+
+
+#define SPECIFIC_IMAGEIO_MODULE_TEST
+
+int
+itkScancoImageIOTest23(int argc, char * argv[])
+{
+  if (argc < 3)
+  {
+    std::cerr << "Missing parameters." << std::endl;
+    std::cerr << "Usage: " << std::endl;
+    std::cerr << itkNameOfTestExecutableMacro(argv) << " Input Output" << std::endl;
+    return EXIT_FAILURE;
+  }
+  const std::string inputFileName = argv[1];
+  const std::string streamedFileName = argv[2];
+
+  constexpr unsigned int Dimension = 3;
+  using PixelType = short;
+  using ImageType = itk::Image<PixelType, Dimension>;
+  using IOType = itk::ScancoImageIO;
+  ImageType::Pointer image;
+  ITK_TRY_EXPECT_NO_EXCEPTION(image = itk::ReadImage<ImageType>(inputFileName));
+  const itk::SizeValueType numberOfPixels = image->GetLargestPossibleRegion().GetNumberOfPixels();
+
+  using WriterType = itk::ImageFileWriter<ImageType>;
+  IOType::Pointer     scancoIO = IOType::New();
+  WriterType::Pointer writer = WriterType::New();
+  writer->SetImageIO(scancoIO);
+  writer->SetInput(image);
+
+  // Stream the image into a file in pieces, each written in place. The
+  // first piece replaces an older file instead of being pasted into it.
+  {
+    std::ofstream olderFile(streamedFileName.c_str(), std::ios::out | std::ios::binary);
+    olderFile << "not a Scanco file";
+  }
+  ITK_TEST_EXPECT_TRUE(scancoIO->CanStreamWrite());
+  writer->SetFileName(streamedFileName);
+  writer->SetNumberOfStreamDivisions(4);
+  ITK_TRY_EXPECT_NO_EXCEPTION(writer->Update());
+  ImageType::Pointer streamedImage;
+  ITK_TRY_EXPECT_NO_EXCEPTION(streamedImage = itk::ReadImage<ImageType>(streamedFileName));
+  ITK_TEST_EXPECT_TRUE(std::equal(
+    image->GetBufferPointer(), image->GetBufferPointer() + numberOfPixels, streamedImage->GetBufferPointer()));
+
+  // Overwrite a region of the file, which is not made of whole rows, with
+  // the pixels one slice below it
+  const ImageType::SizeType size = image->GetLargestPossibleRegion().GetSize();
+  itk::ImageIORegion        region(Dimension);
+  ImageType::RegionType     targetRegion;
+  ImageType::RegionType     sourceRegion;
+  for (unsigned int i = 0; i < Dimension; ++i)
+  {
+    region.SetIndex(i, 1);
+    region.SetSize(i, size[i] - 2);
+    targetRegion.SetIndex(i, 1);
+    targetRegion.SetSize(i, size[i] - 2);
+    sourceRegion.SetIndex(i, i < 2 ? 1 : 0);
+    sourceRegion.SetSize(i, size[i] - 2);
+  }
+  std::vector<PixelType>                   regionBuffer;
+  itk::ImageRegionConstIterator<ImageType> sourceIt(image, sourceRegion);
+  for (sourceIt.GoToBegin(); !sourceIt.IsAtEnd(); ++sourceIt)
+  {
+    regionBuffer.push_back(sourceIt.Get());
+  }
+  scancoIO->SetFileName(streamedFileName);
+  ITK_TRY_EXPECT_NO_EXCEPTION(scancoIO->WriteRegion(region, regionBuffer.data()));
+  const double dataRange[2] = { scancoIO->GetDataRange()[0], scancoIO->GetDataRange()[1] };
+
+  IOType::Pointer regionIO = IOType::New();
+  regionIO->SetFileName(streamedFileName);
+  ITK_TRY_EXPECT_NO_EXCEPTION(regionIO->ReadImageInformation());
+  ITK_TEST_EXPECT_EQUAL(regionIO->GetDataRange()[0], dataRange[0]);
+  ITK_TEST_EXPECT_EQUAL(regionIO->GetDataRange()[1], dataRange[1]);
+  ITK_TRY_EXPECT_NO_EXCEPTION(streamedImage = itk::ReadImage<ImageType>(streamedFileName));
+  bool                 regionMatches = true;
+  ImageType::IndexType index;
+  for (index[2] = 0; index[2] < static_cast<itk::IndexValueType>(size[2]); ++index[2])
+  {
+    for (index[1] = 0; index[1] < static_cast<itk::IndexValueType>(size[1]); ++index[1])
+    {
+      for (index[0] = 0; index[0] < static_cast<itk::IndexValueType>(size[0]); ++index[0])
+      {
+        ImageType::IndexType sourceIndex = index;
+        if (targetRegion.IsInside(index))
+        {
+          --sourceIndex[2];
+        }
+        regionMatches = regionMatches && (streamedImage->GetPixel(index) == image->GetPixel(sourceIndex));
+      }
+    }
+  }
+  ITK_TEST_EXPECT_TRUE(regionMatches);
+
+  // The dimensions, spacing and calibration of the file have to match the
+  // image information
+  scancoIO->SetDimensions(2, size[2] + 1);
+  ITK_TRY_EXPECT_EXCEPTION(scancoIO->WriteRegion(region, regionBuffer.data()));
+  scancoIO->SetDimensions(2, size[2]);
+  const double spacing = scancoIO->GetSpacing(0);
+  scancoIO->SetSpacing(0, 2.0 * spacing);
+  ITK_TRY_EXPECT_EXCEPTION(scancoIO->WriteRegion(region, regionBuffer.data()));
+  scancoIO->SetSpacing(0, spacing);
+  itk::EncapsulateMetaData<double>(scancoIO->GetMetaDataDictionary(), "MuScaling", 2048.0);
+  ITK_TRY_EXPECT_EXCEPTION(scancoIO->WriteRegion(region, regionBuffer.data()));
+
+
+  std::cout << "Test finished" << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,191 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         https://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <algorithm>
+#include <fstream>
+#include "itkImageFileReader.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkMultiThreaderBase.h"
+#include "itkScancoImageIO.h"
+#include "itkTestingMacros.h"
+
+
+#define SPECIFIC_IMAGEIO_MODULE_TEST
+
+int
+itkScancoImageIOTest4(int argc, char * argv[])
+{
+  if (argc < 3)
+  {
+    std::cerr << "Missing parameters." << std::endl;
+    std::cerr << "Usage: " << std::endl;
+    std::cerr << itkNameOfTestExecutableMacro(argv) << " Input InvalidOutput" << std::endl;
+    return EXIT_FAILURE;
+  }
+  const std::string inputFileName = argv[1];
+  const std::string invalidFileName = argv[2];
+
+  constexpr unsigned int Dimension = 3;
+  using PixelType = short;
+  using ImageType = itk::Image<PixelType, Dimension>;
+
+  using ReaderType = itk::ImageFileReader<ImageType>;
+  ReaderType::Pointer reader = ReaderType::New();
+
+  using IOType = itk::ScancoImageIO;
+  IOType::Pointer scancoIO = IOType::New();
+  reader->SetImageIO(scancoIO);
+  reader->SetFileName(inputFileName);
+  ITK_TRY_EXPECT_NO_EXCEPTION(reader->Update());
+  ImageType::Pointer image = reader->GetOutput();
+
+  // Share the parsed header with a second IO, which must not parse again
+  const IOType::HeaderPointer header = scancoIO->GetHeader();
+  ITK_TEST_EXPECT_TRUE(header != nullptr);
+
+  IOType::Pointer sharedIO = IOType::New();
+  sharedIO->SetFileName(inputFileName);
+  sharedIO->SetHeader(header);
+  ITK_TEST_EXPECT_TRUE(sharedIO->GetHeader() == header);
+  for (unsigned int i = 0; i < Dimension; ++i)
+  {
+    ITK_TEST_EXPECT_EQUAL(sharedIO->GetDimensions(i), scancoIO->GetDimensions(i));
+  }
+  ITK_TEST_EXPECT_EQUAL(sharedIO->GetPatientIndex(), scancoIO->GetPatientIndex());
+  ITK_TEST_EXPECT_TRUE(itk::Math::FloatAlmostEqual(sharedIO->GetRescaleSlope(), scancoIO->GetRescaleSlope()));
+
+  // Read the volume as z-slabs from several threads at once
+  const ImageType::SizeType size = image->GetLargestPossibleRegion().GetSize();
+  const itk::SizeValueType  sliceSize = size[0] * size[1];
+  const itk::SizeValueType  slabSlices = 3;
+  const itk::SizeValueType  numberOfSlabs = (size[2] + slabSlices - 1) / slabSlices;
+  std::vector<PixelType>    slabBuffer(sliceSize * size[2]);
+
+  itk::MultiThreaderBase::Pointer threader = itk::MultiThreaderBase::New();
+  threader->ParallelizeArray(
+    0,
+    numberOfSlabs,
+    [&](itk::SizeValueType slab) {
+      const itk::SizeValueType firstSlice = slab * slabSlices;
+      itk::ImageIORegion       region(Dimension);
+      region.SetIndex(0, 0);
+      region.SetIndex(1, 0);
+      region.SetIndex(2, firstSlice);
+      region.SetSize(0, size[0]);
+      region.SetSize(1, size[1]);
+      region.SetSize(2, std::min(slabSlices, size[2] - firstSlice));
+      sharedIO->ReadRegion(region, slabBuffer.data() + firstSlice * sliceSize);
+    },
+    nullptr);
+
+  const PixelType * imageBuffer = image->GetBufferPointer();
+  ITK_TEST_EXPECT_TRUE(std::equal(slabBuffer.begin(), slabBuffer.end(), imageBuffer));
+
+  // Service mode keeps the stream and reuses the header and buffers
+  IOType::Pointer serviceIO = IOType::New();
+  serviceIO->ServiceModeOn();
+  ITK_TEST_EXPECT_TRUE(serviceIO->GetServiceMode());
+  serviceIO->SetFileName(inputFileName);
+  const itk::ScancoHeader * firstHeader = nullptr;
+  std::vector<PixelType>    serviceBuffer(slabBuffer.size());
+  for (int pass = 0; pass < 2; ++pass)
+  {
+    ITK_TRY_EXPECT_NO_EXCEPTION(serviceIO->ReadImageInformation());
+    itk::ImageIORegion largestRegion(Dimension);
+    for (unsigned int i = 0; i < Dimension; ++i)
+    {
+      largestRegion.SetSize(i, size[i]);
+    }
+    serviceIO->SetIORegion(largestRegion);
+    ITK_TRY_EXPECT_NO_EXCEPTION(serviceIO->Read(serviceBuffer.data()));
+    ITK_TEST_EXPECT_TRUE(std::equal(serviceBuffer.begin(), serviceBuffer.end(), imageBuffer));
+    if (pass == 0)
+    {
+      firstHeader = serviceIO->GetHeader().get();
+    }
+  }
+  ITK_TEST_EXPECT_TRUE(serviceIO->GetHeader().get() == firstHeader);
+
+  // A failed read leaves no header behind, and does not modify a header
+  // that is still in use
+  const IOType::HeaderPointer serviceHeader = serviceIO->GetHeader();
+  {
+    std::ofstream invalidFile(invalidFileName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    invalidFile << "not a Scanco file";
+  }
+  serviceIO->SetFileName(invalidFileName);
+  ITK_TRY_EXPECT_EXCEPTION(serviceIO->ReadImageInformation());
+  ITK_TEST_EXPECT_TRUE(serviceIO->GetHeader() == nullptr);
+  ITK_TEST_EXPECT_EQUAL(serviceHeader->Dimensions[2], size[2]);
+  serviceIO->ServiceModeOff();
+
+  // A region that is not made of whole rows
+  itk::ImageIORegion region(Dimension);
+  for (unsigned int i = 0; i < Dimension; ++i)
+  {
+    region.SetIndex(i, size[i] / 4);
+    region.SetSize(i, size[i] / 2);
+  }
+  std::vector<PixelType> regionBuffer(region.GetNumberOfPixels());
+  ITK_TRY_EXPECT_NO_EXCEPTION(sharedIO->ReadRegion(region, regionBuffer.data()));
+
+  ImageType::RegionType imageRegion;
+  for (unsigned int i = 0; i < Dimension; ++i)
+  {
+    imageRegion.SetIndex(i, region.GetIndex(i));
+    imageRegion.SetSize(i, region.GetSize(i));
+  }
+  itk::ImageRegionConstIterator<ImageType> imageIt(image, imageRegion);
+  auto                                     regionIt = regionBuffer.cbegin();
+  bool                                     regionMatches = true;
+  for (imageIt.GoToBegin(); !imageIt.IsAtEnd(); ++imageIt, ++regionIt)
+  {
+    regionMatches = regionMatches && (imageIt.Get() == *regionIt);
+  }
+  ITK_TEST_EXPECT_TRUE(regionMatches);
+
+  // A region outside of the image is rejected
+  region.SetSize(2, size[2]);
+  ITK_TRY_EXPECT_EXCEPTION(sharedIO->ReadRegion(region, regionBuffer.data()));
+
+  // Planes orthogonal to each axis, through the middle of the image
+  for (unsigned int axis = 0; axis < Dimension; ++axis)
+  {
+    const itk::SizeValueType index = size[axis] / 2;
+    std::vector<PixelType>   planeBuffer(sliceSize * size[2] / size[axis]);
+    ITK_TRY_EXPECT_NO_EXCEPTION(sharedIO->ReadOrthogonalSlice(axis, index, planeBuffer.data()));
+
+    ImageType::RegionType planeRegion = image->GetLargestPossibleRegion();
+    planeRegion.SetIndex(axis, index);
+    planeRegion.SetSize(axis, 1);
+    itk::ImageRegionConstIterator<ImageType> planeIt(image, planeRegion);
+    auto                                     bufferIt = planeBuffer.cbegin();
+    bool                                     planeMatches = true;
+    for (planeIt.GoToBegin(); !planeIt.IsAtEnd(); ++planeIt, ++bufferIt)
+    {
+      planeMatches = planeMatches && (planeIt.Get() == *bufferIt);
+    }
+    ITK_TEST_EXPECT_TRUE(planeMatches);
+  }
+  ITK_TRY_EXPECT_EXCEPTION(sharedIO->ReadOrthogonalSlice(0, size[0], slabBuffer.data()));
+  ITK_TRY_EXPECT_EXCEPTION(sharedIO->ReadOrthogonalSlice(Dimension, 0, slabBuffer.data()));
+
+
+  std::cout << "Test finished" << std::endl;
+  return EXIT_SUCCESS;
+}
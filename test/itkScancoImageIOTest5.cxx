@@ -0,0 +1,104 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         https://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <algorithm>
+#include <fstream>
+#include <vector>
+#include "itkScancoImageIO.h"
+#include "itkTestingMacros.h"
+
+
+#define SPECIFIC_IMAGEIO_MODULE_TEST
+
+int
+itkScancoImageIOTest5(int argc, char * argv[])
+{
+  if (argc < 4)
+  {
+    std::cerr << "Missing parameters." << std::endl;
+    std::cerr << "Usage: " << std::endl;
+    std::cerr << itkNameOfTestExecutableMacro(argv) << " Input TruncatedOutput FileType" << std::endl;
+    return EXIT_FAILURE;
+  }
+  const std::string inputFileName = argv[1];
+  const std::string truncatedFileName = argv[2];
+  const int         fileType = std::stoi(argv[3]);
+
+  using IOType = itk::ScancoImageIO;
+
+  const IOType::ProbeInformation info = IOType::Probe(inputFileName);
+  std::cout << "FileType: \t\t" << info.FileType << std::endl;
+  std::cout << "Version: \t\t" << info.Version << std::endl;
+  std::cout << "Dimensions: \t\t" << info.Dimensions[0] << " " << info.Dimensions[1] << " " << info.Dimensions[2]
+            << std::endl;
+  std::cout << "Compression: \t\t" << info.Compression << std::endl;
+  std::cout << "DataOffset: \t\t" << info.DataOffset << std::endl;
+  std::cout << "ExpectedFileSize: \t" << info.ExpectedFileSize << std::endl;
+  std::cout << "ActualFileSize: \t" << info.ActualFileSize << std::endl;
+  ITK_TEST_EXPECT_EQUAL(info.FileType, fileType);
+  ITK_TEST_EXPECT_TRUE(!info.IsTruncated());
+
+  // The probe agrees with the full header parse
+  IOType::Pointer scancoIO = IOType::New();
+  scancoIO->SetFileName(inputFileName);
+  ITK_TRY_EXPECT_NO_EXCEPTION(scancoIO->ReadImageInformation());
+  ITK_TEST_EXPECT_EQUAL(std::string(info.Version), std::string(scancoIO->GetVersion()));
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    ITK_TEST_EXPECT_EQUAL(info.Dimensions[i], scancoIO->GetDimensions(i));
+  }
+  ITK_TEST_EXPECT_EQUAL(info.ComponentType, scancoIO->GetComponentType());
+  ITK_TEST_EXPECT_EQUAL(info.Compression, scancoIO->GetHeader()->Compression);
+  ITK_TEST_EXPECT_EQUAL(info.DataOffset, scancoIO->GetHeader()->HeaderSize);
+
+  // A copy that lacks the second half of the data is reported as truncated
+  {
+    std::ifstream     input(inputFileName.c_str(), std::ios::in | std::ios::binary);
+    std::vector<char> head(info.DataOffset + (info.ExpectedFileSize - info.DataOffset) / 2);
+    input.read(head.data(), head.size());
+    std::ofstream output(truncatedFileName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    output.write(head.data(), head.size());
+  }
+  const IOType::ProbeInformation truncatedInfo = IOType::Probe(truncatedFileName);
+  ITK_TEST_EXPECT_EQUAL(truncatedInfo.FileType, fileType);
+  ITK_TEST_EXPECT_TRUE(truncatedInfo.IsTruncated());
+
+  // An ISQ header with a negative data offset is not recognized
+  if (fileType == 1)
+  {
+    const std::string corruptFileName = truncatedFileName + ".corrupt";
+    {
+      std::ifstream     input(inputFileName.c_str(), std::ios::in | std::ios::binary);
+      std::vector<char> block(512);
+      input.read(block.data(), block.size());
+      std::fill(block.begin() + 508, block.end(), static_cast<char>(0xff));
+      std::ofstream output(corruptFileName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+      output.write(block.data(), block.size());
+    }
+    const IOType::ProbeInformation corruptInfo = IOType::Probe(corruptFileName);
+    ITK_TEST_EXPECT_EQUAL(corruptInfo.FileType, 0);
+    ITK_TEST_EXPECT_EQUAL(corruptInfo.DataOffset, 0);
+  }
+
+  // Files that are not Scanco files are not recognized
+  ITK_TEST_EXPECT_EQUAL(IOType::Probe(truncatedFileName + ".missing").FileType, 0);
+
+
+  std::cout << "Test finished" << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,130 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         https://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <fstream>
+#include <vector>
+#include "itkScancoArchiveIndexer.h"
+#include "itkScancoImageIO.h"
+#include "itkTestingMacros.h"
+#include "itksys/SystemTools.hxx"
+
+
+#define SPECIFIC_IMAGEIO_MODULE_TEST
+
+int
+itkScancoImageIOTest6(int argc, char * argv[])
+{
+  if (argc < 3)
+  {
+    std::cerr << "Missing parameters." << std::endl;
+    std::cerr << "Usage: " << std::endl;
+    std::cerr << itkNameOfTestExecutableMacro(argv) << " Input OutputDirectory" << std::endl;
+    return EXIT_FAILURE;
+  }
+  const std::string inputFileName = argv[1];
+  const std::string archiveDirectory = std::string(argv[2]) + "/archive";
+  const std::string catalogFileName = std::string(argv[2]) + "/catalog.jsonl";
+
+  // A small archive: the input in a subdirectory, a file that only looks
+  // like a Scanco file, and a file that is cut off within the header
+  const std::string archivedFileName =
+    archiveDirectory + "/sub/" + itksys::SystemTools::GetFilenameName(inputFileName);
+  const std::string invalidFileName = archiveDirectory + "/invalid.isq";
+  const std::string truncatedFileName = archiveDirectory + "/truncated.isq";
+  itksys::SystemTools::RemoveFile(catalogFileName);
+  ITK_TEST_EXPECT_TRUE(static_cast<bool>(itksys::SystemTools::MakeDirectory(archiveDirectory + "/sub")));
+  ITK_TEST_EXPECT_TRUE(static_cast<bool>(itksys::SystemTools::CopyFileAlways(inputFileName, archivedFileName)));
+  {
+    std::ofstream invalidFile(invalidFileName.c_str(), std::ios::out | std::ios::binary);
+    invalidFile << "not a Scanco file";
+  }
+  {
+    std::ifstream     input(inputFileName.c_str(), std::ios::in | std::ios::binary);
+    std::vector<char> start(300);
+    input.read(start.data(), start.size());
+    std::ofstream truncatedFile(truncatedFileName.c_str(), std::ios::out | std::ios::binary);
+    truncatedFile.write(start.data(), input.gcount());
+  }
+  ITK_TRY_EXPECT_EXCEPTION(itk::ScancoImageIO::ReadHeader(truncatedFileName));
+
+  using IndexerType = itk::ScancoArchiveIndexer;
+  IndexerType::Pointer indexer = IndexerType::New();
+
+  ITK_EXERCISE_BASIC_OBJECT_METHODS(indexer, ScancoArchiveIndexer, Object);
+
+  indexer->AddDirectory(archiveDirectory);
+
+  // The catalog file name is required
+  ITK_TRY_EXPECT_EXCEPTION(indexer->Update());
+
+  indexer->SetCatalogFileName(catalogFileName);
+  ITK_TEST_SET_GET_VALUE(catalogFileName, std::string(indexer->GetCatalogFileName()));
+  ITK_TRY_EXPECT_NO_EXCEPTION(indexer->Update());
+  ITK_TEST_EXPECT_EQUAL(indexer->GetNumberOfParsedFiles(), 1);
+  ITK_TEST_EXPECT_EQUAL(indexer->GetNumberOfUnchangedFiles(), 0);
+  ITK_TEST_EXPECT_EQUAL(indexer->GetNumberOfFailedFiles(), 2);
+
+  // The catalog holds one entry, matching the header of the file
+  std::string entry;
+  {
+    std::ifstream catalog(catalogFileName.c_str());
+    ITK_TEST_EXPECT_TRUE(static_cast<bool>(std::getline(catalog, entry)));
+    std::string extraEntry;
+    ITK_TEST_EXPECT_TRUE(!std::getline(catalog, extraEntry));
+  }
+  const itk::ScancoImageIO::HeaderPointer header = itk::ScancoImageIO::ReadHeader(archivedFileName);
+  ITK_TEST_EXPECT_EQUAL(entry,
+                        IndexerType::FormatCatalogEntry(archivedFileName,
+                                                        itksys::SystemTools::ModifiedTime(archivedFileName),
+                                                        itksys::SystemTools::FileLength(archivedFileName),
+                                                        *header));
+  std::cout << entry << std::endl;
+
+  // A second run does not parse the unchanged file again
+  ITK_TRY_EXPECT_NO_EXCEPTION(indexer->Update());
+  ITK_TEST_EXPECT_EQUAL(indexer->GetNumberOfParsedFiles(), 0);
+  ITK_TEST_EXPECT_EQUAL(indexer->GetNumberOfUnchangedFiles(), 1);
+  ITK_TEST_EXPECT_EQUAL(indexer->GetNumberOfFailedFiles(), 2);
+
+  // Removed files are dropped from the catalog
+  itksys::SystemTools::RemoveFile(archivedFileName);
+  ITK_TRY_EXPECT_NO_EXCEPTION(indexer->Update());
+  ITK_TEST_EXPECT_EQUAL(indexer->GetNumberOfUnchangedFiles(), 0);
+  ITK_TEST_EXPECT_EQUAL(itksys::SystemTools::FileLength(catalogFileName), 0);
+
+  // Non-ASCII file names are written to the catalog as UTF-8, and are
+  // matched again on the next run
+  const std::string utf8Name = "\xc3\xa9" "chantillon";
+  const std::string utf8FileName =
+    archiveDirectory + "/sub/" + utf8Name + itksys::SystemTools::GetFilenameLastExtension(inputFileName);
+  ITK_TEST_EXPECT_TRUE(static_cast<bool>(itksys::SystemTools::CopyFileAlways(inputFileName, utf8FileName)));
+  ITK_TRY_EXPECT_NO_EXCEPTION(indexer->Update());
+  ITK_TEST_EXPECT_EQUAL(indexer->GetNumberOfParsedFiles(), 1);
+  {
+    std::ifstream catalog(catalogFileName.c_str());
+    ITK_TEST_EXPECT_TRUE(static_cast<bool>(std::getline(catalog, entry)));
+  }
+  ITK_TEST_EXPECT_TRUE(entry.find("/sub/" + utf8Name + ".") != std::string::npos);
+  ITK_TRY_EXPECT_NO_EXCEPTION(indexer->Update());
+  ITK_TEST_EXPECT_EQUAL(indexer->GetNumberOfParsedFiles(), 0);
+  ITK_TEST_EXPECT_EQUAL(indexer->GetNumberOfUnchangedFiles(), 1);
+
+
+  std::cout << "Test finished" << std::endl;
+  return EXIT_SUCCESS;
+}
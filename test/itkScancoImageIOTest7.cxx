@@ -0,0 +1,89 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         https://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <cstring>
+#include "itkScancoHeaderCache.h"
+#include "itkScancoImageIO.h"
+#include "itkTestingMacros.h"
+
+
+#define SPECIFIC_IMAGEIO_MODULE_TEST
+
+int
+itkScancoImageIOTest7(int argc, char * argv[])
+{
+  if (argc < 3)
+  {
+    std::cerr << "Missing parameters." << std::endl;
+    std::cerr << "Usage: " << std::endl;
+    std::cerr << itkNameOfTestExecutableMacro(argv) << " Input CacheFile" << std::endl;
+    return EXIT_FAILURE;
+  }
+  const std::string inputFileName = argv[1];
+  const std::string cacheFileName = argv[2];
+
+  itk::ScancoHeaderCache & cache = itk::ScancoHeaderCache::GetInstance();
+  cache.Clear();
+  ITK_TEST_EXPECT_EQUAL(cache.GetNumberOfEntries(), 0);
+  ITK_TEST_EXPECT_TRUE(cache.GetHeader(inputFileName) == nullptr);
+
+  using IOType = itk::ScancoImageIO;
+  IOType::Pointer scancoIO = IOType::New();
+  ITK_TEST_EXPECT_TRUE(!scancoIO->GetUseHeaderCache());
+  scancoIO->UseHeaderCacheOn();
+  scancoIO->SetFileName(inputFileName);
+  ITK_TRY_EXPECT_NO_EXCEPTION(scancoIO->ReadImageInformation());
+  ITK_TEST_EXPECT_EQUAL(cache.GetNumberOfEntries(), 1);
+  const IOType::HeaderPointer header = scancoIO->GetHeader();
+  ITK_TEST_EXPECT_TRUE(cache.GetHeader(inputFileName) == header);
+
+  // A second IO gets the cached header instead of parsing the file
+  IOType::Pointer cachedIO = IOType::New();
+  cachedIO->UseHeaderCacheOn();
+  ITK_TEST_EXPECT_TRUE(cachedIO->CanReadFile(inputFileName.c_str()));
+  cachedIO->SetFileName(inputFileName);
+  ITK_TRY_EXPECT_NO_EXCEPTION(cachedIO->ReadImageInformation());
+  ITK_TEST_EXPECT_TRUE(cachedIO->GetHeader() == header);
+  ITK_TEST_EXPECT_EQUAL(cachedIO->GetDimensions(2), scancoIO->GetDimensions(2));
+
+  // The cache survives a round trip through a file
+  ITK_TRY_EXPECT_NO_EXCEPTION(cache.Save(cacheFileName));
+  cache.Clear();
+  ITK_TEST_EXPECT_TRUE(cache.GetHeader(inputFileName) == nullptr);
+  ITK_TRY_EXPECT_NO_EXCEPTION(cache.Load(cacheFileName));
+  ITK_TEST_EXPECT_EQUAL(cache.GetNumberOfEntries(), 1);
+  const itk::ScancoHeaderCache::HeaderPointer loadedHeader = cache.GetHeader(inputFileName);
+  ITK_TEST_EXPECT_TRUE(loadedHeader != nullptr);
+  ITK_TEST_EXPECT_EQUAL(std::memcmp(loadedHeader.get(), header.get(), sizeof(itk::ScancoHeader)), 0);
+
+  // Only cache files can be loaded
+  ITK_TRY_EXPECT_EXCEPTION(cache.Load(inputFileName));
+
+  // The least recently used entries are dropped to respect the bound
+  cache.SetMaximumNumberOfEntries(0);
+  ITK_TEST_EXPECT_EQUAL(cache.GetMaximumNumberOfEntries(), 0);
+  ITK_TEST_EXPECT_EQUAL(cache.GetNumberOfEntries(), 0);
+  cache.SetMaximumNumberOfEntries(1024);
+  ITK_TEST_EXPECT_TRUE(cache.ReadHeader(inputFileName) != nullptr);
+  ITK_TEST_EXPECT_EQUAL(cache.GetNumberOfEntries(), 1);
+  cache.Clear();
+
+
+  std::cout << "Test finished" << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,150 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         https://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <algorithm>
+#include "itkImageFileReader.h"
+#include "itkScancoImageIO.h"
+#include "itkScancoRunLengthDecoder.h"
+#include "itkScancoSliceReader.h"
+#include "itkTestingMacros.h"
+
+
+#define SPECIFIC_IMAGEIO_MODULE_TEST
+
+namespace
+{
+
+// Decode in small steps, with the compressed data arriving in pieces, and
+// compare with decoding everything at once.
+bool
+DecodesInPieces(int compression, const std::vector<char> & data, itk::SizeValueType count)
+{
+  const itk::ScancoRunLengthDecoder whole(compression, data.data(), data.size());
+  itk::ScancoRunLengthDecoder::State wholeState = whole.GetInitialState();
+  std::vector<unsigned char>         expected(count, 0);
+  if (whole.Decode(wholeState, expected.data(), count) != count)
+  {
+    return false;
+  }
+
+  std::vector<unsigned char>         output(count, 0);
+  itk::ScancoRunLengthDecoder::State state = whole.GetInitialState();
+  itk::SizeValueType                 produced = 0;
+  itk::SizeValueType                 available = 0;
+  while (produced < count)
+  {
+    available = std::min<itk::SizeValueType>(available + 3, data.size());
+    const itk::ScancoRunLengthDecoder partial(compression, data.data(), available);
+    const itk::SizeValueType          step = std::min<itk::SizeValueType>(7, count - produced);
+    const itk::SizeValueType          n = partial.Decode(state, output.data() + produced, step);
+    if (n == 0 && available == data.size())
+    {
+      return false;
+    }
+    produced += n;
+  }
+  return output == expected;
+}
+
+} // end anonymous namespace
+
+int
+itkScancoImageIOTest8(int argc, char * argv[])
+{
+  if (argc < 2)
+  {
+    std::cerr << "Missing parameters." << std::endl;
+    std::cerr << "Usage: " << std::endl;
+    std::cerr << itkNameOfTestExecutableMacro(argv) << " Input" << std::endl;
+    return EXIT_FAILURE;
+  }
+  const std::string inputFileName = argv[1];
+
+  // 8-bit run-lengths are (length, value) pairs
+  const std::vector<char> c2Data = { 10, 1, 0, 5, 127, 2, 3, 0, 20, 9 };
+  ITK_TEST_EXPECT_TRUE(DecodesInPieces(0x00c2, c2Data, 10 + 127 + 3 + 20));
+
+  // binary run-lengths alternate between two values, 255 continues a run
+  const std::vector<char> b2Data = { 0, 42, 4, static_cast<char>(255), 6, 3, 1, 9 };
+  ITK_TEST_EXPECT_TRUE(DecodesInPieces(0x00b2, b2Data, 4 + 254 + 6 + 3 + 1 + 9));
+
+  constexpr unsigned int Dimension = 3;
+  using PixelType = short;
+  using ImageType = itk::Image<PixelType, Dimension>;
+
+  using ReaderType = itk::ImageFileReader<ImageType>;
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetImageIO(itk::ScancoImageIO::New());
+  reader->SetFileName(inputFileName);
+  ITK_TRY_EXPECT_NO_EXCEPTION(reader->Update());
+  ImageType::Pointer        image = reader->GetOutput();
+  const ImageType::SizeType size = image->GetLargestPossibleRegion().GetSize();
+  const itk::SizeValueType  sliceSize = size[0] * size[1];
+
+  using SliceReaderType = itk::ScancoSliceReader;
+  SliceReaderType::Pointer sliceReader = SliceReaderType::New();
+
+  ITK_EXERCISE_BASIC_OBJECT_METHODS(sliceReader, ScancoSliceReader, Object);
+
+  sliceReader->SetFileName(inputFileName);
+  ITK_TEST_SET_GET_VALUE(inputFileName, sliceReader->GetFileName());
+  sliceReader->SetMaximumNumberOfCachedSlices(4);
+  ITK_TEST_SET_GET_VALUE(4, sliceReader->GetMaximumNumberOfCachedSlices());
+  sliceReader->SetNumberOfPrefetchedSlices(2);
+  ITK_TEST_SET_GET_VALUE(2, sliceReader->GetNumberOfPrefetchedSlices());
+  ITK_TRY_EXPECT_NO_EXCEPTION(sliceReader->Open());
+  ITK_TEST_EXPECT_TRUE(sliceReader->GetHeader() != nullptr);
+  ITK_TEST_EXPECT_EQUAL(sliceReader->GetSliceSizeInBytes(), sliceSize * sizeof(PixelType));
+
+  // Scroll forward, then back, then jump around
+  std::vector<itk::SizeValueType> order;
+  for (itk::SizeValueType z = 0; z < size[2]; ++z)
+  {
+    order.push_back(z);
+  }
+  for (itk::SizeValueType z = size[2]; z > 0; --z)
+  {
+    order.push_back(z - 1);
+  }
+  for (itk::SizeValueType i = 0; i < size[2]; ++i)
+  {
+    order.push_back((i * 7) % size[2]);
+  }
+
+  std::vector<PixelType> slice(sliceSize);
+  bool                   slicesMatch = true;
+  bool                   cacheIsBounded = true;
+  for (const itk::SizeValueType z : order)
+  {
+    sliceReader->ReadSlice(z, slice.data());
+    slicesMatch = slicesMatch && std::equal(slice.begin(), slice.end(), image->GetBufferPointer() + z * sliceSize);
+    cacheIsBounded = cacheIsBounded && sliceReader->GetNumberOfCachedSlices() <= 4;
+  }
+  ITK_TEST_EXPECT_TRUE(slicesMatch);
+  ITK_TEST_EXPECT_TRUE(cacheIsBounded);
+
+  sliceReader->ClearCache();
+  ITK_TEST_EXPECT_EQUAL(sliceReader->GetNumberOfCachedSlices(), 0);
+
+  // A slice outside of the image is rejected
+  ITK_TRY_EXPECT_EXCEPTION(sliceReader->ReadSlice(size[2], slice.data()));
+
+
+  std::cout << "Test finished" << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,119 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         https://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <fstream>
+#include "itkScancoBrickCache.h"
+#include "itkScancoImageIO.h"
+#include "itkTestingMacros.h"
+#include "itksys/SystemTools.hxx"
+
+
+#define SPECIFIC_IMAGEIO_MODULE_TEST
+
+int
+itkScancoImageIOTest9(int argc, char * argv[])
+{
+  if (argc < 3)
+  {
+    std::cerr << "Missing parameters." << std::endl;
+    std::cerr << "Usage: " << std::endl;
+    std::cerr << itkNameOfTestExecutableMacro(argv) << " Input Copy" << std::endl;
+    return EXIT_FAILURE;
+  }
+  const std::string inputFileName = argv[1];
+  const std::string copyFileName = argv[2];
+  const std::string cacheFileName = itk::ScancoBrickCache::GetCacheFileName(copyFileName);
+
+  // Work on a copy, since the cache is written next to the file
+  ITK_TEST_EXPECT_TRUE(static_cast<bool>(itksys::SystemTools::CopyFileAlways(inputFileName, copyFileName)));
+  itksys::SystemTools::RemoveFile(cacheFileName);
+  ITK_TEST_EXPECT_TRUE(!itk::ScancoBrickCache::IsUpToDate(cacheFileName, copyFileName));
+
+  // A brick size that does not divide the image leaves partial bricks
+  const unsigned int brickSize = 7;
+  ITK_TRY_EXPECT_NO_EXCEPTION(itk::ScancoBrickCache::Transcode(copyFileName, cacheFileName, brickSize));
+  ITK_TEST_EXPECT_TRUE(itk::ScancoBrickCache::IsUpToDate(cacheFileName, copyFileName));
+
+  using IOType = itk::ScancoImageIO;
+  IOType::Pointer plainIO = IOType::New();
+  plainIO->SetFileName(copyFileName);
+  ITK_TRY_EXPECT_NO_EXCEPTION(plainIO->ReadImageInformation());
+
+  IOType::Pointer cachedIO = IOType::New();
+  ITK_TEST_EXPECT_TRUE(!cachedIO->GetUseBrickCache());
+  cachedIO->UseBrickCacheOn();
+  cachedIO->SetFileName(copyFileName);
+  cachedIO->SetHeader(plainIO->GetHeader());
+
+  unsigned int                                         cachedBrickSize = 0;
+  std::vector<itk::ScancoBrickCache::BrickInformation> bricks;
+  ITK_TRY_EXPECT_NO_EXCEPTION(itk::ScancoBrickCache::ReadBrickInformation(cacheFileName, cachedBrickSize, bricks));
+  ITK_TEST_EXPECT_EQUAL(cachedBrickSize, brickSize);
+  itk::SizeValueType numberOfBricks = 1;
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    numberOfBricks *= (plainIO->GetDimensions(i) + brickSize - 1) / brickSize;
+  }
+  ITK_TEST_EXPECT_EQUAL(bricks.size(), numberOfBricks);
+  bool rangesAreOrdered = true;
+  for (const auto & brick : bricks)
+  {
+    rangesAreOrdered = rangesAreOrdered && brick.Minimum <= brick.Maximum;
+  }
+  ITK_TEST_EXPECT_TRUE(rangesAreOrdered);
+
+  // The whole image, and a region that starts and ends inside of bricks
+  itk::ImageIORegion largestRegion(3);
+  itk::ImageIORegion region(3);
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    largestRegion.SetSize(i, plainIO->GetDimensions(i));
+    region.SetIndex(i, plainIO->GetDimensions(i) / 3);
+    region.SetSize(i, plainIO->GetDimensions(i) / 2);
+  }
+  for (const itk::ImageIORegion & testRegion : { largestRegion, region })
+  {
+    std::vector<short> expected(testRegion.GetNumberOfPixels());
+    std::vector<short> cached(testRegion.GetNumberOfPixels(), -1);
+    ITK_TRY_EXPECT_NO_EXCEPTION(plainIO->ReadRegion(testRegion, expected.data()));
+    ITK_TEST_EXPECT_TRUE(itk::ScancoBrickCache::ReadRegion(
+      cacheFileName, copyFileName, *plainIO->GetHeader(), testRegion, cached.data()));
+    ITK_TEST_EXPECT_TRUE(expected == cached);
+    std::fill(cached.begin(), cached.end(), -1);
+    ITK_TRY_EXPECT_NO_EXCEPTION(cachedIO->ReadRegion(testRegion, cached.data()));
+    ITK_TEST_EXPECT_TRUE(expected == cached);
+  }
+
+  // A modified file makes the cache stale, and reads fall back to the file
+  {
+    std::ofstream copy(copyFileName.c_str(), std::ios::out | std::ios::binary | std::ios::app);
+    copy.put('\0');
+  }
+  ITK_TEST_EXPECT_TRUE(!itk::ScancoBrickCache::IsUpToDate(cacheFileName, copyFileName));
+  std::vector<short> expected(region.GetNumberOfPixels());
+  std::vector<short> cached(region.GetNumberOfPixels());
+  ITK_TEST_EXPECT_TRUE(
+    !itk::ScancoBrickCache::ReadRegion(cacheFileName, copyFileName, *plainIO->GetHeader(), region, cached.data()));
+  ITK_TRY_EXPECT_NO_EXCEPTION(plainIO->ReadRegion(region, expected.data()));
+  ITK_TRY_EXPECT_NO_EXCEPTION(cachedIO->ReadRegion(region, cached.data()));
+  ITK_TEST_EXPECT_TRUE(expected == cached);
+
+
+  std::cout << "Test finished" << std::endl;
+  return EXIT_SUCCESS;
+}
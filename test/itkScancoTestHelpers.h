@@ -0,0 +1,155 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         https://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkScancoTestHelpers_h
+#define itkScancoTestHelpers_h
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "itkIntTypes.h"
+
+namespace itk
+{
+/** Writers of synthetic AIM files for the IOScanco tests. */
+namespace ScancoTestHelpers
+{
+
+/** Append a little-endian 64-bit integer. */
+inline void
+AppendInt64(std::vector<char> & buffer, int64_t value)
+{
+  for (int i = 0; i < 8; ++i)
+  {
+    buffer.push_back(static_cast<char>(static_cast<uint64_t>(value) >> (8 * i)));
+  }
+}
+
+
+/** 8-bit run-lengths, as (length, value) pairs after the 64-bit size. */
+inline std::vector<char>
+EncodeRunLengths(const std::vector<unsigned char> & voxels)
+{
+  std::vector<char> data(8);
+  for (size_t i = 0; i < voxels.size();)
+  {
+    size_t length = 1;
+    while (i + length < voxels.size() && voxels[i + length] == voxels[i] && length < 255)
+    {
+      ++length;
+    }
+    data.push_back(static_cast<char>(length));
+    data.push_back(static_cast<char>(voxels[i]));
+    i += length;
+  }
+  std::vector<char> sizeWord;
+  AppendInt64(sizeWord, static_cast<int64_t>(data.size()));
+  std::copy(sizeWord.begin(), sizeWord.end(), data.begin());
+  return data;
+}
+
+
+/** Packed bits, where each byte holds a 2x2x2 block of voxels, followed by
+ * the value of the voxels that are set. */
+inline std::vector<char>
+EncodePackedBits(const std::vector<unsigned char> & voxels, const SizeValueType dimensions[3], unsigned char value)
+{
+  const SizeValueType xinc = (dimensions[0] + 1) / 2;
+  const SizeValueType yinc = (dimensions[1] + 1) / 2;
+  const SizeValueType zinc = (dimensions[2] + 1) / 2;
+  std::vector<char>   data(xinc * yinc * zinc + 1);
+  for (SizeValueType z = 0; z < dimensions[2]; ++z)
+  {
+    for (SizeValueType y = 0; y < dimensions[1]; ++y)
+    {
+      for (SizeValueType x = 0; x < dimensions[0]; ++x)
+      {
+        const int bit = static_cast<int>((z & 1) << 2 | (y & 1) << 1 | (x & 1));
+        if (voxels[(z * dimensions[1] + y) * dimensions[0] + x] != 0)
+        {
+          data[((z / 2) * yinc + y / 2) * xinc + x / 2] |= static_cast<char>(1 << bit);
+        }
+      }
+    }
+  }
+  data.back() = static_cast<char>(value);
+  return data;
+}
+
+
+/** The header of an AIM v030 file with an empty log, for data of the given
+ * data type code and size. The position is in voxels and the element size
+ * in units of 1e-6 mm. */
+inline std::vector<char>
+EncodeAIMHeader(int                 dataType,
+                const SizeValueType dimensions[3],
+                const int64_t       position[3],
+                int64_t             elementSize,
+                int64_t             dataSize)
+{
+  std::vector<char> header(16);
+  std::copy_n("AIMDATA_V030   ", 16, header.begin());
+  constexpr int64_t preheaderSize = 40;
+  constexpr int64_t structSize = 280;
+  constexpr int64_t logSize = 32;
+  AppendInt64(header, preheaderSize);
+  AppendInt64(header, structSize);
+  AppendInt64(header, logSize);
+  AppendInt64(header, dataSize);
+  AppendInt64(header, 0);
+  header.resize(header.size() + 12);
+  // the data type is a 32-bit int
+  for (int i = 0; i < 4; ++i)
+  {
+    header.push_back(static_cast<char>(dataType >> (8 * i)));
+  }
+  for (int i = 0; i < 21; ++i)
+  {
+    AppendInt64(header, i < 3 ? position[i] : (i < 6 ? static_cast<int64_t>(dimensions[i - 3]) : 0));
+  }
+  for (int i = 0; i < 3; ++i)
+  {
+    AppendInt64(header, elementSize);
+  }
+  header.resize(16 + preheaderSize + structSize + logSize);
+  return header;
+}
+
+
+/** Write an AIM v030 file, see EncodeAIMHeader(). */
+inline bool
+WriteAIM(const std::string &       fileName,
+         int                       dataType,
+         const SizeValueType       dimensions[3],
+         const int64_t             position[3],
+         int64_t                   elementSize,
+         const std::vector<char> & data)
+{
+  const std::vector<char> header =
+    EncodeAIMHeader(dataType, dimensions, position, elementSize, static_cast<int64_t>(data.size()));
+  std::ofstream file(fileName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+  file.write(header.data(), header.size());
+  file.write(data.data(), data.size());
+  return file.good();
+}
+
+} // end namespace ScancoTestHelpers
+} // end namespace itk
+
+#endif // itkScancoTestHelpers_h